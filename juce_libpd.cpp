@@ -65,7 +65,17 @@ using namespace pd;
 //--------------------------------------------------------------------
 ofxPd::ofxPd() : PdBase() {
 	inBuffer = NULL;
+	inBufferSize = 0;
 	computing = false;
+	realtimeSafe = false;
+	audioBusy = false;
+	audioSuspended = false;
+	settingsPending = false;
+	pendingBufferSize = 0;
+	pendingInChannels = 0;
+	pendingOutChannels = 0;
+	variableBuffer = false;
+	fifoPos = 0;
 	clear();
 }
 
@@ -78,31 +88,41 @@ ofxPd::~ofxPd() {
 bool ofxPd::init(const int numOutChannels, const int numInChannels, 
                  const int sampleRate, const int ticksPerBuffer, bool queued) {
 	
-    log = juce::Logger::getCurrentLogger();
+	// make sure the audio callbacks don't touch the buffers while changing
+	suspendAudio();
     
 	// init pd
 	if(!PdBase::init(numInChannels, numOutChannels, sampleRate, queued)) {
-		log->writeToLog("could not init");
+		OFXPD_TRACE_ERROR("could not init");
+		resumeAudio();
 		clear();
 		return false;
 	}
     
 	ticks = ticksPerBuffer;
-	bsize = ticksPerBuffer*blockSize();
+	bsize = ticksPerBuffer*instanceBlockSize();
 	srate = sampleRate;
 	inChannels = numInChannels;
 	outChannels = numOutChannels;
 
 	// allocate buffers
+	if(inBuffer != NULL) {
+		delete[] inBuffer;
+	}
 	inBuffer = new float[numInChannels*bsize];
-
-	log->writeToLog("inited");
-	log->writeToLog(" samplerate: " + to_string(sampleRate));
-	log->writeToLog(" channels in: " + to_string(numInChannels));
-	log->writeToLog(" channels out: " + to_string(numOutChannels));
-	log->writeToLog(" ticks: " + to_string(ticksPerBuffer));
-	log->writeToLog(" block size: " + to_string(blockSize()));
-	log->writeToLog(" calc buffer size: " + to_string(bsize));
+	inBufferSize = bsize;
+	resetFifo();
+	settingsPending = false;
+
+	resumeAudio();
+
+	OFXPD_TRACE_NOTICE("inited");
+	OFXPD_TRACE_NOTICE(" samplerate: %d", sampleRate);
+	OFXPD_TRACE_NOTICE(" channels in: %d", numInChannels);
+	OFXPD_TRACE_NOTICE(" channels out: %d", numOutChannels);
+	OFXPD_TRACE_NOTICE(" ticks: %d", ticksPerBuffer);
+	OFXPD_TRACE_NOTICE(" block size: %d", instanceBlockSize());
+	OFXPD_TRACE_NOTICE(" calc buffer size: %d", bsize);
 	
 	return true;
 }
@@ -116,11 +136,14 @@ void ofxPd::clear() {
 //	#ifndef TARGET_WIN32
 //		lock();
 //	#endif
+	suspendAudio();
 	if(inBuffer != NULL) {
 		delete[] inBuffer;
 		inBuffer = NULL;
 	}
-	PdContext::instance().clear();
+	inBufferSize = 0;
+	resumeAudio();
+	useContext().clear();
 //	#ifndef TARGET_WIN32
 //		unlock();
 //	#endif
@@ -129,8 +152,7 @@ void ofxPd::clear() {
 	channels.clear();
 
 	// add default global channel
-	Channel c;
-	channels.insert(make_pair(-1, c));
+	channels.resize(1);
 	
 	ticks = 0;
 	bsize = 0;
@@ -143,12 +165,12 @@ void ofxPd::clear() {
 void ofxPd::addToSearchPath(const std::string& path) {
     string fullpath = "/Users/shawn/";
 	//FIXME string fullpath = ofFilePath::getAbsolutePath(ofToDataPath(path));
-	//FIXME juce::Logger::outputDebugString("Pd") << "adding search path: "+fullpath;
+	OFXPD_TRACE_NOTICE("adding search path: %s", fullpath.c_str());
 	PdBase::addToSearchPath(fullpath.c_str());
 }
 
 void ofxPd::clearSearchPath() {
-	log->writeToLog("clearing search paths");
+	OFXPD_TRACE_NOTICE("clearing search paths");
 	PdBase::clearSearchPath();
 }
 
@@ -168,43 +190,43 @@ Patch ofxPd::openPatch(const std::string& patch) {
 		folder.erase(folder.end()-1);
 	}
 	
-	log->writeToLog("opening patch: "+file+" path: "+folder);
+	OFXPD_TRACE_NOTICE("opening patch: %s path: %s", file.c_str(), folder.c_str());
 
 	// [; pd open file folder(
 	Patch p = PdBase::openPatch(file.c_str(), folder.c_str());
  	if(!p.isValid()) {
-		log->writeToLog("opening patch \""+file+"\" failed");
+		OFXPD_TRACE_ERROR("opening patch \"%s\" failed", file.c_str());
 	}
 	
 	return p;
 }
 
 pd::Patch ofxPd::openPatch(pd::Patch& patch) {
-    log->writeToLog("##opening patch: "+patch.filename()+" path: "+patch.path());
+    OFXPD_TRACE_NOTICE("opening patch: %s path: %s", patch.filename().c_str(), patch.path().c_str());
 	Patch p = PdBase::openPatch(patch);
 	if(!p.isValid()) {
-		log->writeToLog("opening patch \""+patch.filename()+"\" failed");
+		OFXPD_TRACE_ERROR("opening patch \"%s\" failed", patch.filename().c_str());
 	}
 	return p;
 }
 
 void ofxPd::closePatch(const std::string& patch) {
-	log->writeToLog("closing path: "+patch);
+	OFXPD_TRACE_NOTICE("closing patch: %s", patch.c_str());
 	PdBase::closePatch(patch);
 }
 
 void ofxPd::closePatch(Patch& patch) {
-	log->writeToLog("closing patch: "+patch.filename());
+	OFXPD_TRACE_NOTICE("closing patch: %s", patch.filename().c_str());
 	PdBase::closePatch(patch);
 }	
 
 //--------------------------------------------------------------------
 void ofxPd::computeAudio(bool state) {
 	if(state) {
-		log->writeToLog("audio processing on");
+		OFXPD_TRACE_NOTICE("audio processing on");
 	}
 	else {
-		log->writeToLog("audio processing off");
+		OFXPD_TRACE_NOTICE("audio processing off");
 	}
 	computing = state;
 
@@ -224,30 +246,34 @@ void ofxPd::stop() {
 //----------------------------------------------------------
 void ofxPd::subscribe(const std::string& source) {
 	if(exists(source)) {
-		//FIXME juce::Logger::outputDebugString("Pd") << "subscribe: ignoring duplicate source";
+		OFXPD_TRACE_WARNING("subscribe: ignoring duplicate source");
 		return;
 	}
 	PdBase::subscribe(source);
+
+	// resolve the pd symbol once so events can be matched by pointer
 	Source s;
-	sources.insert(pair<string,Source>(source, s));
+	s.name = source;
+	sys_lock();
+	s.symbol = gensym(source.c_str());
+	sys_unlock();
+	sources.push_back(s);
+	updateSourceKeys();
 }
 
 void ofxPd::unsubscribe(const std::string& source) {
-	map<string,Source>::iterator iter;
-	iter = sources.find(source);
-	if(iter == sources.end()) {
-		log->writeToLog("unsubscribe: ignoring unknown source");
+	int index = findSource(source);
+	if(index < 1) {
+		OFXPD_TRACE_WARNING("unsubscribe: ignoring unknown source");
 		return;
 	}
 	PdBase::unsubscribe(source);
-	sources.erase(iter);
+	sources.erase(sources.begin()+index);
+	updateSourceKeys();
 }
 
 bool ofxPd::exists(const std::string& source) {
-	if(sources.find(source) != sources.end()) {
-		return true;
-	}
-	return false;
+	return findSource(source) > -1;
 }
 
 void ofxPd::unsubscribeAll(){
@@ -257,16 +283,16 @@ void ofxPd::unsubscribeAll(){
 
 	// add default global source
 	Source s;
-	sources.insert(make_pair("", s));
+	s.symbol = NULL;
+	sources.push_back(s);
+	updateSourceKeys();
 }
 
 //--------------------------------------------------------------------
 void ofxPd::addReceiver(PdReceiver& receiver) {
-	
-	pair<set<PdReceiver*>::iterator, bool> ret;
-	ret = receivers.insert(&receiver);
-	if(!ret.second) {
-		log->writeToLog("addReceiver: ignoring duplicate receiver");
+
+	if(!receivers.add(&receiver)) {
+		OFXPD_TRACE_WARNING("addReceiver: ignoring duplicate receiver");
 		return;
 	}
 
@@ -280,43 +306,61 @@ void ofxPd::addReceiver(PdReceiver& receiver) {
 }
 
 void ofxPd::removeReceiver(PdReceiver& receiver) {
-	
+
 	// exists?
-	set<PdReceiver*>::iterator r_iter;
-	r_iter = receivers.find(&receiver);
-	if(r_iter == receivers.end()) {
-		log->writeToLog("removeReceiver: ignoring unknown receiver");
+	if(!receiverExists(receiver)) {
+		OFXPD_TRACE_WARNING("removeReceiver: ignoring unknown receiver");
 		return;
 	}
-	receivers.erase(r_iter);
-	
+
+	// remove from all sources
+	ignoreSource(receiver);
+
+	receivers.remove(&receiver);
+
 	// clear PdBase receiver on removing last reciever
 	if(receivers.size() == 0) {
 		PdBase::setReceiver(NULL);
 	}
-
-	// remove from all sources
-	ignoreSource(receiver);
 }
 
 bool ofxPd::receiverExists(PdReceiver& receiver) {
-	if(receivers.find(&receiver) != receivers.end())
-		return true;
-	return false;
+	return receivers.contains(&receiver);
 }
 
 void ofxPd::clearReceivers() {
 
 	receivers.clear();
-	
-	map<string,Source>::iterator iter;
-	for(iter = sources.begin(); iter != sources.end(); ++iter) {
-		iter->second.receivers.clear();
+
+	for(size_t i = 0; i < sources.size(); ++i) {
+		sources[i].receivers.clear();
 	}
-	
+
 	PdBase::setReceiver(NULL);
 }
 
+//----------------------------------------------------------
+bool ofxPd::setBlockSize(int size) {
+	suspendAudio();
+	if(!PdBase::setBlockSize(size)) {
+		resumeAudio();
+		OFXPD_TRACE_ERROR("could not set block size to %d", size);
+		return false;
+	}
+	if(inBuffer != NULL) {
+		ticks = std::max(1, bsize/size);
+		bsize = ticks*size;
+		delete[] inBuffer;
+		inBuffer = new float[inChannels*bsize];
+		memset(inBuffer, 0, inChannels*bsize*sizeof(float));
+		inBufferSize = bsize;
+	}
+	resetFifo();
+	resumeAudio();
+	OFXPD_TRACE_NOTICE("block size: %d ticks: %d", size, ticks);
+	return true;
+}
+
 //----------------------------------------------------------
 int ofxPd::ticksPerBuffer() {
 	return ticks;
@@ -346,103 +390,79 @@ bool ofxPd::isComputingAudio() {
 void ofxPd::receiveSource(PdReceiver& receiver, const std::string& source) {
 
 	if(!receiverExists(receiver)) {
-		log->writeToLog("receive: unknown receiver, call addReceiver first");
+		OFXPD_TRACE_WARNING("receive: unknown receiver, call addReceiver first");
 		return;
 	}
-	
-	if(!exists(source)) {
-		log->writeToLog("receive: unknown source, call subscribe first");
+
+	int index = findSource(source);
+	if(index < 0) {
+		OFXPD_TRACE_WARNING("receive: unknown source, call subscribe first");
 		return;
 	}
-	
-	// global source (all sources)
-	map<string,Source>::iterator g_iter;
-	g_iter = sources.find("");
-	
+
 	// subscribe to specific source
-	if(source != "") {
-	
-		// make sure global source is ignored
-		if(g_iter->second.receiverExists(&receiver)) {
-			g_iter->second.removeReceiver(&receiver);
-		}
-		
+	if(index > 0) {
+
+		// make sure global source (all sources) is ignored
+		sources[0].receivers.remove(&receiver);
+
 		// receive from specific source
-		map<string,Source>::iterator s_iter;
-		s_iter = sources.find(source);
-		s_iter->second.addReceiver(&receiver);
+		sources[index].receivers.add(&receiver);
 	}
 	else {
 		// make sure all sources are ignored
 		ignoreSource(receiver);
-	
+
 		// receive from the global source
-		g_iter->second.addReceiver(&receiver);
+		sources[0].receivers.add(&receiver);
 	}
 }
 
 void ofxPd::ignoreSource(PdReceiver& receiver, const std::string& source) {
 
 	if(!receiverExists(receiver)) {
-		log->writeToLog("ignore: ignoring unknown receiver");
+		OFXPD_TRACE_WARNING("ignore: ignoring unknown receiver");
 		return;
 	}
 
-	if(!exists(source)) {
-		log->writeToLog("ignore: ignoring unknown source");
+	int index = findSource(source);
+	if(index < 0) {
+		OFXPD_TRACE_WARNING("ignore: ignoring unknown source");
 		return;
 	}
-	
-	map<string,Source>::iterator s_iter;
-	
+
 	// unsubscribe from specific source
-	if(source != "") {
-	
-		// global source (all sources)
-		map<string,Source>::iterator g_iter;
-		g_iter = sources.find("");
-	
-		// negation from global
-		if(g_iter->second.receiverExists(&receiver)) {
-			
-			// remove from global
-			g_iter->second.removeReceiver(&receiver);
-			
+	if(index > 0) {
+
+		// negation from global (all sources)
+		if(sources[0].receivers.remove(&receiver)) {
+
 			// add to *all* other sources
-			for(s_iter = sources.begin(); s_iter != sources.end(); ++s_iter) {
-				if(s_iter != g_iter) {
-					s_iter->second.addReceiver(&receiver);
-				}
+			for(size_t i = 1; i < sources.size(); ++i) {
+				sources[i].receivers.add(&receiver);
 			}
 		}
-		
+
 		// remove from source
-		s_iter = sources.find(source);
-		s_iter->second.removeReceiver(&receiver);
+		sources[index].receivers.remove(&receiver);
 	}
-	else {	// ignore all sources	
-		for(s_iter = sources.begin(); s_iter != sources.end(); ++s_iter) {
-			s_iter->second.removeReceiver(&receiver);
+	else {	// ignore all sources
+		for(size_t i = 0; i < sources.size(); ++i) {
+			sources[i].receivers.remove(&receiver);
 		}
 	}
 }
 
 bool ofxPd::isReceivingSource(PdReceiver& receiver, const std::string& source) {
-	map<string,Source>::iterator s_iter;
-	s_iter = sources.find(source);
-	if(s_iter != sources.end() && s_iter->second.receiverExists(&receiver)) {
-		return true;
-	}
-	return false;
+	int index = findSource(source);
+	return index > -1 && sources[index].receivers.contains(&receiver);
 }
 
 //----------------------------------------------------------
 void ofxPd::addMidiReceiver(PdMidiReceiver& receiver) {
 
-	pair<set<PdMidiReceiver*>::iterator, bool> ret;
-	ret = midiReceivers.insert(&receiver);
-	if(!ret.second) {
-		log->writeToLog("addMidiReceiver: ignoring duplicate receiver");
+	if(!midiReceivers.add(&receiver)) {
+		OFXPD_TRACE_WARNING("addMidiReceiver: ignoring duplicate receiver");
 		return;
 	}
 
@@ -458,37 +478,32 @@ void ofxPd::addMidiReceiver(PdMidiReceiver& receiver) {
 void ofxPd::removeMidiReceiver(PdMidiReceiver& receiver) {
 
 	// exists?
-	set<PdMidiReceiver*>::iterator r_iter;
-	r_iter = midiReceivers.find(&receiver);
-	if(r_iter == midiReceivers.end()) {
-		log->writeToLog("removeMidiReceiver: ignoring unknown receiver");
+	if(!midiReceiverExists(receiver)) {
+		OFXPD_TRACE_WARNING("removeMidiReceiver: ignoring unknown receiver");
 		return;
 	}
-	midiReceivers.erase(r_iter);
-	
+
+	// remove from all channels
+	ignoreMidiChannel(receiver);
+
+	midiReceivers.remove(&receiver);
+
 	// clear PdBase receiver on removing last reciever
-	if(receivers.size() == 0) {
+	if(midiReceivers.size() == 0) {
 		PdBase::setMidiReceiver(NULL);
 	}
-
-	// remove from all sources
-	ignoreMidiChannel(receiver);
 }
 
 bool ofxPd::midiReceiverExists(PdMidiReceiver& receiver) {
-	if(midiReceivers.find(&receiver) != midiReceivers.end()) {
-		return true;
-	}
-	return false;
+	return midiReceivers.contains(&receiver);
 }
 
 void ofxPd::clearMidiReceivers() {
 
 	midiReceivers.clear();
-	
-	map<int,Channel>::iterator iter;
-	for(iter = channels.begin(); iter != channels.end(); ++iter) {
-		iter->second.receivers.clear();
+
+	for(size_t i = 0; i < channels.size(); ++i) {
+		channels[i].clear();
 	}
 
 	PdBase::setMidiReceiver(NULL);
@@ -498,7 +513,7 @@ void ofxPd::clearMidiReceivers() {
 void ofxPd::receiveMidiChannel(PdMidiReceiver& receiver, int channel) {
 
 	if(!midiReceiverExists(receiver)) {
-		log->writeToLog("receiveMidi: unknown receiver, call addMidiReceiver first");
+		OFXPD_TRACE_WARNING("receiveMidi: unknown receiver, call addMidiReceiver first");
 		return;
 	}
 
@@ -507,86 +522,64 @@ void ofxPd::receiveMidiChannel(PdMidiReceiver& receiver, int channel) {
 		channel = 0;
 	}
 
-	// insert channel if it dosen't exist yet
-	if(channels.find(channel) == channels.end()) {
-		Channel c;
-		channels.insert(pair<int,Channel>(channel, c));
+	// add channel if it dosen't exist yet
+	if(channel >= (int) channels.size()) {
+		channels.resize(channel+1);
 	}
 
-	// global channel (all channels)
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	
 	// subscribe to specific channel
 	if(channel != 0) {
-	
-		// make sure global channel is ignored
-		if(g_iter->second.midiReceiverExists(&receiver)) {
-			g_iter->second.removeMidiReceiver(&receiver);
-		}
-		
+
+		// make sure global channel (all channels) is ignored
+		channels[0].remove(&receiver);
+
 		// receive from specific channel
-		map<int,Channel>::iterator c_iter;
-		c_iter = channels.find(channel);
-		c_iter->second.addMidiReceiver(&receiver);
+		channels[channel].add(&receiver);
 	}
 	else {
 		// make sure all channels are ignored
 		ignoreMidiChannel(receiver);
 
 		// receive from the global channel
-		g_iter->second.addMidiReceiver(&receiver);
+		channels[0].add(&receiver);
 	}
 }
 
 void ofxPd::ignoreMidiChannel(PdMidiReceiver& receiver, int channel) {
 
 	if(!midiReceiverExists(receiver)) {
-		log->writeToLog("ignoreMidi: ignoring unknown receiver");
+		OFXPD_TRACE_WARNING("ignoreMidi: ignoring unknown receiver");
 		return;
-	} 
+	}
 
 	// handle bad channel numbers
 	if(channel < 0) {
 		channel = 0;
 	}
 
-	// insert channel if it dosen't exist yet
-	if(channels.find(channel) == channels.end()) {
-		Channel c;
-		channels.insert(pair<int,Channel>(channel, c));
+	// add channel if it dosen't exist yet
+	if(channel >= (int) channels.size()) {
+		channels.resize(channel+1);
 	}
 
-	map<int,Channel>::iterator c_iter;
-	
 	// unsubscribe from specific channel
 	if(channel != 0) {
-	
-		// global channel (all channels)
-		map<int,Channel>::iterator g_iter;
-		g_iter = channels.find(0);
-	
-		// negation from global
-		if(g_iter->second.midiReceiverExists(&receiver)) {
-			
-			// remove from global
-			g_iter->second.removeMidiReceiver(&receiver);
-			
+
+		// negation from global (all channels)
+		if(channels[0].remove(&receiver)) {
+
 			// add to *all* other channels
-			for(c_iter = channels.begin(); c_iter != channels.end(); ++c_iter) {
-				if(c_iter != g_iter) {
-					c_iter->second.addMidiReceiver(&receiver);
-				}
+			for(size_t i = 1; i < channels.size(); ++i) {
+				channels[i].add(&receiver);
 			}
 		}
-		
+
 		// remove from channel
-		c_iter = channels.find(channel);
-		c_iter->second.removeMidiReceiver(&receiver);
+		channels[channel].remove(&receiver);
 	}
-	else {	// ignore all sources	
-		for(c_iter = channels.begin(); c_iter != channels.end(); ++c_iter) {
-			c_iter->second.removeMidiReceiver(&receiver);
+	else {	// ignore all channels
+		for(size_t i = 0; i < channels.size(); ++i) {
+			channels[i].remove(&receiver);
 		}
 	}
 }
@@ -598,11 +591,7 @@ bool ofxPd::isReceivingMidiChannel(PdMidiReceiver& receiver, int channel) {
 		channel = 0;
 	}
 
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end() && c_iter->second.midiReceiverExists(&receiver))
-		return true;
-	return false;
+	return channel < (int) channels.size() && channels[channel].contains(&receiver);
 }
 
 //----------------------------------------------------------
@@ -632,339 +621,628 @@ void ofxPd::sendPolyAftertouch(const int channel, int pitch, int value) {
 
 //----------------------------------------------------------
 void ofxPd::audioIn(float* input, int bufferSize, int nChannels) {
+	if(realtimeSafe) {
+		audioBusy = true;
+		if(!audioSuspended && inBuffer != NULL) {
+			if(variableBuffer && bufferSize <= inBufferSize && nChannels == inChannels) {
+				memcpy(inBuffer, input, bufferSize*nChannels*sizeof(float));
+			}
+			else if(variableBuffer ||
+			        bufferSize/instanceBlockSize() != ticks || nChannels != inChannels) {
+				// leave the reinit to updateAudioSettings()
+				pendingBufferSize = bufferSize;
+				pendingInChannels = nChannels;
+				if(!settingsPending) {
+					pendingOutChannels = outChannels;
+				}
+				settingsPending = true;
+			}
+			else {
+				// pd only reads ticks*blockSize() frames, extra host frames are dropped
+				memcpy(inBuffer, input,
+				       std::min(bufferSize, bsize)*nChannels*sizeof(float));
+			}
+		}
+		audioBusy = false;
+		return;
+	}
 	try {
 		if(inBuffer != NULL) {
-			if(bufferSize != bsize || nChannels != inChannels) {
-				ticks = bufferSize/blockSize();
-				bsize = bufferSize;
-				inChannels = nChannels;
-				log->writeToLog("buffer size or num input channels updated");
-				init(outChannels, inChannels, srate, ticks, isQueued());
-				PdBase::computeAudio(computing);
+			int frames = bufferSize;
+			if(variableBuffer && nChannels == inChannels) {
+				if(bufferSize > inBufferSize) {
+					resizeInBuffer(bufferSize);
+				}
+			}
+			else {
+				if(bufferSize/instanceBlockSize() != ticks || nChannels != inChannels) {
+					inChannels = nChannels;
+					OFXPD_TRACE_NOTICE("buffer size or num input channels updated");
+					init(outChannels, inChannels, srate,
+					     bufferSize/instanceBlockSize(), isQueued());
+					PdBase::computeAudio(computing);
+				}
+				frames = std::min(bufferSize, bsize);
 			}
-			memcpy(inBuffer, input, bufferSize*nChannels*sizeof(float));
+			memcpy(inBuffer, input, frames*nChannels*sizeof(float));
 		}
 	}
 	catch (...) {
-		log->writeToLog("could not copy input buffer");
+		OFXPD_TRACE_ERROR("could not copy input buffer");
 	}
 }
 
 void ofxPd::audioOut(float* output, int bufferSize, int nChannels) {
+	if(realtimeSafe) {
+		audioBusy = true;
+		int processed = 0; // num samples per channel written by pd
+		if(!audioSuspended && inBuffer != NULL && !settingsPending) {
+			if(variableBuffer && bufferSize <= inBufferSize && nChannels == outChannels) {
+				for(int i = 0; i < inChannels; ++i) {
+					hostInPtrs[i] = inBuffer + i;
+				}
+				for(int i = 0; i < outChannels; ++i) {
+					hostOutPtrs[i] = output + i;
+				}
+				processFifo(hostInPtrs.data(), inChannels,
+				            hostOutPtrs.data(), outChannels, bufferSize);
+				processed = bufferSize;
+			}
+			else if(variableBuffer ||
+			        bufferSize/instanceBlockSize() != ticks || nChannels != outChannels) {
+				// leave the reinit to updateAudioSettings()
+				pendingBufferSize = bufferSize;
+				pendingOutChannels = nChannels;
+				pendingInChannels = inChannels;
+				settingsPending = true;
+			}
+			else if(PdBase::tryProcessFloat(ticks, inBuffer, output)) {
+				processed = bsize; // ticks*blockSize() <= bufferSize
+			}
+		}
+		// silence whatever pd didn't fill
+		memset(output + processed*nChannels, 0,
+		       (bufferSize-processed)*nChannels*sizeof(float));
+		audioBusy = false;
+		return;
+	}
 	if(inBuffer != NULL) {
-		if(bufferSize != bsize || nChannels != outChannels) {
-			ticks = bufferSize/blockSize();
-			bsize = bufferSize;
+		if(variableBuffer && nChannels == outChannels) {
+			if(bufferSize > inBufferSize) {
+				// audioIn() wasn't called with this size, so no input
+				resizeInBuffer(bufferSize);
+			}
+			for(int i = 0; i < inChannels; ++i) {
+				hostInPtrs[i] = inBuffer + i;
+			}
+			for(int i = 0; i < outChannels; ++i) {
+				hostOutPtrs[i] = output + i;
+			}
+			processFifo(hostInPtrs.data(), inChannels,
+			            hostOutPtrs.data(), outChannels, bufferSize);
+			return;
+		}
+		if(bufferSize/instanceBlockSize() != ticks || nChannels != outChannels) {
 			outChannels = nChannels;
-			log->writeToLog("buffer size or num output channels updated");
-			init(outChannels, inChannels, srate, ticks, isQueued());
+			OFXPD_TRACE_NOTICE("buffer size or num output channels updated");
+			init(outChannels, inChannels, srate,
+			     bufferSize/instanceBlockSize(), isQueued());
+			PdBase::computeAudio(computing);
+		}
+		int processed = 0;
+        if(PdBase::processFloat(ticks, inBuffer, output)) {
+			processed = bsize;
+		}
+		else {
+			OFXPD_TRACE_ERROR("could not process output buffer");
+		}
+		// silence the frames past ticks*blockSize()
+		memset(output + processed*nChannels, 0,
+		       (bufferSize-processed)*nChannels*sizeof(float));
+	}
+}
+
+void ofxPd::audioProcess(const float * const * input, int nInChannels,
+                         float * const * output, int nOutChannels,
+                         int bufferSize) {
+	if(realtimeSafe) {
+		audioBusy = true;
+		int processed = 0; // num samples per channel written by pd
+		if(!audioSuspended && inBuffer != NULL && !settingsPending) {
+			if(variableBuffer &&
+			   nInChannels == inChannels && nOutChannels == outChannels) {
+				processFifo(input, 1, output, 1, bufferSize);
+				processed = bufferSize;
+			}
+			else if(bufferSize/instanceBlockSize() != ticks ||
+			   nInChannels != inChannels || nOutChannels != outChannels) {
+				// leave the reinit to updateAudioSettings()
+				pendingBufferSize = bufferSize;
+				pendingInChannels = nInChannels;
+				pendingOutChannels = nOutChannels;
+				settingsPending = true;
+			}
+			else if(PdBase::tryProcessPlanar(ticks, input, output)) {
+				processed = bsize; // ticks*blockSize() <= bufferSize
+			}
+		}
+		// silence whatever pd didn't fill
+		for(int i = 0; i < nOutChannels; ++i) {
+			if(output[i] != NULL) {
+				memset(output[i] + processed, 0,
+				       (bufferSize-processed)*sizeof(float));
+			}
+		}
+		audioBusy = false;
+		return;
+	}
+	if(inBuffer != NULL) {
+		if(variableBuffer &&
+		   nInChannels == inChannels && nOutChannels == outChannels) {
+			processFifo(input, 1, output, 1, bufferSize);
+			return;
+		}
+		if(bufferSize/instanceBlockSize() != ticks ||
+		   nInChannels != inChannels || nOutChannels != outChannels) {
+			inChannels = nInChannels;
+			outChannels = nOutChannels;
+			OFXPD_TRACE_NOTICE("buffer size or num channels updated");
+			init(outChannels, inChannels, srate,
+			     bufferSize/instanceBlockSize(), isQueued());
 			PdBase::computeAudio(computing);
 		}
-        if(!PdBase::processFloat(ticks, inBuffer, output)) {
-			log->writeToLog("could not process output buffer");
+		int processed = 0;
+		if(PdBase::processPlanar(ticks, input, output)) {
+			processed = bsize;
+		}
+		else {
+			OFXPD_TRACE_ERROR("could not process output buffer");
+		}
+		// silence the frames past ticks*blockSize()
+		for(int i = 0; i < nOutChannels; ++i) {
+			if(output[i] != NULL) {
+				memset(output[i] + processed, 0,
+				       (bufferSize-processed)*sizeof(float));
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------
+bool ofxPd::renderToFile(const std::string& outFile, double seconds,
+                         const std::string& inFile, int bytesPerSample,
+                         double *realtimeFactor) {
+	double factor = 0;
+	suspendAudio();
+	bool ret = PdBase::renderToFile(outFile, seconds, inFile,
+	                                bytesPerSample, &factor);
+	resumeAudio();
+	if(ret) {
+		OFXPD_TRACE_NOTICE("rendered %.2f s to %s at %.1fx real time",
+		                   seconds, outFile.c_str(), factor);
+	}
+	else {
+		OFXPD_TRACE_ERROR("could not render to %s", outFile.c_str());
+	}
+	if(realtimeFactor != NULL) {
+		*realtimeFactor = factor;
+	}
+	return ret;
+}
+
+//----------------------------------------------------------
+void ofxPd::setRealtimeSafe(bool realtime) {
+	realtimeSafe = realtime;
+}
+
+bool ofxPd::isRealtimeSafe() {
+	return realtimeSafe;
+}
+
+bool ofxPd::updateAudioSettings() {
+	if(!settingsPending) {
+		return false;
+	}
+	int bufferSize = pendingBufferSize;
+	int nInChannels = pendingInChannels;
+	int nOutChannels = pendingOutChannels;
+	if(variableBuffer && nInChannels == inChannels && nOutChannels == outChannels) {
+		// only the input copy needs to grow, pd keeps running
+		resizeInBuffer(bufferSize);
+		return true;
+	}
+	OFXPD_TRACE_NOTICE("buffer size or num channels updated");
+	if(!init(nOutChannels, nInChannels, srate, bufferSize/instanceBlockSize(), isQueued())) {
+		return false;
+	}
+	PdBase::computeAudio(computing);
+	return true;
+}
+
+bool ofxPd::audioSettingsPending() {
+	return settingsPending;
+}
+
+//----------------------------------------------------------
+void ofxPd::setVariableBufferSize(bool variable) {
+	if(variable == variableBuffer) {
+		return;
+	}
+	suspendAudio();
+	variableBuffer = variable;
+	resetFifo();
+	resumeAudio();
+}
+
+bool ofxPd::isVariableBufferSize() {
+	return variableBuffer;
+}
+
+int ofxPd::latency() {
+	return variableBuffer ? instanceBlockSize() : 0;
+}
+
+/* ***** PRIVATE ***** */
+
+//----------------------------------------------------------
+void ofxPd::suspendAudio() {
+	audioSuspended = true;
+	while(audioBusy) {
+		juce::Thread::yield();
+	}
+}
+
+void ofxPd::resumeAudio() {
+	audioSuspended = false;
+}
+
+//----------------------------------------------------------
+void ofxPd::resetFifo() {
+	int block = instanceBlockSize();
+	fifoIn.assign(inChannels*block, 0);
+	fifoOut.assign(outChannels*block, 0);
+	fifoInPtrs.resize(inChannels);
+	fifoOutPtrs.resize(outChannels);
+	for(int i = 0; i < inChannels; ++i) {
+		fifoInPtrs[i] = &fifoIn[i*block];
+	}
+	for(int i = 0; i < outChannels; ++i) {
+		fifoOutPtrs[i] = &fifoOut[i*block];
+	}
+	hostInPtrs.resize(inChannels);
+	hostOutPtrs.resize(outChannels);
+	fifoPos = 0;
+}
+
+void ofxPd::resizeInBuffer(int bufferSize) {
+	suspendAudio();
+	if(bufferSize > inBufferSize) {
+		delete[] inBuffer;
+		inBuffer = new float[inChannels*bufferSize];
+		memset(inBuffer, 0, inChannels*bufferSize*sizeof(float));
+		inBufferSize = bufferSize; // bsize stays ticks*blockSize() for pd
+		OFXPD_TRACE_NOTICE("input buffer resized to %d", bufferSize);
+	}
+	settingsPending = false;
+	resumeAudio();
+}
+
+void ofxPd::processFifo(const float * const * input, int inStride,
+                        float * const * output, int outStride, int nFrames) {
+	const int block = instanceBlockSize();
+	int done = 0;
+	while(done < nFrames) {
+		int n = std::min(nFrames-done, block-fifoPos);
+
+		// read all of the input first so input & output may alias
+		for(int i = 0; i < inChannels; ++i) {
+			float *dest = &fifoIn[i*block+fifoPos];
+			const float *src = input == NULL ? NULL : input[i];
+			if(src == NULL) {
+				memset(dest, 0, n*sizeof(float));
+				continue;
+			}
+			src += done*inStride;
+			for(int j = 0; j < n; ++j, src += inStride) {
+				dest[j] = *src;
+			}
+		}
+		for(int i = 0; i < outChannels; ++i) {
+			const float *src = &fifoOut[i*block+fifoPos];
+			float *dest = output[i] + done*outStride;
+			for(int j = 0; j < n; ++j, dest += outStride) {
+				*dest = src[j];
+			}
+		}
+		fifoPos += n;
+		done += n;
+
+		// a whole block is in, run one tick into the output FIFO
+		if(fifoPos == block) {
+			fifoPos = 0;
+			bool ok = realtimeSafe ?
+				PdBase::tryProcessPlanar(1, fifoInPtrs.data(), fifoOutPtrs.data()) :
+				PdBase::processPlanar(1, fifoInPtrs.data(), fifoOutPtrs.data());
+			if(!ok) {
+				std::fill(fifoOut.begin(), fifoOut.end(), 0.0f);
+			}
 		}
 	}
 }
 
+//----------------------------------------------------------
+int ofxPd::findSource(const std::string& source) {
+	for(size_t i = 0; i < sources.size(); ++i) {
+		if(sources[i].name == source) {
+			return (int) i;
+		}
+	}
+	return -1;
+}
+
+// orders source keys by pointer, std::less as < isn't defined for unrelated pointers
+static bool lessKey(const std::pair<const char*, int>& a,
+                    const std::pair<const char*, int>& b) {
+	return std::less<const char*>()(a.first, b.first);
+}
+
+int ofxPd::findSource(const char* dest) {
+	std::pair<const char*, int> key(dest, 0);
+	std::vector< std::pair<const char*, int> >::const_iterator iter =
+		std::lower_bound(sourceKeys.begin(), sourceKeys.end(), key, lessKey);
+	if(iter != sourceKeys.end() && iter->first == dest) {
+		return iter->second;
+	}
+	return -1;
+}
+
+void ofxPd::updateSourceKeys() {
+	sourceKeys.clear();
+	for(size_t i = 1; i < sources.size(); ++i) {
+		sourceKeys.push_back(std::make_pair(sources[i].symbol->s_name, (int) i));
+	}
+	std::sort(sourceKeys.begin(), sourceKeys.end(), lessKey);
+}
+
 /* ***** PROTECTED ***** */
 
 //----------------------------------------------------------
 void ofxPd::print(const std::string& message) {
 
-	log->writeToLog("print: " +  message);
+	OFXPD_TRACE_VERBOSE("print: %s", message.c_str());
 
 	// broadcast
-	set<PdReceiver*>::iterator iter;
-	for(iter = receivers.begin(); iter != receivers.end(); ++iter) {
-		(*iter)->print(message);
+	for(int i = 0; i < receivers.size(); ++i) {
+		receivers[i]->print(message);
 	}
 }
 
-void ofxPd::receiveBang(const std::string& dest) {
+// note: the source is looked up after the global receivers are called
+//       as they may subscribe or unsubscribe
 
-	log->writeToLog("bang: " + dest);
-	
-	set<PdReceiver*>::iterator r_iter;
-	set<PdReceiver*>* r_set;
+void ofxPd::receiveBangRef(const pd::StringRef& dest) {
+
+	OFXPD_TRACE_VERBOSE("bang: %s", dest.c_str());
 
 	// send to global receivers
-	map<string,Source>::iterator g_iter;
-	g_iter = sources.find("");
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveBang(dest);
+	ReceiverList<PdReceiver>* r = &sources[0].receivers;
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveBangRef(dest);
 	}
-	
+
 	// send to subscribed receivers
-	map<string,Source>::iterator s_iter;
-	s_iter = sources.find(dest);
-	r_set = &s_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveBang(dest);
+	int index = findSource(dest.c_str());
+	if(index > 0) {
+		r = &sources[index].receivers;
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveBangRef(dest);
+		}
 	}
 }
 
-void ofxPd::receiveFloat(const std::string& dest, float value) {
-
-	log->writeToLog("float: " + dest + " " + to_string(value));
+void ofxPd::receiveFloatRef(const pd::StringRef& dest, float value) {
 
-	set<PdReceiver*>::iterator r_iter;
-	set<PdReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("float: %s %g", dest.c_str(), value);
 
 	// send to global receivers
-	map<string,Source>::iterator g_iter;
-	g_iter = sources.find("");
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveFloat(dest, value);
+	ReceiverList<PdReceiver>* r = &sources[0].receivers;
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveFloatRef(dest, value);
 	}
 
 	// send to subscribed receivers
-	map<string,Source>::iterator s_iter;
-	s_iter = sources.find(dest);
-	r_set = &s_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveFloat(dest, value);
+	int index = findSource(dest.c_str());
+	if(index > 0) {
+		r = &sources[index].receivers;
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveFloatRef(dest, value);
+		}
 	}
 }
 
-void ofxPd::receiveSymbol(const std::string& dest, const std::string& symbol) {
+void ofxPd::receiveSymbolRef(const pd::StringRef& dest, const pd::StringRef& symbol) {
 
-	log->writeToLog("symbol: " + dest + " " + symbol);
-
-	set<PdReceiver*>::iterator r_iter;
-	set<PdReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("symbol: %s %s", dest.c_str(), symbol.c_str());
 
 	// send to global receivers
-	map<string,Source>::iterator g_iter;
-	g_iter = sources.find("");
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveSymbol(dest, (string) symbol);
+	ReceiverList<PdReceiver>* r = &sources[0].receivers;
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveSymbolRef(dest, symbol);
 	}
 
 	// send to subscribed receivers
-	map<string,Source>::iterator s_iter;
-	s_iter = sources.find(dest);
-	r_set = &s_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveSymbol(dest, (string) symbol);
+	int index = findSource(dest.c_str());
+	if(index > 0) {
+		r = &sources[index].receivers;
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveSymbolRef(dest, symbol);
+		}
 	}
 }
 
-void ofxPd::receiveList(const std::string& dest, const List& list) {
+void ofxPd::receiveListRef(const pd::StringRef& dest, const pd::ListRef& list) {
 
-	log->writeToLog("list: " + dest + " " + list.toString());
-
-	set<PdReceiver*>::iterator r_iter;
-	set<PdReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("list: %s (%u items)", dest.c_str(), list.len());
 
 	// send to global receivers
-	map<string,Source>::iterator g_iter;
-	g_iter = sources.find("");
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveList(dest, list);
+	ReceiverList<PdReceiver>* r = &sources[0].receivers;
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveListRef(dest, list);
 	}
 
 	// send to subscribed receivers
-	map<string,Source>::iterator s_iter;
-	s_iter = sources.find(dest);
-	r_set = &s_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveList(dest, list);
+	int index = findSource(dest.c_str());
+	if(index > 0) {
+		r = &sources[index].receivers;
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveListRef(dest, list);
+		}
 	}
 }
 
-void ofxPd::receiveMessage(const std::string& dest, const std::string& msg, const List& list) {
+void ofxPd::receiveMessageRef(const pd::StringRef& dest, const pd::StringRef& msg, const pd::ListRef& list) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "message: " << dest << " " << msg << " " << list.toString();
-
-	set<PdReceiver*>::iterator r_iter;
-	set<PdReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("message: %s %s (%u items)", dest.c_str(), msg.c_str(), list.len());
 
 	// send to global receivers
-	map<string,Source>::iterator g_iter;
-	g_iter = sources.find("");
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveMessage(dest, msg, list);
+	ReceiverList<PdReceiver>* r = &sources[0].receivers;
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveMessageRef(dest, msg, list);
 	}
 
 	// send to subscribed receivers
-	map<string,Source>::iterator s_iter;
-	s_iter = sources.find(dest);
-	r_set = &s_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveMessage(dest, msg, list);
+	int index = findSource(dest.c_str());
+	if(index > 0) {
+		r = &sources[index].receivers;
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveMessageRef(dest, msg, list);
+		}
 	}
 }
 
 //----------------------------------------------------------
-void ofxPd::receiveNoteOn(const int channel, const int pitch, const int velocity) {
+// note: pd midi channels are 0 based while the receiver channels
+//       are 1 based with 0 as the global channel
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "note on: " << channel+1 << " " << pitch << " " << velocity;
+void ofxPd::receiveNoteOn(const int channel, const int pitch, const int velocity) {
 
-	set<PdMidiReceiver*>::iterator r_iter;
-	set<PdMidiReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("note on: %d %d %d", channel+1, pitch, velocity);
 
 	// send to global receivers
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveNoteOn(channel+1, pitch, velocity);
+	ReceiverList<PdMidiReceiver>* r = &channels[0];
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveNoteOn(channel+1, pitch, velocity);
 	}
 
 	// send to subscribed receivers
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end()) {
-		r_set = &c_iter->second.receivers;
-		for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-			(*r_iter)->receiveNoteOn(channel+1, pitch, velocity);
+	if(channel+1 < (int) channels.size()) {
+		r = &channels[channel+1];
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveNoteOn(channel+1, pitch, velocity);
 		}
 	}
 }
 
 void ofxPd::receiveControlChange(const int channel, const int controller, const int value) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "control change: " << channel+1 << " " << controller << " " << value;
+	OFXPD_TRACE_VERBOSE("control change: %d %d %d", channel+1, controller, value);
 
-	set<PdMidiReceiver*>::iterator r_iter;
-	set<PdMidiReceiver*>* r_set;
- 
 	// send to global receivers
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveControlChange(channel+1, controller, value);
+	ReceiverList<PdMidiReceiver>* r = &channels[0];
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveControlChange(channel+1, controller, value);
 	}
 
 	// send to subscribed receivers
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end()) {
-		r_set = &c_iter->second.receivers;
-		for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-			(*r_iter)->receiveControlChange(channel+1, controller, value);
+	if(channel+1 < (int) channels.size()) {
+		r = &channels[channel+1];
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveControlChange(channel+1, controller, value);
 		}
 	}
 }
 
 void ofxPd::receiveProgramChange(const int channel, const int value) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "program change: " << channel+1 << " " << value+1;
-
-    set<PdMidiReceiver*>::iterator r_iter;
-	set<PdMidiReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("program change: %d %d", channel+1, value+1);
 
 	// send to global receivers
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveProgramChange(channel+1, value+1);
+	ReceiverList<PdMidiReceiver>* r = &channels[0];
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveProgramChange(channel+1, value+1);
 	}
 
 	// send to subscribed receivers
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end()) {
-		r_set = &c_iter->second.receivers;
-		for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-			(*r_iter)->receiveProgramChange(channel+1, value+1);
+	if(channel+1 < (int) channels.size()) {
+		r = &channels[channel+1];
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveProgramChange(channel+1, value+1);
 		}
 	}
 }
 
 void ofxPd::receivePitchBend(const int channel, const int value) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "pitch bend: " << channel+1 << value;
-
-    set<PdMidiReceiver*>::iterator r_iter;
-	set<PdMidiReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("pitch bend: %d %d", channel+1, value);
 
 	// send to global receivers
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receivePitchBend(channel+1, value);
+	ReceiverList<PdMidiReceiver>* r = &channels[0];
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receivePitchBend(channel+1, value);
 	}
 
 	// send to subscribed receivers
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end()) {
-		r_set = &c_iter->second.receivers;
-		for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-			(*r_iter)->receivePitchBend(channel+1, value);
+	if(channel+1 < (int) channels.size()) {
+		r = &channels[channel+1];
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receivePitchBend(channel+1, value);
 		}
 	}
 }
 
 void ofxPd::receiveAftertouch(const int channel, const int value) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "aftertouch: " << channel+1 << value;
-
-	set<PdMidiReceiver*>::iterator r_iter;
-	set<PdMidiReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("aftertouch: %d %d", channel+1, value);
 
 	// send to global receivers
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receiveAftertouch(channel+1, value);
+	ReceiverList<PdMidiReceiver>* r = &channels[0];
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receiveAftertouch(channel+1, value);
 	}
 
 	// send to subscribed receivers
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end()) {
-		r_set = &c_iter->second.receivers;
-		for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-			(*r_iter)->receiveAftertouch(channel+1, value);
+	if(channel+1 < (int) channels.size()) {
+		r = &channels[channel+1];
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receiveAftertouch(channel+1, value);
 		}
 	}
 }
 
 void ofxPd::receivePolyAftertouch(const int channel, const int pitch, const int value) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "poly aftertouch: " << channel+1 << " " << pitch << " " << value;
-
-    set<PdMidiReceiver*>::iterator r_iter;
-	set<PdMidiReceiver*>* r_set;
+	OFXPD_TRACE_VERBOSE("poly aftertouch: %d %d %d", channel+1, pitch, value);
 
 	// send to global receivers
-	map<int,Channel>::iterator g_iter;
-	g_iter = channels.find(0);
-	r_set = &g_iter->second.receivers;
-	for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-		(*r_iter)->receivePolyAftertouch(channel+1, pitch, value);
+	ReceiverList<PdMidiReceiver>* r = &channels[0];
+	for(int i = 0; i < r->size(); ++i) {
+		(*r)[i]->receivePolyAftertouch(channel+1, pitch, value);
 	}
 
 	// send to subscribed receivers
-	map<int,Channel>::iterator c_iter;
-	c_iter = channels.find(channel);
-	if(c_iter != channels.end()) {
-		r_set = &c_iter->second.receivers;
-		for(r_iter = r_set->begin(); r_iter != r_set->end(); ++r_iter) {
-			(*r_iter)->receivePolyAftertouch(channel+1, pitch, value);
+	if(channel+1 < (int) channels.size()) {
+		r = &channels[channel+1];
+		for(int i = 0; i < r->size(); ++i) {
+			(*r)[i]->receivePolyAftertouch(channel+1, pitch, value);
 		}
 	}
 }
 
 void ofxPd::receiveMidiByte(const int port, const int byte) {
 
-	//FIXME juce::Logger::outputDebugString("Pd") << "midi byte: " << port << " " << byte;
+	OFXPD_TRACE_VERBOSE("midi byte: %d %d", port, byte);
 
-	set<PdMidiReceiver*>& r_set = midiReceivers;
-	set<PdMidiReceiver*>::iterator iter;
-	for(iter = r_set.begin(); iter != r_set.end(); ++iter) {
-		(*iter)->receiveMidiByte(port, byte);
+	for(int i = 0; i < midiReceivers.size(); ++i) {
+		midiReceivers[i]->receiveMidiByte(port, byte);
 	}
 }
-
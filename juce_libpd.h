@@ -67,23 +67,32 @@
 #pragma once
 #define JUCE_LIBPD_H_INCLUDED
 
-#include <map>
-#include <set>
+#include <vector>
+#include <algorithm>
+#include <atomic>
 #include <juce_core/juce_core.h>
 
 #include "libpd/cpp/PdBase.hpp"
+#include "libpd/cpp/PdBatchRenderer.hpp"
+#include "juce_libpd_trace.h"
 
 ///
 /// a Pure Data instance
 ///
 /// references: https://github.com/libpd/libpd/wiki
 ///
-/// note: libpd currently does not support multiple states and it is
-///       suggested that you use only one ofxPd object at a time
+/// note: when libpd & these sources are built with PDINSTANCE & PDTHREADS
+///       defined, each ofxPd owns a separate pd instance and can be
+///       processed on its own thread, ie. one instance per core, otherwise
+///       all ofxPd objects share the same single pd instance
+///
+/// note: all ofxPd objects must use the same queued setting in init()
 ///
 /// also: see PdBase.h in src/pd/cpp for some functions which are not wrapped by
 ///       ofxPd and PdTypes.h for small Pd C++ Objects
 ///
+/// logging: see juce_libpd_trace.h for setting the compiled in trace level
+///
 /// differences from libpd C api and/or C++ wrapper:
 ///     - the ofxPd object is thread safe
 ///     - midi channels are 1-16 to match pd ranges
@@ -102,7 +111,8 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		/// initialize audio resources
 		///
 		/// set the audio latency by setting the libpd ticks per buffer:
-		/// ticks per buffer * lib pd block size (always 64)
+		/// ticks per buffer * blockSize(), which is 64 unless changed
+		/// with setBlockSize()
 		///
 		/// ie 4 ticks per buffer * 64 = buffer len of 512
 		///
@@ -410,14 +420,26 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		/// has this pd instance been initialized?
 		/// bool isInited();
 		///
-		/// get the blocksize of pd (sample length per channel)
+		/// get the blocksize of the current pd instance (sample length per
+		/// channel), or of this object's instance with PDINSTANCE
 		/// static int blockSize();
+		/// int instanceBlockSize();
 		///
 		/// get/set the max length of messages and lists, default: 32
 		/// void setMaxMsgLength(unsigned int len);
 		/// unsigned int maxMsgLength();
 		///
 		/// see PdBase.h for function declarations
+
+		/// set the blocksize of pd, a power of two from 1 to 4096,
+		/// default: 64
+		///
+		/// keeps the current buffer size where possible by changing the
+		/// ticks per buffer, without reiniting pd
+		///
+		/// returns false if the size is invalid
+		///
+		bool setBlockSize(int blockSize);
 	
 		/// get the current ticks per buffer,
 		/// updated if the buffer size changes in audioIn or audioOut
@@ -450,15 +472,98 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		virtual void audioIn(float * input, int bufferSize, int nChannels);
 		virtual void audioOut(float * output, int bufferSize, int nChannels);
 
+		/// process non-interleaved buffers in one call, ie. from
+		/// juce::AudioProcessor::processBlock() with the AudioBuffer's
+		/// getArrayOfReadPointers() & getArrayOfWritePointers()
+		///
+		/// input and output hold one pointer per channel to bufferSize
+		/// samples each, which pd reads & writes directly without the
+		/// interleaving and input copy done by audioIn() & audioOut(),
+		/// input & output may point to the same channel buffers
+		///
+		/// reinits or, in real-time safe mode, records pending settings
+		/// like audioIn() & audioOut() when the buffer size or number of
+		/// channels changes
+		virtual void audioProcess(const float * const * input, int nInChannels,
+		                          float * const * output, int nOutChannels,
+		                          int bufferSize);
+
+	/// \section Offline Rendering
+
+		/// render seconds of audio to a sound file faster than real time,
+		/// see PdBase::renderToFile()
+		///
+		/// the real-time safe audio callbacks output silence while rendering
+		/// instead of failing to get the pd lock every buffer
+		///
+		bool renderToFile(const std::string& outFile, double seconds,
+		                  const std::string& inFile="", int bytesPerSample=4,
+		                  double *realtimeFactor=NULL);
+
+	/// \section Real-time Safe Processing
+
+		/// enable/disable real-time safe processing, default: false
+		///
+		/// when enabled, audioIn(), audioOut() & audioProcess() never reinit,
+		/// log, allocate or wait on the pd lock:
+		///     - a change in buffer size or number of channels is only
+		///       recorded and silence is output until updateAudioSettings()
+		///       is called from a non-audio thread
+		///     - if pd is busy on another thread (ie. a patch is being opened),
+		///       the buffer is skipped and silence is output
+		///
+		/// use this together with init(..., queued=true) so message & midi
+		/// callbacks are not run on the audio thread either, and with
+		/// setSendQueued(true) so sends from other threads don't hold the
+		/// pd lock while the audio thread wants to process
+		///
+		void setRealtimeSafe(bool realtime);
+		bool isRealtimeSafe();
+
+		/// apply a buffer size or channel change requested by the audio
+		/// callbacks in real-time safe mode, call this regularly from a
+		/// non-audio thread, ie. alongside receiveMessages()
+		///
+		/// returns true if the audio settings were updated
+		///
+		bool updateAudioSettings();
+
+		/// returns true if the audio callbacks are waiting on
+		/// updateAudioSettings()
+		bool audioSettingsPending();
+
+	/// \section Variable Buffer Sizes
+
+		/// enable/disable the variable buffer size adapter, default: false
+		///
+		/// when enabled, the audio callbacks accept any buffer size, ie. 37
+		/// or 441 samples, and run whole pd ticks internally through a one
+		/// block FIFO instead of reiniting pd whenever the size changes or
+		/// dropping the samples past the last whole block
+		///
+		/// this delays the output by latency() samples, report it to the
+		/// host, ie. with juce::AudioProcessor::setLatencySamples()
+		///
+		/// audioIn() still needs room for the interleaved input, so only a
+		/// buffer larger than any seen before resizes its copy (without
+		/// reiniting pd), audioProcess() has no such limit
+		///
+		void setVariableBufferSize(bool variable);
+		bool isVariableBufferSize();
+
+		/// get the latency added by the variable buffer size adapter in
+		/// samples: blockSize() when enabled, otherwise 0
+		int latency();
+
 	protected:
 
 		/// message callbacks
 		void print(const std::string& message);
-		void receiveBang(const std::string& dest);
-		void receiveFloat(const std::string& dest, float value);
-		void receiveSymbol(const std::string& dest, const std::string& symbol);
-		void receiveList(const std::string& dest, const pd::List& list);
-		void receiveMessage(const std::string& dest, const std::string& msg, const pd::List& list);
+		void receiveBangRef(const pd::StringRef& dest);
+		void receiveFloatRef(const pd::StringRef& dest, float value);
+		void receiveSymbolRef(const pd::StringRef& dest, const pd::StringRef& symbol);
+		void receiveListRef(const pd::StringRef& dest, const pd::ListRef& list);
+		void receiveMessageRef(const pd::StringRef& dest, const pd::StringRef& msg, const pd::ListRef& list);
 
 		/// midi callbacks
 		void receiveNoteOn(const int channel, const int pitch, const int velocity);
@@ -471,7 +576,6 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 
 	private:
 
-        juce::Logger* log;
 		int ticks; //< number of ticks per buffer
 		int bsize; //< current buffer size aka tbp*blocksize
 		int srate; //< current sample rate
@@ -479,60 +583,157 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		bool computing; //< is compute audio on?
 	
 		float * inBuffer; //< interleaved input audio buffer
+		int inBufferSize; //< frames per channel allocated in inBuffer, >= bsize
+
+		std::atomic<bool> realtimeSafe;  //< use the real-time safe audio path?
+		std::atomic<bool> audioBusy;     //< is an audio callback running?
+		std::atomic<bool> audioSuspended; //< are the audio callbacks paused?
+
+		/// settings requested by the audio callbacks in real-time safe mode
+		std::atomic<bool> settingsPending;
+		std::atomic<int> pendingBufferSize;
+		std::atomic<int> pendingInChannels;
+		std::atomic<int> pendingOutChannels;
+
+		/// pause the real-time safe audio callbacks while changing settings,
+		/// waits for a running callback to finish
+		void suspendAudio();
+		void resumeAudio();
+
+		std::atomic<bool> variableBuffer; //< use the FIFO adapter?
+
+		/// one block FIFOs used by the variable buffer size adapter, stored
+		/// per channel so they are handed to pd with processPlanar()
+		std::vector<float> fifoIn, fifoOut;
+		std::vector<const float *> fifoInPtrs;
+		std::vector<float *> fifoOutPtrs;
+		int fifoPos; //< samples per channel currently in the FIFOs
+
+		/// per channel pointers into interleaved host buffers
+		std::vector<const float *> hostInPtrs;
+		std::vector<float *> hostOutPtrs;
+
+		/// (re)allocate the FIFOs for the current number of channels
+		void resetFifo();
+
+		/// resize the interleaved input buffer copy without reiniting pd
+		void resizeInBuffer(int bufferSize);
+
+		/// run nFrames through the FIFO adapter, channel i of the input &
+		/// output starts at input[i] & output[i] with successive samples
+		/// inStride & outStride floats apart, input may be NULL for silence
+		void processFifo(const float * const * input, int inStride,
+		                 float * const * output, int outStride, int nFrames);
+
+		/// a small flat list of receivers, stored inline for the common case
+		/// of only a few receivers so dispatching doesn't chase pointers
+		template<typename T>
+		class ReceiverList {
+
+			public:
+
+				ReceiverList() : num(0) {}
+
+				/// returns false if the receiver was already added
+				bool add(T* receiver) {
+					if(contains(receiver)) {
+						return false;
+					}
+					if(num < LOCAL) {
+						local[num] = receiver;
+					}
+					else {
+						if(num == LOCAL) { // move to the heap
+							overflow.assign(local, local+LOCAL);
+						}
+						overflow.push_back(receiver);
+					}
+					num++;
+					return true;
+				}
+
+				/// returns false if the receiver was not found
+				bool remove(T* receiver) {
+					T** r = data();
+					int i = 0;
+					while(i < num && r[i] != receiver) {
+						i++;
+					}
+					if(i == num) {
+						return false;
+					}
+					if(num > LOCAL) {
+						overflow.erase(overflow.begin()+i);
+						if(num-1 == LOCAL) { // back to inline storage
+							std::copy(overflow.begin(), overflow.end(), local);
+							overflow.clear();
+						}
+					}
+					else {
+						std::copy(local+i+1, local+num, local+i);
+					}
+					num--;
+					return true;
+				}
+
+				bool contains(T* receiver) const {
+					for(int i = 0; i < num; ++i) {
+						if((*this)[i] == receiver) {
+							return true;
+						}
+					}
+					return false;
+				}
+
+				void clear() {
+					num = 0;
+					overflow.clear();
+				}
+
+				int size() const {return num;}
+				T* operator[](int index) const {
+					return num > LOCAL ? overflow[index] : local[index];
+				}
+
+			private:
+
+				T** data() {return num > LOCAL ? overflow.data() : local;}
+
+				static const int LOCAL = 4; //< num receivers stored inline
+				T* local[LOCAL];            //< inline receivers
+				std::vector<T*> overflow;   //< all receivers when num > LOCAL
+				int num;                    //< current num of receivers
+		};
 
-		/// a receiving source's pointer and receivers
+		/// a subscribed source and its receivers
 		struct Source {
-
-			std::set<pd::PdReceiver*> receivers; //< receivers
-
-			// helper functions
-			void addReceiver(pd::PdReceiver* receiver) {
-				receivers.insert(receiver);
-			}
-
-			void removeReceiver(pd::PdReceiver* receiver) {
-				std::set<pd::PdReceiver*>::iterator iter;
-				iter = receivers.find(receiver);
-				if(iter != receivers.end())
-					receivers.erase(iter);
-			}
-
-			bool receiverExists(pd::PdReceiver* receiver) {
-				if(receivers.find(receiver) != receivers.end())
-					return true;
-				return false;
-			}
+			std::string name;      //< receive name
+			t_symbol* symbol;      //< interned pd symbol, NULL for global
+			ReceiverList<pd::PdReceiver> receivers;
 		};
 
-		std::set<pd::PdReceiver*> receivers;    //< the receivers
-		std::map<std::string,Source> sources;   //< subscribed sources
+		ReceiverList<pd::PdReceiver> receivers; //< the receivers
+		std::vector<Source> sources;            //< subscribed sources,
 		                                        //< first object always global
+		std::vector< std::pair<const char*, int> > sourceKeys; //< interned
+		                                        //< source names & their index
+		                                        //< in sources, sorted by pointer
 
-		/// a receiving midi channel's receivers
-		struct Channel {
+		/// find a subscribed source by name, returns -1 if not found
+		int findSource(const std::string& source);
 
-			std::set<pd::PdMidiReceiver*> receivers; //< receivers
-
-			// helper functions
-			void addMidiReceiver(pd::PdMidiReceiver* receiver) {
-				receivers.insert(receiver);
-			}
-
-			void removeMidiReceiver(pd::PdMidiReceiver* receiver) {
-				std::set<pd::PdMidiReceiver*>::iterator iter;
-				iter = receivers.find(receiver);
-				if(iter != receivers.end())
-					receivers.erase(iter);
-			}
+		/// find the subscribed source of an incoming event by the interned
+		/// name pointer passed by libpd, returns -1 if not found
+		///
+		/// note: [r] passes its symbol's s_name both directly and through the
+		///       queued ringbuffers, so one binary search over the pointers
+		///       finds it without comparing strings
+		int findSource(const char* dest);
 
-			bool midiReceiverExists(pd::PdMidiReceiver* receiver) {
-				if(receivers.find(receiver) != receivers.end())
-					return true;
-				return false;
-			}
-		};
+		/// rebuild sourceKeys after sources changed
+		void updateSourceKeys();
 
-		std::set<pd::PdMidiReceiver*> midiReceivers;  //< the midi receivers
-		std::map<int,Channel> channels;               //< subscribed channels
-		                                              //< first object always global
+		ReceiverList<pd::PdMidiReceiver> midiReceivers;  //< the midi receivers
+		std::vector< ReceiverList<pd::PdMidiReceiver> > channels; //< receivers by
+		                                                  //< channel, first always global
 };
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// compiled by JUCE as its own translation unit, like juce_libpd.cpp
+
+#include "juce_libpd_trace.h"
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+#include <cstdarg>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace {
+
+/// a single trace
+struct TraceRecord {
+	int level;
+	double time;      //< ms since tracing started
+	char text[240];   //< formatted trace, truncated if too long
+};
+
+/// single producer, single consumer trace ringbuffer owned by one thread
+struct TraceBuffer {
+	static const unsigned int SIZE = 256; //< num records, power of 2
+
+	TraceRecord records[SIZE];
+	std::atomic<unsigned int> head;  //< written by the owning thread
+	std::atomic<unsigned int> tail;  //< written by the flushing thread
+	std::atomic<bool> retired;       //< has the owning thread exited?
+	int thread;                      //< thread number for printing
+
+	TraceBuffer(int thread) : head(0), tail(0), retired(false), thread(thread) {}
+};
+
+/// the registered buffers & background flush thread
+class TraceState {
+
+	public:
+
+		TraceState() : interval(100), dropped(0), totalDropped(0),
+		               running(true), numThreads(0) {
+			start = std::chrono::steady_clock::now();
+			flusher = std::thread(&TraceState::run, this);
+		}
+
+		~TraceState() {
+			{
+				std::lock_guard<std::mutex> lock(wakeMutex);
+				running = false;
+			}
+			wake.notify_one();
+			flusher.join();
+			flush();
+			for(size_t i = 0; i < buffers.size(); ++i) {
+				delete buffers[i];
+			}
+		}
+
+		static TraceState& instance() {
+			static TraceState state;
+			return state;
+		}
+
+		/// register a new buffer for the calling thread
+		TraceBuffer* addBuffer() {
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			TraceBuffer* buffer = new TraceBuffer(++numThreads);
+			buffers.push_back(buffer);
+			return buffer;
+		}
+
+		/// drain all buffers to the logger, frees buffers of exited threads
+		void flush() {
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			char line[320];
+			for(size_t i = 0; i < buffers.size();) {
+				TraceBuffer* b = buffers[i];
+				bool retired = b->retired.load(std::memory_order_acquire);
+				unsigned int tail = b->tail.load(std::memory_order_relaxed);
+				unsigned int head = b->head.load(std::memory_order_acquire);
+				for(; tail != head; ++tail) {
+					const TraceRecord& r = b->records[tail & (TraceBuffer::SIZE-1)];
+					snprintf(line, sizeof(line), "Pd %s [%.3f ms, thread %d]: %s",
+					         levelName(r.level), r.time, b->thread, r.text);
+					juce::Logger::writeToLog(juce::String::fromUTF8(line));
+				}
+				b->tail.store(tail, std::memory_order_release);
+				if(retired) {
+					delete b;
+					buffers.erase(buffers.begin()+i);
+				}
+				else {
+					++i;
+				}
+			}
+			unsigned int d = dropped.exchange(0);
+			if(d > 0) {
+				snprintf(line, sizeof(line), "Pd warning: %u traces dropped", d);
+				juce::Logger::writeToLog(juce::String::fromUTF8(line));
+				totalDropped += d;
+			}
+		}
+
+		double now() {
+			std::chrono::duration<double, std::milli> ms =
+				std::chrono::steady_clock::now() - start;
+			return ms.count();
+		}
+
+		static const char* levelName(int level) {
+			switch(level) {
+				case JUCE_LIBPD_TRACE_ERROR: return "error";
+				case JUCE_LIBPD_TRACE_WARNING: return "warning";
+				case JUCE_LIBPD_TRACE_NOTICE: return "notice";
+				default: return "verbose";
+			}
+		}
+
+		std::atomic<int> interval;          //< flush interval in ms
+		std::atomic<unsigned int> dropped;  //< dropped since last flush
+		std::atomic<unsigned int> totalDropped;
+
+	private:
+
+		void run() {
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			while(running) {
+				wake.wait_for(lock, std::chrono::milliseconds(interval.load()));
+				lock.unlock();
+				flush();
+				lock.lock();
+			}
+		}
+
+		std::chrono::steady_clock::time_point start;
+		std::vector<TraceBuffer*> buffers; //< registered buffers
+		std::mutex buffersMutex;           //< guards buffers & draining
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+		bool running;
+		int numThreads;
+		std::thread flusher;
+};
+
+/// the calling thread's buffer, retired when the thread exits
+struct TraceThread {
+	TraceBuffer* buffer;
+	TraceThread() : buffer(TraceState::instance().addBuffer()) {}
+	~TraceThread() {
+		buffer->retired.store(true, std::memory_order_release);
+	}
+};
+
+} // namespace
+
+//--------------------------------------------------------------------
+void ofxPdTrace::write(int level, const char* format, ...) {
+	static thread_local TraceThread thread;
+	TraceBuffer* b = thread.buffer;
+	TraceState& state = TraceState::instance();
+
+	unsigned int head = b->head.load(std::memory_order_relaxed);
+	if(head - b->tail.load(std::memory_order_acquire) >= TraceBuffer::SIZE) {
+		state.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	TraceRecord& r = b->records[head & (TraceBuffer::SIZE-1)];
+	r.level = level;
+	r.time = state.now();
+	va_list args;
+	va_start(args, format);
+	vsnprintf(r.text, sizeof(r.text), format, args);
+	va_end(args);
+
+	b->head.store(head+1, std::memory_order_release);
+}
+
+void ofxPdTrace::flush() {
+	TraceState::instance().flush();
+}
+
+void ofxPdTrace::setFlushInterval(int ms) {
+	TraceState::instance().interval = (ms > 1 ? ms : 1);
+}
+
+unsigned int ofxPdTrace::dropped() {
+	TraceState& state = TraceState::instance();
+	return state.totalDropped + state.dropped;
+}
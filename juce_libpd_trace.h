@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+#pragma once
+
+/// trace levels, a level includes all of the levels below it
+#define JUCE_LIBPD_TRACE_OFF     0
+#define JUCE_LIBPD_TRACE_ERROR   1
+#define JUCE_LIBPD_TRACE_WARNING 2
+#define JUCE_LIBPD_TRACE_NOTICE  3
+#define JUCE_LIBPD_TRACE_VERBOSE 4
+
+/// the compiled in trace level, default: notice
+///
+/// trace calls above this level compile to nothing, so the verbose per-event
+/// traces in the message & midi callbacks cost nothing unless enabled with:
+///
+/// #define JUCE_LIBPD_TRACE_LEVEL JUCE_LIBPD_TRACE_VERBOSE
+///
+/// before including the module or in the project's preprocessor definitions
+///
+#ifndef JUCE_LIBPD_TRACE_LEVEL
+	#define JUCE_LIBPD_TRACE_LEVEL JUCE_LIBPD_TRACE_NOTICE
+#endif
+
+///
+/// lock-free tracing for ofxPd
+///
+/// traces are formatted printf-style into a fixed size per-thread ringbuffer
+/// without locking or allocating and written to the juce::Logger by a
+/// background thread, so they are safe to leave on in the audio & message
+/// callbacks
+///
+/// use the macros below instead of calling write() directly:
+///
+/// OFXPD_TRACE_NOTICE("opening patch: %s", file.c_str());
+///
+/// note: traces are dropped when a thread's ringbuffer is full, see dropped()
+/// note: the first trace on a thread registers its ringbuffer, which locks
+///       and allocates once
+///
+class ofxPdTrace {
+
+	public:
+
+		/// write a printf-style formatted trace, long traces are truncated
+		static void write(int level, const char* format, ...)
+		#ifdef __GNUC__
+			__attribute__((format(printf, 2, 3)))
+		#endif
+		;
+
+		/// write all waiting traces to the logger now,
+		/// this is done every flush interval by the background thread
+		static void flush();
+
+		/// set the background flush interval in ms, default: 100
+		static void setFlushInterval(int ms);
+
+		/// number of traces dropped because a ringbuffer was full
+		static unsigned int dropped();
+};
+
+#if JUCE_LIBPD_TRACE_LEVEL >= JUCE_LIBPD_TRACE_ERROR
+	#define OFXPD_TRACE_ERROR(...) ofxPdTrace::write(JUCE_LIBPD_TRACE_ERROR, __VA_ARGS__)
+#else
+	#define OFXPD_TRACE_ERROR(...) ((void)0)
+#endif
+
+#if JUCE_LIBPD_TRACE_LEVEL >= JUCE_LIBPD_TRACE_WARNING
+	#define OFXPD_TRACE_WARNING(...) ofxPdTrace::write(JUCE_LIBPD_TRACE_WARNING, __VA_ARGS__)
+#else
+	#define OFXPD_TRACE_WARNING(...) ((void)0)
+#endif
+
+#if JUCE_LIBPD_TRACE_LEVEL >= JUCE_LIBPD_TRACE_NOTICE
+	#define OFXPD_TRACE_NOTICE(...) ofxPdTrace::write(JUCE_LIBPD_TRACE_NOTICE, __VA_ARGS__)
+#else
+	#define OFXPD_TRACE_NOTICE(...) ((void)0)
+#endif
+
+#if JUCE_LIBPD_TRACE_LEVEL >= JUCE_LIBPD_TRACE_VERBOSE
+	#define OFXPD_TRACE_VERBOSE(...) ofxPdTrace::write(JUCE_LIBPD_TRACE_VERBOSE, __VA_ARGS__)
+#else
+	#define OFXPD_TRACE_VERBOSE(...) ((void)0)
+#endif
@@ -18,6 +18,7 @@
 #include "../libpd_wrapper/z_print_util.h"
 
 #include <map>  
+#include <atomic>
 
 #include "PdTypes.hpp"
 #include "PdReceiver.hpp"
@@ -40,28 +41,28 @@ namespace pd {
 ///
 /// use this class directly or extend it and any of its virtual functions
 ///
-/// note: libpd currently does not support multiple states and it is
-///       suggested that you use only one PdBase-derived object at a time
+/// each PdBase object has its own context with its own receivers, message
+/// state & subscribed sources
 ///
-///       calls from multiple PdBase instances currently use a global context
-///       kept in a singleton object, thus only one Receiver & one MidiReceiver
-///       can be used within a single program
+/// note: when libpd is compiled with PDINSTANCE & PDTHREADS, each object also
+///       owns a separate pd instance with its own patches, symbols & dsp
+///       chain, so several objects can be processed concurrently on separate
+///       threads, make sure to define PDINSTANCE & PDTHREADS for your C++
+///       sources as well
 ///
-///       multiple context support will be added if/when it is included within
-///       libpd
+///       without PDINSTANCE, all objects share the single pd instance and it
+///       is suggested that you use only one PdBase-derived object at a time
+///
+///       all objects must use the same queued setting in init()
 ///
 class PdBase {
 
     public:
 
-        PdBase() {
-            clear();
-            PdContext::instance().addBase();
-        }
+        PdBase() {}
 
         virtual ~PdBase() {
             clear();
-            PdContext::instance().removeBase();
         }
 
     /// \section Initializing Pd
@@ -69,7 +70,8 @@ class PdBase {
         /// initialize resources and set up the audio processing
         ///
         /// set the audio latency by setting the libpd ticks per buffer:
-        /// ticks per buffer * lib pd block size (always 64)
+        /// ticks per buffer * blockSize(), which is 64 unless changed
+        /// with setBlockSize()
         ///
         /// ie 4 ticks per buffer * 64 = buffer len of 512
         ///
@@ -94,8 +96,8 @@ class PdBase {
         ///
         virtual bool init(const int numInChannels, const int numOutChannels,
                           const int sampleRate, bool queued=false) {
-            PdContext::instance().clear();
-            return PdContext::instance().init(numInChannels,
+            useContext().clear();
+            return useContext().init(numInChannels,
                                               numOutChannels,
                                               sampleRate,
                                               queued);
@@ -103,7 +105,7 @@ class PdBase {
 
         /// clear resources
         virtual void clear() {
-            PdContext::instance().clear();
+            useContext().clear();
             unsubscribeAll();
         }
 
@@ -115,11 +117,13 @@ class PdBase {
         /// note: fails silently if path not found
         ///
         virtual void addToSearchPath(const std::string& path) {
+            useContext();
             libpd_add_to_search_path(path.c_str());
         }
 
         /// clear the current pd search path
         virtual void clearSearchPath() {
+            useContext();
             libpd_clear_search_path();
         }
 
@@ -136,6 +140,7 @@ class PdBase {
         ///     }
         virtual pd::Patch openPatch(const std::string& patch,
                                     const std::string& path) {
+            useContext();
             // [; pd open file folder(
             void* handle = libpd_openfile(patch.c_str(), path.c_str());
             if(handle == NULL) {
@@ -168,7 +173,7 @@ class PdBase {
         virtual void closePatch(const std::string& patch) {
             // [; pd-name menuclose 1(
             std::string patchname = (std::string) "pd-"+patch;
-            libpd_start_message(PdContext::instance().maxMsgLen);
+            libpd_start_message(useContext().maxMsgLen);
             libpd_add_float(1.0f);
             libpd_finish_message(patchname.c_str(), "menuclose");
         }
@@ -176,6 +181,7 @@ class PdBase {
         /// close a patch file, takes a patch object
         /// note: clears the given Patch object
         virtual void closePatch(pd::Patch& patch) {
+            useContext();
             if(!patch.isValid()) {
                 return;
             }
@@ -198,18 +204,21 @@ class PdBase {
         /// process one pd tick, writes raw float data to/from buffers
         /// returns false on error
         bool processRaw(const float *inBuffer, float *outBuffer) {
+            useContext();
             return libpd_process_raw(inBuffer, outBuffer) == 0;
         }
 
         /// process short buffers for a given number of ticks
         /// returns false on error
         bool processShort(int ticks, const short *inBuffer, short *outBuffer) {
+            useContext();
             return libpd_process_short(ticks, inBuffer, outBuffer) == 0;
         }
 
         /// process float buffers for a given number of ticks
         /// returns false on error
         bool processFloat(int ticks, const float *inBuffer, float *outBuffer) {
+            useContext();
             bool ret = libpd_process_float(ticks, inBuffer, outBuffer) == 0;
             return ret;
         }
@@ -218,9 +227,79 @@ class PdBase {
         /// returns false on error
         bool processDouble(int ticks, const double *inBuffer,
                                             double *outBuffer) {
+            useContext();
             return libpd_process_double(ticks, inBuffer, outBuffer) == 0;
         }
 
+        /// process float buffers for a given number of ticks without blocking
+        ///
+        /// returns false without processing if pd is currently locked by
+        /// another thread, ie. while a message is being sent or a patch opened
+        ///
+        /// use this from a real-time audio callback which must never wait on
+        /// a mutex, outBuffer is left untouched when false is returned
+        ///
+        bool tryProcessFloat(int ticks, const float *inBuffer, float *outBuffer) {
+            useContext();
+            return libpd_try_process_float(ticks, inBuffer, outBuffer) == 0;
+        }
+
+        /// process non-interleaved float buffers for a given number of ticks
+        ///
+        /// inBuffer & outBuffer are arrays of per-channel pointers, each to
+        /// ticks * blockSize() samples, ie. juce::AudioBuffer's
+        /// getArrayOfReadPointers() & getArrayOfWritePointers(); samples are
+        /// copied a block at a time without interleaving
+        ///
+        /// inBuffer or any of its channels may be null for silent input,
+        /// null output channels are skipped
+        ///
+        /// returns false on error
+        bool processPlanar(int ticks, const float * const *inBuffer,
+                                      float * const *outBuffer) {
+            useContext();
+            return libpd_process_planar(ticks, inBuffer, outBuffer) == 0;
+        }
+
+        /// process non-interleaved float buffers without blocking,
+        /// see processPlanar() & tryProcessFloat()
+        bool tryProcessPlanar(int ticks, const float * const *inBuffer,
+                                         float * const *outBuffer) {
+            useContext();
+            return libpd_try_process_planar(ticks, inBuffer, outBuffer) == 0;
+        }
+
+        /// render seconds of audio to a sound file faster than real time
+        ///
+        /// pd is locked for the whole render and runs its ticks back to back,
+        /// so turn DSP on first; a larger blockSize() cuts per-tick overhead
+        ///
+        /// each channel of inFile, if given, feeds the matching adc~ and is
+        /// silent once the file ends; the output has numOutChannels from
+        /// init() and its format follows the extension as for [soundfiler]
+        /// write with bytesPerSample 2, 3 or 4 (float)
+        ///
+        /// realtimeFactor, if not null, is set to the rendered duration
+        /// divided by the time the render took
+        ///
+        /// returns false if the file couldn't be opened or fully written
+        ///
+        virtual bool renderToFile(const std::string& outFile, double seconds,
+                                  const std::string& inFile="",
+                                  int bytesPerSample=4,
+                                  double *realtimeFactor=NULL) {
+            useContext();
+            long ret = libpd_render_file(outFile.c_str(),
+                inFile.empty() ? NULL : inFile.c_str(), seconds,
+                bytesPerSample, realtimeFactor);
+            if(ret < 0) {
+                std::cerr << "Pd: Cannot render to \"" << outFile << "\""
+                     << std::endl;
+                return false;
+            }
+            return true;
+        }
+
     /// \section Audio Processing Control
 
         /// start/stop audio processing
@@ -230,7 +309,150 @@ class PdBase {
         /// shortcut for [; pd dsp 1( & [; pd dsp 0(
         ///
         virtual void computeAudio(bool state) {
-            PdContext::instance().computeAudio(state);
+            useContext().computeAudio(state);
+        }
+
+        /// set the number of threads used to compute audio, default: 1
+        ///
+        /// independent parts of a patch, ie. subpatches which don't use
+        /// send~, throw~, arrays, etc, are spread over the threads each tick
+        /// with the same output as on a single thread
+        ///
+        /// note: the calling audio thread is one of the threads
+        ///
+        /// shortcut for [; pd dsp-threads $1(
+        ///
+        virtual void setDspThreads(int numThreads) {
+            useContext();
+            libpd_start_message(1);
+            libpd_add_float((float) numThreads);
+            libpd_finish_message("pd", "dsp-threads");
+        }
+
+        /// choose the FFT used by fft~, rfft~, sigmund~, fiddle~, etc:
+        /// "simd" for the built-in vectorized FFT (the default where the
+        /// CPU supports it), or the name of the library libpd was built
+        /// with ("ooura" or "fftw")
+        ///
+        /// note: the choice applies to the whole process
+        ///
+        /// shortcut for [; pd fft-backend $1(
+        ///
+        virtual void setFftBackend(const std::string &name) {
+            useContext();
+            libpd_start_message(1);
+            libpd_add_symbol(name.c_str());
+            libpd_finish_message("pd", "fft-backend");
+        }
+
+        /// serve small allocations of this instance from its own memory pool
+        /// instead of malloc, so loading patches and rebuilding the DSP graph
+        /// while audio is running don't call the system allocator once the
+        /// pool has warmed up; reserveKb sets aside memory for it up front
+        ///
+        /// print pool statistics with [; pd memory-stats(
+        ///
+        /// shortcut for [; pd memory-pool $1 $2(
+        ///
+        virtual void setMemoryPool(bool on, int reserveKb=0) {
+            useContext();
+            libpd_start_message(2);
+            libpd_add_float(on ? 1 : 0);
+            libpd_add_float((float) reserveKb);
+            libpd_finish_message("pd", "memory-pool");
+        }
+
+    /// \section DSP Profiling
+
+        /// turn DSP profiling on or off, default: off
+        ///
+        /// while on, each perform routine is timed and its time charged to
+        /// the object which added it to the DSP chain, or to its canvas for
+        /// block~, inlet~ & outlet~ overhead; this slows processing down, so
+        /// leave it off in production
+        ///
+        /// the DSP graph is resorted, which starts the profile over, as does
+        /// any later resorting, ie. after editing a patch
+        ///
+        /// shortcut for [; pd dsp-profile $1(
+        ///
+        virtual void setProfiling(bool on) {
+            useContext();
+            libpd_profile(on ? 1 : 0);
+        }
+
+        /// is DSP profiling on?
+        bool isProfiling() {
+            useContext();
+            return libpd_is_profiling() != 0;
+        }
+
+        /// start the DSP profile over
+        ///
+        /// shortcut for [; pd dsp-profile reset(
+        ///
+        void resetProfile() {
+            useContext();
+            libpd_profile_reset();
+        }
+
+        /// get the num objects which took the most time since profiling
+        /// started or was reset, most first
+        ///
+        /// returns an empty vector if profiling is off or no ticks were
+        /// processed yet
+        ///
+        /// print a summary to the pd console with [; pd dsp-profile print $1(
+        ///
+        std::vector<ProfileEntry> getProfileObjects(int num=10) {
+            useContext();
+            std::vector<libpd_profile_entry> entries(num > 0 ? num : 0);
+            if(num > 0) {
+                entries.resize(libpd_profile_objects(&entries[0], num));
+            }
+            return convertProfile(entries);
+        }
+
+        /// get the num canvases, ie. patches, subpatches & abstractions,
+        /// which took the most time, including everything in them,
+        /// most first
+        std::vector<ProfileEntry> getProfileCanvases(int num=10) {
+            useContext();
+            std::vector<libpd_profile_entry> entries(num > 0 ? num : 0);
+            if(num > 0) {
+                entries.resize(libpd_profile_canvases(&entries[0], num));
+            }
+            return convertProfile(entries);
+        }
+
+    /// \section Queued Sending
+    ///
+    /// when using the ringbuffers (init() with queued = true), sends can also
+    /// be routed through an inbound ringbuffer instead of locking pd:
+    ///
+    ///     pd.setSendQueued(true);
+    ///     pd.sendFloat("volume", 0.5); // returns without waiting on pd
+    ///
+    /// queued events are delivered at the start of the next processed tick,
+    /// so this is useful when sending from gui or automation threads while
+    /// the audio thread is processing
+    ///
+    /// note: queued events are only delivered while processing, and events
+    ///       are dropped if the ringbuffer is full
+    ///
+
+        /// enable/disable queued sending, default: false
+        ///
+        /// ignored if the ringbuffers are not in use
+        ///
+        void setSendQueued(bool queued) {
+            useContext().bSendQueued = queued;
+        }
+
+        /// are sends routed through the inbound ringbuffer?
+        bool isSendQueued() {
+            PdContext& context = useContext();
+            return context.bSendQueued && context.isQueued();
         }
 
     /// \section Message Receiving
@@ -251,14 +473,14 @@ class PdBase {
             ;
             void* pointer = libpd_bind(source.c_str());
             if(pointer != NULL) {
-                std::map<std::string,void*>& sources = PdContext::instance().sources;
+                std::map<std::string,void*>& sources = useContext().sources;
                 sources.insert(std::pair<std::string,void*>(source, pointer));
             }
         }
 
         /// unsubscribe from messages sent by a pd send source
         virtual void unsubscribe(const std::string& source) {
-            std::map<std::string,void*>& sources = PdContext::instance().sources;
+            std::map<std::string,void*>& sources = useContext().sources;
             std::map<std::string,void*>::iterator iter;
             iter = sources.find(source);
             if(iter == sources.end()) {
@@ -271,7 +493,7 @@ class PdBase {
 
         /// is a pd send source subscribed?
         virtual bool exists(const std::string& source) {
-            std::map<std::string,void*>& sources = PdContext::instance().sources;
+            std::map<std::string,void*>& sources = useContext().sources;
             if(sources.find(source) != sources.end()) {
                 return true;
             }
@@ -280,7 +502,7 @@ class PdBase {
 
         //// receivers will be unsubscribed from *all* pd send sources
         virtual void unsubscribeAll() {
-            std::map<std::string,void*>& sources = PdContext::instance().sources;
+            std::map<std::string,void*>& sources = useContext().sources;
             std::map<std::string,void*>::iterator iter;
             for(iter = sources.begin(); iter != sources.end(); ++iter) {
                 libpd_unbind(iter->second);
@@ -301,11 +523,13 @@ class PdBase {
 
         /// process waiting messages
         virtual void receiveMessages() {
+            useContext();
             libpd_queued_receive_pd_messages();
         }
 
         /// process waiting midi messages
         virtual void receiveMidi() {
+            useContext();
             libpd_queued_receive_midi_messages();
         }
 
@@ -319,7 +543,7 @@ class PdBase {
         /// event queue
         ///
         void setReceiver(pd::PdReceiver* receiver) {
-            PdContext::instance().receiver = receiver;
+            useContext().receiver = receiver;
         }
 
     /// \section Midi Receiving via Callbacks
@@ -331,23 +555,35 @@ class PdBase {
         /// set this to NULL to disable midi events and re-enable the midi queue
         ///
         void setMidiReceiver(pd::PdMidiReceiver* midiReceiver) {
-            PdContext::instance().midiReceiver = midiReceiver;
+            useContext().midiReceiver = midiReceiver;
         }
 
     /// \section Send Functions
 
         /// send a bang message
         virtual void sendBang(const std::string& dest) {
+            if(isSendQueued()) {
+                libpd_queued_bang(dest.c_str());
+                return;
+            }
             libpd_bang(dest.c_str());
         }
 
         /// send a float
         virtual void sendFloat(const std::string& dest, float value) {
+            if(isSendQueued()) {
+                libpd_queued_float(dest.c_str(), value);
+                return;
+            }
             libpd_float(dest.c_str(), value);
         }
 
         /// send a symbol
         virtual void sendSymbol(const std::string& dest, const std::string& symbol) {
+            if(isSendQueued()) {
+                libpd_queued_symbol(dest.c_str(), symbol.c_str());
+                return;
+            }
             libpd_symbol(dest.c_str(), symbol.c_str());
         }
 
@@ -371,12 +607,12 @@ class PdBase {
 
         /// start a compound list or message
         virtual void startMessage() {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(context.bMsgInProgress) {
                 std::cerr << "Pd: Can not start message, message in progress" << std::endl;
                 return;
             }
-            if(libpd_start_message(context.maxMsgLen) == 0) {
+            if(startLibPdMessage(context.maxMsgLen)) {
                 context.bMsgInProgress = true;
                 context.msgType = MSG;
             }
@@ -384,7 +620,7 @@ class PdBase {
 
         /// add a float to the current compound list or message
         virtual void addFloat(const float num) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(!context.bMsgInProgress) {
                 std::cerr << "Pd: Can not add float, message not in progress" << std::endl;
                 return;
@@ -397,13 +633,18 @@ class PdBase {
                 std::cerr << "Pd: Can not add float, max message len of " << context.maxMsgLen << " reached" << std::endl;
                 return;
             }
-            libpd_add_float(num);
+            if(isSendQueued()) {
+                libpd_queued_add_float(num);
+            }
+            else {
+                libpd_add_float(num);
+            }
             context.curMsgLen++;
         }
 
         /// add a symbol to the current compound list or message
         virtual void addSymbol(const std::string& symbol) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(!context.bMsgInProgress) {
                 std::cerr << "Pd: Can not add symbol, message not in progress" << std::endl;;
                 return;
@@ -416,13 +657,18 @@ class PdBase {
                 std::cerr << "Pd: Can not add symbol, max message len of " << context.maxMsgLen << " reached" << std::endl;
                 return;
             }
-            libpd_add_symbol(symbol.c_str());
+            if(isSendQueued()) {
+                libpd_queued_add_symbol(symbol.c_str());
+            }
+            else {
+                libpd_add_symbol(symbol.c_str());
+            }
             context.curMsgLen++;
         }
 
         /// finish and send as a list
         virtual void finishList(const std::string& dest) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(!context.bMsgInProgress) {
                 std::cerr << "Pd: Can not finish list, message not in progress" << std::endl;
                 return;
@@ -431,14 +677,19 @@ class PdBase {
                 std::cerr << "Pd: Can not finish list, midi byte stream in progress" << std::endl;
                 return;
             }
-            libpd_finish_list(dest.c_str());
+            if(isSendQueued()) {
+                libpd_queued_finish_list(dest.c_str());
+            }
+            else {
+                libpd_finish_list(dest.c_str());
+            }
             context.bMsgInProgress = false;
             context.curMsgLen = 0;
         }
 
         /// finish and send as a list with a specific message name
         virtual void finishMessage(const std::string& dest, const std::string& msg) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(!context.bMsgInProgress) {
                 std::cerr << "Pd: Can not finish message, message not in progress" << std::endl;
                 return;
@@ -447,7 +698,12 @@ class PdBase {
                 std::cerr << "Pd: Can not finish message, midi byte stream in progress" << std::endl;
                 return;
             }
-            libpd_finish_message(dest.c_str(), msg.c_str());
+            if(isSendQueued()) {
+                libpd_queued_finish_message(dest.c_str(), msg.c_str());
+            }
+            else {
+                libpd_finish_message(dest.c_str(), msg.c_str());
+            }
             context.bMsgInProgress = false;
             context.curMsgLen = 0;
         }
@@ -467,12 +723,12 @@ class PdBase {
         ///     pd.sstd::endlist("test", list);
         ///
         virtual void sendList(const std::string& dest, const pd::List& list) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(context.bMsgInProgress) {
                 std::cerr << "Pd: Can not send list, message in progress" << std::endl;
                 return;
             }
-            libpd_start_message(list.len());
+            startLibPdMessage(list.len());
             context.bMsgInProgress = true;
             // step through list
             for(int i = 0; i < (int)list.len(); ++i) {
@@ -501,12 +757,12 @@ class PdBase {
         virtual void sendMessage(const std::string& dest,
                                  const std::string& msg,
                                  const pd::List& list = pd::List()) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(context.bMsgInProgress) {
                 std::cerr << "Pd: Can not send message, message in progress" << std::endl;
                 return;
             }
-            libpd_start_message(list.len());
+            startLibPdMessage(list.len());
             context.bMsgInProgress = true;
             // step through list
             for(int i = 0; i < (int)list.len(); ++i) {
@@ -539,6 +795,10 @@ class PdBase {
         virtual void sendNoteOn(const int channel,
                                 const int pitch,
                                 const int velocity=64) {
+            if(isSendQueued()) {
+                libpd_queued_noteon(channel, pitch, velocity);
+                return;
+            }
             libpd_noteon(channel, pitch, velocity);
         }
 
@@ -546,6 +806,10 @@ class PdBase {
         virtual void sendControlChange(const int channel,
                                        const int controller,
                                        const int value) {
+            if(isSendQueued()) {
+                libpd_queued_controlchange(channel, controller, value);
+                return;
+            }
             libpd_controlchange(channel, controller, value);
         }
 
@@ -554,6 +818,10 @@ class PdBase {
         /// in pd: [pgmin] and [pgmout] are 0 - 127
         ///
         virtual void sendProgramChange(const int channel, const int value) {
+            if(isSendQueued()) {
+                libpd_queued_programchange(channel, value);
+                return;
+            }
             libpd_programchange(channel, value);
         }
         
@@ -562,11 +830,19 @@ class PdBase {
         /// in pd: [bendin] takes 0 - 16383 while [bendout] returns -8192 - 8192
         ///
         virtual void sendPitchBend(const int channel, const int value) {
+            if(isSendQueued()) {
+                libpd_queued_pitchbend(channel, value);
+                return;
+            }
             libpd_pitchbend(channel, value);
         }
         
         /// send a MIDI aftertouch
         virtual void sendAftertouch(const int channel, const int value) {
+            if(isSendQueued()) {
+                libpd_queued_aftertouch(channel, value);
+                return;
+            }
             libpd_aftertouch(channel, value);
         }
 
@@ -574,6 +850,10 @@ class PdBase {
         virtual void sendPolyAftertouch(const int channel,
                                         const int pitch,
                                         const int value) {
+            if(isSendQueued()) {
+                libpd_queued_polyaftertouch(channel, pitch, value);
+                return;
+            }
             libpd_polyaftertouch(channel, pitch, value);
         }
 
@@ -589,16 +869,28 @@ class PdBase {
         /// port num, so sending port 1 to [midiout] returns port 1 in PdBase
         ///
         virtual void sendMidiByte(const int port, const int value) {
+            if(isSendQueued()) {
+                libpd_queued_midibyte(port, value);
+                return;
+            }
             libpd_midibyte(port, value);
         }
 
         /// send a raw MIDI sysex byte
         virtual void sendSysex(const int port, const int value) {
+            if(isSendQueued()) {
+                libpd_queued_sysex(port, value);
+                return;
+            }
             libpd_sysex(port, value);
         }
 
         /// send a raw MIDI realtime byte
         virtual void sendSysRealTime(const int port, const int value) {
+            if(isSendQueued()) {
+                libpd_queued_sysrealtime(port, value);
+                return;
+            }
             libpd_sysrealtime(port, value);
         }
 
@@ -613,7 +905,7 @@ class PdBase {
 
         /// send a bang message
         PdBase& operator<<(const pd::Bang& var) {
-            if(PdContext::instance().bMsgInProgress) {
+            if(useContext().bMsgInProgress) {
                 std::cerr << "Pd: Can not send Bang, message in progress" << std::endl;
                 return *this;
             }
@@ -623,7 +915,7 @@ class PdBase {
 
         /// send a float message
         PdBase& operator<<(const pd::Float& var) {
-            if(PdContext::instance().bMsgInProgress) {
+            if(useContext().bMsgInProgress) {
                 std::cerr << "Pd: Can not send Float, message in progress" << std::endl;
                 return *this;
             }
@@ -633,7 +925,7 @@ class PdBase {
 
         /// send a symbol message
         PdBase& operator<<(const pd::Symbol& var) {
-            if(PdContext::instance().bMsgInProgress) {
+            if(useContext().bMsgInProgress) {
                 std::cerr << "Pd: Can not send Symbol, message in progress" << std::endl;
                 return *this;
             }
@@ -672,7 +964,7 @@ class PdBase {
 
         // add an integer as a float to the compound message
         PdBase& operator<<(const int var) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             switch(context.msgType) {
                 case MSG:
                     addFloat((float) var);
@@ -774,7 +1066,7 @@ class PdBase {
 
         /// start a raw byte MIDI message
         PdBase& operator<<(const pd::StartMidi& var) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(context.bMsgInProgress) {
                 std::cerr << "Pd: Can not start MidiByte stream, "
                      << "message in progress" << std::endl;
@@ -788,7 +1080,7 @@ class PdBase {
 
         /// start a raw byte MIDI sysex message
         PdBase& operator<<(const pd::StartSysex& var) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(context.bMsgInProgress) {
                 std::cerr << "Pd: Can not start Sysex stream, "
                      << "message in progress" << std::endl;
@@ -802,7 +1094,7 @@ class PdBase {
 
         /// start a raw byte MIDI realtime message
         PdBase& operator<<(const pd::StartSysRealTime& var) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(context.bMsgInProgress) {
                 std::cerr << "Pd: Can not start SysRealRime stream, "
                      << "message in progress" << std::endl;
@@ -816,7 +1108,7 @@ class PdBase {
 
         /// finish and send a raw byte MIDI message
         PdBase& operator<<(const pd::Finish& var) {
-            PdContext& context = PdContext::instance();
+            PdContext& context = useContext();
             if(!context.bMsgInProgress) {
                 std::cerr << "Pd: Can not finish midi byte stream, "
                      << "stream not in progress" << std::endl;
@@ -834,7 +1126,7 @@ class PdBase {
 
         /// is a message or byte stream currently in progress?
         bool isMessageInProgress() {
-            return PdContext::instance().bMsgInProgress;
+            return useContext().bMsgInProgress;
         }
 
     /// \section Array Access
@@ -842,6 +1134,7 @@ class PdBase {
         /// get the size of a pd array
         /// returns 0 if array not found
         int arraySize(const std::string& name) {
+            useContext();
             int len = libpd_arraysize(name.c_str());;
             if(len < 0) {
                 std::cerr << "Pd: Cannot get size of unknown array \""
@@ -865,6 +1158,7 @@ class PdBase {
         virtual bool readArray(const std::string& name,
                                std::vector<float>& dest,
                                int readLen=-1, int offset=0) {
+            useContext();
             int len = libpd_arraysize(name.c_str());
             if(len < 0) {
                 std::cerr << "Pd: Cannot read unknown array \""
@@ -909,6 +1203,7 @@ class PdBase {
         virtual bool writeArray(const std::string& name,
                                 std::vector<float>& source,
                                 int writeLen=-1, int offset=0) {
+            useContext();
             int len = libpd_arraysize(name.c_str());
             if(len < 0) {
                 std::cerr << "Pd: Cannot write to unknown array \""
@@ -944,52 +1239,173 @@ class PdBase {
             return true;
         }
 
+        /// read from a pd array into a caller-owned buffer of at least
+        /// readLen floats, without allocating
+        ///
+        /// returns true on success, false on failure
+        virtual bool readArray(const std::string& name, float *dest,
+                               int readLen, int offset=0) {
+            useContext();
+            int ret = libpd_read_array(dest, name.c_str(), offset, readLen);
+            if(ret < 0) {
+                std::cerr << "Pd: Cannot read " << readLen << " at offset "
+                     << offset << " from array \"" << name << "\""
+                     << (ret == -1 ? " (unknown array)" : "") << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        /// write writeLen floats from a caller-owned buffer to a pd array
+        ///
+        /// returns true on success, false on failure
+        virtual bool writeArray(const std::string& name, const float *source,
+                                int writeLen, int offset=0) {
+            useContext();
+            int ret = libpd_write_array(name.c_str(), offset, source, writeLen);
+            if(ret < 0) {
+                std::cerr << "Pd: Cannot write " << writeLen << " at offset "
+                     << offset << " to array \"" << name << "\""
+                     << (ret == -1 ? " (unknown array)" : "") << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        /// zero-copy access to a pd array's storage
+        ///
+        /// locks pd and sets data to the array's first element & stride to
+        /// the distance between elements in floats, so element i is
+        /// data[i*stride]; stride is 1 for packed arrays (send "packed 1" to
+        /// the array), whose elements can be copied with memcpy
+        ///
+        /// returns the array size, or -1 if the array is not found
+        ///
+        /// on success pd stays locked, blocking audio processing, until
+        /// unlockArray() is called, which must always follow:
+        ///
+        /// t_float *data;
+        /// int stride;
+        /// int len = pd.lockArray("array1", data, stride);
+        /// if(len >= 0) {
+        ///     ... read or write data ...
+        ///     pd.unlockArray();
+        /// }
+        ///
+        int lockArray(const std::string& name, t_float*& data, int& stride) {
+            useContext();
+            int len = libpd_array_lock(name.c_str(), &data, &stride);
+            if(len < 0) {
+                std::cerr << "Pd: Cannot lock unknown array \""
+                     << name << "\"" << std::endl;
+            }
+            return len;
+        }
+
+        /// unlock pd after a successful lockArray()
+        void unlockArray() {
+            useContext();
+            libpd_array_unlock();
+        }
+
         /// clear array and set to a specific value
         virtual void clearArray(const std::string& name, int value=0) {
-            int len = libpd_arraysize(name.c_str());
+            t_float *data;
+            int stride;
+            int len = lockArray(name, data, stride);
             if(len < 0) {
-                std::cerr << "Pd: Cannot clear unknown array \""
-                     << name << "\"" << std::endl;
                 return;
             }
-            std::vector<float> array;
-            array.resize(len, value);
-            if(libpd_write_array(name.c_str(), 0, &array[0], len) < 0) {
-                std::cerr << "Pd: libpd_write_array failed while clearing array \""
-                     << name << "\"" << std::endl;
+            for(int i = 0; i < len; ++i) {
+                data[i*stride] = value;
             }
+            unlockArray();
         }
 
     /// \section Utils
 
         /// has the global pd instance been initialized?
         bool isInited() {
-            return PdContext::instance().isInited();
+            return useContext().isInited();
         }
 
         /// is the global pd instance using the ringerbuffer queue
         /// for message padding?
         bool isQueued() {
-            return PdContext::instance().isQueued();
+            return useContext().isQueued();
         }
 
-        /// get the blocksize of pd (sample length per channel)
+        /// get the blocksize of the current pd instance (sample length per
+        /// channel), default: 64
+        ///
+        /// static as before, so existing PdBase::blockSize() calls still
+        /// work; with PDINSTANCE it reads whichever instance was used last,
+        /// see instanceBlockSize()
         static int blockSize() {
-            // shouldn't need to lock this for now, it's always 64
             return libpd_blocksize();
         }
 
+        /// get the blocksize of this object's pd instance
+        int instanceBlockSize() {
+            useContext();
+            return libpd_blocksize();
+        }
+
+        /// set the blocksize of pd: the number of samples per channel
+        /// computed each tick and the top-level signal vector size
+        ///
+        /// must be a power of two from 1 to 4096, ie. 16 or 32 for low-latency
+        /// monitoring or 1024 to cut per-tick overhead when rendering offline
+        ///
+        /// restarts DSP if it is running, buffers passed to the process
+        /// functions must then hold ticks * blockSize() samples per channel
+        ///
+        /// returns false if the size is invalid
+        ///
+        virtual bool setBlockSize(int blockSize) {
+            useContext();
+            return libpd_set_blocksize(blockSize) == 0;
+        }
+
         /// set the max length of messages and lists, default: 32
         void setMaxMessageLen(unsigned int len) {
-            PdContext::instance().maxMsgLen = len;
+            useContext().maxMsgLen = len;
         }
 
         /// get the max length of messages and lists
         unsigned int maxMessageLen() {
-            return PdContext::instance().maxMsgLen;
+            return useContext().maxMsgLen;
         }
 
     protected:
+
+        /// convert libpd profile entries
+        static std::vector<ProfileEntry> convertProfile(
+            const std::vector<libpd_profile_entry>& entries) {
+            std::vector<ProfileEntry> profile(entries.size());
+            for(size_t i = 0; i < entries.size(); ++i) {
+                const libpd_profile_entry& e = entries[i];
+                ProfileEntry& p = profile[i];
+                p.name = e.name;
+                p.canvas = e.canvas;
+                p.index = e.index;
+                p.time = e.time;
+                p.load = e.load;
+                p.calls = e.calls;
+                p.histogram.assign(e.histogram,
+                                   e.histogram + LIBPD_PROFILE_BINS);
+            }
+            return profile;
+        }
+
+        /// start a compound message with the locking or queued libpd api
+        /// returns true on success
+        bool startLibPdMessage(int maxLen) {
+            if(isSendQueued()) {
+                return libpd_queued_start_message(maxLen) == 0;
+            }
+            return libpd_start_message(maxLen) == 0;
+        }
     
         /// compound message status
         enum MsgType {
@@ -999,37 +1415,85 @@ class PdBase {
             SYSRT
         };
 
-        /// a singleton libpd instance wrapper
+        class PdContext;
+
+        /// make this object's pd instance current on the calling thread,
+        /// returns this object's context
+        ///
+        /// called by every function which talks to libpd, as libpd functions
+        /// work on the current instance & callbacks are sent to the current
+        /// context
+        ///
+        PdContext& useContext() {
+            pdContext.makeCurrent();
+            return pdContext;
+        }
+
+        /// a libpd instance wrapper, one per PdBase object
         class PdContext {
 
             public:
 
-                /// singleton data access
-                /// returns a reference to itself
-                /// note: only creates a new object on the first call
-                static PdContext& instance() {
-                    static PdBase::PdContext *singletonInstance = new PdContext;
-                    return *singletonInstance;
+                PdContext() {
+                    pdInstance = NULL;
+                    bInited = false;
+                    bQueued = false;
+                    bSendQueued = false;
+                    receiver = NULL;
+                    midiReceiver = NULL;
+                    clear();
+                    maxMsgLen = 32;
                 }
 
-                /// increments the num of pd base objects
-                void addBase() {numBases++;}
-
-                /// decrements the num of pd base objects
-                /// clears if removing last base
-                void removeBase() {
-                    if(numBases > 0) {
-                        numBases--;
-                    }
-                    else if(bInited) { // double check clear
+                virtual ~PdContext() {
+                    // triple check clear
+                    if(bInited) {
+                        makeCurrent();
                         clear();
                     }
+                    if(pdInstance != NULL) {
+                        libpd_free_instance(pdInstance);
+                    }
+                    if(current() == this) {
+                        current() = NULL;
+                    }
+                }
+
+                /// the context the libpd callbacks are sent to on the calling
+                /// thread, set by makeCurrent()
+                static PdContext*& current() {
+                    static thread_local PdContext* context = NULL;
+                    return context;
+                }
+
+                /// make this the current context & its pd instance the current
+                /// libpd instance on the calling thread
+                void makeCurrent() {
+                    if(pdInstance != NULL) {
+                        libpd_set_instance(pdInstance);
+                    }
+                    current() = this;
                 }
 
                 /// init the pd instance
                 bool init(const int numInChannels, const int numOutChannels,
                           const int sampleRate, bool queued) {
 
+                    // the hooks are shared by all contexts
+                    if(numInited() > 0 && queued != (numQueued() > 0)) {
+                        std::cerr << "Pd: Can not init, all contexts must use "
+                                  << "the same queued setting" << std::endl;
+                        return false;
+                    }
+
+                    // init libpd, only done on the first call, then create
+                    // a separate instance if compiled with PDINSTANCE
+                    libpd_init();
+                    if(pdInstance == NULL) {
+                        pdInstance = libpd_new_instance();
+                    }
+                    makeCurrent();
+
                     // attach callbacks
                     bQueued = queued;
                     if(queued) {
@@ -1050,11 +1514,12 @@ class PdBase {
                         libpd_set_queued_polyaftertouchhook(_polyaftertouch);
                         libpd_set_queued_midibytehook(_midibyte);
                         
-                        // init libpd, should only be called once!
-                        if(!bLibPdInited) {
-                            libpd_queued_init();
-                            bLibPdInited = true;
+                        // create this instance's ringbuffers, these are
+                        // released in clear()
+                        if(libpd_queued_init() != 0) {
+                            return false;
                         }
+                        numQueued()++;
                     }
                     else {
                         libpd_set_printhook(libpd_print_concatenator);
@@ -1073,12 +1538,6 @@ class PdBase {
                         libpd_set_aftertouchhook(_aftertouch);
                         libpd_set_polyaftertouchhook(_polyaftertouch);
                         libpd_set_midibytehook(_midibyte);
-                        
-                        // init libpd, should only be called once!
-                        if(!bLibPdInited) {
-                            libpd_init();
-                            bLibPdInited = true;
-                        }
                     }
                     
                     // init audio
@@ -1086,6 +1545,7 @@ class PdBase {
                         return false;
                     }
                     bInited = true;
+                    numInited()++;
 
                     return bInited;
                 }
@@ -1093,9 +1553,17 @@ class PdBase {
                 /// clear the pd instance
                 void clear() {
 
-                    // detach callbacks
+                    // detach callbacks, the hooks are shared so they are only
+                    // cleared by the last context
                     if(bInited) {
                         computeAudio(false);
+                        numInited()--;
+                        if(bQueued) {
+                            libpd_queued_release();
+                            numQueued()--;
+                        }
+                    }
+                    if(bInited && numInited() == 0) {
                         if(bQueued) {
                             libpd_set_queued_printhook(NULL);
                             libpd_set_concatenated_printhook(NULL);
@@ -1113,8 +1581,6 @@ class PdBase {
                             libpd_set_queued_aftertouchhook(NULL);
                             libpd_set_queued_polyaftertouchhook(NULL);
                             libpd_set_queued_midibytehook(NULL);
-                            
-                            libpd_queued_release();
                         }
                         else {
                             libpd_set_printhook(NULL);
@@ -1161,6 +1627,7 @@ class PdBase {
             /// \section Variables
 
                 bool bMsgInProgress;    //< is a compound message being constructed?
+                bool bSendQueued;       //< send through the inbound ringbuffer?
                 int maxMsgLen;          //< maximum allowed message length
                 int curMsgLen;          //< the length of the current message
 
@@ -1176,146 +1643,121 @@ class PdBase {
 
             private:
 
-                bool bLibPdInited; //< has libpd_init be called?
+                t_pdinstance* pdInstance; //< this context's instance, NULL
+                                          //< without PDINSTANCE
                 bool bInited;      //< is this pd context inited?
                 bool bQueued; //< is this context using the libpd_queued ringbuffer?
 
-                unsigned int numBases;  //< number of pd base objects
-
-                // hide all the constructors, copy functions here
-                PdContext() {                      // cannot create
-                    bLibPdInited = false;
-                    bInited = false;
-                    bQueued = false;
-                    numBases = false;
-                    receiver = NULL;
-                    midiReceiver = NULL;
-                    clear();
-                    maxMsgLen = 32;
-                }                       
-                virtual ~PdContext() {             // cannot destroy
-                    // triple check clear
-                    if(bInited) {clear();}
+                /// number of inited & queued contexts
+                static std::atomic<int>& numInited() {
+                    static std::atomic<int> num(0);
+                    return num;
+                }
+                static std::atomic<int>& numQueued() {
+                    static std::atomic<int> num(0);
+                    return num;
                 }
-                void operator =(PdContext& from) {} // not copyable
+
+                PdContext(const PdContext& from);    // not copyable
+                void operator =(PdContext& from) {}  // not copyable
 
                 /// libpd static callback functions
                 static void _print(const char* s) {
-                    PdContext& context = PdContext::instance();
-                    if(context.receiver) {
-                        context.receiver->print((std::string) s);
+                    PdContext* context = current();
+                    if(context && context->receiver) {
+                        context->receiver->print((std::string) s);
                     }
                 }
 
                 static void _bang(const char* source) {
-                    PdContext& context = PdContext::instance();
-                    if(context.receiver) {
-                        context.receiver->receiveBang((std::string) source);
+                    PdContext* context = current();
+                    if(context && context->receiver) {
+                        context->receiver->receiveBangRef(source);
                     }
                 }
 
                 static void _float(const char* source, float value) {
-                    PdContext& context = PdContext::instance();
-                    if(context.receiver) {
-                        context.receiver->receiveFloat((std::string) source, value);
+                    PdContext* context = current();
+                    if(context && context->receiver) {
+                        context->receiver->receiveFloatRef(source, value);
                     }
                 }
 
                 static void _symbol(const char* source, const char* symbol) {
-                    PdContext& context = PdContext::instance();
-                    if(context.receiver) {
-                        context.receiver->receiveSymbol((std::string) source, (std::string) symbol);
+                    PdContext* context = current();
+                    if(context && context->receiver) {
+                        context->receiver->receiveSymbolRef(source, symbol);
                     }
                 }
 
                 static void _list(const char* source, int argc, t_atom* argv) {
-                    PdContext& context = PdContext::instance();
-                    pd::List list;
-                    for(int i = 0; i < argc; i++) {
-                        t_atom a = argv[i];
-                        if(a.a_type == A_FLOAT) {
-                            float f = a.a_w.w_float;
-                            list.addFloat(f);
-                        }
-                        else if(a.a_type == A_SYMBOL) {
-                            const char* s = a.a_w.w_symbol->s_name;
-                            list.addSymbol((std::string) s);
-                        }
-                    }
-                    if(context.receiver) {
-                        context.receiver->receiveList((std::string) source, list);
+                    PdContext* context = current();
+                    if(context && context->receiver) {
+                        context->receiver->receiveListRef(source, ListRef(argc, argv));
                     }
                 }
 
                 static void _message(const char* source, const char *symbol,
                                      int argc, t_atom *argv) {
-                    PdContext& context = PdContext::instance();
-                    List list;
-                    for(int i = 0; i < argc; i++) {
-                        t_atom a = argv[i];
-                        if(a.a_type == A_FLOAT) {
-                            float f = a.a_w.w_float;
-                            list.addFloat(f);
-                        }
-                        else if(a.a_type == A_SYMBOL) {
-                            const char* s = a.a_w.w_symbol->s_name;
-                            list.addSymbol((std::string) s);
-                        }
-                    }
-                    if(context.receiver) {
-                        context.receiver->receiveMessage((std::string) source, (std::string) symbol, list);
+                    PdContext* context = current();
+                    if(context && context->receiver) {
+                        context->receiver->receiveMessageRef(source, symbol, ListRef(argc, argv));
                     }
                 }
 
                 static void _noteon(int channel, int pitch, int velocity) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receiveNoteOn(channel, pitch, velocity);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receiveNoteOn(channel, pitch, velocity);
                     }
                 }
 
                 static void _controlchange(int channel, int controller, int value) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receiveControlChange(channel, controller, value);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receiveControlChange(channel, controller, value);
                     }
                 }
 
                 static void _programchange(int channel, int value) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receiveProgramChange(channel, value);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receiveProgramChange(channel, value);
                     }
                 }
 
                 static void _pitchbend(int channel, int value) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receivePitchBend(channel, value);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receivePitchBend(channel, value);
                     }
                 }
 
                 static void _aftertouch(int channel, int value) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receiveAftertouch(channel, value);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receiveAftertouch(channel, value);
                     }
                 }
 
                 static void _polyaftertouch(int channel, int pitch, int value) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receivePolyAftertouch(channel, pitch, value);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receivePolyAftertouch(channel, pitch, value);
                     }
                 }
 
                 static void _midibyte(int port, int byte) {
-                    PdContext& context = PdContext::instance();
-                    if(context.midiReceiver) {
-                        context.midiReceiver->receiveMidiByte(port, byte);
+                    PdContext* context = current();
+                    if(context && context->midiReceiver) {
+                        context->midiReceiver->receiveMidiByte(port, byte);
                     }
                 }
         };
+
+    private:
+
+        PdContext pdContext; //< this object's context
 };
 
 } // namespace
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/libpd/libpd for documentation
+ *
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "PdBase.hpp"
+
+namespace pd {
+
+/// one render for PdBatchRenderer: a fresh copy of the patch is opened,
+/// given its parameters and rendered to outFile
+class PdRenderJob {
+
+    public:
+
+        PdRenderJob() : seconds(0), ok(false), realtimeFactor(0) {}
+
+        PdRenderJob(const std::string& outFile, double seconds) :
+            outFile(outFile), seconds(seconds), ok(false), realtimeFactor(0) {}
+
+        /// add a float sent to a receiver after the patch is opened,
+        /// a leading "$0" in the receiver name is replaced by the patch's $0
+        PdRenderJob& addFloat(const std::string& receiver, float value) {
+            floats.push_back(std::make_pair(receiver, value));
+            return *this;
+        }
+
+        std::string outFile; //< sound file to write
+        std::string inFile;  //< optional sound file fed to adc~
+        double seconds;      //< length to render
+
+        /// floats sent to receivers before rendering, see addFloat()
+        std::vector<std::pair<std::string, float> > floats;
+
+        /// optional callback run after the floats are sent, for any other
+        /// messages, called on the worker thread with its pd instance
+        std::function<void(PdBase& pd, Patch& patch)> prepare;
+
+        /// results, set by PdBatchRenderer::run()
+        bool ok;               //< was the file fully written?
+        double realtimeFactor; //< rendered duration / time taken
+};
+
+/// renders a patch with many parameter sets on all cores
+///
+/// each worker thread owns a PdBase and so, when libpd and your sources are
+/// compiled with PDINSTANCE & PDTHREADS, a separate pd instance; jobs are
+/// handed out to the workers as they finish, so a render farm node stays
+/// busy until the batch is done:
+///
+///     PdBatchRenderer batch("synth.pd", "/path/to/patches");
+///     for(int i = 0; i < 1000; ++i) {
+///         PdRenderJob job("/renders/note" + std::to_string(i) + ".wav", 2.0);
+///         job.addFloat("$0-pitch", 36 + i % 48);
+///         batch.add(job);
+///     }
+///     int rendered = batch.run();
+///
+/// without PDINSTANCE there is only one pd instance, so the jobs run one
+/// after the other on a single worker
+///
+class PdBatchRenderer {
+
+    public:
+
+        PdBatchRenderer(const std::string& patch, const std::string& path) :
+            patch(patch), path(path), numThreads(0),
+            numInChannels(0), numOutChannels(2), sampleRate(44100),
+            blockSize(1024), bytesPerSample(4), elapsed(0), rendered(0) {}
+
+    /// \section Settings
+
+        /// set the number of worker threads,
+        /// 0 uses std::thread::hardware_concurrency(), default: 0
+        void setNumThreads(int threads) {numThreads = threads;}
+
+        /// set the number of adc~ & dac~ channels of each pd instance,
+        /// the output files have numOutChannels, default: 0 in & 2 out
+        void setChannels(int in, int out) {
+            numInChannels = in;
+            numOutChannels = out;
+        }
+
+        /// set the sample rate, default: 44100
+        void setSampleRate(int rate) {sampleRate = rate;}
+
+        /// set the pd block size of each instance, larger blocks cut the
+        /// per-tick overhead, default: 1024
+        void setBlockSize(int size) {blockSize = size;}
+
+        /// set the output sample size: 2, 3 or 4 (float) bytes, default: 4
+        void setBytesPerSample(int bytes) {bytesPerSample = bytes;}
+
+    /// \section Jobs
+
+        /// add a job to the batch
+        void add(const PdRenderJob& job) {jobs.push_back(job);}
+
+        /// get the jobs, including their results after run()
+        std::vector<PdRenderJob>& getJobs() {return jobs;}
+
+        /// remove all jobs
+        void clear() {jobs.clear();}
+
+    /// \section Rendering
+
+        /// render all jobs, blocks until they are done
+        ///
+        /// returns the number of jobs which were rendered successfully,
+        /// check each job's ok flag for the ones which failed
+        ///
+        int run() {
+            int threads = numThreads;
+            if(threads <= 0) {
+                threads = (int)std::thread::hardware_concurrency();
+            }
+        #ifndef PDINSTANCE
+            threads = 1;
+        #endif
+            if(threads > (int)jobs.size()) {
+                threads = (int)jobs.size();
+            }
+            next = 0;
+            numOk = 0;
+            rendered = 0;
+            std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+            std::vector<std::thread> workers;
+            for(int i = 0; i < threads; ++i) {
+                workers.push_back(std::thread(&PdBatchRenderer::work, this));
+            }
+            for(size_t i = 0; i < workers.size(); ++i) {
+                workers[i].join();
+            }
+            elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+            return numOk;
+        }
+
+        /// get the wall clock time the last run() took in seconds
+        double getElapsed() {return elapsed;}
+
+        /// get the total duration rendered by the last run() divided by the
+        /// time it took, ie. the combined speed of all workers
+        double getRealtimeFactor() {
+            return elapsed > 0 ? rendered / elapsed : 0;
+        }
+
+    private:
+
+        /// worker thread: set up a pd instance, then take jobs until none
+        /// are left
+        void work() {
+            std::unique_ptr<PdBase> instance;
+            {
+                // libpd's first init & hooks are global
+                std::lock_guard<std::mutex> lock(initMutex());
+                instance.reset(new PdBase);
+                if(!instance->init(numInChannels, numOutChannels, sampleRate)) {
+                    instance.reset();
+                    return;
+                }
+            }
+            PdBase& pd = *instance;
+            pd.setBlockSize(blockSize);
+            pd.computeAudio(true);
+
+            double done = 0;
+            size_t index;
+            while((index = next++) < jobs.size()) {
+                PdRenderJob& job = jobs[index];
+                Patch p = pd.openPatch(patch, path);
+                if(!p.isValid()) {
+                    job.ok = false;
+                    continue;
+                }
+                for(size_t i = 0; i < job.floats.size(); ++i) {
+                    const std::string& dest = job.floats[i].first;
+                    if(dest.compare(0, 2, "$0") == 0) {
+                        pd.sendFloat(p.dollarZeroStr() + dest.substr(2),
+                                     job.floats[i].second);
+                    }
+                    else {
+                        pd.sendFloat(dest, job.floats[i].second);
+                    }
+                }
+                if(job.prepare) {
+                    job.prepare(pd, p);
+                }
+                job.ok = pd.renderToFile(job.outFile, job.seconds, job.inFile,
+                                         bytesPerSample, &job.realtimeFactor);
+                pd.closePatch(p);
+                if(job.ok) {
+                    done += job.seconds;
+                    numOk++;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(initMutex());
+            rendered = rendered + done;
+            pd.computeAudio(false);
+            instance.reset();
+        }
+
+        /// serializes libpd init & clear across all batches
+        static std::mutex& initMutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        std::string patch, path;
+        int numThreads;
+        int numInChannels, numOutChannels;
+        int sampleRate;
+        int blockSize;
+        int bytesPerSample;
+
+        std::vector<PdRenderJob> jobs;
+        std::atomic<size_t> next; //< index of the next job to hand out
+        std::atomic<int> numOk;   //< number of jobs rendered successfully
+        double elapsed;           //< duration of the last run()
+        double rendered;          //< seconds rendered by the last run()
+};
+
+} // namespace
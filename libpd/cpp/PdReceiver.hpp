@@ -39,6 +39,42 @@ class PdReceiver {
 
         /// receive a named message ie. sent from a message box [; dest msg arg1 arg2 arg3... <
         virtual void receiveMessage(const std::string& dest, const std::string& msg, const List& list) {}
+
+    /// \section Zero-copy Callbacks
+    ///
+    /// these are called by PdBase for every event, override them instead of
+    /// the std::string versions above to avoid copying names, symbols and
+    /// lists for each event
+    ///
+    /// by default they copy and forward to the std::string versions
+    ///
+    /// note: refs are only valid for the duration of the call, see PdTypes.hpp
+    ///
+
+        /// receive a bang
+        virtual void receiveBangRef(const StringRef& dest) {
+            receiveBang(dest.str());
+        }
+
+        /// receive a float
+        virtual void receiveFloatRef(const StringRef& dest, float num) {
+            receiveFloat(dest.str(), num);
+        }
+
+        /// receive a symbol
+        virtual void receiveSymbolRef(const StringRef& dest, const StringRef& symbol) {
+            receiveSymbol(dest.str(), symbol.str());
+        }
+
+        /// receive a list
+        virtual void receiveListRef(const StringRef& dest, const ListRef& list) {
+            receiveList(dest.str(), list.toList());
+        }
+
+        /// receive a named message
+        virtual void receiveMessageRef(const StringRef& dest, const StringRef& msg, const ListRef& list) {
+            receiveMessage(dest.str(), msg.str(), list.toList());
+        }
 };
 
 } // namespace
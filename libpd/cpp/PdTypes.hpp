@@ -17,6 +17,9 @@
 #include <vector>
 #include <iostream>
 #include <sstream>
+#include <cstring>
+
+#include "../libpd_wrapper/z_libpd.h"
 
 namespace pd {
 
@@ -111,6 +114,40 @@ class Patch {
         std::string _path;          //< full path to parent folder
 };
 
+/// \section Pd DSP Profile
+
+/// a line of the DSP profile for an object or a canvas,
+/// see PdBase::getProfileObjects() & PdBase::getProfileCanvases()
+struct ProfileEntry {
+
+    std::string name;   //< class name, or the canvas name for a canvas
+    std::string canvas; //< name of the canvas the object is in
+    int index;          //< object index in its canvas, -1 for a canvas
+    double time;        //< average microseconds per tick
+    double load;        //< time / duration of a tick, ie. 1 for 100% CPU
+    double calls;       //< average perform routine calls per tick
+
+    /// perform routine calls by duration: bin n counts calls taking 2^n to
+    /// 2^(n+1) nanoseconds, the last bin also all calls taking longer
+    std::vector<unsigned long long> histogram;
+
+    ProfileEntry() : index(-1), time(0), load(0), calls(0) {}
+
+    /// print info to ostream
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const ProfileEntry& from) {
+        os << from.name;
+        if(from.index >= 0) {
+            os << " " << from.index;
+        }
+        if(!from.canvas.empty()) {
+            os << " in " << from.canvas;
+        }
+        return os << ": " << from.time << " us/tick ("
+                  << from.load * 100 << "%)";
+    }
+};
+
 /// \section Pd stream interface message objects
 
 /// bang event
@@ -318,6 +355,104 @@ class List {
         std::vector<MsgObject> objects; //< list objects
 };
 
+/// \section Zero-copy callback types
+///
+/// used by the PdReceiver *Ref callbacks in order to pass receiver names,
+/// symbols & lists straight from pd without copying them into std::strings
+///
+/// note: these only refer to data owned by pd and are only valid for the
+///       duration of the callback, copy them with str() & toList() if they
+///       need to be kept
+
+/// a reference to a null terminated pd string, ie. a receiver name or symbol
+///
+/// pd keeps a single copy of each symbol name, so two refs to the same
+/// symbol also share the same pointer which can be used as a fast lookup key
+class StringRef {
+
+    public:
+
+        StringRef(const char* str) : _str(str) {}
+
+        /// get the raw null terminated string
+        const char* c_str() const {return _str;}
+
+        /// get the length in bytes
+        std::size_t size() const {return strlen(_str);}
+
+        /// is the string empty?
+        bool empty() const {return _str[0] == '\0';}
+
+        /// copy into a std::string
+        std::string str() const {return std::string(_str);}
+        operator std::string() const {return std::string(_str);}
+
+        /// compare contents
+        bool operator==(const char* other) const {return strcmp(_str, other) == 0;}
+        bool operator==(const std::string& other) const {return other == _str;}
+        bool operator!=(const char* other) const {return !(*this == other);}
+        bool operator!=(const std::string& other) const {return !(*this == other);}
+
+        /// print to ostream
+        friend std::ostream& operator<<(std::ostream& os, const StringRef& from) {
+            return os << from._str;
+        }
+
+    private:
+
+        const char* _str; //< string owned by pd
+};
+
+/// a read only view of a list of floats and symbols from pd
+class ListRef {
+
+    public:
+
+        ListRef(int argc, t_atom* argv) : _argc(argc), _argv(argv) {}
+
+        /// check if index is a float type
+        bool isFloat(const unsigned int index) const {
+            return index < len() && libpd_is_float(_argv + index);
+        }
+
+        /// check if index is a symbol type
+        bool isSymbol(const unsigned int index) const {
+            return index < len() && libpd_is_symbol(_argv + index);
+        }
+
+        /// get index as a float, returns 0 if not a float
+        float getFloat(const unsigned int index) const {
+            return isFloat(index) ? libpd_get_float(_argv + index) : 0;
+        }
+
+        /// get index as a symbol, returns "" if not a symbol
+        StringRef getSymbol(const unsigned int index) const {
+            return isSymbol(index) ? libpd_get_symbol(_argv + index) : "";
+        }
+
+        /// return number of items
+        unsigned int len() const {return (unsigned int) _argc;}
+
+        /// copy into a List
+        List toList() const {
+            List list;
+            for(unsigned int i = 0; i < len(); ++i) {
+                if(isFloat(i)) {
+                    list.addFloat(getFloat(i));
+                }
+                else if(isSymbol(i)) {
+                    list.addSymbol(getSymbol(i).str());
+                }
+            }
+            return list;
+        }
+
+    private:
+
+        int _argc;      //< number of atoms
+        t_atom* _argv;  //< atoms owned by pd
+};
+
 /// start a compound message
 struct StartMessage {
     explicit StartMessage() {}
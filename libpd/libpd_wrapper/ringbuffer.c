@@ -19,21 +19,37 @@
   #define SYNC_FETCH(ptr) atomic_fetch_or((_Atomic int *)ptr, 0)
   #define SYNC_COMPARE_AND_SWAP(ptr, oldval, newval) \
           atomic_compare_exchange_strong((_Atomic int *)ptr, &oldval, newval)
+  #define SYNC_BOOL_COMPARE_AND_SWAP(ptr, oldval, newval) \
+          atomic_compare_exchange_strong((_Atomic int *)ptr, &oldval, newval)
+  #define SYNC_STORE(ptr, val) atomic_store((_Atomic int *)ptr, val)
 #else // use platform specfics
   #ifdef __APPLE__ // apple atomics
     #include <libkern/OSAtomic.h>
     #define SYNC_FETCH(ptr) OSAtomicOr32Barrier(0, (volatile uint32_t *)ptr)
     #define SYNC_COMPARE_AND_SWAP(ptr, oldval, newval) \
             OSAtomicCompareAndSwap32Barrier(oldval, newval, ptr)
+    #define SYNC_BOOL_COMPARE_AND_SWAP(ptr, oldval, newval) \
+            OSAtomicCompareAndSwap32Barrier(oldval, newval, ptr)
+    #define SYNC_STORE(ptr, val) \
+            do {OSMemoryBarrier(); *(volatile int *)(ptr) = (val); \
+                OSMemoryBarrier();} while (0)
   #elif defined(_WIN32) || defined(_WIN64) // win api atomics
     #include <windows.h>
     #define SYNC_FETCH(ptr) InterlockedOr(ptr, 0)
     #define SYNC_COMPARE_AND_SWAP(ptr, oldval, newval) \
             InterlockedCompareExchange(ptr, oldval, newval)
+    #define SYNC_BOOL_COMPARE_AND_SWAP(ptr, oldval, newval) \
+            (InterlockedCompareExchange(ptr, newval, oldval) == (oldval))
+    #define SYNC_STORE(ptr, val) InterlockedExchange(ptr, val)
   #else // gcc atomics
     #define SYNC_FETCH(ptr) __sync_fetch_and_or(ptr, 0)
     #define SYNC_COMPARE_AND_SWAP(ptr, oldval, newval) \
             __sync_val_compare_and_swap(ptr, oldval, newval)
+    #define SYNC_BOOL_COMPARE_AND_SWAP(ptr, oldval, newval) \
+            __sync_bool_compare_and_swap(ptr, oldval, newval)
+    #define SYNC_STORE(ptr, val) \
+            do {__sync_synchronize(); *(volatile int *)(ptr) = (val); \
+                __sync_synchronize();} while (0)
   #endif
 #endif
 
@@ -125,3 +141,115 @@ int rb_read_from_buffer(ring_buffer *buffer, char *dest, int len) {
        (read_idx + len) % buffer->size);  // Includes memory barrier.
   return 0; 
 }
+
+// Every record in a multi writer ring buffer starts with a header giving the
+// payload length and its state. Records are padded to the header size so
+// headers are always aligned, and never wrap around the end of the buffer:
+// a writer that doesn't fit claims the tail as a skip record instead.
+typedef struct mw_record_header {
+    int len;
+    int state;
+} mw_record_header;
+
+#define MW_HEADER_SIZE ((int) sizeof(mw_record_header))
+#define MW_STATE_EMPTY 0
+#define MW_STATE_READY 1
+#define MW_STATE_SKIP  2
+
+mw_ring_buffer *mwrb_create(int size) {
+  if (size < 256 || (size & (size - 1))) return NULL; // power of two
+  mw_ring_buffer *buffer = malloc(sizeof(mw_ring_buffer));
+  if (!buffer) return NULL;
+  buffer->buf_ptr = calloc(size, sizeof(char));
+  if (!buffer->buf_ptr) {
+    free(buffer);
+    return NULL;
+  }
+  buffer->size = size;
+  buffer->reserve_idx = 0;
+  buffer->read_idx = 0;
+  return buffer;
+}
+
+void mwrb_free(mw_ring_buffer *buffer) {
+  free(buffer->buf_ptr);
+  free(buffer);
+}
+
+int mwrb_write_record(mw_ring_buffer *buffer, int n, ...) {
+  if (!buffer) return -1;
+  va_list args;
+  int i, len = 0;
+  va_start(args, n);
+  for (i = 0; i < n; ++i) {
+    va_arg(args, const char*);
+    int l = va_arg(args, int);
+    if (l < 0) {
+      va_end(args);
+      return -1;
+    }
+    len += l;
+  }
+  va_end(args);
+  int rest = len % MW_HEADER_SIZE;
+  int total = MW_HEADER_SIZE + len + (rest ? MW_HEADER_SIZE - rest : 0);
+  if (total > buffer->size / 2) return -1;
+
+  // claim space by moving the reserve index, retrying if another writer
+  // got there first
+  int reserve_idx, record_idx, skip, next_idx;
+  do {
+    reserve_idx = SYNC_FETCH(&(buffer->reserve_idx));
+    int read_idx = SYNC_FETCH(&(buffer->read_idx));
+    int available =
+        (buffer->size + read_idx - reserve_idx - 1) & (buffer->size - 1);
+    skip = (reserve_idx + total > buffer->size) ?
+        buffer->size - reserve_idx : 0;
+    if (skip + total > available) return -1;
+    record_idx = (reserve_idx + skip) & (buffer->size - 1);
+    next_idx = (record_idx + total) & (buffer->size - 1);
+  } while (!SYNC_BOOL_COMPARE_AND_SWAP(&(buffer->reserve_idx),
+      reserve_idx, next_idx));
+
+  if (skip) {
+    mw_record_header *h = (mw_record_header *)(buffer->buf_ptr + reserve_idx);
+    h->len = skip - MW_HEADER_SIZE;
+    SYNC_STORE(&(h->state), MW_STATE_SKIP);
+  }
+  mw_record_header *h = (mw_record_header *)(buffer->buf_ptr + record_idx);
+  char *dest = buffer->buf_ptr + record_idx + MW_HEADER_SIZE;
+  va_start(args, n);
+  for (i = 0; i < n; ++i) {
+    const char* src = va_arg(args, const char*);
+    int l = va_arg(args, int);
+    if (l) memcpy(dest, src, l);
+    dest += l;
+  }
+  va_end(args);
+  h->len = total - MW_HEADER_SIZE;
+  SYNC_STORE(&(h->state), MW_STATE_READY); // publishes the record
+  return 0;
+}
+
+int mwrb_read_record(mw_ring_buffer *buffer, char *dest, int len) {
+  if (!buffer) return 0;
+  int read_idx = buffer->read_idx;  // No need for sync in reader thread.
+  while (1) {
+    if (read_idx == SYNC_FETCH(&(buffer->reserve_idx))) return 0;
+    mw_record_header *h = (mw_record_header *)(buffer->buf_ptr + read_idx);
+    int state = SYNC_FETCH(&(h->state));
+    if (state == MW_STATE_EMPTY) return 0; // still being written
+    int total = MW_HEADER_SIZE + h->len;
+    int ret = 0;
+    if (state == MW_STATE_READY) {
+      ret = (h->len <= len) ? h->len : -1;
+      if (ret > 0) memcpy(dest, buffer->buf_ptr + read_idx + MW_HEADER_SIZE,
+          ret);
+    }
+    // clear the record so later headers claimed on top of it start out empty
+    memset(buffer->buf_ptr + read_idx, 0, total);
+    read_idx = (read_idx + total) & (buffer->size - 1);
+    SYNC_STORE(&(buffer->read_idx), read_idx);  // Includes memory barrier.
+    if (state == MW_STATE_READY) return ret;
+  }
+}
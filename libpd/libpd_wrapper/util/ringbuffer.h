@@ -46,4 +46,34 @@ int rb_write_to_buffer(ring_buffer *buffer, int n, ...);
 // Returns 0 on success.
 int rb_read_from_buffer(ring_buffer *buffer, char *dest, int len);
 
+// Lock-free ring buffer for any number of writer threads and one consumer
+// thread. Data is passed as whole records, each record becomes readable once
+// its writer has finished copying it, so writers never wait on each other and
+// the reader never waits at all.
+typedef struct mw_ring_buffer {
+    int size;
+    char *buf_ptr;
+    int reserve_idx;
+    int read_idx;
+} mw_ring_buffer;
+
+// Creates a multi writer ring buffer (returns NULL on failure), size must be a
+// power of two and at least 256.
+mw_ring_buffer *mwrb_create(int size);
+
+// Deletes a multi writer ring buffer.
+void mwrb_free(mw_ring_buffer *buffer);
+
+// Writes a single record from n sources to the ring buffer (if the ring buffer
+// has enough space). The varargs are pairs of type (const char*, int) as with
+// rb_write_to_buffer. Safe to be called from any number of threads.
+// Returns 0 on success.
+int mwrb_write_record(mw_ring_buffer *buffer, int n, ...);
+
+// Reads the next complete record into dest, which must be able to hold len
+// bytes. Only to be called from a single reader thread.
+// Returns the record length, 0 if there is no complete record to read or -1 if
+// the record is larger than len, in which case it is dropped.
+int mwrb_read_record(mw_ring_buffer *buffer, char *dest, int len);
+
 #endif
@@ -25,8 +25,9 @@ void libpd_set_concatenated_printhook(const t_libpd_printhook hook) {
 void libpd_print_concatenator(const char *s) {
   if (!libpd_concatenated_printhook) return;
 
-  static char concatenated_print_line[PRINT_LINE_SIZE];
-  static int len_line = 0;
+  // one line per thread, as instances may be processed on separate threads
+  static PERTHREAD char concatenated_print_line[PRINT_LINE_SIZE];
+  static PERTHREAD int len_line = 0;
   concatenated_print_line[len_line] = '\0';
 
   int len = (int) strlen(s);
@@ -14,6 +14,8 @@
 #include <string.h>
 
 #include "ringbuffer.h"
+#include "z_hooks.h"
+#include "s_stuff.h"
 
 t_libpd_printhook libpd_queued_printhook = NULL;
 t_libpd_banghook libpd_queued_banghook = NULL;
@@ -56,8 +58,46 @@ typedef struct _midi_params {
 #define S_MIDI_PARAMS sizeof(midi_params)
 #define S_ATOM sizeof(t_atom)
 
-static ring_buffer *pd_receive_buffer = NULL;
-static ring_buffer *midi_receive_buffer = NULL;
+
+// inbound events from host threads to pd
+typedef struct _send_params {
+  enum {
+    LIBPD_SEND_BANG, LIBPD_SEND_FLOAT, LIBPD_SEND_SYMBOL, LIBPD_SEND_LIST,
+    LIBPD_SEND_MESSAGE, LIBPD_SEND_NOTEON, LIBPD_SEND_CONTROLCHANGE,
+    LIBPD_SEND_PROGRAMCHANGE, LIBPD_SEND_PITCHBEND, LIBPD_SEND_AFTERTOUCH,
+    LIBPD_SEND_POLYAFTERTOUCH, LIBPD_SEND_MIDIBYTE, LIBPD_SEND_SYSEX,
+    LIBPD_SEND_SYSREALTIME
+  } type;
+  float x;
+  int argc;
+  int midi1;
+  int midi2;
+  int midi3;
+} send_params;
+
+#define S_SEND_PARAMS sizeof(send_params)
+#define SEND_MSG_SIZE (BUFFER_SIZE / 4)
+
+// the receiver name and message selector follow the params as null terminated
+// strings, then the list atoms, each an int type tag followed by either a
+// float or a null terminated symbol name padded to a multiple of 4 bytes
+#define S_SEND_TAG 4
+
+// the ringbuffers belong to the current pd instance so that several instances
+// can be processed on separate threads, NULL if the instance is not queued
+typedef struct _queued_stuff {
+  ring_buffer *pd_receive_buffer;
+  ring_buffer *midi_receive_buffer;
+  mw_ring_buffer *pd_send_buffer;
+} t_queued_stuff;
+
+#define QUEUED ((t_queued_stuff *)STUFF->st_impdata)
+
+// compound message under construction, one per host thread
+static PERTHREAD char send_msg[SEND_MSG_SIZE];
+static PERTHREAD int send_msg_len = 0;
+static PERTHREAD int send_msg_argc = 0;
+static PERTHREAD int send_msg_overflow = 0;
 
 static void receive_print(pd_params *p, char **buffer) {
   if (libpd_queued_printhook) {
@@ -102,53 +142,65 @@ static void receive_message(pd_params *p, char **buffer) {
 
 static void internal_printhook(const char *s) {
   static char padding[LIBPD_WORD_ALIGN];
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
   int len = (int) strlen(s) + 1; // remember terminating null char
   int rest = len % LIBPD_WORD_ALIGN;
   if (rest) rest = LIBPD_WORD_ALIGN - rest;
   int total = len + rest;
-  if (rb_available_to_write(pd_receive_buffer) >= S_PD_PARAMS + total) {
+  if (rb_available_to_write(q->pd_receive_buffer) >= S_PD_PARAMS + total) {
     pd_params p = {LIBPD_PRINT, NULL, 0.0f, NULL, total};
-    rb_write_to_buffer(pd_receive_buffer, 3,
+    rb_write_to_buffer(q->pd_receive_buffer, 3,
         (const char *)&p, S_PD_PARAMS, s, len, padding, rest);
   }
 }
 
 static void internal_banghook(const char *src) {
-  if (rb_available_to_write(pd_receive_buffer) >= S_PD_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->pd_receive_buffer) >= S_PD_PARAMS) {
     pd_params p = {LIBPD_BANG, src, 0.0f, NULL, 0};
-    rb_write_to_buffer(pd_receive_buffer, 1, (const char *)&p, S_PD_PARAMS);
+    rb_write_to_buffer(q->pd_receive_buffer, 1, (const char *)&p, S_PD_PARAMS);
   }
 }
 
 static void internal_floathook(const char *src, float x) {
-  if (rb_available_to_write(pd_receive_buffer) >= S_PD_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->pd_receive_buffer) >= S_PD_PARAMS) {
     pd_params p = {LIBPD_FLOAT, src, x, NULL, 0};
-    rb_write_to_buffer(pd_receive_buffer, 1, (const char *)&p, S_PD_PARAMS);
+    rb_write_to_buffer(q->pd_receive_buffer, 1, (const char *)&p, S_PD_PARAMS);
   }
 }
 
 static void internal_symbolhook(const char *src, const char *sym) {
-  if (rb_available_to_write(pd_receive_buffer) >= S_PD_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->pd_receive_buffer) >= S_PD_PARAMS) {
     pd_params p = {LIBPD_SYMBOL, src, 0.0f, sym, 0};
-    rb_write_to_buffer(pd_receive_buffer, 1, (const char *)&p, S_PD_PARAMS);
+    rb_write_to_buffer(q->pd_receive_buffer, 1, (const char *)&p, S_PD_PARAMS);
   }
 }
 
 static void internal_listhook(const char *src, int argc, t_atom *argv) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
   int n = argc * S_ATOM;
-  if (rb_available_to_write(pd_receive_buffer) >= S_PD_PARAMS + n) {
+  if (rb_available_to_write(q->pd_receive_buffer) >= S_PD_PARAMS + n) {
     pd_params p = {LIBPD_LIST, src, 0.0f, NULL, argc};
-    rb_write_to_buffer(pd_receive_buffer, 2,
+    rb_write_to_buffer(q->pd_receive_buffer, 2,
         (const char *)&p, S_PD_PARAMS, (const char *)argv, n);
   }
 }
 
 static void internal_messagehook(const char *src, const char* sym,
     int argc, t_atom *argv) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
   int n = argc * S_ATOM;
-  if (rb_available_to_write(pd_receive_buffer) >= S_PD_PARAMS + n) {
+  if (rb_available_to_write(q->pd_receive_buffer) >= S_PD_PARAMS + n) {
     pd_params p = {LIBPD_MESSAGE, src, 0.0f, sym, argc};
-    rb_write_to_buffer(pd_receive_buffer, 2,
+    rb_write_to_buffer(q->pd_receive_buffer, 2,
         (const char *)&p, S_PD_PARAMS, (const char *)argv, n);
   }
 }
@@ -196,51 +248,170 @@ static void receive_midibyte(midi_params *p, char **buffer) {
 }
 
 static void internal_noteonhook(int channel, int pitch, int velocity) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_NOTEON, channel, pitch, velocity};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
   }
 }
 
 static void internal_controlchangehook(int channel, int controller, int value) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_CONTROLCHANGE, channel, controller, value};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
   }
 }
 
 static void internal_programchangehook(int channel, int value) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_PROGRAMCHANGE, channel, value, 0};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
   }
 }
 
 static void internal_pitchbendhook(int channel, int value) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_PITCHBEND, channel, value, 0};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
   }
 }
 
 static void internal_aftertouchhook(int channel, int value) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_AFTERTOUCH, channel, value, 0};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
   }
 }
 
 static void internal_polyaftertouchhook(int channel, int pitch, int value) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_POLYAFTERTOUCH, channel, pitch, value};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
   }
 }
 
 static void internal_midibytehook(int port, int byte) {
-  if (rb_available_to_write(midi_receive_buffer) >= S_MIDI_PARAMS) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  if (rb_available_to_write(q->midi_receive_buffer) >= S_MIDI_PARAMS) {
     midi_params p = {LIBPD_MIDIBYTE, port, byte, 0};
-    rb_write_to_buffer(midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+    rb_write_to_buffer(q->midi_receive_buffer, 1, (const char *)&p, S_MIDI_PARAMS);
+  }
+}
+
+static char *send_read_string(char **buffer) {
+  char *s = *buffer;
+  *buffer += strlen(s) + 1;
+  return s;
+}
+
+static int send_read_atoms(char **buffer, int argc, t_atom *argv) {
+  int i, tag;
+  for (i = 0; i < argc; i++) {
+    memcpy(&tag, *buffer, S_SEND_TAG);
+    *buffer += S_SEND_TAG;
+    if (tag == A_FLOAT) {
+      t_float f;
+      float x;
+      memcpy(&x, *buffer, sizeof(float));
+      *buffer += sizeof(float);
+      f = x;
+      SETFLOAT(argv + i, f);
+    }
+    else {
+      int len = (int) strlen(*buffer) + 1;
+      SETSYMBOL(argv + i, gensym(*buffer));
+      *buffer += (len + S_SEND_TAG - 1) / S_SEND_TAG * S_SEND_TAG;
+    }
+  }
+  return argc;
+}
+
+#define PORT (p->midi1 >> 4)
+#define CHANNEL (p->midi1 & 0x0f)
+
+// called with pd locked, so this is the only place the inbound events touch pd
+static void send_event(send_params *p, char *buffer) {
+  static PERTHREAD t_atom argv[SEND_MSG_SIZE / (2 * S_SEND_TAG)];
+  t_pd *dest = NULL;
+  char *recv, *sym;
+  if (p->type <= LIBPD_SEND_MESSAGE) {
+    recv = send_read_string(&buffer);
+    dest = gensym(recv)->s_thing;
+    if (!dest) return;
+  }
+  switch (p->type) {
+    case LIBPD_SEND_BANG:
+      pd_bang(dest);
+      break;
+    case LIBPD_SEND_FLOAT:
+      pd_float(dest, p->x);
+      break;
+    case LIBPD_SEND_SYMBOL:
+      pd_symbol(dest, gensym(send_read_string(&buffer)));
+      break;
+    case LIBPD_SEND_LIST:
+      pd_list(dest, &s_list, send_read_atoms(&buffer, p->argc, argv), argv);
+      break;
+    case LIBPD_SEND_MESSAGE:
+      sym = send_read_string(&buffer);
+      pd_typedmess(dest, gensym(sym),
+          send_read_atoms(&buffer, p->argc, argv), argv);
+      break;
+    case LIBPD_SEND_NOTEON:
+      inmidi_noteon(PORT, CHANNEL, p->midi2, p->midi3);
+      break;
+    case LIBPD_SEND_CONTROLCHANGE:
+      inmidi_controlchange(PORT, CHANNEL, p->midi2, p->midi3);
+      break;
+    case LIBPD_SEND_PROGRAMCHANGE:
+      inmidi_programchange(PORT, CHANNEL, p->midi2);
+      break;
+    case LIBPD_SEND_PITCHBEND:
+      inmidi_pitchbend(PORT, CHANNEL, p->midi2);
+      break;
+    case LIBPD_SEND_AFTERTOUCH:
+      inmidi_aftertouch(PORT, CHANNEL, p->midi2);
+      break;
+    case LIBPD_SEND_POLYAFTERTOUCH:
+      inmidi_polyaftertouch(PORT, CHANNEL, p->midi2, p->midi3);
+      break;
+    case LIBPD_SEND_MIDIBYTE:
+      inmidi_byte(p->midi1, p->midi2);
+      break;
+    case LIBPD_SEND_SYSEX:
+      inmidi_sysex(p->midi1, p->midi2);
+      break;
+    case LIBPD_SEND_SYSREALTIME:
+      inmidi_realtimein(p->midi1, p->midi2);
+      break;
+    default:
+      break;
+  }
+}
+
+#undef PORT
+#undef CHANNEL
+
+static void internal_tickhook(void) {
+  static PERTHREAD char temp_buffer[BUFFER_SIZE / 2];
+  t_queued_stuff *q = QUEUED;
+  send_params p;
+  if (!q) return;
+  while (mwrb_read_record(q->pd_send_buffer, temp_buffer, BUFFER_SIZE / 2) > 0) {
+    memcpy(&p, temp_buffer, S_SEND_PARAMS);
+    send_event(&p, temp_buffer + S_SEND_PARAMS);
   }
 }
 
@@ -297,10 +468,25 @@ void libpd_set_queued_midibytehook(const t_libpd_midibytehook hook) {
 }
 
 int libpd_queued_init() {
-  pd_receive_buffer = rb_create(BUFFER_SIZE);
-  if (!pd_receive_buffer) return -1;
-  midi_receive_buffer = rb_create(BUFFER_SIZE);
-  if (!midi_receive_buffer) return -1;
+  t_queued_stuff *q;
+  libpd_init(); // make sure the main instance exists
+  libpd_queued_release();
+  q = (t_queued_stuff *)calloc(1, sizeof(t_queued_stuff));
+  if (!q) return -1;
+  q->pd_receive_buffer = rb_create(BUFFER_SIZE);
+  q->midi_receive_buffer = rb_create(BUFFER_SIZE);
+  q->pd_send_buffer = mwrb_create(BUFFER_SIZE);
+  if (!q->pd_receive_buffer || !q->midi_receive_buffer ||
+      !q->pd_send_buffer) {
+    if (q->pd_receive_buffer) rb_free(q->pd_receive_buffer);
+    if (q->midi_receive_buffer) rb_free(q->midi_receive_buffer);
+    if (q->pd_send_buffer) mwrb_free(q->pd_send_buffer);
+    free(q);
+    return -1;
+  }
+  // only publish the ringbuffers once they all exist, the hooks and
+  // libpd_queued_* functions use them whenever st_impdata is set
+  STUFF->st_impdata = q;
 
   libpd_set_printhook(internal_printhook);
   libpd_set_banghook(internal_banghook);
@@ -317,20 +503,30 @@ int libpd_queued_init() {
   libpd_set_polyaftertouchhook(internal_polyaftertouchhook);
   libpd_set_midibytehook(internal_midibytehook);
 
-  libpd_init();
+  libpd_tickhook = internal_tickhook;
+
   return 0;
 }
 
+// the hooks stay set as other instances may still be queued,
+// they do nothing for an instance without ringbuffers
 void libpd_queued_release() {
-  rb_free(pd_receive_buffer);
-  rb_free(midi_receive_buffer);
+  t_queued_stuff *q;
+  if (!pd_this->pd_stuff || !(q = QUEUED)) return;
+  STUFF->st_impdata = NULL;
+  if (q->pd_receive_buffer) rb_free(q->pd_receive_buffer);
+  if (q->midi_receive_buffer) rb_free(q->midi_receive_buffer);
+  if (q->pd_send_buffer) mwrb_free(q->pd_send_buffer);
+  free(q);
 }
 
 void libpd_queued_receive_pd_messages() {
-  size_t available = rb_available_to_read(pd_receive_buffer);
+  static PERTHREAD char temp_buffer[BUFFER_SIZE];
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  size_t available = rb_available_to_read(q->pd_receive_buffer);
   if (!available) return;
-  static char temp_buffer[BUFFER_SIZE];
-  rb_read_from_buffer(pd_receive_buffer, temp_buffer, (int) available);
+  rb_read_from_buffer(q->pd_receive_buffer, temp_buffer, (int) available);
   char *end = temp_buffer + available;
   char *buffer = temp_buffer;
   while (buffer < end) {
@@ -368,10 +564,12 @@ void libpd_queued_receive_pd_messages() {
 }
 
 void libpd_queued_receive_midi_messages() {
-  size_t available = rb_available_to_read(midi_receive_buffer);
+  static PERTHREAD char temp_buffer[BUFFER_SIZE];
+  t_queued_stuff *q = QUEUED;
+  if (!q) return;
+  size_t available = rb_available_to_read(q->midi_receive_buffer);
   if (!available) return;
-  static char temp_buffer[BUFFER_SIZE];
-  rb_read_from_buffer(midi_receive_buffer, temp_buffer, (int) available);
+  rb_read_from_buffer(q->midi_receive_buffer, temp_buffer, (int) available);
   char *end = temp_buffer + available;
   char *buffer = temp_buffer;
   while (buffer < end) {
@@ -411,3 +609,146 @@ void libpd_queued_receive_midi_messages() {
     }
   }
 }
+
+static int send_write(send_params *p, const char *recv, const char *sym,
+    const char *atoms, int n) {
+  t_queued_stuff *q = QUEUED;
+  if (!q) return -1;
+  int r = recv ? (int) strlen(recv) + 1 : 0;
+  int s = sym ? (int) strlen(sym) + 1 : 0;
+  return mwrb_write_record(q->pd_send_buffer, 4, (const char *)p, S_SEND_PARAMS,
+      recv, r, sym, s, atoms, n);
+}
+
+int libpd_queued_bang(const char *recv) {
+  send_params p = {LIBPD_SEND_BANG, 0.0f, 0, 0, 0, 0};
+  return send_write(&p, recv, NULL, NULL, 0);
+}
+
+int libpd_queued_float(const char *recv, float x) {
+  send_params p = {LIBPD_SEND_FLOAT, x, 0, 0, 0, 0};
+  return send_write(&p, recv, NULL, NULL, 0);
+}
+
+int libpd_queued_symbol(const char *recv, const char *sym) {
+  send_params p = {LIBPD_SEND_SYMBOL, 0.0f, 0, 0, 0, 0};
+  return send_write(&p, recv, sym, NULL, 0);
+}
+
+int libpd_queued_start_message(int max_length) {
+  send_msg_len = 0;
+  send_msg_argc = 0;
+  send_msg_overflow = 0;
+  return (max_length * 2 * S_SEND_TAG > SEND_MSG_SIZE) ? -1 : 0;
+}
+
+void libpd_queued_add_float(float x) {
+  if (send_msg_len + S_SEND_TAG + (int) sizeof(float) > SEND_MSG_SIZE) {
+    send_msg_overflow = 1;
+    return;
+  }
+  int tag = A_FLOAT;
+  memcpy(send_msg + send_msg_len, &tag, S_SEND_TAG);
+  memcpy(send_msg + send_msg_len + S_SEND_TAG, &x, sizeof(float));
+  send_msg_len += S_SEND_TAG + sizeof(float);
+  send_msg_argc++;
+}
+
+void libpd_queued_add_symbol(const char *sym) {
+  int len = (int) strlen(sym) + 1;
+  int padded = (len + S_SEND_TAG - 1) / S_SEND_TAG * S_SEND_TAG;
+  if (send_msg_len + S_SEND_TAG + padded > SEND_MSG_SIZE) {
+    send_msg_overflow = 1;
+    return;
+  }
+  int tag = A_SYMBOL;
+  memcpy(send_msg + send_msg_len, &tag, S_SEND_TAG);
+  memcpy(send_msg + send_msg_len + S_SEND_TAG, sym, len);
+  memset(send_msg + send_msg_len + S_SEND_TAG + len, 0, padded - len);
+  send_msg_len += S_SEND_TAG + padded;
+  send_msg_argc++;
+}
+
+int libpd_queued_finish_list(const char *recv) {
+  if (send_msg_overflow) return -1;
+  send_params p = {LIBPD_SEND_LIST, 0.0f, send_msg_argc, 0, 0, 0};
+  return send_write(&p, recv, NULL, send_msg, send_msg_len);
+}
+
+int libpd_queued_finish_message(const char *recv, const char *msg) {
+  if (send_msg_overflow) return -1;
+  send_params p = {LIBPD_SEND_MESSAGE, 0.0f, send_msg_argc, 0, 0, 0};
+  return send_write(&p, recv, msg, send_msg, send_msg_len);
+}
+
+#define CHECK_CHANNEL if (channel < 0) return -1;
+#define CHECK_PORT if (port < 0 || port > 0x0fff) return -1;
+#define CHECK_RANGE_7BIT(v) if (v < 0 || v > 0x7f) return -1;
+#define CHECK_RANGE_8BIT(v) if (v < 0 || v > 0xff) return -1;
+
+int libpd_queued_noteon(int channel, int pitch, int velocity) {
+  CHECK_CHANNEL
+  CHECK_RANGE_7BIT(pitch)
+  CHECK_RANGE_7BIT(velocity)
+  send_params p = {LIBPD_SEND_NOTEON, 0.0f, 0, channel, pitch, velocity};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_controlchange(int channel, int controller, int value) {
+  CHECK_CHANNEL
+  CHECK_RANGE_7BIT(controller)
+  CHECK_RANGE_7BIT(value)
+  send_params p = {LIBPD_SEND_CONTROLCHANGE, 0.0f, 0, channel, controller, value};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_programchange(int channel, int value) {
+  CHECK_CHANNEL
+  CHECK_RANGE_7BIT(value)
+  send_params p = {LIBPD_SEND_PROGRAMCHANGE, 0.0f, 0, channel, value, 0};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_pitchbend(int channel, int value) {
+  CHECK_CHANNEL
+  if (value < -8192 || value > 8191) return -1;
+  // centered at 8192 for consistency with libpd_pitchbend()
+  send_params p = {LIBPD_SEND_PITCHBEND, 0.0f, 0, channel, value + 8192, 0};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_aftertouch(int channel, int value) {
+  CHECK_CHANNEL
+  CHECK_RANGE_7BIT(value)
+  send_params p = {LIBPD_SEND_AFTERTOUCH, 0.0f, 0, channel, value, 0};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_polyaftertouch(int channel, int pitch, int value) {
+  CHECK_CHANNEL
+  CHECK_RANGE_7BIT(pitch)
+  CHECK_RANGE_7BIT(value)
+  send_params p = {LIBPD_SEND_POLYAFTERTOUCH, 0.0f, 0, channel, pitch, value};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_midibyte(int port, int byte) {
+  CHECK_PORT
+  CHECK_RANGE_8BIT(byte)
+  send_params p = {LIBPD_SEND_MIDIBYTE, 0.0f, 0, port, byte, 0};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_sysex(int port, int byte) {
+  CHECK_PORT
+  CHECK_RANGE_8BIT(byte)
+  send_params p = {LIBPD_SEND_SYSEX, 0.0f, 0, port, byte, 0};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
+
+int libpd_queued_sysrealtime(int port, int byte) {
+  CHECK_PORT
+  CHECK_RANGE_8BIT(byte)
+  send_params p = {LIBPD_SEND_SYSREALTIME, 0.0f, 0, port, byte, 0};
+  return send_write(&p, NULL, NULL, NULL, 0);
+}
@@ -33,11 +33,50 @@ EXTERN void libpd_set_queued_aftertouchhook(const t_libpd_aftertouchhook hook);
 EXTERN void libpd_set_queued_polyaftertouchhook(const t_libpd_polyaftertouchhook hook);
 EXTERN void libpd_set_queued_midibytehook(const t_libpd_midibytehook hook);
 
+/// the ringbuffers belong to the current instance (see libpd_set_instance()),
+/// init & release them and receive from them with that instance set
 EXTERN int libpd_queued_init();
 EXTERN void libpd_queued_release();
 EXTERN void libpd_queued_receive_pd_messages();
 EXTERN void libpd_queued_receive_midi_messages();
 
+/// \section Inbound Queue
+///
+/// queued counterparts of the libpd send functions: instead of locking pd,
+/// events are written to an inbound ringbuffer which is drained at the start
+/// of each processed tick, so any number of host threads can send without
+/// ever stalling the audio thread
+///
+/// all return 0 on success and -1 if the queue is full, libpd_queued_init()
+/// has not been called, or the midi values are out of range; unknown
+/// receivers are silently ignored when the queue is drained
+///
+/// note: events are only delivered while libpd_process_*() is being called
+
+EXTERN int libpd_queued_bang(const char *recv);
+EXTERN int libpd_queued_float(const char *recv, float x);
+EXTERN int libpd_queued_symbol(const char *recv, const char *sym);
+
+/// compound messages are assembled in one buffer, as with
+/// libpd_start_message(): it is kept per thread only when libpd is built
+/// with PDINSTANCE and PDTHREADS, otherwise it is shared by the whole
+/// process and only one thread at a time may build a message
+EXTERN int libpd_queued_start_message(int max_length);
+EXTERN void libpd_queued_add_float(float x);
+EXTERN void libpd_queued_add_symbol(const char *sym);
+EXTERN int libpd_queued_finish_list(const char *recv);
+EXTERN int libpd_queued_finish_message(const char *recv, const char *msg);
+
+EXTERN int libpd_queued_noteon(int channel, int pitch, int velocity);
+EXTERN int libpd_queued_controlchange(int channel, int controller, int value);
+EXTERN int libpd_queued_programchange(int channel, int value);
+EXTERN int libpd_queued_pitchbend(int channel, int value);
+EXTERN int libpd_queued_aftertouch(int channel, int value);
+EXTERN int libpd_queued_polyaftertouch(int channel, int pitch, int value);
+EXTERN int libpd_queued_midibyte(int port, int byte);
+EXTERN int libpd_queued_sysex(int port, int byte);
+EXTERN int libpd_queued_sysrealtime(int port, int byte);
+
 #ifdef __cplusplus
 }
 #endif
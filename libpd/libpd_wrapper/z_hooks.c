@@ -23,3 +23,5 @@ t_libpd_pitchbendhook libpd_pitchbendhook = NULL;
 t_libpd_aftertouchhook libpd_aftertouchhook = NULL;
 t_libpd_polyaftertouchhook libpd_polyaftertouchhook = NULL;
 t_libpd_midibytehook libpd_midibytehook = NULL;
+
+t_libpd_tickhook libpd_tickhook = NULL;
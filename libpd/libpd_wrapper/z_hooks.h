@@ -32,4 +32,9 @@ extern t_libpd_aftertouchhook libpd_aftertouchhook;
 extern t_libpd_polyaftertouchhook libpd_polyaftertouchhook;
 extern t_libpd_midibytehook libpd_midibytehook;
 
+// called with pd locked at the start of every processed tick,
+// set by z_queued.c to drain the inbound message queue
+typedef void (*t_libpd_tickhook)(void);
+extern t_libpd_tickhook libpd_tickhook;
+
 #endif
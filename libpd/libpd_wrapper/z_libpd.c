@@ -21,6 +21,7 @@
 #include "z_hooks.h"
 #include "s_stuff.h"
 #include "m_imp.h"
+#include "g_canvas.h"
 #include "g_all_guis.h"
 
 #if PD_MINOR_VERSION < 46
@@ -152,25 +153,29 @@ int libpd_init_audio(int inChans, int outChans, int sampleRate) {
   inch[0] = inChans;
   outch[0] = outChans;
   sys_lock();
+  pd_globallock(); // the audio settings are shared by all instances
   sys_set_audio_settings(1, indev, 1, inch,
          1, outdev, 1, outch, sampleRate, -1, 1, DEFDACBLKSIZE);
   sched_set_using_audio(SCHED_AUDIO_CALLBACK);
   sys_reopen_audio();
+  pd_globalunlock();
   sys_unlock();
   return 0;
 }
 
 int libpd_process_raw(const float *inBuffer, float *outBuffer) {
-  size_t n_in = STUFF->st_inchannels * DEFDACBLKSIZE;
-  size_t n_out = STUFF->st_outchannels * DEFDACBLKSIZE;
+  size_t n_in, n_out;
   t_sample *p;
   size_t i;
   sys_lock();
+  n_in = STUFF->st_inchannels * STUFF->st_schedblocksize;
+  n_out = STUFF->st_outchannels * STUFF->st_schedblocksize;
   sys_microsleep(0);
   for (p = STUFF->st_soundin, i = 0; i < n_in; i++) {
     *p++ = *inBuffer++;
   }
   memset(STUFF->st_soundout, 0, n_out * sizeof(t_sample));
+  if (libpd_tickhook) libpd_tickhook();
   SCHED_TICK(pd_this->pd_systime + STUFF->st_time_per_dsp_tick);
   for (p = STUFF->st_soundout, i = 0; i < n_out; i++) {
     *outBuffer++ = *p++;
@@ -182,28 +187,41 @@ int libpd_process_raw(const float *inBuffer, float *outBuffer) {
 static const t_sample sample_to_short = SHRT_MAX,
                    short_to_sample = 1.0 / (t_sample) SHRT_MAX;
 
-#define PROCESS(_x, _y) \
+#define PROCESS_TICKS(_x, _y) \
   int i, j, k; \
+  const int blocksize = STUFF->st_schedblocksize; \
   t_sample *p0, *p1; \
-  sys_lock(); \
   sys_microsleep(0); \
   for (i = 0; i < ticks; i++) { \
-    for (j = 0, p0 = STUFF->st_soundin; j < DEFDACBLKSIZE; j++, p0++) { \
-      for (k = 0, p1 = p0; k < STUFF->st_inchannels; k++, p1 += DEFDACBLKSIZE) \
+    for (j = 0, p0 = STUFF->st_soundin; j < blocksize; j++, p0++) { \
+      for (k = 0, p1 = p0; k < STUFF->st_inchannels; k++, p1 += blocksize) \
         { \
         *p1 = *inBuffer++ _x; \
       } \
     } \
     memset(STUFF->st_soundout, 0, \
-        STUFF->st_outchannels*DEFDACBLKSIZE*sizeof(t_sample)); \
+        STUFF->st_outchannels*blocksize*sizeof(t_sample)); \
+    if (libpd_tickhook) libpd_tickhook(); \
     SCHED_TICK(pd_this->pd_systime + STUFF->st_time_per_dsp_tick); \
-    for (j = 0, p0 = STUFF->st_soundout; j < DEFDACBLKSIZE; j++, p0++) { \
-      for (k = 0, p1 = p0; k < STUFF->st_outchannels; k++, p1 += DEFDACBLKSIZE) \
+    for (j = 0, p0 = STUFF->st_soundout; j < blocksize; j++, p0++) { \
+      for (k = 0, p1 = p0; k < STUFF->st_outchannels; k++, p1 += blocksize) \
         { \
         *outBuffer++ = *p1 _y; \
       } \
     } \
-  } \
+  }
+
+#define PROCESS(_x, _y) \
+  sys_lock(); \
+  { PROCESS_TICKS(_x, _y) } \
+  sys_unlock(); \
+  return 0;
+
+// same as PROCESS, but returns 1 without touching the buffers if another
+// thread currently holds the pd lock
+#define TRY_PROCESS(_x, _y) \
+  if (sys_trylock()) return 1; \
+  { PROCESS_TICKS(_x, _y) } \
   sys_unlock(); \
   return 0;
 
@@ -218,6 +236,132 @@ int libpd_process_float(const int ticks, const float *inBuffer, float *outBuffer
 int libpd_process_double(const int ticks, const double *inBuffer, double *outBuffer) {
   PROCESS(,)
 }
+
+int libpd_try_process_float(const int ticks,
+    const float *inBuffer, float *outBuffer) {
+  TRY_PROCESS(,)
+}
+
+// copies whole channel blocks between the host's per-channel buffers and
+// st_soundin/st_soundout, which are already planar; a null channel pointer
+// (or a null inBuffer) reads as silence, a null output channel is skipped
+#define PROCESS_PLANAR_TICKS \
+  int i, k, n; \
+  const int blocksize = STUFF->st_schedblocksize; \
+  const int inchans = STUFF->st_inchannels, outchans = STUFF->st_outchannels; \
+  t_sample *p; \
+  sys_microsleep(0); \
+  for (i = 0; i < ticks; i++) { \
+    for (k = 0, p = STUFF->st_soundin; k < inchans; \
+        k++, p += blocksize) { \
+      const float *src = inBuffer ? inBuffer[k] : NULL; \
+      if (!src) \
+        memset(p, 0, blocksize * sizeof(t_sample)); \
+      else if (sizeof(t_sample) == sizeof(float)) \
+        memcpy(p, src + i * blocksize, blocksize * sizeof(float)); \
+      else for (n = 0, src += i * blocksize; n < blocksize; n++) \
+        p[n] = src[n]; \
+    } \
+    memset(STUFF->st_soundout, 0, outchans*blocksize*sizeof(t_sample)); \
+    if (libpd_tickhook) libpd_tickhook(); \
+    SCHED_TICK(pd_this->pd_systime + STUFF->st_time_per_dsp_tick); \
+    for (k = 0, p = STUFF->st_soundout; k < outchans; \
+        k++, p += blocksize) { \
+      float *dest = outBuffer[k]; \
+      if (!dest) \
+        continue; \
+      if (sizeof(t_sample) == sizeof(float)) \
+        memcpy(dest + i * blocksize, p, blocksize * sizeof(float)); \
+      else for (n = 0, dest += i * blocksize; n < blocksize; n++) \
+        dest[n] = p[n]; \
+    } \
+  }
+
+int libpd_process_planar(const int ticks,
+    const float * const *inBuffer, float * const *outBuffer) {
+  sys_lock();
+  { PROCESS_PLANAR_TICKS }
+  sys_unlock();
+  return 0;
+}
+
+int libpd_try_process_planar(const int ticks,
+    const float * const *inBuffer, float * const *outBuffer) {
+  if (sys_trylock()) return 1;
+  { PROCESS_PLANAR_TICKS }
+  sys_unlock();
+  return 0;
+}
+
+long libpd_render_file(const char *outFile, const char *inFile,
+    double seconds, int bytesPerSample, double *realtimeFactor) {
+  t_sfstream *out, *in = NULL;
+  t_sample **outvecs, **invecs;
+  int inchans, outchans, blocksize, k, filechans, filesr;
+  long nframes, done = 0, n;
+  double starttime, elapsed;
+  if (realtimeFactor) *realtimeFactor = 0;
+  sys_lock();
+  inchans = STUFF->st_inchannels;
+  outchans = STUFF->st_outchannels;
+  blocksize = STUFF->st_schedblocksize;
+  nframes = (long)(seconds * STUFF->st_dacsr + 0.5);
+  if (outchans < 1 || nframes < 0) {
+    error("libpd_render_file: no output channels or negative length");
+    sys_unlock();
+    return -1;
+  }
+  if (inFile && *inFile) {
+    if (!(in = soundfile_openread(inFile, &filechans, &filesr))) {
+      sys_unlock();
+      return -1;
+    }
+    if (filesr != (int)STUFF->st_dacsr)
+      post("%s: sample rate %d differs from pd's %d, not resampling",
+        inFile, filesr, (int)STUFF->st_dacsr);
+  }
+  if (!(out = soundfile_openwrite(outFile, outchans,
+      (int)STUFF->st_dacsr, bytesPerSample))) {
+    if (in) soundfile_close(in);
+    sys_unlock();
+    return -1;
+  }
+
+  // the file streams read & write straight from the adc~/dac~ buffers
+  invecs = (t_sample **)getbytes((inchans + 1) * sizeof(t_sample *));
+  outvecs = (t_sample **)getbytes(outchans * sizeof(t_sample *));
+  for (k = 0; k < inchans; k++)
+    invecs[k] = STUFF->st_soundin + k * blocksize;
+  for (k = 0; k < outchans; k++)
+    outvecs[k] = STUFF->st_soundout + k * blocksize;
+  memset(STUFF->st_soundin, 0, inchans * blocksize * sizeof(t_sample));
+
+  // the lock is held for the whole render and there is no sys_microsleep(),
+  // so each tick only runs the scheduler and the DSP chain
+  starttime = sys_getrealtime();
+  while (done < nframes) {
+    if (in)
+      soundfile_readframes(in, invecs, inchans, blocksize);
+    memset(STUFF->st_soundout, 0, outchans * blocksize * sizeof(t_sample));
+    if (libpd_tickhook) libpd_tickhook();
+    SCHED_TICK(pd_this->pd_systime + STUFF->st_time_per_dsp_tick);
+    n = (nframes - done < blocksize ? nframes - done : blocksize);
+    n = soundfile_writeframes(out, outvecs, n);
+    done += n;
+    if (n < blocksize && done < nframes)
+      break;
+  }
+  elapsed = sys_getrealtime() - starttime;
+
+  soundfile_close(out);
+  if (in) soundfile_close(in);
+  freebytes(invecs, (inchans + 1) * sizeof(t_sample *));
+  freebytes(outvecs, outchans * sizeof(t_sample *));
+  if (realtimeFactor && elapsed > 0)
+    *realtimeFactor = (done / STUFF->st_dacsr) / elapsed;
+  sys_unlock();
+  return (done < nframes ? -1 : done);
+}
  
 #define GETARRAY \
   t_garray *garray = (t_garray *) pd_findbyclass(gensym(name), garray_class); \
@@ -232,25 +376,43 @@ int libpd_arraysize(const char *name) {
   return retval;
 }
 
-#define MEMCPY(_x, _y) \
-  GETARRAY \
-  if (n < 0 || offset < 0 || offset + n > garray_npoints(garray)) return -2; \
-  t_word *vec = ((t_word *) garray_vec(garray)) + offset; \
-  int i; \
-  for (i = 0; i < n; i++) _x = _y;
-
-int libpd_read_array(float *dest, const char *name, int offset, int n) {
+int libpd_array_lock(const char *name, t_float **vec, int *stride) {
+  int size;
   sys_lock();
-  MEMCPY(*dest++, (vec++)->w_float)
+  GETARRAY
+  if (!garray_getfloatvec(garray, &size, vec, stride)) {
+    sys_unlock();
+    return -1;
+  }
+  return size;
+}
+
+void libpd_array_unlock(void) {
   sys_unlock();
+}
+
+// packed arrays hold plain floats and are copied in one go, others hold
+// one t_word per point
+#define MEMCPY(_x, _y, _bulk) \
+  t_float *vec; \
+  int size, stride, i; \
+  if ((size = libpd_array_lock(name, &vec, &stride)) < 0) return -1; \
+  if (n < 0 || offset < 0 || offset + n > size) { \
+    sys_unlock(); \
+    return -2; \
+  } \
+  vec += offset * stride; \
+  if (stride == 1 && sizeof(t_float) == sizeof(float)) _bulk; \
+  else for (i = 0; i < n; i++, vec += stride) _x = _y; \
+  sys_unlock(); \
   return 0;
+
+int libpd_read_array(float *dest, const char *name, int offset, int n) {
+  MEMCPY(*dest++, *vec, memcpy(dest, vec, n * sizeof(float)))
 }
 
 int libpd_write_array(const char *name, int offset, const float *src, int n) {
-  sys_lock();
-  MEMCPY((vec++)->w_float, *src++)
-  sys_unlock();
-  return 0;
+  MEMCPY(*vec, *src++, memcpy(vec, src, n * sizeof(float)))
 }
 
 void libpd_set_float(t_atom *v, float x) {
@@ -427,7 +589,81 @@ int libpd_bang(const char *recv) {
 }
 
 int libpd_blocksize(void) {
-  return DEFDACBLKSIZE;
+  return STUFF->st_schedblocksize;
+}
+
+int libpd_set_blocksize(int blocksize) {
+  int ret;
+  sys_lock();
+  ret = sys_setschedblocksize(blocksize);
+  sys_unlock();
+  return ret;
+}
+
+void libpd_profile(int on) {
+  sys_lock();
+  dsp_setprofile(on);
+  sys_unlock();
+}
+
+int libpd_is_profiling(void) {
+  int ret;
+  sys_lock();
+  ret = dsp_getprofile();
+  sys_unlock();
+  return ret;
+}
+
+void libpd_profile_reset(void) {
+  sys_lock();
+  dsp_resetprofile();
+  sys_unlock();
+}
+
+static int libpd_profile_top(libpd_profile_entry *entries, int n,
+    int bycanvas) {
+  t_dspprofile *vec;
+  uint64_t ticks;
+  double tickus;
+  int count, i, j;
+  if (n <= 0) return 0;
+  vec = (t_dspprofile *)malloc(n * sizeof(t_dspprofile));
+  if (!vec) return 0;
+  sys_lock();
+  count = dsp_getprofiletop(vec, n, bycanvas, &ticks);
+  if (!ticks) count = 0;
+  tickus = 1e6 * STUFF->st_schedblocksize / STUFF->st_dacsr;
+  for (i = 0; i < count; i++) {
+    t_dspprofile *p = &vec[i];
+    libpd_profile_entry *e = &entries[i];
+    if (p->p_object) {
+      e->name = class_getname(pd_class(&p->p_object->ob_pd));
+      e->canvas = (p->p_canvas ? p->p_canvas->gl_name->s_name : "");
+      e->index = (p->p_canvas ?
+        canvas_getindex(p->p_canvas, &p->p_object->ob_g) : -1);
+    } else {
+      e->name = (p->p_canvas ? p->p_canvas->gl_name->s_name : "");
+      e->canvas = (p->p_canvas && p->p_canvas->gl_owner ?
+        p->p_canvas->gl_owner->gl_name->s_name : "");
+      e->index = -1;
+    }
+    e->time = 1e-3 * p->p_time / ticks;
+    e->load = e->time / tickus;
+    e->calls = (double)p->p_calls / ticks;
+    for (j = 0; j < LIBPD_PROFILE_BINS && j < DSP_PROFBINS; j++)
+      e->histogram[j] = p->p_hist[j];
+  }
+  sys_unlock();
+  free(vec);
+  return count;
+}
+
+int libpd_profile_objects(libpd_profile_entry *entries, int n) {
+  return libpd_profile_top(entries, n, 0);
+}
+
+int libpd_profile_canvases(libpd_profile_entry *entries, int n) {
+  return libpd_profile_top(entries, n, 1);
 }
 
 int libpd_exists(const char *sym) {
@@ -595,7 +831,9 @@ void libpd_set_instance(t_pdinstance *x) {
 
 void libpd_free_instance(t_pdinstance *x) {
 #ifdef PDINSTANCE
+  if (x == &pd_maininstance) return;
   pdinstance_free(x);
+  pd_setinstance(&pd_maininstance);
 #endif
 }
 
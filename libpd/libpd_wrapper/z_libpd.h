@@ -26,7 +26,16 @@ EXTERN void *libpd_openfile(const char *basename, const char *dirname);
 EXTERN void libpd_closefile(void *p);
 EXTERN int libpd_getdollarzero(void *p);
 
+/// number of samples per channel computed in each tick, which is also the
+/// top-level signal vector size seen by adc~ and dac~, default: 64
 EXTERN int libpd_blocksize(void);
+
+/// set the tick size of the current instance to a power of two from 1 to
+/// 4096, ie. 16 for low-latency monitoring or 1024 to cut the per-tick
+/// overhead of offline rendering; restarts DSP if it is running, and buffers
+/// passed to the process functions must then hold ticks * blocksize samples
+/// per channel, returns 0 on success or -1 for an invalid size
+EXTERN int libpd_set_blocksize(int blocksize);
 EXTERN int libpd_init_audio(int inChans, int outChans, int sampleRate);
 EXTERN int libpd_process_raw(const float *inBuffer, float *outBuffer);
 EXTERN int libpd_process_short(const int ticks,
@@ -36,11 +45,51 @@ EXTERN int libpd_process_float(const int ticks,
 EXTERN int libpd_process_double(const int ticks,
     const double *inBuffer, double *outBuffer);
 
+/// non-blocking variant of libpd_process_float for real-time callers:
+/// returns 1 without processing if pd is currently locked by another thread
+EXTERN int libpd_try_process_float(const int ticks,
+    const float *inBuffer, float *outBuffer);
+
+/// process non-interleaved float buffers: inBuffer and outBuffer hold one
+/// pointer per channel, each to ticks * libpd_blocksize() samples, which are
+/// copied block-wise to/from the adc~/dac~ buffers without interleaving;
+/// inBuffer or any of its channels may be NULL for silence, output channels
+/// that are NULL are skipped
+EXTERN int libpd_process_planar(const int ticks,
+    const float * const *inBuffer, float * const *outBuffer);
+
+/// non-blocking variant of libpd_process_planar, see libpd_try_process_float
+EXTERN int libpd_try_process_planar(const int ticks,
+    const float * const *inBuffer, float * const *outBuffer);
+
+/// render seconds of audio offline, faster than real time, to outFile
+///
+/// pd stays locked for the whole render and ticks back to back without
+/// polling, so DSP should already be on; each channel of inFile, which may be
+/// NULL, feeds the matching adc~ and is silent once the file ends
+///
+/// the output format follows the file extension as for [soundfiler] write
+/// with bytesPerSample 2, 3 or 4 (float); realtimeFactor, if not NULL, is set
+/// to the rendered duration divided by the time taken
+///
+/// returns the number of frames written or -1 if a file couldn't be opened or
+/// the output couldn't be fully written
+EXTERN long libpd_render_file(const char *outFile, const char *inFile,
+    double seconds, int bytesPerSample, double *realtimeFactor);
+
 EXTERN int libpd_arraysize(const char *name);
 // The parameters of the next two functions are inspired by memcpy.
 EXTERN int libpd_read_array(float *dest, const char *src, int offset, int n);
 EXTERN int libpd_write_array(const char *dest, int offset, const float *src, int n);
 
+/// zero-copy array access: locks pd and points vec at the array's storage,
+/// where element i is vec[i * stride]; stride is 1 for packed arrays
+/// returns the array size, or -1 if not found, in which case pd is unlocked
+/// otherwise pd stays locked, blocking audio processing, until
+/// libpd_array_unlock() is called, which must always follow
+EXTERN int libpd_array_lock(const char *name, t_float **vec, int *stride);
+EXTERN void libpd_array_unlock(void);
+
 EXTERN int libpd_bang(const char *recv);
 EXTERN int libpd_float(const char *recv, float x);
 EXTERN int libpd_symbol(const char *recv, const char *sym);
@@ -121,6 +170,47 @@ EXTERN void libpd_stop_gui(void);
 /// update and handle any GUI messages
 EXTERN void libpd_poll_gui(void);
 
+/// \section DSP Profiling
+
+/// number of duration bins in a libpd_profile_entry histogram
+#define LIBPD_PROFILE_BINS 24
+
+/// a line of the DSP profile, for an object or a canvas
+typedef struct _libpd_profile_entry {
+  const char *name;   ///< class name, or the canvas name for a canvas
+  const char *canvas; ///< name of the canvas the object is in
+  int index;          ///< object index in its canvas, -1 for a canvas
+  double time;        ///< average microseconds per tick
+  double load;        ///< time / duration of a tick, ie. 1 for 100% CPU
+  double calls;       ///< average perform routine calls per tick
+  /// perform routine calls by duration: bin n counts calls taking 2^n to
+  /// 2^(n+1) nanoseconds, the last bin also all calls taking longer
+  unsigned long long histogram[LIBPD_PROFILE_BINS];
+} libpd_profile_entry;
+
+/// turn DSP profiling on or off, same as sending "pd dsp-profile 0/1"
+/// while on, each perform routine is timed and its time charged to the
+/// object which added it to the DSP chain, so processing becomes slower
+/// the DSP graph is resorted, which starts the profile over, as does any
+/// later resorting, ie. after editing a patch
+EXTERN void libpd_profile(int on);
+
+/// returns 1 if DSP profiling is on, otherwise 0
+EXTERN int libpd_is_profiling(void);
+
+/// start the DSP profile over
+EXTERN void libpd_profile_reset(void);
+
+/// fill entries with the n objects which took the most time, most first
+/// returns the number of entries filled, 0 if profiling is off or
+/// no ticks were processed
+/// the name strings stay valid until the pd instance is freed
+EXTERN int libpd_profile_objects(libpd_profile_entry *entries, int n);
+
+/// like libpd_profile_objects for the n canvases (patches, subpatches and
+/// abstractions) which took the most time, including everything in them
+EXTERN int libpd_profile_canvases(libpd_profile_entry *entries, int n);
+
 /// \section Multiple Instances
 
 /// create a new pd instance
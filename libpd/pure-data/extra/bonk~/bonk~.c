@@ -200,6 +200,10 @@ typedef struct _bonk
     t_outlet *x_cookedout;
     t_clock *x_clock;
     t_canvas *x_canvas;     /* ptr to current canvas --fbar */
+    t_worker *x_worker;     /* nonzero in "async" mode */
+    struct _bonkjob *x_jobs;        /* BONK_MAXJOBS of them */
+    struct _bonkjob *x_freejobs;    /* those not given to the worker */
+    int x_nskipped;         /* windows dropped since last reported */
 #endif /* PD */
 #ifdef MSP
     t_pxobject x_obj;
@@ -245,6 +249,39 @@ typedef struct _bonk
     int x_hit;                  /* next "tick" called because of a hit, not a poll */
 } t_bonk;
 
+#ifdef PD
+/* In "async" mode the filterbank is run in a worker thread (see worker_new())
+instead of in the DSP routine.  Each window is copied into a job, along with
+what the clock would report for it if it's a hit (or if in "spew" mode), and
+comes back a tick or more later to be matched to the templates and output.
+Messages that change the settings or state first wait for the jobs still out,
+and in "debug" and "learn" modes the analysis is done right away as usual.
+Windows are dropped, with a complaint, if the worker falls BONK_MAXJOBS
+behind, since it can't be waited for in the DSP routine. */
+
+#define BONK_MAXJOBS 32
+
+typedef struct _bonkjob
+{
+    struct _bonkjob *j_next;    /* next unused job */
+    t_float *j_inbuf;           /* x_npoints for each input */
+    int j_hit;                  /* as for x_hit, or -1 if nothing to output */
+    t_float *j_powerout;        /* x_nfilters for each input */
+    t_float j_vel;
+    t_float j_temperature;
+} t_bonkjob;
+#endif /* PD */
+
+    /* in "async" mode, wait for the analyses still out before changing
+    anything they use */
+static void bonk_sync(t_bonk *x)
+{
+#ifdef PD
+    if (x->x_worker)
+        worker_sync(x->x_worker);
+#endif
+}
+
 #ifdef MSP
 static void *bonk_new(t_symbol *s, long ac, t_atom *av);
 static void bonk_tick(t_bonk *x);
@@ -480,22 +517,16 @@ static void bonk_donew(t_bonk *x, int npoints, int period, int nsig,
                 x->x_filterbank->b_refcount++;
 }
 
-static void bonk_tick(t_bonk *x)
+    /* find the power each filter will output, and their total ("velocity")
+    and centroid ("temperature"); a hit is checked against the debounce and
+    minimum velocities, and zero returned if it's to be ignored. */
+static int bonk_getpower(t_bonk *x, int hit, t_float *powerout,
+    t_float *velp, t_float *temperaturep)
 {
-    t_atom at[MAXNFILTERS], *ap, at2[3];
-    int i, j, k, n;
+    int i, j, ninsig = x->x_ninsig, nfilters = x->x_nfilters;
     t_hist *h;
     t_float *pp, vel = 0., temperature = 0.;
-    t_float *fp;
-    t_template *tp;
-    int nfit, ninsig = x->x_ninsig, ntemplate = x->x_ntemplate, nfilters = x->x_nfilters;
     t_insig *gp;
-#ifdef _MSC_VER
-    t_float powerout[MAXNFILTERS*MAXCHANNELS];
-#else
-    t_float *powerout = alloca(x->x_nfilters * x->x_ninsig * sizeof(*powerout));
-#endif
-    
     for (i = ninsig, pp = powerout, gp = x->x_insig; i--; gp++)
     {
         for (j = 0, h = gp->g_hist; j < nfilters; j++, h++, pp++)
@@ -509,104 +540,122 @@ static void bonk_tick(t_bonk *x)
     if (vel > 0) temperature /= vel;
     else temperature = 0;
     vel *= 0.5 / ninsig;        /* fudge factor */
-    if (x->x_hit)
+    *velp = vel;
+    *temperaturep = temperature;
+    if (hit)
     {
-        /* if hit nonzero it's a clock callback.  if in "learn" mode update the
-         template list; in any event match the hit to known templates. */
-        
         if (vel < x->x_debouncevel)
         {
             if (x->x_debug)
                 post("bounce cancelled: vel %f debounce %f",
                      vel, x->x_debouncevel);
-            return;
+            return (0);
         }
         if (vel < x->x_minvel)
         {
             if (x->x_debug)
                 post("low velocity cancelled: vel %f, minvel %f",
                      vel, x->x_minvel);
-            return;
+            return (0);
         }
         x->x_debouncevel = vel;
-        if (x->x_learn)
+    }
+    return (1);
+}
+
+    /* match a hit to known templates, first updating the template list if
+    in "learn" mode.  Returns the template number, or -2 if the hit is to
+    be ignored. */
+static int bonk_match(t_bonk *x, t_float *powerout)
+{
+    int i, j, k, nfit;
+    t_float *pp, *fp;
+    t_template *tp;
+    int ninsig = x->x_ninsig, ntemplate = x->x_ntemplate, nfilters = x->x_nfilters;
+    if (x->x_learn)
+    {
+        double lasttime = x->x_learndebounce;
+        double msec = clock_gettimesince(lasttime);
+        if ((!ntemplate) || (msec > 200))
         {
-            double lasttime = x->x_learndebounce;
-            double msec = clock_gettimesince(lasttime);
-            if ((!ntemplate) || (msec > 200))
+            int countup = x->x_learncount;
+            /* normalize to 100  */
+            t_float norm;
+            for (i = nfilters * ninsig, norm = 0, pp = powerout; i--; pp++)
+                norm += *pp * *pp;
+            if (norm < 1.0e-15) norm = 1.0e-15;
+            norm = 100. * qrsqrt(norm);
+            /* check if this is the first strike for a new template */
+            if (!countup)
             {
-                int countup = x->x_learncount;
-                /* normalize to 100  */
-                t_float norm;
-                for (i = nfilters * ninsig, norm = 0, pp = powerout; i--; pp++)
-                    norm += *pp * *pp;
-                if (norm < 1.0e-15) norm = 1.0e-15;
-                norm = 100. * qrsqrt(norm);
-                /* check if this is the first strike for a new template */
-                if (!countup)
-                {
-                    int oldn = ntemplate;
-                    x->x_ntemplate = ntemplate = oldn + ninsig;
-                    x->x_template = (t_template *)t_resizebytes(x->x_template,
-                        oldn * sizeof(x->x_template[0]),
-                            ntemplate * sizeof(x->x_template[0]));
-                    for (i = ninsig, pp = powerout; i--; oldn++)
-                        for (j = nfilters, fp = x->x_template[oldn].t_amp; j--;
-                             pp++, fp++)
-                                *fp = *pp * norm;
-                }
-                else
+                int oldn = ntemplate;
+                x->x_ntemplate = ntemplate = oldn + ninsig;
+                x->x_template = (t_template *)t_resizebytes(x->x_template,
+                    oldn * sizeof(x->x_template[0]),
+                        ntemplate * sizeof(x->x_template[0]));
+                for (i = ninsig, pp = powerout; i--; oldn++)
+                    for (j = nfilters, fp = x->x_template[oldn].t_amp; j--;
+                         pp++, fp++)
+                            *fp = *pp * norm;
+            }
+            else
+            {
+                int oldn = ntemplate - ninsig;
+                if (oldn < 0) post("bonk_tick bug");
+                for (i = ninsig, pp = powerout; i--; oldn++)
                 {
-                    int oldn = ntemplate - ninsig;
-                    if (oldn < 0) post("bonk_tick bug");
-                    for (i = ninsig, pp = powerout; i--; oldn++)
-                    {
-                        for (j = nfilters, fp = x->x_template[oldn].t_amp; j--;
-                             pp++, fp++)
-                            *fp = (countup * *fp + *pp * norm)
-                            /(countup + 1.0);
-                    }
+                    for (j = nfilters, fp = x->x_template[oldn].t_amp; j--;
+                         pp++, fp++)
+                        *fp = (countup * *fp + *pp * norm)
+                        /(countup + 1.0);
                 }
-                countup++;
-                if (countup == x->x_learn) countup = 0;
-                x->x_learncount = countup;
             }
-            else return;
+            countup++;
+            if (countup == x->x_learn) countup = 0;
+            x->x_learncount = countup;
         }
-        x->x_learndebounce = clock_getsystime();
-        if (ntemplate)
+        else return (-2);
+    }
+    x->x_learndebounce = clock_getsystime();
+    if (ntemplate)
+    {
+        t_float bestfit = -1e30;
+        int templatecount;
+        nfit = -1;
+        for (i = 0, templatecount = 0, tp = x->x_template; 
+             templatecount < ntemplate; i++)
         {
-            t_float bestfit = -1e30;
-            int templatecount;
-            nfit = -1;
-            for (i = 0, templatecount = 0, tp = x->x_template; 
-                 templatecount < ntemplate; i++)
+            t_float dotprod = 0;
+            for (k = 0, pp = powerout;
+                 k < ninsig && templatecount < ntemplate;
+                 k++, tp++, templatecount++)
             {
-                t_float dotprod = 0;
-                for (k = 0, pp = powerout;
-                     k < ninsig && templatecount < ntemplate;
-                     k++, tp++, templatecount++)
-                {
-                    for (j = nfilters, fp = tp->t_amp;
-                         j--; fp++, pp++)
-                    {
-                        if (*fp < 0 || *pp < 0) post("bonk_tick bug 2");
-                        dotprod += *fp * *pp;
-                    }
-                }
-                if (dotprod > bestfit)
+                for (j = nfilters, fp = tp->t_amp;
+                     j--; fp++, pp++)
                 {
-                    bestfit = dotprod;
-                    nfit = i;
+                    if (*fp < 0 || *pp < 0) post("bonk_tick bug 2");
+                    dotprod += *fp * *pp;
                 }
             }
-            if (nfit < 0) post("bonk_tick bug");
+            if (dotprod > bestfit)
+            {
+                bestfit = dotprod;
+                nfit = i;
+            }
         }
-        else nfit = 0;
+        if (nfit < 0) post("bonk_tick bug");
     }
-    else nfit = -1;     /* hit is zero; this is the "bang" method. */
-    
-    x->x_attacked = 1;
+    else nfit = 0;
+    return (nfit);
+}
+
+static void bonk_output(t_bonk *x, int nfit, t_float *powerout,
+    t_float vel, t_float temperature)
+{
+    t_atom at[MAXNFILTERS], *ap, at2[3];
+    int i, n, ninsig = x->x_ninsig, nfilters = x->x_nfilters;
+    t_float *pp;
+    t_insig *gp;
     if (x->x_debug)
         post("bonk out: number %d, vel %f, temperature %f",
             nfit, vel, temperature);
@@ -631,9 +680,36 @@ static void bonk_tick(t_bonk *x)
     }
 }
 
-static void bonk_doit(t_bonk *x)
+static void bonk_tick(t_bonk *x)
 {
-    int i, j, ch, n;
+    t_float vel, temperature;
+    int nfit;
+#ifdef _MSC_VER
+    t_float powerout[MAXNFILTERS*MAXCHANNELS];
+#else
+    t_float *powerout = alloca(x->x_nfilters * x->x_ninsig * sizeof(*powerout));
+#endif
+    
+    if (!bonk_getpower(x, x->x_hit, powerout, &vel, &temperature))
+        return;
+        /* if hit nonzero it's a clock callback; otherwise it's the
+        "bang" method. */
+    if (x->x_hit)
+    {
+        if ((nfit = bonk_match(x, powerout)) < -1)
+            return;
+    }
+    else nfit = -1;
+    x->x_attacked = 1;
+    bonk_output(x, nfit, powerout, vel, temperature);
+}
+
+    /* run the filterbank on a window (one buffer per input) and update the
+    masks and attack state.  Returns 1 if there's a hit to report, 0 if in
+    "spew" mode, and -1 otherwise; h_outpower then holds what to report. */
+static int bonk_analyze(t_bonk *x, t_float **inbufs)
+{
+    int i, j, ch, n, hit = -1;
     t_filterkernel *k;
     t_hist *h;
     t_float growth = 0, *fp1, *fp3, *fp4, hithresh, lothresh;
@@ -657,7 +733,7 @@ static void bonk_doit(t_bonk *x)
              i < nfilters; i++, k++, h++)
         {
             t_float power = 0, maskpow = h->h_mask[maskphase];
-            t_float *inbuf= gp->g_inbuf + k->k_skippoints;
+            t_float *inbuf= inbufs[ch] + k->k_skippoints;
             int countup = h->h_countup;
             int filterpoints = k->k_filterpoints;
             /* if the user asked for more filters that fit under the
@@ -718,8 +794,7 @@ static void bonk_doit(t_bonk *x)
                 for (ch = 0, gp = x->x_insig; ch < ninsig; ch++, gp++)
                     for (i = nfilters, h = gp->g_hist; i--; h++)
                         h->h_outpower = h->h_mask[nextphase];
-                x->x_hit = 1;
-                clock_delay(x->x_clock, 0);
+                hit = 1;
             }
         }
         if (growth < x->x_lothresh)
@@ -742,12 +817,121 @@ static void bonk_doit(t_bonk *x)
         for (ch = 0, gp = x->x_insig; ch < ninsig; ch++, gp++)
             for (i = nfilters, h = gp->g_hist; i--; h++)
                 h->h_outpower = h->h_power;
-        x->x_hit = 0;
-        clock_delay(x->x_clock, 0);
+        hit = 0;
     }
     x->x_debouncevel *= x->x_debouncedecay;
+    return (hit);
+}
+
+static void bonk_doit(t_bonk *x)
+{
+    t_float *inbufs[MAXCHANNELS];
+    int i, hit;
+    for (i = 0; i < x->x_ninsig; i++)
+        inbufs[i] = x->x_insig[i].g_inbuf;
+    if ((hit = bonk_analyze(x, inbufs)) >= 0)
+    {
+        x->x_hit = hit;
+        clock_delay(x->x_clock, 0);
+    }
+}
+
+#ifdef PD
+static void bonk_freejobs(t_bonk *x)
+{
+    int i, size = x->x_ninsig * x->x_npoints, npower =
+        x->x_ninsig * x->x_nfilters;
+    if (!x->x_worker)
+        return;
+    worker_free(x->x_worker);
+    for (i = 0; i < BONK_MAXJOBS; i++)
+    {
+        freebytes(x->x_jobs[i].j_inbuf, size * sizeof(t_float));
+        freebytes(x->x_jobs[i].j_powerout, npower * sizeof(t_float));
+    }
+    freebytes(x->x_jobs, BONK_MAXJOBS * sizeof(*x->x_jobs));
+    x->x_worker = 0;
+    x->x_jobs = x->x_freejobs = 0;
+}
+
+    /* these two are called by the worker, in its thread and then in Pd's */
+static void bonk_work(t_bonk *x, t_bonkjob *j)
+{
+    t_float *inbufs[MAXCHANNELS];
+    int i;
+    for (i = 0; i < x->x_ninsig; i++)
+        inbufs[i] = j->j_inbuf + i * x->x_npoints;
+    j->j_hit = bonk_analyze(x, inbufs);
+    if (j->j_hit >= 0)
+    {
+        if (bonk_getpower(x, j->j_hit, j->j_powerout, &j->j_vel,
+            &j->j_temperature))
+                x->x_attacked = 1;
+        else j->j_hit = -1;
+    }
 }
 
+static void bonk_done(t_bonk *x, t_bonkjob *j)
+{
+    int nfit;
+    if (x->x_nskipped)
+    {
+        pd_error(x, "bonk~: analysis falling behind; skipped %d windows",
+            x->x_nskipped);
+        x->x_nskipped = 0;
+    }
+    if (j->j_hit >= 0 &&
+        (nfit = (j->j_hit ? bonk_match(x, j->j_powerout) : -1)) >= -1)
+            bonk_output(x, nfit, j->j_powerout, j->j_vel, j->j_temperature);
+    j->j_next = x->x_freejobs;
+    x->x_freejobs = j;
+}
+
+    /* hand the input buffers to the worker; called from the DSP routine */
+static void bonk_submit(t_bonk *x)
+{
+    t_bonkjob *j = x->x_freejobs;
+    int i;
+    if (!j)
+    {
+        x->x_nskipped++;
+        return;
+    }
+    x->x_freejobs = j->j_next;
+    for (i = 0; i < x->x_ninsig; i++)
+        memcpy(j->j_inbuf + i * x->x_npoints, x->x_insig[i].g_inbuf,
+            x->x_npoints * sizeof(t_float));
+    worker_submit(x->x_worker, j);
+}
+
+static void bonk_async(t_bonk *x, t_floatarg f)
+{
+    if (f != 0 && !x->x_worker)
+    {
+        int i, size = x->x_ninsig * x->x_npoints, npower =
+            x->x_ninsig * x->x_nfilters;
+        x->x_jobs = (t_bonkjob *)getbytes(BONK_MAXJOBS * sizeof(*x->x_jobs));
+        for (i = 0; i < BONK_MAXJOBS; i++)
+        {
+            x->x_jobs[i].j_next = (i < BONK_MAXJOBS - 1 ?
+                &x->x_jobs[i+1] : 0);
+            x->x_jobs[i].j_inbuf = (t_float *)getbytes(size * sizeof(t_float));
+            x->x_jobs[i].j_powerout =
+                (t_float *)getbytes(npower * sizeof(t_float));
+        }
+        x->x_freejobs = x->x_jobs;
+        x->x_nskipped = 0;
+        x->x_worker = worker_new(x, (t_workmethod)bonk_work,
+            (t_workmethod)bonk_done, BONK_MAXJOBS);
+    }
+    else if (f == 0 && x->x_worker)
+    {
+        worker_sync(x->x_worker);
+        bonk_freejobs(x);
+    }
+}
+#endif /* PD */
+
 static void bonk_perform_generic(t_bonk *x, int n) {
     int onset = 0;
     if (x->x_countdown >= n)
@@ -778,6 +962,13 @@ static void bonk_perform_generic(t_bonk *x, int n) {
             x->x_infill = infill;
             if (infill == x->x_npoints)
             {
+#ifdef PD
+                    /* "debug" and "learn" wait for the worker, so
+                    these can be done here */
+                if (x->x_worker && !x->x_debug && !x->x_learn)
+                    bonk_submit(x);
+                else
+#endif
                 bonk_doit(x);
                 
                 /* shift or clear the input buffer and update counters */
@@ -825,6 +1016,7 @@ static void bonk_dsp(t_bonk *x, t_signal **sp)
 
 static void bonk_thresh(t_bonk *x, t_floatarg f1, t_floatarg f2)
 {
+    bonk_sync(x);
     if (f1 > f2)
         post("bonk: warning: low threshold greater than hi threshold");
     x->x_lothresh = (f1 <= 0 ? 0.0001 : f1);
@@ -834,6 +1026,7 @@ static void bonk_thresh(t_bonk *x, t_floatarg f1, t_floatarg f2)
 #ifdef PD
 static void bonk_mask(t_bonk *x, t_floatarg f1, t_floatarg f2)
 {
+    bonk_sync(x);
     int ticks = f1;
     if (ticks < 0) ticks = 0;
     if (f2 < 0) f2 = 0;
@@ -844,6 +1037,7 @@ static void bonk_mask(t_bonk *x, t_floatarg f1, t_floatarg f2)
 
 static void bonk_debounce(t_bonk *x, t_floatarg f1)
 {
+    bonk_sync(x);
     if (f1 < 0) f1 = 0;
     else if (f1 > 1) f1 = 1;
     x->x_debouncedecay = f1;
@@ -851,27 +1045,32 @@ static void bonk_debounce(t_bonk *x, t_floatarg f1)
 
 static void bonk_minvel(t_bonk *x, t_floatarg f)
 {
+    bonk_sync(x);
     if (f < 0) f = 0; 
     x->x_minvel = f;
 }
 
 static void bonk_debug(t_bonk *x, t_floatarg f)
 {
+    bonk_sync(x);
     x->x_debug = (f != 0);
 }
 
 static void bonk_spew(t_bonk *x, t_floatarg f)
 {
+    bonk_sync(x);
     x->x_spew = (f != 0);
 }
 
 static void bonk_useloudness(t_bonk *x, t_floatarg f)
 {
+    bonk_sync(x);
     x->x_useloudness = (f != 0);
 }
 
 static void bonk_attackbins(t_bonk *x, t_floatarg f)
 {
+    bonk_sync(x);
     if (f < 1)
         f = 1;
     else if (f > MASKHIST)
@@ -882,6 +1081,7 @@ static void bonk_attackbins(t_bonk *x, t_floatarg f)
 static void bonk_learn(t_bonk *x, t_floatarg f)
 {
     int n = f;
+    bonk_sync(x);
     if (n < 0) n = 0;
     if (n)
     {
@@ -897,6 +1097,7 @@ static void bonk_learn(t_bonk *x, t_floatarg f)
 static void bonk_print(t_bonk *x, t_floatarg f)
 {
     int i;
+    bonk_sync(x);
     post("thresh %f %f", x->x_lothresh, x->x_hithresh);
     post("mask %d %f", x->x_masktime, x->x_maskdecay);
     post("attack-frames %d", x->x_attackbins);
@@ -972,6 +1173,7 @@ static void bonk_bang(t_bonk *x)
 {
     int i, ch;
     t_insig *gp;
+    bonk_sync(x);
     x->x_hit = 0;
     for (ch = 0, gp = x->x_insig; ch < x->x_ninsig; ch++, gp++)
     {
@@ -1229,6 +1431,10 @@ static void bonk_free(t_bonk *x)
     
     int i, ninsig = x->x_ninsig;
     t_insig *gp = x->x_insig;
+#ifdef PD
+        /* first, so that no analysis is still using the filter state */
+    bonk_freejobs(x);
+#endif
 #ifdef MSP
     dsp_free((t_pxobject *)x);
 #endif
@@ -1248,7 +1454,7 @@ static void *bonk_new(t_symbol *s, int argc, t_atom *argv)
 {
     t_bonk *x = (t_bonk *)pd_new(bonk_class);
     int nsig = 1, period = DEFPERIOD, npts = DEFNPOINTS,
-        nfilters = DEFNFILTERS, j;
+        nfilters = DEFNFILTERS, async = 0, j;
     t_float halftones = DEFHALFTONES, overlap = DEFOVERLAP,
         firstbin = DEFFIRSTBIN, minbandwidth = DEFMINBANDWIDTH;
     t_insig *g;
@@ -1308,12 +1514,17 @@ static void *bonk_new(t_symbol *s, int argc, t_atom *argv)
             x->x_spew = (atom_getfloatarg(1, argc, argv) != 0);
             argc -= 2; argv += 2;
         }
+        else if (!strcmp(firstarg->s_name, "-async"))
+        {
+            async = 1;
+            argc--; argv++;
+        }
         else
         {
             pd_error(x,
 "usage is: bonk [-npts #] [-hop #] [-nsigs #] [-nfilters #] [-halftones #]"); 
             post(
-"... [-overlap #] [-firstbin #] [-spew #]");
+"... [-overlap #] [-firstbin #] [-spew #] [-async]");
             argc = 0;
         }
     }
@@ -1345,6 +1556,8 @@ static void *bonk_new(t_symbol *s, int argc, t_atom *argv)
     x->x_cookedout = outlet_new(&x->x_obj, gensym("list"));
     bonk_donew(x, npts, period, nsig, nfilters, halftones, overlap,
         firstbin, minbandwidth, sys_getsr());
+    if (async)
+        bonk_async(x, 1);
     return (x);
 }
 
@@ -1382,6 +1595,8 @@ void bonk_tilde_setup(void)
         gensym("read"), A_SYMBOL, 0);
     class_addmethod(bonk_class, (t_method)bonk_write,
         gensym("write"), A_SYMBOL, 0);
+    class_addmethod(bonk_class, (t_method)bonk_async,
+        gensym("async"), A_FLOAT, 0);
     post("bonk version 1.5");
 }
 #endif
@@ -99,6 +99,7 @@ static fts_symbol_t *dsp_symbol = 0;
 
 #ifdef PD
 #include "m_pd.h"
+#include <string.h>
 #endif /* PD */
 
 #ifdef MSP
@@ -256,6 +257,10 @@ typedef struct sigfiddle                    /* instance struct */
 #ifdef PD
     t_object x_ob;                  /* object header */
     t_clock *x_clock;               /* callback for timeouts */
+    t_worker *x_worker;             /* nonzero in "async" mode */
+    struct _fiddlejob *x_jobs;      /* FIDDLE_MAXJOBS of them */
+    struct _fiddlejob *x_freejobs;  /* those not given to the worker */
+    int x_nskipped;                 /* windows dropped since last reported */
 #endif
 #ifdef MSP
         t_pxobject x_obj;
@@ -302,6 +307,42 @@ typedef struct sigfiddle                    /* instance struct */
 t_float fiddle_checker[1024];
 #endif
 
+#ifdef PD
+/* In "async" mode the analysis is done in a worker thread (see worker_new())
+instead of in the DSP routine: each window is copied into a job, and what
+sigfiddle_bang() would output comes back with it a tick or more later.
+Messages that change the settings or state first wait for the jobs still
+out, and windows to be printed ("debug") are analyzed right away as usual.
+A worker that falls FIDDLE_MAXJOBS windows behind can't be waited for in the
+DSP routine, since that would mean outputting from it, so windows are
+dropped then, with a complaint. */
+
+#define FIDDLE_MAXJOBS 16
+
+typedef struct _fiddlejob
+{
+    struct _fiddlejob *j_next;      /* next unused job */
+    t_float *j_inbuf;               /* the window to analyze, x_hop long */
+    int j_hop;
+    t_peakout *j_peakbuf;           /* results, x_npeakout peaks */
+    t_float j_db;
+    t_float j_pitches[MAXNPITCH];
+    t_float j_amps[MAXNPITCH];
+    t_float j_notes[MAXNPITCH];
+    int j_attack;
+} t_fiddlejob;
+#endif /* PD */
+
+    /* in "async" mode, wait for the analyses still out before changing
+    anything they use */
+static void sigfiddle_sync(t_sigfiddle *x)
+{
+#ifdef PD
+    if (x->x_worker)
+        worker_sync(x->x_worker);
+#endif
+}
+
 #ifdef MSP
 /* Mac compiler requires prototypes for everything */
 
@@ -357,7 +398,7 @@ t_float fiddle_ftom(t_float f)
 #define ftom fiddle_ftom
 #define mtof fiddle_mtof
 
-void sigfiddle_doit(t_sigfiddle *x)
+static void sigfiddle_analyze(t_sigfiddle *x, t_float *inbuf)
 {
 #ifdef MSP
         /* prevents interrupt-level stack overflow crash with Netscape. */
@@ -392,7 +433,7 @@ void sigfiddle_doit(t_sigfiddle *x)
          * multiply the H points by a 1/4-wave complex exponential,
          * and take FFT of the result.
          */
-    for (i = 0, fp1 = x->x_inbuf, fp2 = x->x_spiral, fp3 = spect1;
+    for (i = 0, fp1 = inbuf, fp2 = x->x_spiral, fp3 = spect1;
         i < hop; i++, fp1++, fp2 += 2, fp3 += 2)
             fp3[0] = fp1[0] * fp2[0], fp3[1] = fp1[0] * fp2[1];
 
@@ -493,6 +534,11 @@ void sigfiddle_doit(t_sigfiddle *x)
         
         fp1 += 8, fp2 += 2, fp3 += 2;
     }
+        /* the peak search below looks at two points past the end; make
+        them zero rather than whatever the stack held, which differs from
+        one thread to another in "async" mode */
+    for (i = 4*n; i < 4*n + 4; i++)
+        spect1[i] = 0;
 #if 0
     if (x->x_nprint)
     {
@@ -535,7 +581,7 @@ void sigfiddle_doit(t_sigfiddle *x)
     {
         checker3[2*i] = fiddle_checker[i];
         checker3[2*i + 1] = 0;
-        checker3[n + 2*i] = fiddle_checker[i] = x->x_inbuf[i];
+        checker3[n + 2*i] = fiddle_checker[i] = inbuf[i];
         checker3[n + 2*i + 1] = 0;
     }
     for (i = 2*n; i < 4*n; i++) checker3[i] = 0;
@@ -996,8 +1042,14 @@ nopow:
     x->x_dbage = 0;
 }
 
+void sigfiddle_doit(t_sigfiddle *x)
+{
+    sigfiddle_analyze(x, x->x_inbuf);
+}
+
 void sigfiddle_debug(t_sigfiddle *x)
 {
+    sigfiddle_sync(x);
     x->x_nprint = 1;
 }
 
@@ -1013,6 +1065,7 @@ void sigfiddle_print(t_sigfiddle *x)
 
 void sigfiddle_amprange(t_sigfiddle *x, t_floatarg amplo, t_floatarg amphi)
 {
+    sigfiddle_sync(x);
     if (amplo < 0) amplo = 0;
     if (amphi < amplo) amphi = amplo + 1;
     x->x_amplo = amplo;
@@ -1022,6 +1075,7 @@ void sigfiddle_amprange(t_sigfiddle *x, t_floatarg amplo, t_floatarg amphi)
 void sigfiddle_reattack(t_sigfiddle *x,
     t_floatarg attacktime, t_floatarg attackthresh)
 {
+    sigfiddle_sync(x);
     if (attacktime < 0) attacktime = 0;
     if (attackthresh <= 0) attackthresh = 1000;
     x->x_attacktime = attacktime;
@@ -1032,6 +1086,7 @@ void sigfiddle_reattack(t_sigfiddle *x,
 
 void sigfiddle_vibrato(t_sigfiddle *x, t_floatarg vibtime, t_floatarg vibdepth)
 {
+    sigfiddle_sync(x);
     if (vibtime < 0) vibtime = 0;
     if (vibdepth <= 0) vibdepth = 1000;
     x->x_vibtime = vibtime;
@@ -1043,6 +1098,7 @@ void sigfiddle_vibrato(t_sigfiddle *x, t_floatarg vibtime, t_floatarg vibdepth)
 
 void sigfiddle_npartial(t_sigfiddle *x, t_floatarg npartial)
 {
+    sigfiddle_sync(x);
     if (npartial < 0.1) npartial = 0.1;
     x->x_npartial = npartial;
 }
@@ -1076,6 +1132,7 @@ static void sigfiddle_freebird(t_sigfiddle *x)
 int sigfiddle_setnpoints(t_sigfiddle *x, t_floatarg fnpoints)
 {
     int i, npoints = fnpoints;
+    sigfiddle_sync(x);
     sigfiddle_freebird(x);
     if (npoints < MINPOINTS || npoints > MAXPOINTS)
     {
@@ -1388,6 +1445,145 @@ fts_module_t fiddle_module =
 
 #ifdef PD
 
+static void sigfiddle_freejobs(t_sigfiddle *x)
+{
+    int i;
+    if (!x->x_worker)
+        return;
+    worker_free(x->x_worker);
+    for (i = 0; i < FIDDLE_MAXJOBS; i++)
+    {
+        t_fiddlejob *j = &x->x_jobs[i];
+        if (j->j_inbuf)
+            freebytes(j->j_inbuf, sizeof(t_float) * j->j_hop);
+        if (j->j_peakbuf)
+            freebytes(j->j_peakbuf, sizeof(*j->j_peakbuf) * x->x_npeakout);
+    }
+    freebytes(x->x_jobs, sizeof(*x->x_jobs) * FIDDLE_MAXJOBS);
+    x->x_worker = 0;
+    x->x_jobs = x->x_freejobs = 0;
+}
+
+    /* collect what's to be output after an analysis */
+static void sigfiddle_getresult(t_sigfiddle *x, t_fiddlejob *j)
+{
+    int i;
+    t_pitchhist *ph;
+    if (x->x_npeakout && j->j_peakbuf != x->x_peakbuf)
+        memcpy(j->j_peakbuf, x->x_peakbuf,
+            sizeof(*j->j_peakbuf) * x->x_npeakout);
+    j->j_db = x->x_dbs[x->x_histphase];
+    for (i = 0,  ph = x->x_hist; i < x->x_npitch; i++,  ph++)
+    {
+        j->j_pitches[i] = ph->h_pitches[x->x_histphase];
+        j->j_amps[i] = ph->h_amps[x->x_histphase];
+        j->j_notes[i] = ph->h_pitch;
+    }
+    j->j_attack = x->x_attackvalue;
+}
+
+static void sigfiddle_output(t_sigfiddle *x, t_fiddlejob *j)
+{
+    int i;
+    t_pitchhist *ph;
+    if (x->x_npeakout)
+    {
+        int npeakout = x->x_npeakout;
+        t_peakout *po;
+        for (i = 0, po = j->j_peakbuf; i < npeakout; i++, po++)
+        {
+            t_atom at[3];
+            SETFLOAT(at, i+1);
+            SETFLOAT(at+1, po->po_freq);
+            SETFLOAT(at+2, po->po_amp);
+            outlet_list(x->x_peakout, 0, 3, at);
+        }
+    }
+    outlet_float(x->x_envout, j->j_db);
+    for (i = 0,  ph = x->x_hist; i < x->x_npitch; i++,  ph++)
+    {
+        t_atom at[2];
+        SETFLOAT(at, j->j_pitches[i]);
+        SETFLOAT(at+1, j->j_amps[i]);
+        outlet_list(ph->h_outlet, 0, 2, at);
+    }
+    if (j->j_attack) outlet_bang(x->x_attackout);
+    for (i = 0; i < x->x_npitch; i++)
+        if (j->j_notes[i]) outlet_float(x->x_noteout, j->j_notes[i]);
+}
+
+    /* these two are called by the worker, in its thread and then in Pd's */
+static void sigfiddle_work(t_sigfiddle *x, t_fiddlejob *j)
+{
+    sigfiddle_analyze(x, j->j_inbuf);
+    sigfiddle_getresult(x, j);
+}
+
+static void sigfiddle_done(t_sigfiddle *x, t_fiddlejob *j)
+{
+    if (x->x_nskipped)
+    {
+        pd_error(x, "fiddle~: analysis falling behind; skipped %d windows",
+            x->x_nskipped);
+        x->x_nskipped = 0;
+    }
+    if (x->x_auto)
+        sigfiddle_output(x, j);
+    j->j_next = x->x_freejobs;
+    x->x_freejobs = j;
+}
+
+    /* hand the input buffer to the worker; called from the DSP routine */
+static void sigfiddle_submit(t_sigfiddle *x)
+{
+    t_fiddlejob *j = x->x_freejobs;
+    if (!j)
+    {
+        x->x_nskipped++;
+        return;
+    }
+    x->x_freejobs = j->j_next;
+    if (j->j_hop != x->x_hop)
+    {
+        if (j->j_inbuf)
+            freebytes(j->j_inbuf, sizeof(t_float) * j->j_hop);
+        j->j_inbuf = (t_float *)getbytes(sizeof(t_float) * x->x_hop);
+        j->j_hop = x->x_hop;
+    }
+    memcpy(j->j_inbuf, x->x_inbuf, sizeof(t_float) * x->x_hop);
+    worker_submit(x->x_worker, j);
+}
+
+static void sigfiddle_async(t_sigfiddle *x, t_floatarg f)
+{
+    if (f != 0 && !x->x_worker && !mayer_threadsafe())
+        pd_error(x, "fiddle~: async: not with the fftw FFT backend "
+            "(see \"pd fft-backend\")");
+    else if (f != 0 && !x->x_worker)
+    {
+        int i;
+        x->x_jobs = (t_fiddlejob *)getbytes(
+            sizeof(*x->x_jobs) * FIDDLE_MAXJOBS);
+        for (i = 0; i < FIDDLE_MAXJOBS; i++)
+        {
+            x->x_jobs[i].j_next = (i < FIDDLE_MAXJOBS - 1 ?
+                &x->x_jobs[i+1] : 0);
+            if (x->x_npeakout)
+                x->x_jobs[i].j_peakbuf = (t_peakout *)getbytes(
+                    sizeof(t_peakout) * x->x_npeakout);
+        }
+        x->x_freejobs = x->x_jobs;
+        x->x_nskipped = 0;
+        x->x_worker = worker_new(x, (t_workmethod)sigfiddle_work,
+            (t_workmethod)sigfiddle_done, FIDDLE_MAXJOBS);
+    }
+    else if (f == 0 && x->x_worker)
+    {
+        worker_sync(x->x_worker);
+        sigfiddle_freejobs(x);
+    }
+}
+
 static t_int *fiddle_perform(t_int *w)
 {
     t_float *in = (t_float *)(w[1]);
@@ -1401,9 +1597,15 @@ static t_int *fiddle_perform(t_int *w)
         *fp++ = *in++;
     if (fp == x->x_inbuf + x->x_hop)
     {
-        sigfiddle_doit(x);
+            /* "debug" waited for the worker, so this can print */
+        if (x->x_worker && !x->x_nprint)
+            sigfiddle_submit(x);
+        else
+        {
+            sigfiddle_doit(x);
+            if (x->x_auto) clock_delay(x->x_clock, 0L);
+        }
         x->x_phase = 0;
-        if (x->x_auto) clock_delay(x->x_clock, 0L);
         if (x->x_nprint) x->x_nprint--;
     }
     else x->x_phase += n;
@@ -1425,36 +1627,17 @@ void sigfiddle_dsp(t_sigfiddle *x, t_signal **sp)
 
 void sigfiddle_bang(t_sigfiddle *x)
 {
-    int i;
-    t_pitchhist *ph;
-    if (x->x_npeakout)
-    {
-        int npeakout = x->x_npeakout;
-        t_peakout *po;
-        for (i = 0, po = x->x_peakbuf; i < npeakout; i++, po++)
-        {
-            t_atom at[3];
-            SETFLOAT(at, i+1);
-            SETFLOAT(at+1, po->po_freq);
-            SETFLOAT(at+2, po->po_amp);
-            outlet_list(x->x_peakout, 0, 3, at);
-        }
-    }
-    outlet_float(x->x_envout, x->x_dbs[x->x_histphase]);
-    for (i = 0,  ph = x->x_hist; i < x->x_npitch; i++,  ph++)
-    {
-        t_atom at[2];
-        SETFLOAT(at, ph->h_pitches[x->x_histphase]);
-        SETFLOAT(at+1, ph->h_amps[x->x_histphase]);
-        outlet_list(ph->h_outlet, 0, 2, at);
-    }
-    if (x->x_attackvalue) outlet_bang(x->x_attackout);
-    for (i = 0,  ph = x->x_hist; i < x->x_npitch; i++,  ph++)
-        if (ph->h_pitch) outlet_float(x->x_noteout, ph->h_pitch);
+    t_fiddlejob result;
+    sigfiddle_sync(x);
+    result.j_peakbuf = x->x_peakbuf;
+    sigfiddle_getresult(x, &result);
+    sigfiddle_output(x, &result);
 }
 
 void sigfiddle_ff(t_sigfiddle *x)               /* cleanup on free */
 {
+        /* first, so that no analysis is still using the buffers */
+    sigfiddle_freejobs(x);
     if (x->x_inbuf)
     {
         freebytes(x->x_inbuf, sizeof(t_float) * x->x_hop);
@@ -1517,6 +1700,8 @@ void fiddle_tilde_setup(void)
         gensym("auto"), A_FLOAT, 0);
     class_addmethod(sigfiddle_class, (t_method)sigfiddle_print,
         gensym("print"), 0);
+    class_addmethod(sigfiddle_class, (t_method)sigfiddle_async,
+        gensym("async"), A_FLOAT, 0);
     class_addmethod(sigfiddle_class, nullfn, gensym("signal"), 0);
     class_addbang(sigfiddle_class, sigfiddle_bang);
     class_addcreator((t_newmethod)sigfiddle_new, gensym("fiddle"),
@@ -51,8 +51,10 @@ static t_float hanning(t_float pidetune, t_float sinpidetune)
         (sinpidetune/(pidetune+pi) + sinpidetune/(pidetune-pi)));
 }
 
-static t_float peakerror(t_word *fpreal, t_word *fpimag, t_float pidetune,
-    t_float norm, t_float peakreal, t_float peakimag)
+    /* the arrays may be packed or not: point i of each is at i * stride */
+static t_float peakerror(t_float *fpreal, int rstride, t_float *fpimag,
+    int istride, t_float pidetune, t_float norm, t_float peakreal,
+    t_float peakimag)
 {
     t_float sinpidetune = sin(pidetune);
     t_float cospidetune = cos(pidetune);
@@ -61,10 +63,10 @@ static t_float peakerror(t_word *fpreal, t_word *fpimag, t_float pidetune,
         peakreal * cospidetune + peakimag * sinpidetune);
     t_float imagshould =  windowshould * (
         peakimag * cospidetune - peakreal * sinpidetune);
-    t_float realgot = norm * (fpreal[0].w_float -
-        0.5 * (fpreal[1].w_float + fpreal[-1].w_float));
-    t_float imaggot = norm * (fpimag[0].w_float -
-        0.5 * (fpimag[1].w_float + fpimag[-1].w_float));
+    t_float realgot = norm * (fpreal[0] -
+        0.5 * (fpreal[rstride] + fpreal[-rstride]));
+    t_float imaggot = norm * (fpimag[0] -
+        0.5 * (fpimag[istride] + fpimag[-istride]));
     t_float realdev = realshould - realgot, imagdev = imagshould - imaggot;
     
     /* post("real %f->%f; imag %f->%f", realshould, realgot,
@@ -72,23 +74,21 @@ static t_float peakerror(t_word *fpreal, t_word *fpimag, t_float pidetune,
     return (realdev * realdev + imagdev * imagdev);
 }
 
-static void pique_doit(int npts, t_word *fpreal, t_word *fpimag,
-    int npeak, int *nfound, t_float *fpfreq, t_float *fpamp,
-        t_float *fpampre, t_float *fpampim, t_float errthresh)
+static void pique_doit(int npts, t_float *fpreal, int rstride,
+    t_float *fpimag, int istride, int npeak, int *nfound, t_float *fpfreq,
+        t_float *fpamp, t_float *fpampre, t_float *fpampim, t_float errthresh)
 {
     t_float srate = sys_getsr();      /* not sure how to get this correctly */
     t_float oneovern = 1.0/ (t_float)npts;
     t_float fperbin = srate * oneovern;
     t_float pow1, pow2 = 0, pow3 = 0, pow4 = 0, pow5 = 0;
-    t_float re1, re2 = 0, re3 = fpreal->w_float;
+    t_float re1, re2 = 0, re3 = *fpreal;
     t_float im1, im2 = 0, im3 = 0, powthresh, relativeerror;
     int count, peakcount = 0, n2 = (npts >> 1);
     t_float *fp1, *fp2;
-    t_word *wp1, *wp2;
-    for (count = n2, wp1 = fpreal, wp2 = fpimag, powthresh = 0;
-        count--; wp1++, wp2++)
-            powthresh += (wp1->w_float) * (wp1->w_float) +
-                (wp2->w_float) * (wp2->w_float) ; 
+    for (count = n2, fp1 = fpreal, fp2 = fpimag, powthresh = 0;
+        count--; fp1 += rstride, fp2 += istride)
+            powthresh += (*fp1) * (*fp1) + (*fp2) * (*fp2) ; 
     powthresh *= 0.00001;
     for (count = 1; count < n2; count++)
     {
@@ -98,14 +98,14 @@ static void pique_doit(int npts, t_word *fpreal, t_word *fpimag,
         t_float rpeak, rpeaknext, rpeakprev;
         t_float ipeak, ipeaknext, ipeakprev;
         t_float errleft, errright;
-        fpreal++;
-        fpimag++;
+        fpreal += rstride;
+        fpimag += istride;
         re1 = re2;
         re2 = re3;
-        re3 = fpreal->w_float;
+        re3 = *fpreal;
         im1 = im2;
         im2 = im3;
-        im3 = fpimag->w_float;
+        im3 = *fpimag;
         if (count < 2) continue;
         pow1 = pow2;
         pow2 = pow3;
@@ -122,12 +122,12 @@ static void pique_doit(int npts, t_word *fpreal, t_word *fpimag,
             || pow3 < powthresh)
                 continue;
             /* go back for the raw FFT values around the peak. */
-        rpeak = fpreal[-3].w_float;
-        rpeaknext = fpreal[-2].w_float;
-        rpeakprev = fpreal[-4].w_float;
-        ipeak = fpimag[-3].w_float;
-        ipeaknext = fpimag[-2].w_float;
-        ipeakprev = fpimag[-4].w_float;
+        rpeak = fpreal[-3 * rstride];
+        rpeaknext = fpreal[-2 * rstride];
+        rpeakprev = fpreal[-4 * rstride];
+        ipeak = fpimag[-3 * istride];
+        ipeaknext = fpimag[-2 * istride];
+        ipeakprev = fpimag[-4 * istride];
             /* recalculate Hanning-windowed spectrum by convolution */
         windreal = rpeak - 0.5 * (rpeaknext + rpeakprev);
         windimag = ipeak - 0.5 * (ipeaknext + ipeakprev);
@@ -158,9 +158,11 @@ static void pique_doit(int npts, t_word *fpreal, t_word *fpimag,
         if (errthresh > 0)
         {
             /* post("peak %f %f", freqout, ampout); */
-            errleft = peakerror(fpreal-4, fpimag-4, pidetune+pi,
+            errleft = peakerror(fpreal - 4 * rstride, rstride,
+                fpimag - 4 * istride, istride, pidetune+pi,
                 2. * oneovern, ampoutreal, ampoutimag);
-            errright = peakerror(fpreal-2, fpimag-2, pidetune-pi,
+            errright = peakerror(fpreal - 2 * rstride, rstride,
+                fpimag - 2 * istride, istride, pidetune-pi,
                 2. * oneovern,  ampoutreal, ampoutimag);
             relativeerror = (errleft + errright)/(ampout * ampout);
             if (relativeerror > errthresh) continue;
@@ -182,17 +184,17 @@ static void pique_list(t_pique *x, t_symbol *s, int argc, t_atom *argv)
     t_symbol *symreal = atom_getsymbolarg(1, argc, argv);
     t_symbol *symimag = atom_getsymbolarg(2, argc, argv);
     int npeak = atom_getfloatarg(3, argc, argv);
-    int n;
+    int n, rstride, istride;
     t_garray *a;
-    t_word *fpreal, *fpimag;
+    t_float *fpreal, *fpimag;
     if (npts < 8 || npeak < 1) error("pique: bad npoints or npeak");
     if (npeak > x->x_n) npeak = x->x_n;
     if (!(a = (t_garray *)pd_findbyclass(symreal, garray_class)) ||
-        !garray_getfloatwords(a, &n, &fpreal) ||
+        !garray_getfloatvec(a, &n, &fpreal, &rstride) ||
             n < npts)
                 error("%s: missing or bad array", symreal->s_name);
     else if (!(a = (t_garray *)pd_findbyclass(symimag, garray_class)) ||
-        !garray_getfloatwords(a, &n, &fpimag) ||
+        !garray_getfloatvec(a, &n, &fpimag, &istride) ||
             n < npts)
                 error("%s: missing or bad array", symimag->s_name);
     else
@@ -202,7 +204,7 @@ static void pique_list(t_pique *x, t_symbol *s, int argc, t_atom *argv)
         t_float *fpamp = x->x_amp;
         t_float *fpampre = x->x_ampre;
         t_float *fpampim = x->x_ampim;
-        pique_doit(npts, fpreal, fpimag, npeak,
+        pique_doit(npts, fpreal, rstride, fpimag, istride, npeak,
             &nfound, fpfreq, fpamp, fpampre, fpampim, x->x_errthresh);
         for (i = 0; i < nfound; i++, fpamp++, fpfreq++, fpampre++, fpampim++)
         {
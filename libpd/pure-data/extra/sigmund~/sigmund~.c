@@ -824,6 +824,9 @@ typedef struct _sigmund
     t_object x_obj;
     t_clock *x_clock;
     t_float x_f;        /* for main signal inlet */
+    t_worker *x_worker; /* nonzero in "async" mode */
+    struct _sigmundjob *x_jobs;     /* SIGMUND_MAXJOBS of them */
+    struct _sigmundjob *x_freejobs; /* those not given to the worker */
 #endif /* PD */
 #ifdef MSP
     t_pxobject x_obj;
@@ -883,6 +886,68 @@ static void sigmund_preinit(t_sigmund *x)
 #ifdef MSP
     x->x_inbuf2 = 0;
 #endif
+#ifdef PD
+    x->x_worker = 0;
+    x->x_jobs = x->x_freejobs = 0;
+#endif
+}
+
+#ifdef PD
+/* In "async" mode the analysis is done in a worker thread (see worker_new())
+rather than in the clock callback, so that a few large analyses can't hold up
+the scheduler and with it the DSP.  Each window is copied into a job, and the
+results, with a copy of the tracks, come back a tick or more later to be
+output.  Messages that change the analysis settings or state first wait for
+the jobs still out, as does a window that is to be printed out, so that the
+output is the same as without "async", only later. */
+
+#define SIGMUND_MAXJOBS 8
+
+typedef struct _sigmundjob
+{
+    struct _sigmundjob *j_next;     /* next unused job */
+    t_sample *j_inbuf;              /* the window to analyze */
+    int j_npts;
+    t_float j_srate;
+    t_peak *j_peakv;                /* results */
+    int j_npeak;
+    int j_nfound;
+    t_float j_freq;
+    t_float j_power;
+    t_float j_note;
+    t_peak *j_trackv;               /* the tracks after this window */
+} t_sigmundjob;
+
+static void sigmund_freejobs(t_sigmund *x)
+{
+    int i;
+    if (!x->x_worker)
+        return;
+    worker_free(x->x_worker);
+    for (i = 0; i < SIGMUND_MAXJOBS; i++)
+    {
+        t_sigmundjob *j = &x->x_jobs[i];
+        if (j->j_inbuf)
+            freebytes(j->j_inbuf, j->j_npts * sizeof(*j->j_inbuf));
+        if (j->j_peakv)
+            freebytes(j->j_peakv, j->j_npeak * sizeof(*j->j_peakv));
+        if (j->j_trackv)
+            freebytes(j->j_trackv, x->x_ntrack * sizeof(*j->j_trackv));
+    }
+    freebytes(x->x_jobs, SIGMUND_MAXJOBS * sizeof(*x->x_jobs));
+    x->x_worker = 0;
+    x->x_jobs = x->x_freejobs = 0;
+}
+#endif /* PD */
+
+    /* in "async" mode, wait for the analyses still out before changing
+    anything they use */
+static void sigmund_sync(t_sigmund *x)
+{
+#ifdef PD
+    if (x->x_worker)
+        worker_sync(x->x_worker);
+#endif
 }
 
 static void sigmund_npts(t_sigmund *x, t_floatarg f)
@@ -929,6 +994,7 @@ static void sigmund_npts(t_sigmund *x, t_floatarg f)
 static void sigmund_hop(t_sigmund *x, t_floatarg f)
 {
     int hop = f;
+    sigmund_sync(x);
     if (hop < 0)
     {
         error("sigmund~: ignoring negative hopsize %d", hop);
@@ -944,6 +1010,7 @@ static void sigmund_hop(t_sigmund *x, t_floatarg f)
 
 static void sigmund_npeak(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     if (f < 1)
         f = 1;
     x->x_npeak = f;
@@ -951,11 +1018,13 @@ static void sigmund_npeak(t_sigmund *x, t_floatarg f)
 
 static void sigmund_maxfreq(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     x->x_maxfreq = f;
 }
 
 static void sigmund_vibrato(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     if (f < 0)
         f = 0;
     x->x_vibrato = f;
@@ -963,6 +1032,7 @@ static void sigmund_vibrato(t_sigmund *x, t_floatarg f)
 
 static void sigmund_stabletime(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     if (f < 0)
         f = 0;
     x->x_stabletime = f;
@@ -970,6 +1040,7 @@ static void sigmund_stabletime(t_sigmund *x, t_floatarg f)
 
 static void sigmund_growth(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     if (f < 0)
         f = 0;
     x->x_growth = f;
@@ -977,29 +1048,38 @@ static void sigmund_growth(t_sigmund *x, t_floatarg f)
 
 static void sigmund_minpower(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     if (f < 0)
         f = 0;
     x->x_minpower = f;
 }
 
-static void sigmund_doit(t_sigmund *x, int npts, t_float *arraypoints,
-    int loud, t_float srate)
+    /* analyze a window into x->x_npeak peaks, updating the note and
+    tracking state; this is the part that may be done in a worker thread */
+static void sigmund_analyze(t_sigmund *x, int npts, t_float *arraypoints,
+    int loud, t_float srate, t_peak *peakv, int *nfoundp, t_float *freqp,
+    t_float *powerp, t_float *notep)
 {
-    t_peak *peakv = (t_peak *)alloca(sizeof(t_peak) * x->x_npeak);
-    int nfound, i, cnt;
-    t_float freq = 0, power, note = 0;
+    *freqp = *notep = 0;
     sigmund_getrawpeaks(npts, arraypoints, x->x_npeak, peakv,
-        &nfound, &power, srate, loud, x->x_maxfreq);
+        nfoundp, powerp, srate, loud, x->x_maxfreq);
     if (x->x_dopitch)
-        sigmund_getpitch(nfound, peakv, &freq, npts, srate, 
+        sigmund_getpitch(*nfoundp, peakv, freqp, npts, srate, 
         x->x_param1, x->x_param2, loud);
     if (x->x_donote)
-        notefinder_doit(&x->x_notefinder, freq, power, &note, x->x_vibrato, 
+        notefinder_doit(&x->x_notefinder, *freqp, *powerp, notep,
+            x->x_vibrato, 
             1 + x->x_stabletime * 0.001 * srate / (t_float)x->x_hop,
                 exp(LOG10*0.1*(x->x_minpower - 100)), x->x_growth, loud);
     if (x->x_dotracks)
-        sigmund_peaktrack(nfound, peakv, x->x_ntrack, x->x_trackv, 
+        sigmund_peaktrack(*nfoundp, peakv, x->x_ntrack, x->x_trackv, 
             2* srate / npts, loud);
+}
+
+static void sigmund_output(t_sigmund *x, int nfound, t_peak *peakv,
+    t_float freq, t_float power, t_float note, t_peak *trackv)
+{
+    int i, cnt;
     for (cnt = x->x_nvarout; cnt--;)
     {
         t_varout *v = &x->x_varoutv[cnt];
@@ -1032,9 +1112,9 @@ static void sigmund_doit(t_sigmund *x, int npts, t_float *arraypoints,
             {
                 t_atom at[4];
                 SETFLOAT(at, (t_float)i);
-                SETFLOAT(at+1, x->x_trackv[i].p_freq);
-                SETFLOAT(at+2, 2*x->x_trackv[i].p_amp);
-                SETFLOAT(at+3, x->x_trackv[i].p_tmp);
+                SETFLOAT(at+1, trackv[i].p_freq);
+                SETFLOAT(at+2, 2*trackv[i].p_amp);
+                SETFLOAT(at+3, trackv[i].p_tmp);
                 outlet_list(v->v_outlet, 0, 4, at);   
             }
             break;
@@ -1042,11 +1122,23 @@ static void sigmund_doit(t_sigmund *x, int npts, t_float *arraypoints,
     }
 }
 
+static void sigmund_doit(t_sigmund *x, int npts, t_float *arraypoints,
+    int loud, t_float srate)
+{
+    t_peak *peakv = (t_peak *)alloca(sizeof(t_peak) * x->x_npeak);
+    int nfound;
+    t_float freq, power, note;
+    sigmund_analyze(x, npts, arraypoints, loud, srate, peakv, &nfound,
+        &freq, &power, &note);
+    sigmund_output(x, nfound, peakv, freq, power, note, x->x_trackv);
+}
+
 static t_int *sigmund_perform(t_int *w);
 static void sigmund_dsp(t_sigmund *x, t_signal **sp)
 {
     if (x->x_mode == MODE_STREAM)
     {
+        sigmund_sync(x);
         if (x->x_hop % sp[0]->s_n)
             post("sigmund: adjusting hop size to %d",
                 (x->x_hop = sp[0]->s_n * (x->x_hop / sp[0]->s_n)));
@@ -1071,6 +1163,10 @@ static void sigmund_print(t_sigmund *x)
 
 static void sigmund_free(t_sigmund *x)
 {
+#ifdef PD
+        /* first, so that no analysis is still using the tracks */
+    sigmund_freejobs(x);
+#endif
     if (x->x_inbuf)
     {
         freebytes(x->x_inbuf, x->x_npts * sizeof(*x->x_inbuf));
@@ -1101,11 +1197,88 @@ static void sigmund_stabletime(t_sigmund *x, t_floatarg f);
 static void sigmund_growth(t_sigmund *x, t_floatarg f);
 static void sigmund_minpower(t_sigmund *x, t_floatarg f);
 
+    /* these two are called by the worker, in its thread and then in Pd's */
+static void sigmund_work(t_sigmund *x, t_sigmundjob *j)
+{
+    sigmund_analyze(x, j->j_npts, j->j_inbuf, 0, j->j_srate, j->j_peakv,
+        &j->j_nfound, &j->j_freq, &j->j_power, &j->j_note);
+    if (x->x_ntrack)
+        memcpy(j->j_trackv, x->x_trackv, x->x_ntrack * sizeof(*j->j_trackv));
+}
+
+static void sigmund_done(t_sigmund *x, t_sigmundjob *j)
+{
+    sigmund_output(x, j->j_nfound, j->j_peakv, j->j_freq, j->j_power,
+        j->j_note, j->j_trackv);
+    j->j_next = x->x_freejobs;
+    x->x_freejobs = j;
+}
+
+    /* hand the input buffer's window to the worker */
+static void sigmund_submit(t_sigmund *x)
+{
+    t_sigmundjob *j;
+    if (!x->x_freejobs)     /* the worker is falling behind */
+        worker_sync(x->x_worker);
+    j = x->x_freejobs;
+    x->x_freejobs = j->j_next;
+    if (j->j_npts != x->x_npts)
+    {
+        if (j->j_inbuf)
+            freebytes(j->j_inbuf, j->j_npts * sizeof(*j->j_inbuf));
+        j->j_inbuf = (t_sample *)getbytes(x->x_npts * sizeof(*j->j_inbuf));
+        j->j_npts = x->x_npts;
+    }
+    if (j->j_npeak != x->x_npeak)
+    {
+        if (j->j_peakv)
+            freebytes(j->j_peakv, j->j_npeak * sizeof(*j->j_peakv));
+        j->j_peakv = (t_peak *)getbytes(x->x_npeak * sizeof(*j->j_peakv));
+        j->j_npeak = x->x_npeak;
+    }
+    if (x->x_ntrack && !j->j_trackv)
+        j->j_trackv = (t_peak *)getbytes(x->x_ntrack * sizeof(*j->j_trackv));
+    memcpy(j->j_inbuf, x->x_inbuf, x->x_npts * sizeof(*j->j_inbuf));
+    j->j_srate = x->x_sr;
+    worker_submit(x->x_worker, j);
+}
+
+static void sigmund_async(t_sigmund *x, t_floatarg f)
+{
+    if (f != 0 && !x->x_worker && !mayer_threadsafe())
+        pd_error(x, "sigmund~: async: not with the fftw FFT backend "
+            "(see \"pd fft-backend\")");
+    else if (f != 0 && !x->x_worker)
+    {
+        int i;
+        x->x_jobs = (t_sigmundjob *)getbytes(
+            SIGMUND_MAXJOBS * sizeof(*x->x_jobs));
+        for (i = 0; i < SIGMUND_MAXJOBS; i++)
+            x->x_jobs[i].j_next = (i < SIGMUND_MAXJOBS - 1 ?
+                &x->x_jobs[i+1] : 0);
+        x->x_freejobs = x->x_jobs;
+        x->x_worker = worker_new(x, (t_workmethod)sigmund_work,
+            (t_workmethod)sigmund_done, SIGMUND_MAXJOBS);
+    }
+    else if (f == 0 && x->x_worker)
+    {
+        worker_sync(x->x_worker);
+        sigmund_freejobs(x);
+    }
+}
+
 static void sigmund_tick(t_sigmund *x)
 {
     if (x->x_infill == x->x_npts)
     {
-        sigmund_doit(x, x->x_npts, x->x_inbuf, x->x_loud, x->x_sr);
+            /* printouts can only be done here, so those aren't async */
+        if (x->x_worker && !x->x_loud)
+            sigmund_submit(x);
+        else
+        {
+            sigmund_sync(x);
+            sigmund_doit(x, x->x_npts, x->x_inbuf, x->x_loud, x->x_sr);
+        }
         if (x->x_hop >= x->x_npts)
         {
             x->x_infill = 0;
@@ -1148,6 +1321,7 @@ static t_int *sigmund_perform(t_int *w)
 static void *sigmund_new(t_symbol *s, int argc, t_atom *argv)
 {
     t_sigmund *x = (t_sigmund *)pd_new(sigmund_class);
+    int async = 0;
     sigmund_preinit(x);
 
     while (argc > 0)
@@ -1163,6 +1337,11 @@ static void *sigmund_new(t_symbol *s, int argc, t_atom *argv)
             x->x_mode = MODE_STREAM;
             argc--, argv++;
         }
+        else if (!strcmp(firstarg->s_name, "-async"))
+        {
+            async = 1;
+            argc--, argv++;
+        }
 #if 0
         else if (!strcmp(firstarg->s_name, "-b"))
         {
@@ -1299,6 +1478,8 @@ static void *sigmund_new(t_symbol *s, int argc, t_atom *argv)
     sigmund_npts(x, x->x_npts);
     notefinder_init(&x->x_notefinder);
     sigmund_clear(x);
+    if (async)
+        sigmund_async(x, 1);
     return (x);
 }
 
@@ -1309,10 +1490,11 @@ static void sigmund_list(t_sigmund *x, t_symbol *s, int argc, t_atom *argv)
     int onset = atom_getfloatarg(2, argc, argv);
     t_float srate = atom_getfloatarg(3, argc, argv);
     int loud = atom_getfloatarg(4, argc, argv);
-    int arraysize, totstorage, nfound, i;
+    int arraysize, stride, totstorage, nfound, i;
     t_garray *a;
     t_float *arraypoints, pit;
-    t_word *wordarray = 0;
+    t_float *floatarray = 0;
+    sigmund_sync(x);
     if (argc < 5)
     {
         post(
@@ -1331,7 +1513,7 @@ static void sigmund_list(t_sigmund *x, t_symbol *s, int argc, t_atom *argv)
     }
     arraypoints = alloca(sizeof(t_float)*npts);
     if (!(a = (t_garray *)pd_findbyclass(syminput, garray_class)) ||
-        !garray_getfloatwords(a, &arraysize, &wordarray) ||
+        !garray_getfloatvec(a, &arraysize, &floatarray, &stride) ||
             arraysize < onset + npts)
     {
         error("%s: array missing or too small", syminput->s_name);
@@ -1343,12 +1525,13 @@ static void sigmund_list(t_sigmund *x, t_symbol *s, int argc, t_atom *argv)
         return;
     }
     for (i = 0; i < npts; i++)
-        arraypoints[i] = wordarray[i+onset].w_float;
+        arraypoints[i] = floatarray[(i+onset) * stride];
     sigmund_doit(x, npts, arraypoints, loud, srate);
 }
 
 static void sigmund_clear(t_sigmund *x)
 {
+    sigmund_sync(x);
     if (x->x_trackv)
         memset(x->x_trackv, 0, x->x_ntrack * sizeof(*x->x_trackv));
     x->x_infill = x->x_countdown = 0;
@@ -1357,16 +1540,19 @@ static void sigmund_clear(t_sigmund *x)
     /* these are for testing; their meanings vary... */
 static void sigmund_param1(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     x->x_param1 = f;
 }
 
 static void sigmund_param2(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     x->x_param2 = f;
 }
 
 static void sigmund_param3(t_sigmund *x, t_floatarg f)
 {
+    sigmund_sync(x);
     x->x_param3 = f;
 }
 
@@ -1408,6 +1594,8 @@ void sigmund_tilde_setup(void)
         gensym("print"), 0);
     class_addmethod(sigmund_class, (t_method)sigmund_printnext,
         gensym("printnext"), A_FLOAT, 0);
+    class_addmethod(sigmund_class, (t_method)sigmund_async,
+        gensym("async"), A_FLOAT, 0);
     post("sigmund~ version 0.07");
 }
 
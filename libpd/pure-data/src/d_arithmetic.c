@@ -9,6 +9,7 @@ to reset the value.
 */
 
 #include "m_pd.h"
+#include "d_simd.h"
 
 /* ----------------------------- plus ----------------------------- */
 static t_class *plus_class, *scalarplus_class;
@@ -105,12 +106,15 @@ t_int *scalarplus_perf8(t_int *w)
     return (w+5);
 }
 
+SIMD_DEFINE(SIMD_BINOP, plus, add)
+SIMD_DEFINE(SIMD_SCALAROP, scalarplus, add)
+
 void dsp_add_plus(t_sample *in1, t_sample *in2, t_sample *out, int n)
 {
     if (n&7)
         dsp_add(plus_perform, 4, in1, in2, out, n);
     else
-        dsp_add(plus_perf8, 4, in1, in2, out, n);
+        dsp_add(SIMD_PERFORM(plus_perf8, plus), 4, in1, in2, out, n);
 }
 
 static void plus_dsp(t_plus *x, t_signal **sp)
@@ -124,19 +128,21 @@ static void scalarplus_dsp(t_scalarplus *x, t_signal **sp)
         dsp_add(scalarplus_perform, 4, sp[0]->s_vec, &x->x_g,
             sp[1]->s_vec, sp[0]->s_n);
     else
-        dsp_add(scalarplus_perf8, 4, sp[0]->s_vec, &x->x_g,
-            sp[1]->s_vec, sp[0]->s_n);
+        dsp_add(SIMD_PERFORM(scalarplus_perf8, scalarplus), 4,
+            sp[0]->s_vec, &x->x_g, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void plus_setup(void)
 {
     plus_class = class_new(gensym("+~"), (t_newmethod)plus_new, 0,
         sizeof(t_plus), 0, A_GIMME, 0);
+    class_setparalleldsp(plus_class);
     class_addmethod(plus_class, (t_method)plus_dsp, gensym("dsp"), A_CANT, 0);
     CLASS_MAINSIGNALIN(plus_class, t_plus, x_f);
     class_sethelpsymbol(plus_class, gensym("sigbinops"));
     scalarplus_class = class_new(gensym("+~"), 0, 0,
         sizeof(t_scalarplus), 0, 0);
+    class_setparalleldsp(scalarplus_class);
     CLASS_MAINSIGNALIN(scalarplus_class, t_scalarplus, x_f);
     class_addmethod(scalarplus_class, (t_method)scalarplus_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -238,13 +244,16 @@ t_int *scalarminus_perf8(t_int *w)
     return (w+5);
 }
 
+SIMD_DEFINE(SIMD_BINOP, minus, sub)
+SIMD_DEFINE(SIMD_SCALAROP, scalarminus, sub)
+
 static void minus_dsp(t_minus *x, t_signal **sp)
 {
     if (sp[0]->s_n&7)
         dsp_add(minus_perform, 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
     else
-        dsp_add(minus_perf8, 4,
+        dsp_add(SIMD_PERFORM(minus_perf8, minus), 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
 }
 
@@ -254,19 +263,21 @@ static void scalarminus_dsp(t_scalarminus *x, t_signal **sp)
         dsp_add(scalarminus_perform, 4, sp[0]->s_vec, &x->x_g,
             sp[1]->s_vec, sp[0]->s_n);
     else
-        dsp_add(scalarminus_perf8, 4, sp[0]->s_vec, &x->x_g,
-            sp[1]->s_vec, sp[0]->s_n);
+        dsp_add(SIMD_PERFORM(scalarminus_perf8, scalarminus), 4,
+            sp[0]->s_vec, &x->x_g, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void minus_setup(void)
 {
     minus_class = class_new(gensym("-~"), (t_newmethod)minus_new, 0,
         sizeof(t_minus), 0, A_GIMME, 0);
+    class_setparalleldsp(minus_class);
     CLASS_MAINSIGNALIN(minus_class, t_minus, x_f);
     class_addmethod(minus_class, (t_method)minus_dsp, gensym("dsp"), A_CANT, 0);
     class_sethelpsymbol(minus_class, gensym("sigbinops"));
     scalarminus_class = class_new(gensym("-~"), 0, 0,
         sizeof(t_scalarminus), 0, 0);
+    class_setparalleldsp(scalarminus_class);
     CLASS_MAINSIGNALIN(scalarminus_class, t_scalarminus, x_f);
     class_addmethod(scalarminus_class, (t_method)scalarminus_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -369,13 +380,16 @@ t_int *scalartimes_perf8(t_int *w)
     return (w+5);
 }
 
+SIMD_DEFINE(SIMD_BINOP, times, mul)
+SIMD_DEFINE(SIMD_SCALAROP, scalartimes, mul)
+
 static void times_dsp(t_times *x, t_signal **sp)
 {
     if (sp[0]->s_n&7)
         dsp_add(times_perform, 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
     else
-        dsp_add(times_perf8, 4,
+        dsp_add(SIMD_PERFORM(times_perf8, times), 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
 }
 
@@ -385,19 +399,21 @@ static void scalartimes_dsp(t_scalartimes *x, t_signal **sp)
         dsp_add(scalartimes_perform, 4, sp[0]->s_vec, &x->x_g,
             sp[1]->s_vec, sp[0]->s_n);
     else
-        dsp_add(scalartimes_perf8, 4, sp[0]->s_vec, &x->x_g,
-            sp[1]->s_vec, sp[0]->s_n);
+        dsp_add(SIMD_PERFORM(scalartimes_perf8, scalartimes), 4,
+            sp[0]->s_vec, &x->x_g, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void times_setup(void)
 {
     times_class = class_new(gensym("*~"), (t_newmethod)times_new, 0,
         sizeof(t_times), 0, A_GIMME, 0);
+    class_setparalleldsp(times_class);
     CLASS_MAINSIGNALIN(times_class, t_times, x_f);
     class_addmethod(times_class, (t_method)times_dsp, gensym("dsp"), A_CANT, 0);
     class_sethelpsymbol(times_class, gensym("sigbinops"));
     scalartimes_class = class_new(gensym("*~"), 0, 0,
         sizeof(t_scalartimes), 0, 0);
+    class_setparalleldsp(scalartimes_class);
     CLASS_MAINSIGNALIN(scalartimes_class, t_scalartimes, x_f);
     class_addmethod(scalartimes_class, (t_method)scalartimes_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -511,13 +527,37 @@ t_int *scalarover_perf8(t_int *w)
     return (w+5);
 }
 
+    /* like SIMD_SCALAROP() but dividing by the scalar, which scalarover_perf8
+    does by multiplying with its reciprocal */
+#define SIMD_SCALAROVER(name, v, op, attr) \
+attr static t_int *name##_perf##v(t_int *w) \
+{ \
+    t_sample *in = (t_sample *)(w[1]); \
+    t_float f = *(t_float *)(w[2]); \
+    t_sample *out = (t_sample *)(w[3]); \
+    int n = (int)(w[4]); \
+    t_##v g; \
+    if (f) f = 1.f / f; \
+    g = v##_set1(f); \
+    for (; n; n -= 8, in += 8, out += 8) \
+    { \
+        v##_store(out, op(v##_load(in), g)); \
+        if (sizeof(t_##v) < 8 * sizeof(t_sample)) \
+            v##_store(out+4, op(v##_load(in+4), g)); \
+    } \
+    return (w+5); \
+}
+
+SIMD_DEFINE(SIMD_BINOP, over, divnz)
+SIMD_DEFINE(SIMD_SCALAROVER, scalarover, mul)
+
 static void over_dsp(t_over *x, t_signal **sp)
 {
     if (sp[0]->s_n&7)
         dsp_add(over_perform, 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
     else
-        dsp_add(over_perf8, 4,
+        dsp_add(SIMD_PERFORM(over_perf8, over), 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
 }
 
@@ -527,19 +567,21 @@ static void scalarover_dsp(t_scalarover *x, t_signal **sp)
         dsp_add(scalarover_perform, 4, sp[0]->s_vec, &x->x_g,
             sp[1]->s_vec, sp[0]->s_n);
     else
-        dsp_add(scalarover_perf8, 4, sp[0]->s_vec, &x->x_g,
-            sp[1]->s_vec, sp[0]->s_n);
+        dsp_add(SIMD_PERFORM(scalarover_perf8, scalarover), 4,
+            sp[0]->s_vec, &x->x_g, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void over_setup(void)
 {
     over_class = class_new(gensym("/~"), (t_newmethod)over_new, 0,
         sizeof(t_over), 0, A_GIMME, 0);
+    class_setparalleldsp(over_class);
     CLASS_MAINSIGNALIN(over_class, t_over, x_f);
     class_addmethod(over_class, (t_method)over_dsp, gensym("dsp"), A_CANT, 0);
     class_sethelpsymbol(over_class, gensym("sigbinops"));
     scalarover_class = class_new(gensym("/~"), 0, 0,
         sizeof(t_scalarover), 0, 0);
+    class_setparalleldsp(scalarover_class);
     CLASS_MAINSIGNALIN(scalarover_class, t_scalarover, x_f);
     class_addmethod(scalarover_class, (t_method)scalarover_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -653,13 +695,16 @@ t_int *scalarmax_perf8(t_int *w)
     return (w+5);
 }
 
+SIMD_DEFINE(SIMD_BINOP, max, max)
+SIMD_DEFINE(SIMD_SCALAROP, scalarmax, max)
+
 static void max_dsp(t_max *x, t_signal **sp)
 {
     if (sp[0]->s_n&7)
         dsp_add(max_perform, 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
     else
-        dsp_add(max_perf8, 4,
+        dsp_add(SIMD_PERFORM(max_perf8, max), 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
 }
 
@@ -669,19 +714,21 @@ static void scalarmax_dsp(t_scalarmax *x, t_signal **sp)
         dsp_add(scalarmax_perform, 4, sp[0]->s_vec, &x->x_g,
             sp[1]->s_vec, sp[0]->s_n);
     else
-        dsp_add(scalarmax_perf8, 4, sp[0]->s_vec, &x->x_g,
-            sp[1]->s_vec, sp[0]->s_n);
+        dsp_add(SIMD_PERFORM(scalarmax_perf8, scalarmax), 4,
+            sp[0]->s_vec, &x->x_g, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void max_setup(void)
 {
     max_class = class_new(gensym("max~"), (t_newmethod)max_new, 0,
         sizeof(t_max), 0, A_GIMME, 0);
+    class_setparalleldsp(max_class);
     CLASS_MAINSIGNALIN(max_class, t_max, x_f);
     class_addmethod(max_class, (t_method)max_dsp, gensym("dsp"), A_CANT, 0);
     class_sethelpsymbol(max_class, gensym("sigbinops"));
     scalarmax_class = class_new(gensym("max~"), 0, 0,
         sizeof(t_scalarmax), 0, 0);
+    class_setparalleldsp(scalarmax_class);
     CLASS_MAINSIGNALIN(scalarmax_class, t_scalarmax, x_f);
     class_addmethod(scalarmax_class, (t_method)scalarmax_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -795,13 +842,16 @@ t_int *scalarmin_perf8(t_int *w)
     return (w+5);
 }
 
+SIMD_DEFINE(SIMD_BINOP, min, min)
+SIMD_DEFINE(SIMD_SCALAROP, scalarmin, min)
+
 static void min_dsp(t_min *x, t_signal **sp)
 {
     if (sp[0]->s_n&7)
         dsp_add(min_perform, 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
     else
-        dsp_add(min_perf8, 4,
+        dsp_add(SIMD_PERFORM(min_perf8, min), 4,
             sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
 }
 
@@ -811,19 +861,21 @@ static void scalarmin_dsp(t_scalarmin *x, t_signal **sp)
         dsp_add(scalarmin_perform, 4, sp[0]->s_vec, &x->x_g,
             sp[1]->s_vec, sp[0]->s_n);
     else
-        dsp_add(scalarmin_perf8, 4, sp[0]->s_vec, &x->x_g,
-            sp[1]->s_vec, sp[0]->s_n);
+        dsp_add(SIMD_PERFORM(scalarmin_perf8, scalarmin), 4,
+            sp[0]->s_vec, &x->x_g, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void min_setup(void)
 {
     min_class = class_new(gensym("min~"), (t_newmethod)min_new, 0,
         sizeof(t_min), 0, A_GIMME, 0);
+    class_setparalleldsp(min_class);
     CLASS_MAINSIGNALIN(min_class, t_min, x_f);
     class_addmethod(min_class, (t_method)min_dsp, gensym("dsp"), A_CANT, 0);
     class_sethelpsymbol(min_class, gensym("sigbinops"));
     scalarmin_class = class_new(gensym("min~"), 0, 0,
         sizeof(t_scalarmin), 0, 0);
+    class_setparalleldsp(scalarmin_class);
     CLASS_MAINSIGNALIN(scalarmin_class, t_scalarmin, x_f);
     class_addmethod(scalarmin_class, (t_method)scalarmin_dsp,
         gensym("dsp"), A_CANT, 0);
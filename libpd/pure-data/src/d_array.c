@@ -18,7 +18,8 @@ typedef struct _tabwrite_tilde
     t_object x_obj;
     int x_phase;
     int x_nsampsintab;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     t_symbol *x_arrayname;
     t_float x_f;
 } t_tabwrite_tilde;
@@ -51,8 +52,8 @@ static t_int *tabwrite_tilde_perform(t_int *w)
 
     if (endphase > phase)
     {
-        int nxfer = endphase - phase;
-        t_word *wp = x->x_vec + phase;
+        int nxfer = endphase - phase, stride = x->x_stride;
+        t_float *fp = x->x_vec + phase * stride;
         if (nxfer > n) nxfer = n;
         phase += nxfer;
         while (nxfer--)
@@ -60,7 +61,8 @@ static t_int *tabwrite_tilde_perform(t_int *w)
             t_sample f = *in++;
             if (PD_BIGORSMALL(f))
                 f = 0;
-            (wp++)->w_float = f;
+            *fp = f;
+            fp += stride;
         }
         if (phase >= endphase)
         {
@@ -85,7 +87,7 @@ static void tabwrite_tilde_set(t_tabwrite_tilde *x, t_symbol *s)
             x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_nsampsintab, &x->x_vec))
+    else if (!garray_getfloatvec(a, &x->x_nsampsintab, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabwrite~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -146,7 +148,8 @@ typedef struct _tabplay_tilde
     int x_phase;
     int x_nsampsintab;
     int x_limit;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     t_symbol *x_arrayname;
     t_clock *x_clock;
 } t_tabplay_tilde;
@@ -169,21 +172,24 @@ static t_int *tabplay_tilde_perform(t_int *w)
 {
     t_tabplay_tilde *x = (t_tabplay_tilde *)(w[1]);
     t_sample *out = (t_sample *)(w[2]);
-    t_word *wp;
-    int n = (int)(w[3]), phase = x->x_phase,
+    t_float *fp;
+    int n = (int)(w[3]), phase = x->x_phase, stride = x->x_stride,
         endphase = (x->x_nsampsintab < x->x_limit ?
             x->x_nsampsintab : x->x_limit), nxfer, n3;
     if (!x->x_vec || phase >= endphase)
         goto zero;
 
     nxfer = endphase - phase;
-    wp = x->x_vec + phase;
+    fp = x->x_vec + phase * stride;
     if (nxfer > n)
         nxfer = n;
     n3 = n - nxfer;
     phase += nxfer;
-    while (nxfer--)
-        *out++ = (wp++)->w_float;
+    if (stride == 1)
+        while (nxfer--)
+            *out++ = *fp++;
+    else while (nxfer--)
+        *out++ = *fp, fp += stride;
     if (phase >= endphase)
     {
         clock_delay(x->x_clock, 0);
@@ -210,7 +216,7 @@ static void tabplay_tilde_set(t_tabplay_tilde *x, t_symbol *s)
             x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_nsampsintab, &x->x_vec))
+    else if (!garray_getfloatvec(a, &x->x_nsampsintab, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabplay~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -274,7 +280,8 @@ typedef struct _tabread_tilde
 {
     t_object x_obj;
     int x_npoints;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     t_symbol *x_arrayname;
     t_float x_f;
 } t_tabread_tilde;
@@ -295,8 +302,8 @@ static t_int *tabread_tilde_perform(t_int *w)
     t_sample *in = (t_sample *)(w[2]);
     t_sample *out = (t_sample *)(w[3]);
     int n = (int)(w[4]);
-    int maxindex;
-    t_word *buf = x->x_vec;
+    int maxindex, stride = x->x_stride;
+    t_float *buf = x->x_vec;
     int i;
 
     maxindex = x->x_npoints - 1;
@@ -310,7 +317,7 @@ static t_int *tabread_tilde_perform(t_int *w)
             index = 0;
         else if (index > maxindex)
             index = maxindex;
-        *out++ = buf[index].w_float;
+        *out++ = buf[index * stride];
     }
     return (w+5);
  zero:
@@ -330,7 +337,7 @@ static void tabread_tilde_set(t_tabread_tilde *x, t_symbol *s)
             pd_error(x, "tabread~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    else if (!garray_getfloatvec(a, &x->x_npoints, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabread~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -371,7 +378,8 @@ typedef struct _tabread4_tilde
 {
     t_object x_obj;
     int x_npoints;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     t_symbol *x_arrayname;
     t_float x_f;
     t_float x_onset;
@@ -395,8 +403,8 @@ static t_int *tabread4_tilde_perform(t_int *w)
     t_sample *in = (t_sample *)(w[2]);
     t_sample *out = (t_sample *)(w[3]);
     int n = (int)(w[4]);
-    int maxindex;
-    t_word *buf = x->x_vec, *wp;
+    int maxindex, stride = x->x_stride;
+    t_float *buf = x->x_vec, *fp;
     double onset = x->x_onset;
     int i;
 
@@ -431,11 +439,11 @@ static t_int *tabread4_tilde_perform(t_int *w)
         else if (index > maxindex)
             index = maxindex, frac = 1;
         else frac = findex - index;
-        wp = buf + index;
-        a = wp[-1].w_float;
-        b = wp[0].w_float;
-        c = wp[1].w_float;
-        d = wp[2].w_float;
+        fp = buf + index * stride;
+        a = fp[-stride];
+        b = fp[0];
+        c = fp[stride];
+        d = fp[2 * stride];
         cminusb = c-b;
         *out++ = b + frac * (
             cminusb - 0.1666667f * (1.-frac) * (
@@ -461,7 +469,7 @@ static void tabread4_tilde_set(t_tabread4_tilde *x, t_symbol *s)
             pd_error(x, "tabread4~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    else if (!garray_getfloatvec(a, &x->x_npoints, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabread4~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -544,7 +552,8 @@ typedef struct _tabosc4_tilde
     t_object x_obj;
     t_float x_fnpoints;
     t_float x_finvnpoints;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     t_symbol *x_arrayname;
     t_float x_f;
     double x_phase;
@@ -575,7 +584,8 @@ static t_int *tabosc4_tilde_perform(t_int *w)
     t_float fnpoints = x->x_fnpoints;
     int mask = fnpoints - 1;
     t_float conv = fnpoints * x->x_conv;
-    t_word *tab = x->x_vec, *addr;
+    t_float *tab = x->x_vec, *addr;
+    int stride = x->x_stride;
     double dphase = fnpoints * x->x_phase + UNITBIT32;
 
     if (!tab) goto zero;
@@ -588,13 +598,13 @@ static t_int *tabosc4_tilde_perform(t_int *w)
         t_sample frac,  a,  b,  c,  d, cminusb;
         tf.tf_d = dphase;
         dphase += *in++ * conv;
-        addr = tab + (tf.tf_i[HIOFFSET] & mask);
+        addr = tab + (tf.tf_i[HIOFFSET] & mask) * stride;
         tf.tf_i[HIOFFSET] = normhipart;
         frac = tf.tf_d - UNITBIT32;
-        a = addr[0].w_float;
-        b = addr[1].w_float;
-        c = addr[2].w_float;
-        d = addr[3].w_float;
+        a = addr[0];
+        b = addr[stride];
+        c = addr[2 * stride];
+        d = addr[3 * stride];
         cminusb = c-b;
         *out++ = b + frac * (
             cminusb - 0.1666667f * (1.-frac) * (
@@ -628,7 +638,7 @@ static void tabosc4_tilde_set(t_tabosc4_tilde *x, t_symbol *s)
             pd_error(x, "tabosc4~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &pointsinarray, &x->x_vec))
+    else if (!garray_getfloatvec(a, &pointsinarray, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabosc4~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -683,7 +693,8 @@ static t_class *tabsend_class;
 typedef struct _tabsend
 {
     t_object x_obj;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     int x_graphperiod;
     int x_graphcount;
     t_symbol *x_arrayname;
@@ -707,8 +718,8 @@ static t_int *tabsend_perform(t_int *w)
     t_tabsend *x = (t_tabsend *)(w[1]);
     t_sample *in = (t_sample *)(w[2]);
     int n = (int)w[3];
-    t_word *dest = x->x_vec;
-    int i = x->x_graphcount;
+    t_float *dest = x->x_vec;
+    int i = x->x_graphcount, stride = x->x_stride;
     if (!x->x_vec) goto bad;
     if (n > x->x_npoints)
         n = x->x_npoints;
@@ -717,7 +728,8 @@ static t_int *tabsend_perform(t_int *w)
         t_sample f = *in++;
         if (PD_BIGORSMALL(f))
             f = 0;
-         (dest++)->w_float = f;
+        *dest = f;
+        dest += stride;
     }
     if (!i--)
     {
@@ -743,7 +755,7 @@ static void tabsend_set(t_tabsend *x, t_symbol *s)
             pd_error(x, "tabsend~: %s: no such array", x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    else if (!garray_getfloatvec(a, &x->x_npoints, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabsend~", x->x_arrayname->s_name);
         x->x_vec = 0;
@@ -780,7 +792,8 @@ static t_class *tabreceive_class;
 typedef struct _tabreceive
 {
     t_object x_obj;
-    t_word *x_vec;
+    t_float *x_vec;
+    int x_stride;
     t_symbol *x_arrayname;
     int x_npoints;
 } t_tabreceive;
@@ -790,14 +803,17 @@ static t_int *tabreceive_perform(t_int *w)
     t_tabreceive *x = (t_tabreceive *)(w[1]);
     t_sample *out = (t_sample *)(w[2]);
     int n = (int)w[3];
-    t_word *from = x->x_vec;
+    t_float *from = x->x_vec;
     if (from)
     {
-        t_int vecsize = x->x_npoints;
+        t_int vecsize = x->x_npoints, stride = x->x_stride;
         if (vecsize > n)
             vecsize = n;
-        while (vecsize--)
-            *out++ = (from++)->w_float;
+        if (stride == 1)
+            while (vecsize--)
+                *out++ = *from++;
+        else while (vecsize--)
+            *out++ = *from, from += stride;
         vecsize = n - x->x_npoints;
         if (vecsize > 0)
             while (vecsize--)
@@ -819,7 +835,7 @@ static void tabreceive_set(t_tabreceive *x, t_symbol *s)
                 x->x_arrayname->s_name);
         x->x_vec = 0;
     }
-    else if (!garray_getfloatwords(a, &x->x_npoints, &x->x_vec))
+    else if (!garray_getfloatvec(a, &x->x_npoints, &x->x_vec, &x->x_stride))
     {
         pd_error(x, "%s: bad template for tabreceive~",
             x->x_arrayname->s_name);
@@ -866,19 +882,19 @@ typedef struct _tabread
 static void tabread_float(t_tabread *x, t_float f)
 {
     t_garray *a;
-    int npoints;
-    t_word *vec;
+    int npoints, stride;
+    t_float *vec;
 
     if (!(a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class)))
         pd_error(x, "%s: no such array", x->x_arrayname->s_name);
-    else if (!garray_getfloatwords(a, &npoints, &vec))
+    else if (!garray_getfloatvec(a, &npoints, &vec, &stride))
         pd_error(x, "%s: bad template for tabread", x->x_arrayname->s_name);
     else
     {
         int n = f;
         if (n < 0) n = 0;
         else if (n >= npoints) n = npoints - 1;
-        outlet_float(x->x_obj.ob_outlet, (npoints ? vec[n].w_float : 0));
+        outlet_float(x->x_obj.ob_outlet, (npoints ? vec[n * stride] : 0));
     }
 }
 
@@ -917,32 +933,32 @@ typedef struct _tabread4
 static void tabread4_float(t_tabread4 *x, t_float f)
 {
     t_garray *a;
-    int npoints;
-    t_word *vec;
+    int npoints, stride;
+    t_float *vec;
 
     if (!(a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class)))
         pd_error(x, "%s: no such array", x->x_arrayname->s_name);
-    else if (!garray_getfloatwords(a, &npoints, &vec))
+    else if (!garray_getfloatvec(a, &npoints, &vec, &stride))
         pd_error(x, "%s: bad template for tabread4", x->x_arrayname->s_name);
     else if (npoints < 4)
         outlet_float(x->x_obj.ob_outlet, 0);
     else if (f <= 1)
-        outlet_float(x->x_obj.ob_outlet, vec[1].w_float);
+        outlet_float(x->x_obj.ob_outlet, vec[stride]);
     else if (f >= npoints - 2)
-        outlet_float(x->x_obj.ob_outlet, vec[npoints - 2].w_float);
+        outlet_float(x->x_obj.ob_outlet, vec[(npoints - 2) * stride]);
     else
     {
         int n = f;
         float a, b, c, d, cminusb, frac;
-        t_word *wp;
+        t_float *fp;
         if (n >= npoints - 2)
             n = npoints - 3;
-        wp = vec + n;
+        fp = vec + n * stride;
         frac = f - n;
-        a = wp[-1].w_float;
-        b = wp[0].w_float;
-        c = wp[1].w_float;
-        d = wp[2].w_float;
+        a = fp[-stride];
+        b = fp[0];
+        c = fp[stride];
+        d = fp[2 * stride];
         cminusb = c-b;
         outlet_float(x->x_obj.ob_outlet, b + frac * (
             cminusb - 0.1666667f * (1.-frac) * (
@@ -985,13 +1001,13 @@ typedef struct _tabwrite
 
 static void tabwrite_float(t_tabwrite *x, t_float f)
 {
-    int vecsize;
+    int vecsize, stride;
     t_garray *a;
-    t_word *vec;
+    t_float *vec;
 
     if (!(a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class)))
         pd_error(x, "%s: no such array", x->x_arrayname->s_name);
-    else if (!garray_getfloatwords(a, &vecsize, &vec))
+    else if (!garray_getfloatvec(a, &vecsize, &vec, &stride))
         pd_error(x, "%s: bad template for tabwrite", x->x_arrayname->s_name);
     else
     {
@@ -1000,7 +1016,7 @@ static void tabwrite_float(t_tabwrite *x, t_float f)
             n = 0;
         else if (n >= vecsize)
             n = vecsize-1;
-        vec[n].w_float = f;
+        vec[n * stride] = f;
         garray_redraw(a);
     }
 }
@@ -78,6 +78,7 @@ static void sig_tilde_setup(void)
 {
     sig_tilde_class = class_new(gensym("sig~"), (t_newmethod)sig_tilde_new, 0,
         sizeof(t_sig), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(sig_tilde_class);
     class_addfloat(sig_tilde_class, (t_method)sig_tilde_float);
     class_addmethod(sig_tilde_class, (t_method)sig_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -219,6 +220,7 @@ static void line_tilde_setup(void)
 {
     line_tilde_class = class_new(gensym("line~"), line_tilde_new, 0,
         sizeof(t_line), 0, 0);
+    class_setparalleldsp(line_tilde_class);
     class_addfloat(line_tilde_class, (t_method)line_tilde_float);
     class_addmethod(line_tilde_class, (t_method)line_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -228,7 +230,6 @@ static void line_tilde_setup(void)
 
 /* -------------------------- vline~ ------------------------------ */
 static t_class *vline_tilde_class;
-#include "s_stuff.h"    /* for DEFDACBLKSIZE; this should be in m_pd.h */
 typedef struct _vseg
 {
     double s_targettime;
@@ -266,7 +267,8 @@ static t_int *vline_tilde_perform(t_int *w)
     t_vseg *s = x->x_list;
     if (logicaltimenow != x->x_lastlogicaltime)
     {
-        int sampstotime = (n > DEFDACBLKSIZE ? n : DEFDACBLKSIZE);
+        int blocksize = sys_getblksize();
+        int sampstotime = (n > blocksize ? n : blocksize);
         x->x_lastlogicaltime = logicaltimenow;
         x->x_nextblocktime = logicaltimenow - sampstotime * msecpersamp;
     }
@@ -467,6 +469,7 @@ static void snapshot_tilde_setup(void)
 {
     snapshot_tilde_class = class_new(gensym("snapshot~"), snapshot_tilde_new, 0,
         sizeof(t_snapshot), 0, 0);
+    class_setparalleldsp(snapshot_tilde_class);
     CLASS_MAINSIGNALIN(snapshot_tilde_class, t_snapshot, x_f);
     class_addmethod(snapshot_tilde_class, (t_method)snapshot_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -555,6 +558,7 @@ static void vsnapshot_tilde_setup(void)
     vsnapshot_tilde_class = class_new(gensym("vsnapshot~"),
         vsnapshot_tilde_new, (t_method)vsnapshot_tilde_ff,
         sizeof(t_vsnapshot), 0, 0);
+    class_setparalleldsp(vsnapshot_tilde_class);
     CLASS_MAINSIGNALIN(vsnapshot_tilde_class, t_vsnapshot, x_f);
     class_addmethod(vsnapshot_tilde_class, (t_method)vsnapshot_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
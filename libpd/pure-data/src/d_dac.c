@@ -45,14 +45,15 @@ static void dac_dsp(t_dac *x, t_signal **sp)
 {
     t_int i, *ip;
     t_signal **sp2;
+    int blocksize = sys_getblksize();
     for (i = x->x_n, ip = x->x_vec, sp2 = sp; i--; ip++, sp2++)
     {
         int ch = (int)(*ip - 1);
-        if ((*sp2)->s_n != DEFDACBLKSIZE)
+        if ((*sp2)->s_n != blocksize)
             error("dac~: bad vector size");
         else if (ch >= 0 && ch < sys_get_outchannels())
-            dsp_add(plus_perform, 4, STUFF->st_soundout + DEFDACBLKSIZE*ch,
-                (*sp2)->s_vec, STUFF->st_soundout + DEFDACBLKSIZE*ch, DEFDACBLKSIZE);
+            dsp_add(plus_perform, 4, STUFF->st_soundout + blocksize*ch,
+                (*sp2)->s_vec, STUFF->st_soundout + blocksize*ch, blocksize);
     }
 }
 
@@ -160,15 +161,16 @@ static void adc_dsp(t_adc *x, t_signal **sp)
 {
     t_int i, *ip;
     t_signal **sp2;
+    int blocksize = sys_getblksize();
     for (i = x->x_n, ip = x->x_vec, sp2 = sp; i--; ip++, sp2++)
     {
         int ch = (int)(*ip - 1);
-        if ((*sp2)->s_n != DEFDACBLKSIZE)
+        if ((*sp2)->s_n != blocksize)
             error("adc~: bad vector size");
         else if (ch >= 0 && ch < sys_get_inchannels())
-            dsp_add_copy(STUFF->st_soundin + DEFDACBLKSIZE*ch,
-                (*sp2)->s_vec, DEFDACBLKSIZE);
-        else dsp_add_zero((*sp2)->s_vec, DEFDACBLKSIZE);
+            dsp_add_copy(STUFF->st_soundin + blocksize*ch,
+                (*sp2)->s_vec, blocksize);
+        else dsp_add_zero((*sp2)->s_vec, blocksize);
     }
 }
 
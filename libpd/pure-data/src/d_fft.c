@@ -8,7 +8,9 @@
 to implement the "fft~", etc, Pd objects.  If using Mayer, also compile
 d_fft_mayer.c; if ooura, use d_fft_fftsg.c instead; if fftw, use d_fft_fftw.c
 and also link in the fftw library.  You can only have one of these three
-linked in.  The configure script can be used to select which one.
+linked in.  The configure script can be used to select which one.  With
+Ooura or fftw, also compile d_fft_simd.c, which takes over power-of-two
+transforms unless "pd fft-backend" hands them back at run time.
 */
 
 /* ------------------ initialization and cleanup -------------------------- */
@@ -21,6 +21,7 @@ for another, more permissive-sounding copyright notice.  -MSP
 /* ---------- Pd interface to OOURA FFT; imitate Mayer API ---------- */
 #include "m_pd.h"
 #include "m_imp.h"
+#include <stdlib.h>
 
 #ifdef _WIN32
 # include <malloc.h> /* MSVC or mingw on windows */
@@ -36,10 +37,34 @@ void rdft(int, int, FFTFLT *, int *, FFTFLT *);
 
 int ilog2(int n);
 
-static PERTHREAD int ooura_maxn;
-static PERTHREAD int *ooura_bitrev;
-static PERTHREAD int ooura_bitrevsize;
-static PERTHREAD FFTFLT *ooura_costab;
+    /* d_fft_simd.c gets the first chance at each transform */
+int simdfft_fft(int n, t_sample *re, t_sample *im, int inverse);
+int simdfft_realfft(int n, t_sample *fz);
+int simdfft_realifft(int n, t_sample *fz);
+int simdfft_pdfft(t_float *buf, int npoints, int inverse);
+void simdfft_term(void);
+
+const char mayer_backend[] = "ooura";
+
+    /* The tables are kept per thread wherever there may be threads, even
+    without PDINSTANCE, so that analyses running on worker threads (see
+    worker_new()) can't reallocate them under the DSP thread's feet.  They
+    come from calloc() since getbytes() may not be called from those, and
+    for the same reason running out of memory isn't reported here. */
+#if PDTHREADS
+#ifdef _MSC_VER
+#define OOURA_PERTHREAD __declspec(thread)
+#else
+#define OOURA_PERTHREAD __thread
+#endif
+#else
+#define OOURA_PERTHREAD
+#endif
+
+static OOURA_PERTHREAD int ooura_maxn;
+static OOURA_PERTHREAD int *ooura_bitrev;
+static OOURA_PERTHREAD int ooura_bitrevsize;
+static OOURA_PERTHREAD FFTFLT *ooura_costab;
 
 static int ooura_init( int n)
 {
@@ -52,23 +77,20 @@ static int ooura_init( int n)
         {
             if (ooura_maxn)
             {
-                t_freebytes(ooura_bitrev, ooura_bitrevsize);
-                t_freebytes(ooura_costab, ooura_maxn * sizeof(FFTFLT) / 2);
+                free(ooura_bitrev);
+                free(ooura_costab);
             }
             ooura_bitrevsize = sizeof(int) * (2 + (1 << (ilog2(n)/2)));
-            ooura_bitrev = (int *)t_getbytes(ooura_bitrevsize);
-            ooura_bitrev[0] = 0;
+            ooura_bitrev = (int *)calloc(1, ooura_bitrevsize);
             if (!ooura_bitrev)
             {
-                error("out of memory allocating FFT buffer");
                 ooura_maxn = 0;
                 return (0);
             }
-            ooura_costab = (FFTFLT *)t_getbytes(n * sizeof(FFTFLT)/2);
+            ooura_costab = (FFTFLT *)calloc(n/2, sizeof(FFTFLT));
             if (!ooura_costab)
             {
-                error("out of memory allocating FFT buffer");
-                t_freebytes(ooura_bitrev, ooura_bitrevsize);
+                free(ooura_bitrev);
                 ooura_maxn = 0;
                 return (0);
             }
@@ -82,8 +104,8 @@ static int ooura_init( int n)
 static void ooura_term() {
   if (!ooura_maxn)
     return;
-  t_freebytes(ooura_bitrev, ooura_bitrevsize);
-  t_freebytes(ooura_costab, ooura_maxn * sizeof(FFTFLT)/2);
+  free(ooura_bitrev);
+  free(ooura_costab);
   ooura_maxn = 0;
   ooura_bitrev = 0;
   ooura_bitrevsize = 0;
@@ -103,7 +125,10 @@ void mayer_init()
 void mayer_term()
 {
     if (--mayer_refcount == 0)  /* clean up */
+    {
         ooura_term();
+        simdfft_term();
+    }
 }
 
 /* -------- public routines -------- */
@@ -117,6 +142,8 @@ EXTERN void mayer_dofft(t_sample *fz1, t_sample *fz2, int n, int sgn)
     FFTFLT *buf, *fp3;
     int i;
     t_sample *fp1, *fp2;
+    if (simdfft_fft(n, fz1, fz2, (sgn > 0)))
+        return;
     buf = alloca(n * (2 * sizeof(FFTFLT)));
     if (!ooura_init(2*n))
         return;
@@ -150,6 +177,8 @@ EXTERN void mayer_realfft(int n, t_sample *fz)
     FFTFLT *buf, *fp3;
     int i, nover2 = n/2;
     t_sample *fp1, *fp2;
+    if (simdfft_realfft(n, fz))
+        return;
     buf = alloca(n * sizeof(FFTFLT));
     if (!ooura_init(n))
         return;
@@ -168,6 +197,8 @@ EXTERN void mayer_realifft(int n, t_sample *fz)
     FFTFLT *buf, *fp3;
     int i, nover2 = n/2;
     t_sample *fp1, *fp2;
+    if (simdfft_realifft(n, fz))
+        return;
     buf = alloca(n * sizeof(FFTFLT));
     if (!ooura_init(n))
         return;
@@ -185,9 +216,12 @@ EXTERN void mayer_realifft(int n, t_sample *fz)
     here and there. */
 void pd_fft(t_float *buf, int npoints, int inverse)
 {
-    FFTFLT *buf2 = (FFTFLT *)alloca(2 * npoints * sizeof(FFTFLT)), *bp2;
+    FFTFLT *buf2, *bp2;
     t_float *fp;
     int i;
+    if (simdfft_pdfft(buf, npoints, inverse))
+        return;
+    buf2 = (FFTFLT *)alloca(2 * npoints * sizeof(FFTFLT));
     if (!ooura_init(2*npoints))
         return;
     for (i = 0, bp2 = buf2, fp = buf; i < 2 * npoints; i++, bp2++, fp++)
@@ -11,6 +11,15 @@
 
 int ilog2(int n);
 
+    /* d_fft_simd.c gets the first chance at each transform */
+int simdfft_fft(int n, t_sample *re, t_sample *im, int inverse);
+int simdfft_realfft(int n, t_sample *fz);
+int simdfft_realifft(int n, t_sample *fz);
+int simdfft_pdfft(t_float *buf, int npoints, int inverse);
+void simdfft_term(void);
+
+const char mayer_backend[] = "fftw";
+
 #define MINFFT 0
 #define MAXFFT 30
 
@@ -163,6 +172,7 @@ void mayer_term(void)
     {
         cfftw_term();
         rfftw_term();
+        simdfft_term();
     }
 }
 
@@ -176,7 +186,10 @@ static void mayer_do_cfft(int n, t_sample *fz1, t_sample *fz2, int fwd)
 {
     int i;
     float *fz;
-    cfftw_info *p = cfftw_getplan(n, fwd);
+    cfftw_info *p;
+    if (simdfft_fft(n, fz1, fz2, !fwd))
+        return;
+    p = cfftw_getplan(n, fwd);
     if (!p)
         return;
 
@@ -208,7 +221,10 @@ EXTERN void mayer_ifft(int n, t_sample *fz1, t_sample *fz2)
 EXTERN void mayer_realfft(int n, t_sample *fz)
 {
     int i;
-    rfftw_info *p = rfftw_getplan(n, 1);
+    rfftw_info *p;
+    if (simdfft_realfft(n, fz))
+        return;
+    p = rfftw_getplan(n, 1);
     if (!p)
         return;
 
@@ -224,7 +240,10 @@ EXTERN void mayer_realfft(int n, t_sample *fz)
 EXTERN void mayer_realifft(int n, t_sample *fz)
 {
     int i;
-    rfftw_info *p = rfftw_getplan(n, 0);
+    rfftw_info *p;
+    if (simdfft_realifft(n, fz))
+        return;
+    p = rfftw_getplan(n, 0);
     if (!p)
         return;
 
@@ -241,9 +260,12 @@ EXTERN void mayer_realifft(int n, t_sample *fz)
     here and there. */
 void pd_fft(t_float *buf, int npoints, int inverse)
 {
-    cfftw_info *p = cfftw_getplan(npoints, !inverse);
+    cfftw_info *p;
     int i;
     float *fz;
+    if (simdfft_pdfft(buf, npoints, inverse))
+        return;
+    p = cfftw_getplan(npoints, !inverse);
     for (i = 0, fz = (float *)(p->in); i < 2 * npoints; i++)
         *fz++ = buf[i];
     fftwf_execute(p->plan);
@@ -0,0 +1,549 @@
+/* Copyright (c) 1997- Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/* A vectorized FFT that sits in front of whichever of Ooura or FFTW is
+linked in (see d_fft.c).  The mayer_*() and pd_fft() routines of that
+package first offer each transform to simdfft_*() below, which returns
+zero to decline it -- if another backend has been chosen with the
+"pd fft-backend" message, if the size isn't a power of two, or if it is
+too small to bother.
+
+The complex transform is a radix-4 Stockham ("self-sorting") FFT on split
+real and imaginary arrays, with a radix-2 pass at the end for odd powers
+of two.  Each pass reads one buffer and writes another so no bit-reversal
+is needed, and for all but the first pass the butterflies for neighbouring
+sub-transforms sit next to each other in memory, so they vectorize
+directly with the v4 and v8 routines in d_simd.h.  Real transforms of 2n
+points are done as complex transforms of n points followed by the usual
+split into even and odd parts.
+
+Twiddle factors and scratch space for each size are computed once and kept
+in a "plan".  The plans are kept per thread, like Ooura's tables, so that
+analyses running on worker threads (see worker_new()) need no locking; for
+the same reason they come from malloc() and running out of memory simply
+hands the transform back to the built-in backend. */
+
+#include "m_pd.h"
+#include "d_simd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int ilog2(int n);
+
+    /* the name of the backend linked in, from d_fft_fftsg.c or d_fft_fftw.c */
+extern const char mayer_backend[];
+
+int worker_threaded(void);
+
+#if PDTHREADS
+#ifdef _MSC_VER
+#define SIMDFFT_PERTHREAD __declspec(thread)
+#else
+#define SIMDFFT_PERTHREAD __thread
+#endif
+#else
+#define SIMDFFT_PERTHREAD
+#endif
+
+#define SIMDFFT_MAXLOG 30
+
+typedef struct _fftplan
+{
+    int p_n;            /* number of complex points */
+    t_sample *p_tw;     /* twiddles for each radix-4 pass */
+    t_sample *p_rtw;    /* twiddles for real transforms of 2n points */
+    t_sample *p_work;   /* 4n points of scratch */
+} t_fftplan;
+
+static SIMDFFT_PERTHREAD t_fftplan *simdfft_plans[SIMDFFT_MAXLOG+1];
+
+    /* selected with "pd fft-backend"; on by default if we can vectorize */
+#ifdef SIMD_V4
+static int simdfft_on = 1;
+#else
+static int simdfft_on = 0;
+#endif
+
+/* ------------------------- plans ---------------------------- */
+
+static void simdfft_freeplan(t_fftplan *x)
+{
+    free(x->p_tw);
+    free(x->p_rtw);
+    free(x->p_work);
+    free(x);
+}
+
+static t_fftplan *simdfft_newplan(int n)
+{
+    t_fftplan *x = (t_fftplan *)calloc(1, sizeof(*x));
+    int ns, p, ntw = 0;
+    t_sample *tw;
+    if (!x)
+        return (0);
+    for (ns = n; ns >= 4; ns /= 4)
+        ntw += 6 * (ns/4);
+    x->p_n = n;
+    x->p_tw = (t_sample *)malloc((ntw ? ntw : 1) * sizeof(t_sample));
+    x->p_rtw = (t_sample *)malloc(2 * n * sizeof(t_sample));
+    x->p_work = (t_sample *)malloc(4 * n * sizeof(t_sample));
+    if (!x->p_tw || !x->p_rtw || !x->p_work)
+    {
+        simdfft_freeplan(x);
+        return (0);
+    }
+        /* each pass of ns points with m = ns/4 takes 6m twiddles, laid out
+        as w1 real, w1 imaginary, then w2 and w3 likewise */
+    for (ns = n, tw = x->p_tw; ns >= 4; tw += 6 * (ns/4), ns /= 4)
+    {
+        int m = ns/4;
+        for (p = 0; p < m; p++)
+        {
+            double a = -2 * 3.14159265358979323846 * p / ns;
+            tw[p] = cos(a);
+            tw[m + p] = sin(a);
+            tw[2*m + p] = cos(2*a);
+            tw[3*m + p] = sin(2*a);
+            tw[4*m + p] = cos(3*a);
+            tw[5*m + p] = sin(3*a);
+        }
+    }
+    for (p = 0; p < n; p++)
+    {
+        double a = 3.14159265358979323846 * p / n;
+        x->p_rtw[p] = cos(a);
+        x->p_rtw[n + p] = -sin(a);
+    }
+    return (x);
+}
+
+    /* find or make the plan for an n-point complex transform */
+static t_fftplan *simdfft_getplan(int n)
+{
+    int logn = ilog2(n);
+    if (n < 4 || n != (1 << logn) || logn > SIMDFFT_MAXLOG)
+        return (0);
+    if (!simdfft_plans[logn])
+        simdfft_plans[logn] = simdfft_newplan(n);
+    return (simdfft_plans[logn]);
+}
+
+    /* free the calling thread's plans */
+void simdfft_term(void)
+{
+    int i;
+    for (i = 0; i <= SIMDFFT_MAXLOG; i++)
+        if (simdfft_plans[i])
+            simdfft_freeplan(simdfft_plans[i]), simdfft_plans[i] = 0;
+}
+
+/* ---------------------- radix-4 passes ------------------------ */
+
+    /* one pass of n points with stride s: the four inputs of butterfly
+    (p, q) are at q + s*p + k*s*m, the four outputs at q + 4*s*p + k*s. */
+static void simdfft_radix4_scalar(int n, int s, const t_sample *xr,
+    const t_sample *xi, t_sample *yr, t_sample *yi, const t_sample *tw)
+{
+    int m = n / s / 4, sm = s * m, p, q;
+    for (p = 0; p < m; p++)
+    {
+        t_sample w1r = tw[p], w1i = tw[m+p], w2r = tw[2*m+p],
+            w2i = tw[3*m+p], w3r = tw[4*m+p], w3i = tw[5*m+p];
+        const t_sample *ar = xr + s*p, *ai = xi + s*p;
+        t_sample *ypr = yr + 4*s*p, *ypi = yi + 4*s*p;
+        for (q = 0; q < s; q++)
+        {
+            t_sample apcr = ar[q] + ar[q+2*sm], apci = ai[q] + ai[q+2*sm];
+            t_sample amcr = ar[q] - ar[q+2*sm], amci = ai[q] - ai[q+2*sm];
+            t_sample bpdr = ar[q+sm] + ar[q+3*sm],
+                bpdi = ai[q+sm] + ai[q+3*sm];
+            t_sample bmdr = ar[q+sm] - ar[q+3*sm],
+                bmdi = ai[q+sm] - ai[q+3*sm];
+            t_sample t1r = amcr + bmdi, t1i = amci - bmdr;
+            t_sample t2r = apcr - bpdr, t2i = apci - bpdi;
+            t_sample t3r = amcr - bmdi, t3i = amci + bmdr;
+            ypr[q] = apcr + bpdr;
+            ypi[q] = apci + bpdi;
+            ypr[q+s] = w1r * t1r - w1i * t1i;
+            ypi[q+s] = w1r * t1i + w1i * t1r;
+            ypr[q+2*s] = w2r * t2r - w2i * t2i;
+            ypi[q+2*s] = w2r * t2i + w2i * t2r;
+            ypr[q+3*s] = w3r * t3r - w3i * t3i;
+            ypi[q+3*s] = w3r * t3i + w3i * t3r;
+        }
+    }
+}
+
+    /* the last pass for odd powers of two: n = 2, no twiddles */
+static void simdfft_radix2(int s, const t_sample *xr, const t_sample *xi,
+    t_sample *yr, t_sample *yi)
+{
+    int q = 0;
+#ifdef SIMD_V4
+    for (; q + 4 <= s; q += 4)
+    {
+        t_v4 ar = v4_load(xr+q), ai = v4_load(xi+q),
+            br = v4_load(xr+q+s), bi = v4_load(xi+q+s);
+        v4_store(yr+q, v4_add(ar, br));
+        v4_store(yi+q, v4_add(ai, bi));
+        v4_store(yr+q+s, v4_sub(ar, br));
+        v4_store(yi+q+s, v4_sub(ai, bi));
+    }
+#endif
+    for (; q < s; q++)
+    {
+        t_sample ar = xr[q], ai = xi[q], br = xr[q+s], bi = xi[q+s];
+        yr[q] = ar + br, yi[q] = ai + bi;
+        yr[q+s] = ar - br, yi[q+s] = ai - bi;
+    }
+}
+
+#ifdef SIMD_V4
+    /* complex multiply of vectors */
+#define v4_cmulr(wr, wi, tr, ti) v4_sub(v4_mul(wr, tr), v4_mul(wi, ti))
+#define v4_cmuli(wr, wi, tr, ti) v4_add(v4_mul(wr, ti), v4_mul(wi, tr))
+
+    /* the radix-4 butterfly itself, shared by the passes below */
+#define SIMDFFT_BUTTERFLY(T, add, sub, cmulr, cmuli) \
+    T apcr = add(ar, cr), apci = add(ai, ci); \
+    T amcr = sub(ar, cr), amci = sub(ai, ci); \
+    T bpdr = add(br, dr), bpdi = add(bi, di); \
+    T bmdr = sub(br, dr), bmdi = sub(bi, di); \
+    T t1r = add(amcr, bmdi), t1i = sub(amci, bmdr); \
+    T t2r = sub(apcr, bpdr), t2i = sub(apci, bpdi); \
+    T t3r = sub(amcr, bmdi), t3i = add(amci, bmdr); \
+    T y0r = add(apcr, bpdr), y0i = add(apci, bpdi); \
+    T y1r = cmulr(w1r, w1i, t1r, t1i), y1i = cmuli(w1r, w1i, t1r, t1i); \
+    T y2r = cmulr(w2r, w2i, t2r, t2i), y2i = cmuli(w2r, w2i, t2r, t2i); \
+    T y3r = cmulr(w3r, w3i, t3r, t3i), y3i = cmuli(w3r, w3i, t3r, t3i);
+
+    /* the first pass (s = 1): vectorize over p and transpose so that the
+    four outputs of each butterfly land next to each other */
+static void simdfft_radix4_first(int n, const t_sample *xr,
+    const t_sample *xi, t_sample *yr, t_sample *yi, const t_sample *tw)
+{
+    int m = n/4, p;
+    for (p = 0; p < m; p += 4)
+    {
+        t_v4 ar = v4_load(xr+p), ai = v4_load(xi+p);
+        t_v4 br = v4_load(xr+m+p), bi = v4_load(xi+m+p);
+        t_v4 cr = v4_load(xr+2*m+p), ci = v4_load(xi+2*m+p);
+        t_v4 dr = v4_load(xr+3*m+p), di = v4_load(xi+3*m+p);
+        t_v4 w1r = v4_load(tw+p), w1i = v4_load(tw+m+p);
+        t_v4 w2r = v4_load(tw+2*m+p), w2i = v4_load(tw+3*m+p);
+        t_v4 w3r = v4_load(tw+4*m+p), w3i = v4_load(tw+5*m+p);
+        SIMDFFT_BUTTERFLY(t_v4, v4_add, v4_sub, v4_cmulr, v4_cmuli)
+        v4_transpose(y0r, y1r, y2r, y3r);
+        v4_transpose(y0i, y1i, y2i, y3i);
+        v4_store(yr+4*p, y0r); v4_store(yr+4*p+4, y1r);
+        v4_store(yr+4*p+8, y2r); v4_store(yr+4*p+12, y3r);
+        v4_store(yi+4*p, y0i); v4_store(yi+4*p+4, y1i);
+        v4_store(yi+4*p+8, y2i); v4_store(yi+4*p+12, y3i);
+    }
+}
+
+    /* later passes (s >= 4): vectorize over q with the twiddles fixed */
+static void simdfft_radix4_v4(int n, int s, const t_sample *xr,
+    const t_sample *xi, t_sample *yr, t_sample *yi, const t_sample *tw)
+{
+    int m = n / s / 4, sm = s * m, p, q;
+    for (p = 0; p < m; p++)
+    {
+        t_v4 w1r = v4_set1(tw[p]), w1i = v4_set1(tw[m+p]);
+        t_v4 w2r = v4_set1(tw[2*m+p]), w2i = v4_set1(tw[3*m+p]);
+        t_v4 w3r = v4_set1(tw[4*m+p]), w3i = v4_set1(tw[5*m+p]);
+        const t_sample *xpr = xr + s*p, *xpi = xi + s*p;
+        t_sample *ypr = yr + 4*s*p, *ypi = yi + 4*s*p;
+        for (q = 0; q < s; q += 4)
+        {
+            t_v4 ar = v4_load(xpr+q), ai = v4_load(xpi+q);
+            t_v4 br = v4_load(xpr+q+sm), bi = v4_load(xpi+q+sm);
+            t_v4 cr = v4_load(xpr+q+2*sm), ci = v4_load(xpi+q+2*sm);
+            t_v4 dr = v4_load(xpr+q+3*sm), di = v4_load(xpi+q+3*sm);
+            SIMDFFT_BUTTERFLY(t_v4, v4_add, v4_sub, v4_cmulr, v4_cmuli)
+            v4_store(ypr+q, y0r); v4_store(ypi+q, y0i);
+            v4_store(ypr+q+s, y1r); v4_store(ypi+q+s, y1i);
+            v4_store(ypr+q+2*s, y2r); v4_store(ypi+q+2*s, y2i);
+            v4_store(ypr+q+3*s, y3r); v4_store(ypi+q+3*s, y3i);
+        }
+    }
+}
+#endif /* SIMD_V4 */
+
+#ifdef SIMD_AVX2
+#define v8_cmulr(wr, wi, tr, ti) v8_sub(v8_mul(wr, tr), v8_mul(wi, ti))
+#define v8_cmuli(wr, wi, tr, ti) v8_add(v8_mul(wr, ti), v8_mul(wi, tr))
+
+static SIMD_TARGET void simdfft_radix4_v8(int n, int s, const t_sample *xr,
+    const t_sample *xi, t_sample *yr, t_sample *yi, const t_sample *tw)
+{
+    int m = n / s / 4, sm = s * m, p, q;
+    for (p = 0; p < m; p++)
+    {
+        t_v8 w1r = v8_set1(tw[p]), w1i = v8_set1(tw[m+p]);
+        t_v8 w2r = v8_set1(tw[2*m+p]), w2i = v8_set1(tw[3*m+p]);
+        t_v8 w3r = v8_set1(tw[4*m+p]), w3i = v8_set1(tw[5*m+p]);
+        const t_sample *xpr = xr + s*p, *xpi = xi + s*p;
+        t_sample *ypr = yr + 4*s*p, *ypi = yi + 4*s*p;
+        for (q = 0; q < s; q += 8)
+        {
+            t_v8 ar = v8_load(xpr+q), ai = v8_load(xpi+q);
+            t_v8 br = v8_load(xpr+q+sm), bi = v8_load(xpi+q+sm);
+            t_v8 cr = v8_load(xpr+q+2*sm), ci = v8_load(xpi+q+2*sm);
+            t_v8 dr = v8_load(xpr+q+3*sm), di = v8_load(xpi+q+3*sm);
+            SIMDFFT_BUTTERFLY(t_v8, v8_add, v8_sub, v8_cmulr, v8_cmuli)
+            v8_store(ypr+q, y0r); v8_store(ypi+q, y0i);
+            v8_store(ypr+q+s, y1r); v8_store(ypi+q+s, y1i);
+            v8_store(ypr+q+2*s, y2r); v8_store(ypi+q+2*s, y2i);
+            v8_store(ypr+q+3*s, y3r); v8_store(ypi+q+3*s, y3i);
+        }
+    }
+}
+#endif /* SIMD_AVX2 */
+
+    /* choose the fastest routine for a pass */
+static void simdfft_radix4(int n, int s, const t_sample *xr,
+    const t_sample *xi, t_sample *yr, t_sample *yi, const t_sample *tw)
+{
+#ifdef SIMD_AVX2
+    if (s >= 8 && simd_avx2())
+        simdfft_radix4_v8(n, s, xr, xi, yr, yi, tw);
+    else
+#endif
+#ifdef SIMD_V4
+    if (s >= 4)
+        simdfft_radix4_v4(n, s, xr, xi, yr, yi, tw);
+    else if (n >= 16)
+        simdfft_radix4_first(n, xr, xi, yr, yi, tw);
+    else
+#endif
+        simdfft_radix4_scalar(n, s, xr, xi, yr, yi, tw);
+}
+
+    /* forward complex transform (exponent -1, unnormalized) in place */
+static void simdfft_cfft(t_fftplan *x, t_sample *re, t_sample *im)
+{
+    int n = x->p_n, ns, s;
+    const t_sample *tw = x->p_tw;
+    t_sample *xr = re, *xi = im, *yr = x->p_work, *yi = x->p_work + n, *t;
+    for (ns = n, s = 1; ns >= 4; tw += 6 * (ns/4), ns /= 4, s *= 4)
+    {
+        simdfft_radix4(n, s, xr, xi, yr, yi, tw);
+        t = xr, xr = yr, yr = t;
+        t = xi, xi = yi, yi = t;
+    }
+    if (ns == 2)
+    {
+        simdfft_radix2(s, xr, xi, yr, yi);
+        t = xr, xr = yr, yr = t;
+        t = xi, xi = yi, yi = t;
+    }
+    if (xr != re)
+    {
+        memcpy(re, xr, n * sizeof(t_sample));
+        memcpy(im, xi, n * sizeof(t_sample));
+    }
+}
+
+/* ---------------------- real transforms ----------------------- */
+
+    /* combine the n-point complex transform z of the even and odd samples
+    into the first half of the 2n-point real transform, in Mayer's layout:
+    real parts in fz[0..n], minus the imaginary parts backward from the end
+    of fz.  With a = Z[k], b = conj(Z[n-k]) and W = exp(-i pi k/n),
+    X[k] = (a+b)/2 + W (a-b)/2i. */
+static void simdfft_realpost(t_fftplan *x, const t_sample *zr,
+    const t_sample *zi, t_sample *fz)
+{
+    int n = x->p_n, k = 1;
+    const t_sample *wr = x->p_rtw, *wi = x->p_rtw + n;
+    fz[0] = zr[0] + zi[0];
+    fz[n] = zr[0] - zi[0];
+#ifdef SIMD_V4
+    for (; k < 4; k++)
+#else
+    for (; k < n; k++)
+#endif
+    {
+        t_sample ar = zr[k], ai = zi[k], br = zr[n-k], bi = -zi[n-k];
+        t_sample er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        t_sample fr = 0.5f * (ai - bi), fi = -0.5f * (ar - br);
+        fz[k] = er + wr[k] * fr - wi[k] * fi;
+        fz[2*n-k] = -(ei + wr[k] * fi + wi[k] * fr);
+    }
+#ifdef SIMD_V4
+    {
+        t_v4 half = v4_set1(0.5f), mhalf = v4_set1(-0.5f);
+        for (; k < n; k += 4)
+        {
+            t_v4 ar = v4_load(zr+k), ai = v4_load(zi+k);
+            t_v4 br = v4_reverse(v4_load(zr+n-k-3));
+            t_v4 nbi = v4_reverse(v4_load(zi+n-k-3));   /* -bi */
+            t_v4 vwr = v4_load(wr+k), vwi = v4_load(wi+k);
+            t_v4 er = v4_mul(half, v4_add(ar, br));
+            t_v4 mei = v4_mul(mhalf, v4_sub(ai, nbi));      /* -ei */
+            t_v4 fr = v4_mul(half, v4_add(ai, nbi));
+            t_v4 fi = v4_mul(mhalf, v4_sub(ar, br));
+            v4_store(fz+k, v4_add(er, v4_cmulr(vwr, vwi, fr, fi)));
+            v4_store(fz+2*n-k-3, v4_reverse(
+                v4_sub(mei, v4_cmuli(vwr, vwi, fr, fi))));
+        }
+    }
+#endif
+}
+
+    /* the reverse: from the real transform in fz, make twice the complex
+    transform of the even and odd samples.  Here a = X[k] and
+    b = conj(X[n-k]); Z[k] = (a+b) + i (a-b) conj(W). */
+static void simdfft_realpre(t_fftplan *x, const t_sample *fz,
+    t_sample *zr, t_sample *zi)
+{
+    int n = x->p_n, k = 1;
+    const t_sample *wr = x->p_rtw, *wi = x->p_rtw + n;
+    zr[0] = fz[0] + fz[n];
+    zi[0] = fz[0] - fz[n];
+#ifdef SIMD_V4
+    for (; k < 4; k++)
+#else
+    for (; k < n; k++)
+#endif
+    {
+        t_sample ar = fz[k], ai = -fz[2*n-k], br = fz[n-k], bi = fz[n+k];
+        t_sample dr = ar - br, di = ai - bi;
+        t_sample fr = dr * wr[k] + di * wi[k], fi = di * wr[k] - dr * wi[k];
+        zr[k] = ar + br - fi;
+        zi[k] = ai + bi + fr;
+    }
+#ifdef SIMD_V4
+    for (; k < n; k += 4)
+    {
+        t_v4 ar = v4_load(fz+k);
+        t_v4 nai = v4_reverse(v4_load(fz+2*n-k-3));     /* -ai */
+        t_v4 br = v4_reverse(v4_load(fz+n-k-3));
+        t_v4 bi = v4_load(fz+n+k);
+        t_v4 vwr = v4_load(wr+k), vwi = v4_load(wi+k);
+        t_v4 dr = v4_sub(ar, br), di = v4_sub(v4_set1(0), v4_add(nai, bi));
+        t_v4 fr = v4_add(v4_mul(dr, vwr), v4_mul(di, vwi));
+        t_v4 fi = v4_sub(v4_mul(di, vwr), v4_mul(dr, vwi));
+        v4_store(zr+k, v4_sub(v4_add(ar, br), fi));
+        v4_store(zi+k, v4_add(v4_sub(bi, nai), fr));
+    }
+#endif
+}
+
+/* ------------------ entry points for the backends ------------------- */
+
+    /* complex transform of n points; the inverse is the forward transform
+    with real and imaginary parts exchanged */
+int simdfft_fft(int n, t_sample *re, t_sample *im, int inverse)
+{
+    t_fftplan *x;
+    if (!simdfft_on || !(x = simdfft_getplan(n)))
+        return (0);
+    if (inverse)
+        simdfft_cfft(x, im, re);
+    else simdfft_cfft(x, re, im);
+    return (1);
+}
+
+    /* real transform of n points in place, as mayer_realfft() */
+int simdfft_realfft(int n, t_sample *fz)
+{
+    t_fftplan *x;
+    t_sample *zr, *zi;
+    int i;
+    if (!simdfft_on || n < 8 || !(x = simdfft_getplan(n/2)))
+        return (0);
+    n /= 2;
+    zr = x->p_work + 2*n, zi = zr + n;
+#ifdef SIMD_V4
+    for (i = 0; i < n; i += 4)
+    {
+        t_v4 ev, od;
+        v4_unzip(v4_load(fz+2*i), v4_load(fz+2*i+4), ev, od);
+        v4_store(zr+i, ev);
+        v4_store(zi+i, od);
+    }
+#else
+    for (i = 0; i < n; i++)
+        zr[i] = fz[2*i], zi[i] = fz[2*i+1];
+#endif
+    simdfft_cfft(x, zr, zi);
+    simdfft_realpost(x, zr, zi, fz);
+    return (1);
+}
+
+    /* inverse of simdfft_realfft(), unnormalized (scaled by n) */
+int simdfft_realifft(int n, t_sample *fz)
+{
+    t_fftplan *x;
+    t_sample *zr, *zi;
+    int i;
+    if (!simdfft_on || n < 8 || !(x = simdfft_getplan(n/2)))
+        return (0);
+    n /= 2;
+    zr = x->p_work + 2*n, zi = zr + n;
+    simdfft_realpre(x, fz, zr, zi);
+    simdfft_cfft(x, zi, zr);
+#ifdef SIMD_V4
+    for (i = 0; i < n; i += 4)
+    {
+        t_v4 lo, hi;
+        v4_zip(v4_load(zr+i), v4_load(zi+i), lo, hi);
+        v4_store(fz+2*i, lo);
+        v4_store(fz+2*i+4, hi);
+    }
+#else
+    for (i = 0; i < n; i++)
+        fz[2*i] = zr[i], fz[2*i+1] = zi[i];
+#endif
+    return (1);
+}
+
+    /* interleaved complex transform, as pd_fft() */
+int simdfft_pdfft(t_float *buf, int npoints, int inverse)
+{
+    t_fftplan *x;
+    t_sample *zr, *zi;
+    int i;
+    if (!simdfft_on || !(x = simdfft_getplan(npoints)))
+        return (0);
+    zr = x->p_work + 2*npoints, zi = zr + npoints;
+    for (i = 0; i < npoints; i++)
+        zr[i] = buf[2*i], zi[i] = buf[2*i+1];
+    if (inverse)
+        simdfft_cfft(x, zi, zr);
+    else simdfft_cfft(x, zr, zi);
+    for (i = 0; i < npoints; i++)
+        buf[2*i] = zr[i], buf[2*i+1] = zi[i];
+    return (1);
+}
+
+    /* whether the mayer_*() routines may be called from several threads at
+    once, as analyses on worker threads ("async" sigmund~ and fiddle~) do.
+    FFTW's plans share their buffers, so with FFTW chosen they may not. */
+int mayer_threadsafe(void)
+{
+    return (simdfft_on || strcmp(mayer_backend, "fftw"));
+}
+
+    /* "pd fft-backend <name>": "simd" for the routines above, or the name
+    of the package linked in ("ooura" or "fftw") to hand all transforms to
+    it.  With no name, print the current choice.  The choice is global to
+    the process, like the package itself, so it can't be changed while
+    worker threads may be in the middle of a transform. */
+void glob_fftbackend(void *dummy, t_symbol *s)
+{
+    if (!*s->s_name)
+        post("fft-backend: %s", (simdfft_on ? "simd" : mayer_backend));
+    else if (strcmp(s->s_name, mayer_backend) && strcmp(s->s_name, "simd"))
+        pd_error(0, "fft-backend: %s: unknown backend (use simd or %s)",
+            s->s_name, mayer_backend);
+    else if ((strcmp(s->s_name, "simd") == 0) != simdfft_on &&
+        worker_threaded())
+        pd_error(0, "fft-backend: can't change while \"async\" analyses "
+            "are running in other threads");
+    else simdfft_on = !strcmp(s->s_name, "simd");
+}
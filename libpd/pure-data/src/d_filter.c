@@ -5,6 +5,7 @@
 /*  "filters", both linear and nonlinear.
 */
 #include "m_pd.h"
+#include "d_simd.h"
 #include <math.h>
 
 /* ---------------- hip~ - 1-pole 1-zero hipass filter. ----------------- */
@@ -131,6 +132,7 @@ void sighip_setup(void)
 {
     sighip_class = class_new(gensym("hip~"), (t_newmethod)sighip_new, 0,
         sizeof(t_sighip), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(sighip_class);
     CLASS_MAINSIGNALIN(sighip_class, t_sighip, x_f);
     class_addmethod(sighip_class, (t_method)sighip_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -222,6 +224,7 @@ void siglop_setup(void)
 {
     siglop_class = class_new(gensym("lop~"), (t_newmethod)siglop_new, 0,
         sizeof(t_siglop), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(siglop_class);
     CLASS_MAINSIGNALIN(siglop_class, t_siglop, x_f);
     class_addmethod(siglop_class, (t_method)siglop_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -357,6 +360,7 @@ void sigbp_setup(void)
 {
     sigbp_class = class_new(gensym("bp~"), (t_newmethod)sigbp_new, 0,
         sizeof(t_sigbp), 0, A_DEFFLOAT, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigbp_class);
     CLASS_MAINSIGNALIN(sigbp_class, t_sigbp, x_f);
     class_addmethod(sigbp_class, (t_method)sigbp_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -403,6 +407,26 @@ static void *sigbiquad_new(t_symbol *s, int argc, t_atom *argv)
     return (x);
 }
 
+    /* check whether the feedback coefficients make a stable filter */
+static int biquad_stable(t_float fb1, t_float fb2)
+{
+    t_float discriminant = fb1 * fb1 + 4 * fb2;
+    if (discriminant < 0) /* imaginary roots -- resonant filter */
+    {
+            /* they're conjugates so we just check that the product
+            is less than one */
+        return (fb2 >= -1.0f);
+    }
+    else    /* real roots */
+    {
+            /* check that the parabola 1 - fb1 x - fb2 x^2 has a
+                vertex between -1 and 1, and that it's nonnegative
+                at both ends, which implies both roots are in [1-,1]. */
+        return (fb1 <= 2.0f && fb1 >= -2.0f &&
+            1.0f - fb1 -fb2 >= 0 && 1.0f + fb1 - fb2 >= 0);
+    }
+}
+
 static t_int *sigbiquad_perform(t_int *w)
 {
     t_sample *in = (t_sample *)(w[1]);
@@ -438,26 +462,10 @@ static void sigbiquad_list(t_sigbiquad *x, t_symbol *s, int argc, t_atom *argv)
     t_float ff1 = atom_getfloatarg(2, argc, argv);
     t_float ff2 = atom_getfloatarg(3, argc, argv);
     t_float ff3 = atom_getfloatarg(4, argc, argv);
-    t_float discriminant = fb1 * fb1 + 4 * fb2;
     t_biquadctl *c = x->x_ctl;
-    if (discriminant < 0) /* imaginary roots -- resonant filter */
-    {
-            /* they're conjugates so we just check that the product
-            is less than one */
-        if (fb2 >= -1.0f) goto stable;
-    }
-    else    /* real roots */
-    {
-            /* check that the parabola 1 - fb1 x - fb2 x^2 has a
-                vertex between -1 and 1, and that it's nonnegative
-                at both ends, which implies both roots are in [1-,1]. */
-        if (fb1 <= 2.0f && fb1 >= -2.0f &&
-            1.0f - fb1 -fb2 >= 0 && 1.0f + fb1 - fb2 >= 0)
-                goto stable;
-    }
         /* if unstable, just bash to zero */
-    fb1 = fb2 = ff1 = ff2 = ff3 = 0;
-stable:
+    if (!biquad_stable(fb1, fb2))
+        fb1 = fb2 = ff1 = ff2 = ff3 = 0;
     c->c_fb1 = fb1;
     c->c_fb2 = fb2;
     c->c_ff1 = ff1;
@@ -484,6 +492,7 @@ void sigbiquad_setup(void)
 {
     sigbiquad_class = class_new(gensym("biquad~"), (t_newmethod)sigbiquad_new,
         0, sizeof(t_sigbiquad), 0, A_GIMME, 0);
+    class_setparalleldsp(sigbiquad_class);
     CLASS_MAINSIGNALIN(sigbiquad_class, t_sigbiquad, x_f);
     class_addmethod(sigbiquad_class, (t_method)sigbiquad_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -494,6 +503,304 @@ void sigbiquad_setup(void)
         A_GIMME, 0);
 }
 
+/* -------------- biquads~ - bank of independent biquads --------------- */
+
+/* biquads~ runs any number of biquad~ filters side by side, one per
+signal inlet/outlet pair, each with its own coefficients.  Rather than
+running the filters one after the other, the block is first interleaved
+so that each sample time holds one value per channel; the filters then
+run over the bank a vector of channels at a time, and the results are
+split back to the outlets.  This also means outlets may safely share
+signal vectors with any of the inlets.  Vector routines flush denormals
+through the FPU mode (see d_simd.h) in place of biquad~'s per-sample
+test; states that blew up or decayed to nothing are zeroed once a block. */
+
+    /* rows in x_state, each x_stride long */
+#define BQS_X1 0
+#define BQS_X2 1
+#define BQS_FB1 2
+#define BQS_FB2 3
+#define BQS_FF1 4
+#define BQS_FF2 5
+#define BQS_FF3 6
+#define BQS_NROWS 7
+
+#define BQS_MAXCHANS 1024
+
+typedef void (*t_biquadskernel)(t_sample *state, t_sample *buf,
+    int stride, int n);
+
+typedef struct sigbiquads
+{
+    t_object x_obj;
+    t_float x_f;
+    int x_nchans;           /* number of filters */
+    int x_stride;           /* x_nchans rounded up to a multiple of 8 */
+    t_sample *x_state;      /* BQS_NROWS rows of x_stride values */
+    t_sample *x_buf;        /* interleaved block, x_stride per sample */
+    int x_bufsize;          /* in samples */
+    t_sample **x_vecs;      /* x_nchans inputs, then x_nchans outputs */
+    t_biquadskernel x_kernel;
+} t_sigbiquads;
+
+t_class *sigbiquads_class;
+
+    /* plain C version of the filter kernel */
+static void biquads_kernel(t_sample *state, t_sample *buf, int stride, int n)
+{
+    int ch, i;
+    for (ch = 0; ch < stride; ch++)
+    {
+        t_sample *s = state + ch, *bp = buf + ch;
+        t_sample last = s[BQS_X1 * stride], prev = s[BQS_X2 * stride];
+        t_sample fb1 = s[BQS_FB1 * stride], fb2 = s[BQS_FB2 * stride];
+        t_sample ff1 = s[BQS_FF1 * stride], ff2 = s[BQS_FF2 * stride];
+        t_sample ff3 = s[BQS_FF3 * stride];
+        for (i = 0; i < n; i++, bp += stride)
+        {
+            t_sample output = *bp + fb1 * last + fb2 * prev;
+            if (PD_BIGORSMALL(output))
+                output = 0;
+            *bp = ff1 * output + ff2 * last + ff3 * prev;
+            prev = last;
+            last = output;
+        }
+        s[BQS_X1 * stride] = last;
+        s[BQS_X2 * stride] = prev;
+    }
+}
+
+    /* vector versions: as above, on as many channels as fit in a vector */
+#define SIMD_BIQUADS(name, v, op, attr) \
+attr static void name##_perf##v(t_sample *state, t_sample *buf, \
+    int stride, int n) \
+{ \
+    int lanes = sizeof(t_##v) / sizeof(t_sample), ch, i; \
+    for (ch = 0; ch < stride; ch += lanes) \
+    { \
+        t_sample *s = state + ch, *bp = buf + ch; \
+        t_##v last = v##_load(s + BQS_X1 * stride); \
+        t_##v prev = v##_load(s + BQS_X2 * stride); \
+        t_##v fb1 = v##_load(s + BQS_FB1 * stride); \
+        t_##v fb2 = v##_load(s + BQS_FB2 * stride); \
+        t_##v ff1 = v##_load(s + BQS_FF1 * stride); \
+        t_##v ff2 = v##_load(s + BQS_FF2 * stride); \
+        t_##v ff3 = v##_load(s + BQS_FF3 * stride); \
+        for (i = 0; i < n; i++, bp += stride) \
+        { \
+            t_##v output = v##_add(v##_add(v##_load(bp), \
+                v##_mul(fb1, last)), v##_mul(fb2, prev)); \
+            v##_store(bp, v##_add(v##_add(v##_mul(ff1, output), \
+                v##_mul(ff2, last)), v##_mul(ff3, prev))); \
+            prev = last; \
+            last = output; \
+        } \
+        v##_store(s + BQS_X1 * stride, last); \
+        v##_store(s + BQS_X2 * stride, prev); \
+    } \
+}
+
+SIMD_DEFINE(SIMD_BIQUADS, biquads, biquads)
+
+    /* copy n samples of nchans signals into the interleaved buffer
+    ("out" clear) or back out of it ("out" set).  Where vectors are built
+    and n is a multiple of 4, four channels go at a time as 4x4 transposes,
+    as copying one value at a time across the buffer costs more than the
+    vector filters themselves. */
+static void biquads_copy(t_sample **vecs, t_sample *buf, int nchans,
+    int stride, int n, int out)
+{
+    int ch = 0, i;
+#ifdef SIMD_V4
+    if (!(n & 3))
+        for (; ch + 4 <= nchans; ch += 4)
+    {
+        t_sample *v0 = vecs[ch], *v1 = vecs[ch+1], *v2 = vecs[ch+2],
+            *v3 = vecs[ch+3], *bp = buf + ch;
+        for (i = 0; i < n; i += 4, bp += 4 * stride)
+        {
+            t_v4 a, b, c, d;
+            if (out)
+            {
+                a = v4_load(bp); b = v4_load(bp + stride);
+                c = v4_load(bp + 2 * stride); d = v4_load(bp + 3 * stride);
+                v4_transpose(a, b, c, d);
+                v4_store(v0 + i, a); v4_store(v1 + i, b);
+                v4_store(v2 + i, c); v4_store(v3 + i, d);
+            }
+            else
+            {
+                a = v4_load(v0 + i); b = v4_load(v1 + i);
+                c = v4_load(v2 + i); d = v4_load(v3 + i);
+                v4_transpose(a, b, c, d);
+                v4_store(bp, a); v4_store(bp + stride, b);
+                v4_store(bp + 2 * stride, c); v4_store(bp + 3 * stride, d);
+            }
+        }
+    }
+#endif
+    for (; ch < nchans; ch++)
+    {
+        t_sample *vec = vecs[ch], *bp = buf + ch;
+        if (out)
+            for (i = 0; i < n; i++, bp += stride)
+                vec[i] = *bp;
+        else for (i = 0; i < n; i++, bp += stride)
+            *bp = vec[i];
+    }
+}
+
+static t_int *sigbiquads_perform(t_int *w)
+{
+    t_sigbiquads *x = (t_sigbiquads *)(w[1]);
+    int n = (int)(w[2]), nchans = x->x_nchans, stride = x->x_stride, ch;
+    t_sample *x1 = x->x_state + BQS_X1 * stride,
+        *x2 = x->x_state + BQS_X2 * stride;
+#ifdef SIMD_V4
+    t_simd_fpstate fp;
+#endif
+    biquads_copy(x->x_vecs, x->x_buf, nchans, stride, n, 0);
+#ifdef SIMD_V4
+    fp = simd_ftz_on();
+    (*x->x_kernel)(x->x_state, x->x_buf, stride, n);
+    simd_ftz_off(fp);
+#else
+    (*x->x_kernel)(x->x_state, x->x_buf, stride, n);
+#endif
+    biquads_copy(x->x_vecs + nchans, x->x_buf, nchans, stride, n, 1);
+    for (ch = 0; ch < nchans; ch++)
+    {
+            /* each on its own: zero counts as "small", and one state
+            being zero (a filter just starting) mustn't clear the other */
+        if (PD_BIGORSMALL(x1[ch]))
+            x1[ch] = 0;
+        if (PD_BIGORSMALL(x2[ch]))
+            x2[ch] = 0;
+    }
+    return (w+3);
+}
+
+    /* set coefficients of channel "ch" from up to 5 atoms */
+static void sigbiquads_setchan(t_sigbiquads *x, int ch, int argc,
+    t_atom *argv)
+{
+    t_sample *s = x->x_state + ch;
+    int stride = x->x_stride;
+    t_float fb1 = atom_getfloatarg(0, argc, argv);
+    t_float fb2 = atom_getfloatarg(1, argc, argv);
+    t_float ff1 = atom_getfloatarg(2, argc, argv);
+    t_float ff2 = atom_getfloatarg(3, argc, argv);
+    t_float ff3 = atom_getfloatarg(4, argc, argv);
+    if (!biquad_stable(fb1, fb2))
+        fb1 = fb2 = ff1 = ff2 = ff3 = 0;
+    s[BQS_FB1 * stride] = fb1;
+    s[BQS_FB2 * stride] = fb2;
+    s[BQS_FF1 * stride] = ff1;
+    s[BQS_FF2 * stride] = ff2;
+    s[BQS_FF3 * stride] = ff3;
+}
+
+    /* a list of five coefficients sets all filters alike; longer lists
+    give five coefficients for each filter in turn */
+static void sigbiquads_list(t_sigbiquads *x, t_symbol *s, int argc,
+    t_atom *argv)
+{
+    int ch;
+    if (argc <= 5)
+        for (ch = 0; ch < x->x_nchans; ch++)
+            sigbiquads_setchan(x, ch, argc, argv);
+    else for (ch = 0; ch < x->x_nchans && argc > 0;
+        ch++, argc -= 5, argv += 5)
+            sigbiquads_setchan(x, ch, argc, argv);
+}
+
+    /* "channel <n> fb1 fb2 ff1 ff2 ff3" sets one filter, counting from 0 */
+static void sigbiquads_channel(t_sigbiquads *x, t_symbol *s, int argc,
+    t_atom *argv)
+{
+    int ch = atom_getfloatarg(0, argc, argv);
+    if (ch < 0 || ch >= x->x_nchans)
+    {
+        pd_error(x, "biquads~: channel %d out of range", ch);
+        return;
+    }
+    sigbiquads_setchan(x, ch, (argc > 1 ? argc - 1 : 0), argv + 1);
+}
+
+static void sigbiquads_clear(t_sigbiquads *x)
+{
+    int ch;
+    for (ch = 0; ch < x->x_stride; ch++)
+        x->x_state[BQS_X1 * x->x_stride + ch] =
+            x->x_state[BQS_X2 * x->x_stride + ch] = 0;
+}
+
+static void sigbiquads_dsp(t_sigbiquads *x, t_signal **sp)
+{
+    int n = sp[0]->s_n, ch;
+    if (n * x->x_stride > x->x_bufsize)
+    {
+        x->x_buf = (t_sample *)resizebytes(x->x_buf,
+            x->x_bufsize * sizeof(t_sample),
+                n * x->x_stride * sizeof(t_sample));
+        x->x_bufsize = n * x->x_stride;
+    }
+    for (ch = 0; ch < 2 * x->x_nchans; ch++)
+        x->x_vecs[ch] = sp[ch]->s_vec;
+    x->x_kernel = SIMD_PERFORM(biquads_kernel, biquads);
+    dsp_add(sigbiquads_perform, 2, x, n);
+}
+
+static void *sigbiquads_new(t_symbol *s, int argc, t_atom *argv)
+{
+    t_sigbiquads *x = (t_sigbiquads *)pd_new(sigbiquads_class);
+    int nchans = atom_getfloatarg(0, argc, argv), ch;
+    if (nchans < 1)
+        nchans = 1;
+    else if (nchans > BQS_MAXCHANS)
+        nchans = BQS_MAXCHANS;
+    x->x_nchans = nchans;
+    x->x_stride = (nchans + 7) & ~7;
+    x->x_state = (t_sample *)getbytes(
+        BQS_NROWS * x->x_stride * sizeof(t_sample));
+    x->x_buf = 0;
+    x->x_bufsize = 0;
+    x->x_vecs = (t_sample **)getbytes(2 * nchans * sizeof(t_sample *));
+    x->x_kernel = biquads_kernel;
+    for (ch = 1; ch < nchans; ch++)
+        inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_signal, &s_signal);
+    for (ch = 0; ch < nchans; ch++)
+        outlet_new(&x->x_obj, &s_signal);
+    if (argc > 1)
+        sigbiquads_list(x, s, argc - 1, argv + 1);
+    x->x_f = 0;
+    return (x);
+}
+
+static void sigbiquads_free(t_sigbiquads *x)
+{
+    freebytes(x->x_state, BQS_NROWS * x->x_stride * sizeof(t_sample));
+    if (x->x_buf)
+        freebytes(x->x_buf, x->x_bufsize * sizeof(t_sample));
+    freebytes(x->x_vecs, 2 * x->x_nchans * sizeof(t_sample *));
+}
+
+void sigbiquads_setup(void)
+{
+    sigbiquads_class = class_new(gensym("biquads~"),
+        (t_newmethod)sigbiquads_new, (t_method)sigbiquads_free,
+            sizeof(t_sigbiquads), 0, A_GIMME, 0);
+    class_setparalleldsp(sigbiquads_class);
+    CLASS_MAINSIGNALIN(sigbiquads_class, t_sigbiquads, x_f);
+    class_addmethod(sigbiquads_class, (t_method)sigbiquads_dsp,
+        gensym("dsp"), A_CANT, 0);
+    class_addlist(sigbiquads_class, sigbiquads_list);
+    class_addmethod(sigbiquads_class, (t_method)sigbiquads_channel,
+        gensym("channel"), A_GIMME, 0);
+    class_addmethod(sigbiquads_class, (t_method)sigbiquads_clear,
+        gensym("clear"), 0);
+}
+
 /* ---------------- samphold~ - sample and hold  ----------------- */
 
 typedef struct sigsamphold
@@ -562,6 +869,7 @@ void sigsamphold_setup(void)
 {
     sigsamphold_class = class_new(gensym("samphold~"),
         (t_newmethod)sigsamphold_new, 0, sizeof(t_sigsamphold), 0, 0);
+    class_setparalleldsp(sigsamphold_class);
     CLASS_MAINSIGNALIN(sigsamphold_class, t_sigsamphold, x_f);
     class_addmethod(sigsamphold_class, (t_method)sigsamphold_set,
         gensym("set"), A_DEFFLOAT, 0);
@@ -635,6 +943,7 @@ void sigrpole_setup(void)
 {
     sigrpole_class = class_new(gensym("rpole~"),
         (t_newmethod)sigrpole_new, 0, sizeof(t_sigrpole), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigrpole_class);
     CLASS_MAINSIGNALIN(sigrpole_class, t_sigrpole, x_f);
     class_addmethod(sigrpole_class, (t_method)sigrpole_set,
         gensym("set"), A_DEFFLOAT, 0);
@@ -707,6 +1016,7 @@ void sigrzero_setup(void)
 {
     sigrzero_class = class_new(gensym("rzero~"),
         (t_newmethod)sigrzero_new, 0, sizeof(t_sigrzero), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigrzero_class);
     CLASS_MAINSIGNALIN(sigrzero_class, t_sigrzero, x_f);
     class_addmethod(sigrzero_class, (t_method)sigrzero_set,
         gensym("set"), A_DEFFLOAT, 0);
@@ -780,6 +1090,7 @@ void sigrzero_rev_setup(void)
     sigrzero_rev_class = class_new(gensym("rzero_rev~"),
         (t_newmethod)sigrzero_rev_new, 0, sizeof(t_sigrzero_rev),
         0, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigrzero_rev_class);
     CLASS_MAINSIGNALIN(sigrzero_rev_class, t_sigrzero_rev, x_f);
     class_addmethod(sigrzero_rev_class, (t_method)sigrzero_rev_set,
         gensym("set"), A_DEFFLOAT, 0);
@@ -873,6 +1184,7 @@ void sigcpole_setup(void)
     sigcpole_class = class_new(gensym("cpole~"),
         (t_newmethod)sigcpole_new, 0, sizeof(t_sigcpole), 0,
             A_DEFFLOAT, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigcpole_class);
     CLASS_MAINSIGNALIN(sigcpole_class, t_sigcpole, x_f);
     class_addmethod(sigcpole_class, (t_method)sigcpole_set,
         gensym("set"), A_DEFFLOAT, A_DEFFLOAT, 0);
@@ -963,6 +1275,7 @@ void sigczero_setup(void)
     sigczero_class = class_new(gensym("czero~"),
         (t_newmethod)sigczero_new, 0, sizeof(t_sigczero), 0,
             A_DEFFLOAT, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigczero_class);
     CLASS_MAINSIGNALIN(sigczero_class, t_sigczero, x_f);
     class_addmethod(sigczero_class, (t_method)sigczero_set,
         gensym("set"), A_DEFFLOAT, A_DEFFLOAT, 0);
@@ -1055,6 +1368,7 @@ void sigczero_rev_setup(void)
     sigczero_rev_class = class_new(gensym("czero_rev~"),
         (t_newmethod)sigczero_rev_new, 0, sizeof(t_sigczero_rev), 0,
             A_DEFFLOAT, A_DEFFLOAT, 0);
+    class_setparalleldsp(sigczero_rev_class);
     CLASS_MAINSIGNALIN(sigczero_rev_class, t_sigczero_rev, x_f);
     class_addmethod(sigczero_rev_class, (t_method)sigczero_rev_set,
         gensym("set"), A_DEFFLOAT, A_DEFFLOAT, 0);
@@ -1072,6 +1386,7 @@ void d_filter_setup(void)
     siglop_setup();
     sigbp_setup();
     sigbiquad_setup();
+    sigbiquads_setup();
     sigsamphold_setup();
     sigrpole_setup();
     sigrzero_setup();
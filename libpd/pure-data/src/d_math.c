@@ -7,6 +7,7 @@
 */
 
 #include "m_pd.h"
+#include "d_simd.h"
 #include <math.h>
 #define LOGTEN 2.302585092994
 
@@ -49,15 +50,39 @@ static t_int *clip_perform(t_int *w)
     return (w+5);
 }
 
+    /* clip_perform() for block sizes that are a multiple of 8: first
+    (lo > f ? lo : f) and then (hi < f ? hi : f) as above */
+#define SIMD_CLIP(name, v, op, attr) \
+attr static t_int *name##_perf##v(t_int *w) \
+{ \
+    t_clip *x = (t_clip *)(w[1]); \
+    t_sample *in = (t_sample *)(w[2]); \
+    t_sample *out = (t_sample *)(w[3]); \
+    int n = (int)(w[4]); \
+    t_##v lo = v##_set1(x->x_lo), hi = v##_set1(x->x_hi); \
+    for (; n; n -= 8, in += 8, out += 8) \
+    { \
+        v##_store(out, v##_min(hi, v##_max(lo, v##_load(in)))); \
+        if (sizeof(t_##v) < 8 * sizeof(t_sample)) \
+            v##_store(out+4, v##_min(hi, v##_max(lo, v##_load(in+4)))); \
+    } \
+    return (w+5); \
+}
+
+SIMD_DEFINE(SIMD_CLIP, clip, clip)
+
 static void clip_dsp(t_clip *x, t_signal **sp)
 {
-    dsp_add(clip_perform, 4, x, sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
+    dsp_add((sp[0]->s_n & 7 ? clip_perform :
+        SIMD_PERFORM(clip_perform, clip)),
+            4, x, sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void clip_setup(void)
 {
     clip_class = class_new(gensym("clip~"), (t_newmethod)clip_new, 0,
         sizeof(t_clip), 0, A_DEFFLOAT, A_DEFFLOAT, 0);
+    class_setparalleldsp(clip_class);
     CLASS_MAINSIGNALIN(clip_class, t_clip, x_f);
     class_addmethod(clip_class, (t_method)clip_dsp, gensym("dsp"), A_CANT, 0);
 }
@@ -168,6 +193,7 @@ void sigrsqrt_setup(void)
     init_rsqrt();
     sigrsqrt_class = class_new(gensym("rsqrt~"), (t_newmethod)sigrsqrt_new, 0,
         sizeof(t_sigrsqrt), 0, 0);
+    class_setparalleldsp(sigrsqrt_class);
             /* an old name for it: */
     class_addcreator(sigrsqrt_new, gensym("q8_rsqrt~"), 0);
     CLASS_MAINSIGNALIN(sigrsqrt_class, t_sigrsqrt, x_f);
@@ -226,6 +252,7 @@ void sigsqrt_setup(void)
 {
     sigsqrt_class = class_new(gensym("sqrt~"), (t_newmethod)sigsqrt_new, 0,
         sizeof(t_sigsqrt), 0, 0);
+    class_setparalleldsp(sigsqrt_class);
     class_addcreator(sigsqrt_new, gensym("q8_sqrt~"), 0);   /* old name */
     CLASS_MAINSIGNALIN(sigsqrt_class, t_sigsqrt, x_f);
     class_addmethod(sigsqrt_class, (t_method)sigsqrt_dsp,
@@ -279,17 +306,21 @@ static t_int *sigwrap_old_perform(t_int *w)
     return (w + 4);
 }
 
+SIMD_DEFINE(SIMD_UNOP, sigwrap, wrap)
+
 static void sigwrap_dsp(t_sigwrap *x, t_signal **sp)
 {
-    dsp_add((pd_compatibilitylevel < 48 ?
-        sigwrap_old_perform : sigwrap_perform),
-            3, sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
+    dsp_add((pd_compatibilitylevel < 48 ? sigwrap_old_perform :
+        (sp[0]->s_n & 7 ? sigwrap_perform :
+            SIMD_PERFORM(sigwrap_perform, sigwrap))),
+                3, sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
 }
 
 void sigwrap_setup(void)
 {
     sigwrap_class = class_new(gensym("wrap~"), (t_newmethod)sigwrap_new, 0,
         sizeof(t_sigwrap), 0, 0);
+    class_setparalleldsp(sigwrap_class);
     CLASS_MAINSIGNALIN(sigwrap_class, t_sigwrap, x_f);
     class_addmethod(sigwrap_class, (t_method)sigwrap_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -339,6 +370,7 @@ void mtof_tilde_setup(void)
 {
     mtof_tilde_class = class_new(gensym("mtof~"), (t_newmethod)mtof_tilde_new, 0,
         sizeof(t_mtof_tilde), 0, 0);
+    class_setparalleldsp(mtof_tilde_class);
     CLASS_MAINSIGNALIN(mtof_tilde_class, t_mtof_tilde, x_f);
     class_addmethod(mtof_tilde_class, (t_method)mtof_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -383,6 +415,7 @@ void ftom_tilde_setup(void)
 {
     ftom_tilde_class = class_new(gensym("ftom~"), (t_newmethod)ftom_tilde_new, 0,
         sizeof(t_ftom_tilde), 0, 0);
+    class_setparalleldsp(ftom_tilde_class);
     CLASS_MAINSIGNALIN(ftom_tilde_class, t_ftom_tilde, x_f);
     class_addmethod(ftom_tilde_class, (t_method)ftom_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -433,6 +466,7 @@ void dbtorms_tilde_setup(void)
 {
     dbtorms_tilde_class = class_new(gensym("dbtorms~"), (t_newmethod)dbtorms_tilde_new, 0,
         sizeof(t_dbtorms_tilde), 0, 0);
+    class_setparalleldsp(dbtorms_tilde_class);
     CLASS_MAINSIGNALIN(dbtorms_tilde_class, t_dbtorms_tilde, x_f);
     class_addmethod(dbtorms_tilde_class, (t_method)dbtorms_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -482,6 +516,7 @@ void rmstodb_tilde_setup(void)
 {
     rmstodb_tilde_class = class_new(gensym("rmstodb~"),
         (t_newmethod)rmstodb_tilde_new, 0, sizeof(t_rmstodb_tilde), 0, 0);
+    class_setparalleldsp(rmstodb_tilde_class);
     CLASS_MAINSIGNALIN(rmstodb_tilde_class, t_rmstodb_tilde, x_f);
     class_addmethod(rmstodb_tilde_class, (t_method)rmstodb_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -532,6 +567,7 @@ void dbtopow_tilde_setup(void)
 {
     dbtopow_tilde_class = class_new(gensym("dbtopow~"), (t_newmethod)dbtopow_tilde_new, 0,
         sizeof(t_dbtopow_tilde), 0, 0);
+    class_setparalleldsp(dbtopow_tilde_class);
     CLASS_MAINSIGNALIN(dbtopow_tilde_class, t_dbtopow_tilde, x_f);
     class_addmethod(dbtopow_tilde_class, (t_method)dbtopow_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -581,6 +617,7 @@ void powtodb_tilde_setup(void)
 {
     powtodb_tilde_class = class_new(gensym("powtodb~"), (t_newmethod)powtodb_tilde_new, 0,
         sizeof(t_powtodb_tilde), 0, 0);
+    class_setparalleldsp(powtodb_tilde_class);
     CLASS_MAINSIGNALIN(powtodb_tilde_class, t_powtodb_tilde, x_f);
     class_addmethod(powtodb_tilde_class, (t_method)powtodb_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -631,6 +668,7 @@ static void pow_tilde_setup(void)
 {
     pow_tilde_class = class_new(gensym("pow~"), (t_newmethod)pow_tilde_new, 0,
         sizeof(t_pow_tilde), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(pow_tilde_class);
     CLASS_MAINSIGNALIN(pow_tilde_class, t_pow_tilde, x_f);
     class_addmethod(pow_tilde_class, (t_method)pow_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -672,6 +710,7 @@ static void exp_tilde_setup(void)
 {
     exp_tilde_class = class_new(gensym("exp~"), (t_newmethod)exp_tilde_new, 0,
         sizeof(t_exp_tilde), 0, 0);
+    class_setparalleldsp(exp_tilde_class);
     CLASS_MAINSIGNALIN(exp_tilde_class, t_exp_tilde, x_f);
     class_addmethod(exp_tilde_class, (t_method)exp_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -725,6 +764,7 @@ static void log_tilde_setup(void)
 {
     log_tilde_class = class_new(gensym("log~"), (t_newmethod)log_tilde_new, 0,
         sizeof(t_log_tilde), 0, A_DEFFLOAT, 0);
+    class_setparalleldsp(log_tilde_class);
     CLASS_MAINSIGNALIN(log_tilde_class, t_log_tilde, x_f);
     class_addmethod(log_tilde_class, (t_method)log_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
@@ -759,16 +799,20 @@ t_int *abs_tilde_perform(t_int *w)
     return (w+4);
 }
 
+SIMD_DEFINE(SIMD_UNOP, abs_tilde, abs)
+
 static void abs_tilde_dsp(t_abs_tilde *x, t_signal **sp)
 {
-    dsp_add(abs_tilde_perform, 3,
-        sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
+    dsp_add((sp[0]->s_n & 7 ? abs_tilde_perform :
+        SIMD_PERFORM(abs_tilde_perform, abs_tilde)), 3,
+            sp[0]->s_vec, sp[1]->s_vec, sp[0]->s_n);
 }
 
 static void abs_tilde_setup(void)
 {
     abs_tilde_class = class_new(gensym("abs~"), (t_newmethod)abs_tilde_new, 0,
         sizeof(t_abs_tilde), 0, 0);
+    class_setparalleldsp(abs_tilde_class);
     CLASS_MAINSIGNALIN(abs_tilde_class, t_abs_tilde, x_f);
     class_addmethod(abs_tilde_class, (t_method)abs_tilde_dsp,
         gensym("dsp"), A_CANT, 0);
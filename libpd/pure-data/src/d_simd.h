@@ -0,0 +1,345 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  vector helpers for the perform routines in d_arithmetic.c and d_math.c,
+    and for the FFT in d_fft_simd.c.
+    "v4" routines are four lanes wide and use the instruction set the
+    compiler targets anyway (SSE2 on x86, NEON on 64-bit ARM).  On x86 with
+    gcc or clang we also build eight-lane "v8" routines for AVX2 and choose
+    between the two at DSP sort time according to what the CPU supports.
+    Every helper reproduces the scalar expression it replaces bit for bit,
+    including signed zeros and comparisons against NaN, so patches sound the
+    same whichever routine runs.  (Only the sign of a NaN coming out of an
+    arithmetic operation on two NaNs may differ, as it already does between
+    compilers.)  Built with -ffast-math, as by makefile.gnu, the compiler
+    may change what the scalar loops themselves do with NaNs, signed zeros
+    and denormals, and then only ordinary numbers are sure to come out the
+    same.  ../tests/simd_test.c checks all this.  Define PD_NOSIMD to use
+    the scalar loops only.
+*/
+
+#ifndef __d_simd_h_
+#define __d_simd_h_
+
+#if PD_FLOATSIZE == 32 && !defined(PD_NOSIMD)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define SIMD_NEON
+#endif
+#endif
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+#define SIMD_V4
+#endif
+
+#if defined(SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_AVX2
+#endif
+
+#ifdef _MSC_VER
+#define SIMD_INLINE static __inline
+#else
+#define SIMD_INLINE static inline
+#endif
+
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/* ------------------------ four lanes ------------------------ */
+
+#ifdef SIMD_SSE2
+typedef __m128 t_v4;
+#define v4_load(p) _mm_loadu_ps(p)
+#define v4_store(p, v) _mm_storeu_ps(p, v)
+#define v4_set1(f) _mm_set1_ps(f)
+#define v4_add(a, b) _mm_add_ps(a, b)
+#define v4_sub(a, b) _mm_sub_ps(a, b)
+#define v4_mul(a, b) _mm_mul_ps(a, b)
+#define v4_div(a, b) _mm_div_ps(a, b)
+    /* maxps and minps return their second operand unless the first one
+    wins the comparison, which is just what the scalar code does */
+#define v4_max(a, b) _mm_max_ps(a, b)               /* (a > b ? a : b) */
+#define v4_min(a, b) _mm_min_ps(a, b)               /* (a < b ? a : b) */
+
+SIMD_INLINE t_v4 v4_nonzero(t_v4 a, t_v4 b)         /* (b ? a : 0) */
+{
+    return (_mm_and_ps(a, _mm_cmpneq_ps(b, _mm_setzero_ps())));
+}
+
+SIMD_INLINE t_v4 v4_abs(t_v4 a)                     /* (a >= 0 ? a : -a) */
+{
+    t_v4 pos = _mm_cmpge_ps(a, _mm_setzero_ps());
+    return (_mm_or_ps(_mm_and_ps(pos, a),
+        _mm_andnot_ps(pos, _mm_xor_ps(a, _mm_set1_ps(-0.f)))));
+}
+
+    /* k-1 is taken in integers as in the scalar code, where it wraps
+    around for inputs below -2^31 (and all we care about is giving the
+    same nonsense for those) */
+SIMD_INLINE t_v4 v4_wrap(t_v4 a)    /* k = (int)a; (k <= a ? a-k : a-(k-1)) */
+{
+    __m128i ki = _mm_cvttps_epi32(a);
+    t_v4 k = _mm_cvtepi32_ps(ki);
+    t_v4 k1 = _mm_cvtepi32_ps(_mm_sub_epi32(ki, _mm_set1_epi32(1)));
+    t_v4 le = _mm_cmple_ps(k, a);
+    return (_mm_sub_ps(a, _mm_or_ps(_mm_and_ps(le, k),
+        _mm_andnot_ps(le, k1))));
+}
+
+    /* shuffles: transpose four vectors as the rows of a 4x4 matrix;
+    reverse the lanes; split pairs into evens and odds and back again. */
+#define v4_transpose(a, b, c, d) _MM_TRANSPOSE4_PS(a, b, c, d)
+#define v4_reverse(a) _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3))
+#define v4_unzip(lo, hi, ev, od) \
+    (ev = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)), \
+    od = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)))
+#define v4_zip(ev, od, lo, hi) \
+    (lo = _mm_unpacklo_ps(ev, od), hi = _mm_unpackhi_ps(ev, od))
+#endif /* SIMD_SSE2 */
+
+#ifdef SIMD_NEON
+typedef float32x4_t t_v4;
+#define v4_load(p) vld1q_f32(p)
+#define v4_store(p, v) vst1q_f32(p, v)
+#define v4_set1(f) vdupq_n_f32(f)
+#define v4_add(a, b) vaddq_f32(a, b)
+#define v4_sub(a, b) vsubq_f32(a, b)
+#define v4_mul(a, b) vmulq_f32(a, b)
+#define v4_div(a, b) vdivq_f32(a, b)
+    /* vmaxq/vminq propagate NaN and order signed zeros, so select
+    explicitly to match the scalar comparison */
+#define v4_max(a, b) vbslq_f32(vcgtq_f32(a, b), a, b)
+#define v4_min(a, b) vbslq_f32(vcltq_f32(a, b), a, b)
+
+SIMD_INLINE t_v4 v4_nonzero(t_v4 a, t_v4 b)
+{
+    return (vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a),
+        vmvnq_u32(vceqq_f32(b, vdupq_n_f32(0))))));
+}
+
+SIMD_INLINE t_v4 v4_abs(t_v4 a)
+{
+    return (vbslq_f32(vcgeq_f32(a, vdupq_n_f32(0)), a, vnegq_f32(a)));
+}
+
+SIMD_INLINE t_v4 v4_wrap(t_v4 a)
+{
+    int32x4_t ki = vcvtq_s32_f32(a);
+    t_v4 k = vcvtq_f32_s32(ki);
+    return (vsubq_f32(a, vbslq_f32(vcleq_f32(k, a), k,
+        vcvtq_f32_s32(vsubq_s32(ki, vdupq_n_s32(1))))));
+}
+
+#define v4_transpose(a, b, c, d) \
+{ \
+    float32x4x2_t t01 = vtrnq_f32(a, b), t23 = vtrnq_f32(c, d); \
+    a = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])); \
+    b = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])); \
+    c = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])); \
+    d = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])); \
+}
+SIMD_INLINE t_v4 v4_reverse(t_v4 a)
+{
+    a = vrev64q_f32(a);
+    return (vcombine_f32(vget_high_f32(a), vget_low_f32(a)));
+}
+#define v4_unzip(lo, hi, ev, od) \
+{ \
+    float32x4x2_t u = vuzpq_f32(lo, hi); \
+    ev = u.val[0]; od = u.val[1]; \
+}
+#define v4_zip(ev, od, lo, hi) \
+{ \
+    float32x4x2_t z = vzipq_f32(ev, od); \
+    lo = z.val[0]; hi = z.val[1]; \
+}
+#endif /* SIMD_NEON */
+
+#ifdef SIMD_V4
+#define v4_divnz(a, b) v4_nonzero(v4_div(a, b), b)  /* (b ? a / b : 0) */
+#endif
+
+/* ------------------------ eight lanes (AVX2) ------------------------ */
+
+#ifdef SIMD_AVX2
+#define SIMD_TARGET __attribute__((target("avx2")))
+typedef __m256 t_v8;
+
+SIMD_INLINE SIMD_TARGET t_v8 v8_load(const t_sample *p)
+    { return (_mm256_loadu_ps(p)); }
+SIMD_INLINE SIMD_TARGET void v8_store(t_sample *p, t_v8 v)
+    { _mm256_storeu_ps(p, v); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_set1(t_sample f)
+    { return (_mm256_set1_ps(f)); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_add(t_v8 a, t_v8 b)
+    { return (_mm256_add_ps(a, b)); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_sub(t_v8 a, t_v8 b)
+    { return (_mm256_sub_ps(a, b)); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_mul(t_v8 a, t_v8 b)
+    { return (_mm256_mul_ps(a, b)); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_div(t_v8 a, t_v8 b)
+    { return (_mm256_div_ps(a, b)); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_max(t_v8 a, t_v8 b)
+    { return (_mm256_max_ps(a, b)); }
+SIMD_INLINE SIMD_TARGET t_v8 v8_min(t_v8 a, t_v8 b)
+    { return (_mm256_min_ps(a, b)); }
+
+SIMD_INLINE SIMD_TARGET t_v8 v8_nonzero(t_v8 a, t_v8 b)
+{
+    return (_mm256_and_ps(a,
+        _mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_NEQ_UQ)));
+}
+
+SIMD_INLINE SIMD_TARGET t_v8 v8_divnz(t_v8 a, t_v8 b)
+{
+    return (v8_nonzero(_mm256_div_ps(a, b), b));
+}
+
+SIMD_INLINE SIMD_TARGET t_v8 v8_abs(t_v8 a)
+{
+    t_v8 pos = _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ);
+    return (_mm256_blendv_ps(
+        _mm256_xor_ps(a, _mm256_set1_ps(-0.f)), a, pos));
+}
+
+SIMD_INLINE SIMD_TARGET t_v8 v8_wrap(t_v8 a)
+{
+    __m256i ki = _mm256_cvttps_epi32(a);
+    t_v8 k = _mm256_cvtepi32_ps(ki);
+    t_v8 k1 = _mm256_cvtepi32_ps(_mm256_sub_epi32(ki, _mm256_set1_epi32(1)));
+    return (_mm256_sub_ps(a, _mm256_blendv_ps(k1, k,
+        _mm256_cmp_ps(k, a, _CMP_LE_OQ))));
+}
+
+    /* true if the CPU we're running on can execute v8 routines */
+SIMD_INLINE int simd_avx2(void)
+{
+    return (__builtin_cpu_supports("avx2"));
+}
+#endif /* SIMD_AVX2 */
+
+/* ------------------------ denormals ------------------------ */
+
+    /* recursive filters decay into denormals, which are very slow on most
+    CPUs.  Rather than checking every sample, vector routines can run with
+    the FPU set to flush them to zero (FTZ, plus DAZ on x86-64):
+        t_simd_fpstate fp = simd_ftz_on();  ...  simd_ftz_off(fp); */
+#if defined(SIMD_SSE2)
+typedef unsigned int t_simd_fpstate;
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_FTZBITS 0x8040     /* FTZ | DAZ */
+#else
+#define SIMD_FTZBITS 0x8000     /* FTZ; some 32-bit CPUs fault on DAZ */
+#endif
+SIMD_INLINE t_simd_fpstate simd_ftz_on(void)
+{
+    t_simd_fpstate old = _mm_getcsr();
+    _mm_setcsr(old | SIMD_FTZBITS);
+    return (old);
+}
+SIMD_INLINE void simd_ftz_off(t_simd_fpstate old)
+{
+    _mm_setcsr(old);
+}
+#elif defined(SIMD_NEON)
+typedef unsigned long long t_simd_fpstate;
+SIMD_INLINE t_simd_fpstate simd_ftz_on(void)
+{
+    t_simd_fpstate old;
+    __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (old));
+    __asm__ __volatile__ ("msr fpcr, %0" : : "r" (old | (1 << 24)));
+    return (old);
+}
+SIMD_INLINE void simd_ftz_off(t_simd_fpstate old)
+{
+    __asm__ __volatile__ ("msr fpcr, %0" : : "r" (old));
+}
+#endif
+
+/* ------------------------ routine templates ------------------------ */
+
+    /* perform routines for a vector operation; "name" is e.g. plus and
+    "v" is v4 or v8.  Like the "perf8" routines, they require the block
+    size to be a multiple of 8. */
+#define SIMD_BINOP(name, v, op, attr) \
+attr static t_int *name##_perf##v(t_int *w) \
+{ \
+    t_sample *in1 = (t_sample *)(w[1]); \
+    t_sample *in2 = (t_sample *)(w[2]); \
+    t_sample *out = (t_sample *)(w[3]); \
+    int n = (int)(w[4]); \
+    for (; n; n -= 8, in1 += 8, in2 += 8, out += 8) \
+    { \
+        v##_store(out, op(v##_load(in1), v##_load(in2))); \
+        if (sizeof(t_##v) < 8 * sizeof(t_sample)) \
+            v##_store(out+4, op(v##_load(in1+4), v##_load(in2+4))); \
+    } \
+    return (w+5); \
+}
+
+    /* vector-scalar operation; the scalar is fetched once per block */
+#define SIMD_SCALAROP(name, v, op, attr) \
+attr static t_int *name##_perf##v(t_int *w) \
+{ \
+    t_sample *in = (t_sample *)(w[1]); \
+    t_##v g = v##_set1(*(t_float *)(w[2])); \
+    t_sample *out = (t_sample *)(w[3]); \
+    int n = (int)(w[4]); \
+    for (; n; n -= 8, in += 8, out += 8) \
+    { \
+        v##_store(out, op(v##_load(in), g)); \
+        if (sizeof(t_##v) < 8 * sizeof(t_sample)) \
+            v##_store(out+4, op(v##_load(in+4), g)); \
+    } \
+    return (w+5); \
+}
+
+    /* one-input transfer function, for "perform" routines taking
+    (in, out, n) */
+#define SIMD_UNOP(name, v, op, attr) \
+attr static t_int *name##_perf##v(t_int *w) \
+{ \
+    t_sample *in = (t_sample *)(w[1]); \
+    t_sample *out = (t_sample *)(w[2]); \
+    int n = (int)(w[3]); \
+    for (; n; n -= 8, in += 8, out += 8) \
+    { \
+        v##_store(out, op(v##_load(in))); \
+        if (sizeof(t_##v) < 8 * sizeof(t_sample)) \
+            v##_store(out+4, op(v##_load(in+4))); \
+    } \
+    return (w+4); \
+}
+
+    /* instantiate a template for every vector width we can build */
+#ifdef SIMD_AVX2
+#define SIMD_DEFINE(template, name, op) \
+    template(name, v4, v4_##op, ) \
+    template(name, v8, v8_##op, SIMD_TARGET)
+#elif defined(SIMD_V4)
+#define SIMD_DEFINE(template, name, op) \
+    template(name, v4, v4_##op, )
+#else
+#define SIMD_DEFINE(template, name, op)
+#endif
+
+    /* choose the routine for a block size that's a multiple of 8:
+    "scalar" is the portable fallback, "name" the SIMD_DEFINE()d one. */
+#ifdef SIMD_AVX2
+#define SIMD_PERFORM(scalar, name) \
+    (simd_avx2() ? name##_perfv8 : name##_perfv4)
+#elif defined(SIMD_V4)
+#define SIMD_PERFORM(scalar, name) (name##_perfv4)
+#else
+#define SIMD_PERFORM(scalar, name) (scalar)
+#endif
+
+#endif /* __d_simd_h_ */
@@ -17,8 +17,14 @@ objects use Posix-like threads.  */
 #include <pthread.h>
 #ifdef _WIN32
 #include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 #include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
@@ -26,6 +32,8 @@ objects use Posix-like threads.  */
 #include <limits.h>
 
 #include "m_pd.h"
+#include "s_stuff.h"
+#include "g_canvas.h"
 
 #define MAXSFCHANS 64
 
@@ -574,86 +582,80 @@ static void soundfile_xferin_sample(int sfchannels, int nvecs, t_sample **vecs,
 
 }
 
-static void soundfile_xferin_words(int sfchannels, int nvecs, t_word **vecs,
-    long itemsread, unsigned char *buf, long nitems, int bytespersamp,
+    /* convert frames into the float arrays for soundfiler_read.  This is the
+    hot loop when loading large samples, so samples are picked up whole and
+    scaled by a power of two rather than shifted up into a long and scaled
+    in double precision, and each format gets a short loop with constant
+    byte offsets.  The result is bit-identical to the streaming version
+    above.  The loops aren't vectorized: each point is stored "stride"
+    floats from the last, a whole t_word apart unless the array is packed,
+    and the channels of the file are interleaved. */
+
+#define XFER16(b0, b1) \
+    for (j = 0; j < nitems; j++, sp += bytesperframe, fp += stride) \
+        *fp = (t_float)(short)(sp[b0] | (sp[b1] << 8)) * \
+            (t_float)(1./32768.)
+#define XFER24(b0, b1, b2) \
+    for (j = 0; j < nitems; j++, sp += bytesperframe, fp += stride) \
+        *fp = (t_float)(((int)(sp[b0] | (sp[b1] << 8) | (sp[b2] << 16)) \
+            ^ 0x800000) - 0x800000) * (t_float)(1./8388608.)
+#define XFER32(b0, b1, b2, b3) \
+    for (j = 0; j < nitems; j++, sp += bytesperframe, fp += stride) \
+        *fp = (word32.long32 = (unsigned int)sp[b0] | \
+            ((unsigned int)sp[b1] << 8) | ((unsigned int)sp[b2] << 16) | \
+            ((unsigned int)sp[b3] << 24), word32.float32)
+
+static void soundfile_xferin_words(int sfchannels, int nvecs, t_float **vecs,
+    int *strides, long itemsread, unsigned char *buf, long nitems, int bytespersamp,
     int bigendian)
 {
-    int i;
+    int i, stride;
     long j;
-    unsigned char *sp, *sp2;
-    t_word *wp;
+    unsigned char *sp;
+    t_float *fp;
     int nchannels = (sfchannels < nvecs ? sfchannels : nvecs);
     int bytesperframe = bytespersamp * sfchannels;
     union
     {
-        long long32;
+        unsigned int long32;
         float float32;
     } word32;
-    for (i = 0, sp = buf; i < nchannels; i++, sp += bytespersamp)
+    for (i = 0; i < nchannels; i++)
     {
+        sp = buf + i * bytespersamp;
+        stride = strides[i];
+        fp = vecs[i] + itemsread * stride;
         if (bytespersamp == 2)
         {
             if (bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + itemsread;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[0] << 24) | (sp2[1] << 16));
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + itemsread;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[1] << 24) | (sp2[0] << 16));
-            }
+                XFER16(1, 0);
+            else XFER16(0, 1);
         }
         else if (bytespersamp == 3)
         {
             if (bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + itemsread;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[0] << 24) | (sp2[1] << 16)
-                            | (sp2[2] << 8));
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + itemsread;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[2] << 24) | (sp2[1] << 16)
-                            | (sp2[0] << 8));
-            }
+                XFER24(2, 1, 0);
+            else XFER24(0, 1, 2);
         }
         else if (bytespersamp == 4)
         {
             if (bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + itemsread;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
-                {
-                    word32.long32 = (sp2[0] << 24) |
-                            (sp2[1] << 16) | (sp2[2] << 8) | sp2[3];
-                    wp->w_float = word32.float32;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + itemsread;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
-                {
-                    word32.long32 = (sp2[3] << 24) |
-                        (sp2[2] << 16) | (sp2[1] << 8) | sp2[0];
-                    wp->w_float = word32.float32;
-                }
-            }
+                XFER32(3, 2, 1, 0);
+            else XFER32(0, 1, 2, 3);
         }
     }
         /* zero out other outputs */
     for (i = sfchannels; i < nvecs; i++)
-        for (j = nitems, wp = vecs[i]; j--; )
-            (wp++)->w_float = 0;
+        for (j = nitems, fp = vecs[i] + itemsread * strides[i]; j--;
+            fp += strides[i])
+                *fp = 0;
 
 }
 
+#undef XFER16
+#undef XFER24
+#undef XFER32
+
     /* soundfiler_write ...
 
     usage: write [flags] filename table ...
@@ -827,7 +829,8 @@ usage:
     return (-1);
 }
 
-/* p_headersize is a getter, set to NULL if not needed */
+/* p_headersize is a getter, set to NULL if not needed.  If canvas is NULL
+the filename is used as is. */
 static int create_soundfile(t_canvas *canvas, const char *filename,
     int filetype, long nframes, int bytespersamp, int bigendian, int nchannels,
     int swap, t_float samplerate, int *p_headersize)
@@ -905,7 +908,9 @@ static int create_soundfile(t_canvas *canvas, const char *filename,
         headersize = sizeof(t_wave);
     }
 
-    canvas_makefilename(canvas, filenamebuf, buf2, MAXPDSTRING);
+    if (canvas)
+        canvas_makefilename(canvas, filenamebuf, buf2, MAXPDSTRING);
+    else strcpy(buf2, filenamebuf);
     if ((fd = sys_open(buf2, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
         return (-1);
 
@@ -1097,13 +1102,13 @@ static void soundfile_xferout_sample(int nchannels, t_sample **vecs,
     }
 }
 
-static void soundfile_xferout_words(int nchannels, t_word **vecs,
-    unsigned char *buf, long nitems, long onset, int bytespersamp,
+static void soundfile_xferout_words(int nchannels, t_float **vecs,
+    int *strides, unsigned char *buf, long nitems, long onset, int bytespersamp,
     int bigendian, t_sample normalfactor)
 {
     int i, j;
     unsigned char *sp, *sp2;
-    t_word *wp;
+    t_float *fp;
     int bytesperframe = bytespersamp * nchannels;
     for (i = 0, sp = buf; i < nchannels; i++, sp += bytespersamp)
     {
@@ -1112,10 +1117,10 @@ static void soundfile_xferout_words(int nchannels, t_word **vecs,
             t_sample ff = normalfactor * 32768.;
             if (bigendian)
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onset;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
+                for (j = 0, sp2 = sp, fp = vecs[i] + onset * strides[i];
+                    j < nitems; j++, sp2 += bytesperframe, fp += strides[i])
                 {
-                    int xx = 32768. + (wp->w_float * ff);
+                    int xx = 32768. + (*fp * ff);
                     xx -= 32768;
                     if (xx < -32767)
                         xx = -32767;
@@ -1127,10 +1132,10 @@ static void soundfile_xferout_words(int nchannels, t_word **vecs,
             }
             else
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onset;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
+                for (j = 0, sp2 = sp, fp = vecs[i] + onset * strides[i];
+                    j < nitems; j++, sp2 += bytesperframe, fp += strides[i])
                 {
-                    int xx = 32768. + (wp->w_float * ff);
+                    int xx = 32768. + (*fp * ff);
                     xx -= 32768;
                     if (xx < -32767)
                         xx = -32767;
@@ -1146,10 +1151,10 @@ static void soundfile_xferout_words(int nchannels, t_word **vecs,
             t_sample ff = normalfactor * 8388608.;
             if (bigendian)
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onset;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
+                for (j = 0, sp2 = sp, fp = vecs[i] + onset * strides[i];
+                    j < nitems; j++, sp2 += bytesperframe, fp += strides[i])
                 {
-                    int xx = 8388608. + (wp->w_float * ff);
+                    int xx = 8388608. + (*fp * ff);
                     xx -= 8388608;
                     if (xx < -8388607)
                         xx = -8388607;
@@ -1162,10 +1167,10 @@ static void soundfile_xferout_words(int nchannels, t_word **vecs,
             }
             else
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onset;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
+                for (j = 0, sp2 = sp, fp = vecs[i] + onset * strides[i];
+                    j < nitems; j++, sp2 += bytesperframe, fp += strides[i])
                 {
-                    int xx = 8388608. + (wp->w_float * ff);
+                    int xx = 8388608. + (*fp * ff);
                     xx -= 8388608;
                     if (xx < -8388607)
                         xx = -8388607;
@@ -1181,22 +1186,22 @@ static void soundfile_xferout_words(int nchannels, t_word **vecs,
         {
             if (bigendian)
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onset;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
+                for (j = 0, sp2 = sp, fp = vecs[i] + onset * strides[i];
+                    j < nitems; j++, sp2 += bytesperframe, fp += strides[i])
                 {
                     t_sampleuint f2;
-                    f2.f = wp->w_float * normalfactor;
+                    f2.f = *fp * normalfactor;
                     sp2[0] = (f2.l >> 24); sp2[1] = (f2.l >> 16);
                     sp2[2] = (f2.l >> 8); sp2[3] = f2.l;
                 }
             }
             else
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onset;
-                    j < nitems; j++, sp2 += bytesperframe, wp++)
+                for (j = 0, sp2 = sp, fp = vecs[i] + onset * strides[i];
+                    j < nitems; j++, sp2 += bytesperframe, fp += strides[i])
                 {
                     t_sampleuint f2;
-                    f2.f = wp->w_float * normalfactor;
+                    f2.f = *fp * normalfactor;
                     sp2[3] = (f2.l >> 24); sp2[2] = (f2.l >> 16);
                     sp2[1] = (f2.l >> 8); sp2[0] = f2.l;
                 }
@@ -1208,6 +1213,8 @@ static void soundfile_xferout_words(int nchannels, t_word **vecs,
 /* ------- soundfiler - reads and writes soundfiles to/from "garrays" ---- */
 #define DEFMAXSIZE 0x7fffffff      /* default maximum size in sample frames */
 #define SAMPBUFSIZE 1024
+#define READBUFSIZE 65536           /* soundfiler_read buffer if no mmap */
+#define MAPBLOCKSIZE 65536          /* bytes converted per mapped block */
 
 
 static t_class *soundfiler_class;
@@ -1216,18 +1223,468 @@ typedef struct _soundfiler
 {
     t_object x_obj;
     t_outlet *x_out2;
+    t_outlet *x_out3;
     t_canvas *x_canvas;
+    t_clock *x_clock;           /* polls for finished "-async" reads */
+    struct _sfload *x_loads;    /* pending "-async" reads, in order */
 } t_soundfiler;
 
+    /* read up to "nframes" frames from the current position of "fd" by
+    mapping the file into memory and converting straight out of the page
+    cache, in blocks small enough to stay in cache while each channel in
+    turn is picked out of them.  Returns the number of frames read, or -1
+    if the file can't be mapped, in which case the caller uses read().
+        The mapping is only kept for the read.  A packed array could point
+    straight into it for mono 32-bit float files in the machine's byte
+    order, so that only the pages touched would be loaded, but the arrays'
+    storage is resized and freed with resizebytes() and freebytes() in
+    g_array.c, g_traversal.c and g_template.c, all of which would have to
+    tell a mapping apart, and the array would fault (SIGBUS) in the DSP
+    routines if the file were later truncated or rewritten. */
+
+static long soundfiler_mapread(int fd, t_soundfile_info *info, int nvecs,
+    t_float **vecs, int *strides, long nframes)
+{
+#ifdef _WIN32
+    return (-1);
+#else
+    int bytesperframe = info->channels * info->bytespersample;
+    long itemsread = 0, blockframes = MAPBLOCKSIZE / bytesperframe;
+    off_t pos = lseek(fd, 0, SEEK_CUR), mapstart, maplen;
+    long pagesize = sysconf(_SC_PAGESIZE);
+    struct stat st;
+    unsigned char *map;
+    if (pos < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+        pagesize <= 0)
+            return (-1);
+    if (st.st_size <= pos)
+        return (0);
+    if ((off_t)nframes > (st.st_size - pos) / bytesperframe)
+        nframes = (long)((st.st_size - pos) / bytesperframe);
+    if (!nframes)
+        return (0);
+        /* the mapping has to start on a page boundary */
+    mapstart = pos - pos % pagesize;
+    maplen = pos - mapstart + (off_t)nframes * bytesperframe;
+    if ((size_t)maplen != maplen)
+        return (-1);
+    map = (unsigned char *)mmap(0, (size_t)maplen, PROT_READ, MAP_PRIVATE,
+        fd, mapstart);
+    if (map == MAP_FAILED)
+        return (-1);
+#ifdef MADV_SEQUENTIAL
+    madvise(map, (size_t)maplen, MADV_SEQUENTIAL);
+#endif
+    while (itemsread < nframes)
+    {
+        long thisread = nframes - itemsread;
+        if (thisread > blockframes)
+            thisread = blockframes;
+        soundfile_xferin_words(info->channels, nvecs, vecs, strides,
+            itemsread, map + (pos - mapstart) +
+                (off_t)itemsread * bytesperframe,
+            thisread, info->bytespersample, info->bigendian);
+        itemsread += thisread;
+    }
+    munmap(map, (size_t)maplen);
+    return (itemsread);
+#endif /* _WIN32 */
+}
+
+    /* read up to "nframes" frames into the arrays, through a mapping if
+    possible and otherwise with read().  Returns the number of frames read.
+    Doesn't call into Pd, not even getbytes(), so the async loader threads
+    can use it too. */
+static long soundfiler_readframes(int fd, t_soundfile_info *info, int nvecs,
+    t_float **vecs, int *strides, long nframes)
+{
+    int bytesperframe = info->channels * info->bytespersample;
+    long itemsread, bufframes = READBUFSIZE / bytesperframe, nitems, have = 0;
+    char *buf;
+    if ((itemsread = soundfiler_mapread(fd, info, nvecs, vecs, strides,
+        nframes)) >= 0)
+            return (itemsread);
+    if (!(buf = (char *)malloc(READBUFSIZE)))
+        return (0);
+    for (itemsread = 0; itemsread < nframes; )
+    {
+        long thisread = nframes - itemsread, got;
+        thisread = (thisread > bufframes ? bufframes : thisread);
+        if ((got = read(fd, buf + have, thisread * bytesperframe - have)) <= 0)
+            break;
+            /* convert whole frames, keep any partial one for next time */
+        have += got;
+        if ((nitems = have / bytesperframe))
+        {
+            soundfile_xferin_words(info->channels, nvecs, vecs, strides,
+                itemsread, (unsigned char *)buf, nitems,
+                info->bytespersample, info->bigendian);
+            itemsread += nitems;
+            have -= nitems * bytesperframe;
+            memmove(buf, buf + nitems * bytesperframe, have);
+        }
+    }
+    free(buf);
+    return (itemsread);
+}
+
+    /* number of frames from the current position to the end of the file,
+    leaving the position alone, or -1 if lseek() fails */
+static long soundfiler_framesinfile(int fd, t_soundfile_info *info)
+{
+    long poswas, eofis;
+    poswas = (long)lseek(fd, 0, SEEK_CUR);
+    eofis = (long)lseek(fd, 0, SEEK_END);
+    if (poswas < 0 || eofis < 0 || eofis < poswas)
+        return (-1);
+    lseek(fd, poswas, SEEK_SET);
+    return ((eofis - poswas) / (info->channels * info->bytespersample));
+}
+
+/************** "read -async": loading files in parallel ***************/
+
+/* Each "read -async" opens its file on Pd's thread, where the canvas search
+path may be used, and queues the rest of the work.  Loader threads parse the
+header and decode the samples, as many files at once as there are processors,
+into buffers laid out like the tables' own storage.  They never touch Pd, so
+their memory comes from calloc() rather than getbytes() and they close their
+files with close() rather than sys_close().  The soundfiler polls
+with a clock and hands finished reads to their tables in the order they were
+asked for, so the outlets fire just as they would have for "read" in a row,
+and it bangs its right outlet once nothing is pending.  Handing over is just
+swapping in the buffers (see garray_setvec()) unless a table was deleted or
+changed in the meantime, in which case it's looked up and copied as usual.
+Separate threads are used so long loads can't hold up readsf~ and writesf~. */
+
+#define SFLOAD_MAXTHREADS 16
+#define SFLOAD_POLLMS 5             /* how often a soundfiler looks */
+
+#ifdef _WIN32                       /* not sys_close(), see above */
+#define sfload_close _close
+#else
+#define sfload_close close
+#endif
+
+#define SFLOAD_QUEUED 0
+#define SFLOAD_BUSY 1
+#define SFLOAD_DONE 2
+
+typedef struct _sfload
+{
+    struct _sfload *l_next;     /* next in the loader queue */
+    struct _sfload *l_nextread; /* next read of the same soundfiler */
+    t_soundfiler *l_owner;      /* zero once the soundfiler is freed */
+    int l_state;                /* SFLOAD_QUEUED, _BUSY or _DONE */
+    int l_fd;
+    t_symbol *l_filename;
+    t_soundfile_info l_info;
+    long l_skipframes;
+    int l_resize;
+    long l_maxsize;
+    long l_finalsize;           /* table size, or what to resize to */
+    int l_ntables;
+    t_symbol *l_tables[MAXSFCHANS];
+    int l_strides[MAXSFCHANS];  /* the tables' layout when asked */
+    t_float *l_vecs[MAXSFCHANS];  /* decoded channels, laid out the same */
+    long l_nalloc;              /* points in each of l_vecs */
+    long l_nframes;             /* frames decoded */
+    int l_errno;                /* nonzero if the read failed */
+    int l_truncated;            /* true if cut down to l_maxsize */
+} t_sfload;
+
+static struct _sfloader
+{
+    pthread_mutex_t l_mutex;
+    t_sfload *l_head;           /* reads waiting for a thread */
+    t_sfload *l_tail;
+    int l_nthreads;             /* threads running; they quit when idle */
+} sfloader = {PTHREAD_MUTEX_INITIALIZER, 0, 0, 0};
+
+static int sfloader_maxthreads(void)
+{
+    static int maxthreads;
+    if (!maxthreads)
+    {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        maxthreads = info.dwNumberOfProcessors;
+#else
+        maxthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (maxthreads < 2)
+            maxthreads = 2;
+        else if (maxthreads > SFLOAD_MAXTHREADS)
+            maxthreads = SFLOAD_MAXTHREADS;
+    }
+    return (maxthreads);
+}
+
+static void sfload_free(t_sfload *l)
+{
+    int i;
+    if (l->l_fd >= 0)
+        sfload_close(l->l_fd);
+    for (i = 0; i < l->l_ntables; i++)
+        free(l->l_vecs[i]);
+    free(l);
+}
+
+    /* the part of soundfiler_read that runs in a loader thread */
+static void sfload_run(t_sfload *l)
+{
+    int i, nvecs, bytesperframe;
+    long framesinfile, nframes = l->l_finalsize;
+    errno = 0;
+    if (open_soundfile_via_fd(l->l_fd, &l->l_info, l->l_skipframes) < 0 ||
+        (framesinfile = soundfiler_framesinfile(l->l_fd, &l->l_info)) < 0)
+    {
+        l->l_errno = (errno ? errno : EIO);
+        return;
+    }
+    bytesperframe = l->l_info.channels * l->l_info.bytespersample;
+    if (l->l_resize)
+    {
+        nframes = framesinfile;
+        if (nframes > l->l_maxsize)
+            nframes = l->l_maxsize, l->l_truncated = 1;
+        if (nframes > l->l_info.bytelimit / bytesperframe)
+            nframes = l->l_info.bytelimit / bytesperframe;
+        l->l_finalsize = nframes;
+    }
+    if (nframes > l->l_info.bytelimit / bytesperframe)
+        nframes = l->l_info.bytelimit / bytesperframe;
+    if (nframes > framesinfile)
+        nframes = framesinfile;
+    nvecs = (l->l_ntables < l->l_info.channels ?
+        l->l_ntables : l->l_info.channels);
+    if (!nvecs || nframes <= 0)
+        return;
+        /* the whole table, so that the rest is already zeroed */
+    l->l_nalloc = (l->l_finalsize > nframes ? l->l_finalsize : nframes);
+    for (i = 0; i < nvecs; i++)
+        if (!(l->l_vecs[i] = (t_float *)calloc(l->l_nalloc,
+            l->l_strides[i] * sizeof(t_float))))
+        {
+            l->l_errno = ENOMEM;
+            return;
+        }
+    l->l_nframes = soundfiler_readframes(l->l_fd, &l->l_info, nvecs,
+        l->l_vecs, l->l_strides, nframes);
+}
+
+static void *sfloader_thread(void *dummy)
+{
+    t_sfload *l;
+    pthread_mutex_lock(&sfloader.l_mutex);
+    while ((l = sfloader.l_head))
+    {
+        if (!(sfloader.l_head = l->l_next))
+            sfloader.l_tail = 0;
+        l->l_state = SFLOAD_BUSY;
+        pthread_mutex_unlock(&sfloader.l_mutex);
+
+        sfload_run(l);
+        sfload_close(l->l_fd);
+        l->l_fd = -1;
+
+        pthread_mutex_lock(&sfloader.l_mutex);
+        if (l->l_owner)
+            l->l_state = SFLOAD_DONE;
+        else sfload_free(l);
+    }
+    sfloader.l_nthreads--;
+    pthread_mutex_unlock(&sfloader.l_mutex);
+    return (0);
+}
+
+    /* queue a read for the loader threads, with the loader locked */
+static void sfloader_push(t_sfload *l)
+{
+    l->l_next = 0;
+    if (sfloader.l_tail)
+        sfloader.l_tail->l_next = l;
+    else sfloader.l_head = l;
+    sfloader.l_tail = l;
+    if (sfloader.l_nthreads < sfloader_maxthreads())
+    {
+        pthread_t thread;
+        if (!pthread_create(&thread, 0, sfloader_thread, 0))
+        {
+            pthread_detach(thread);
+            sfloader.l_nthreads++;
+        }
+        else if (!sfloader.l_nthreads)
+            error("soundfiler: couldn't start loader thread");
+    }
+}
+
+    /* set up an async read after soundfiler_read has checked its
+    arguments; errors opening the file are reported in turn, later */
+static void soundfiler_readasync(t_soundfiler *x, t_symbol *filename,
+    int ntables, t_atom *tables, int *strides, t_soundfile_info *info,
+    long skipframes, int resize, long maxsize, long finalsize)
+{
+    char buf[MAXPDSTRING], *bufptr;
+    t_sfload *l = (t_sfload *)calloc(1, sizeof(*l)), **lp;
+    int i, wasidle = !x->x_loads;
+    if (!l)
+    {
+        pd_error(x, "soundfiler_read: out of memory");
+        return;
+    }
+    l->l_owner = x;
+    l->l_filename = filename;
+    l->l_info = *info;
+    l->l_skipframes = skipframes;
+    l->l_resize = resize;
+    l->l_maxsize = maxsize;
+    l->l_finalsize = finalsize;
+    l->l_ntables = ntables;
+    for (i = 0; i < ntables; i++)
+    {
+        l->l_tables[i] = tables[i].a_w.w_symbol;
+        l->l_strides[i] = strides[i];
+    }
+    if ((l->l_fd = canvas_open(x->x_canvas, filename->s_name, "",
+        buf, &bufptr, MAXPDSTRING, 1)) < 0)
+            l->l_errno = (errno ? errno : ENOENT);
+    for (lp = &x->x_loads; *lp; lp = &(*lp)->l_nextread)
+        ;
+    *lp = l;
+    pthread_mutex_lock(&sfloader.l_mutex);
+    if (l->l_fd < 0)
+        l->l_state = SFLOAD_DONE;
+    else sfloader_push(l);
+    pthread_mutex_unlock(&sfloader.l_mutex);
+    if (wasidle)
+        clock_delay(x->x_clock, SFLOAD_POLLMS);
+}
+
+    /* copy a finished read into its tables and report it like "read" */
+static void soundfiler_finishread(t_soundfiler *x, t_sfload *l)
+{
+    int i, vecsize, stride;
+    int nvecs = (l->l_ntables < l->l_info.channels ?
+        l->l_ntables : l->l_info.channels);
+    long j, n, itemsread = 0;
+    t_float *vec;
+    if (l->l_errno)
+        pd_error(x, "soundfiler_read: %s: %s", l->l_filename->s_name,
+            (l->l_errno == EIO ? "unknown or bad header format" :
+                strerror(l->l_errno)));
+    else
+    {
+        if (l->l_truncated)
+            pd_error(x, "soundfiler_read: truncated to %ld elements",
+                l->l_maxsize);
+        itemsread = l->l_nframes;
+        for (i = 0; i < l->l_ntables; i++)
+        {
+            t_garray *a = (t_garray *)pd_findbyclass(l->l_tables[i],
+                garray_class);
+            if (!a)
+            {
+                pd_error(x, "%s: no such table", l->l_tables[i]->s_name);
+                continue;
+            }
+            if (!garray_getfloatvec(a, &vecsize, &vec, &stride))
+                continue;
+            if (l->l_resize)
+                garray_setsaveit(a, 0);
+            if (i < nvecs && l->l_vecs[i] &&
+                (l->l_resize || vecsize == l->l_nalloc) &&
+                garray_setvec(a, l->l_nalloc, l->l_vecs[i], l->l_strides[i]))
+            {
+                l->l_vecs[i] = 0;
+                continue;
+            }
+            if (l->l_resize)
+            {
+                garray_resize_long(a, l->l_finalsize);
+                if (!garray_getfloatvec(a, &vecsize, &vec, &stride))
+                    continue;
+                if (vecsize != (l->l_finalsize < 1 ? 1 : l->l_finalsize))
+                    pd_error(x, "resize failed");
+            }
+            n = (i < nvecs && l->l_vecs[i] ?
+                (itemsread < vecsize ? itemsread : vecsize) : 0);
+            for (j = 0; j < n; j++)
+                vec[j * stride] = l->l_vecs[i][j * l->l_strides[i]];
+            for (; j < vecsize; j++)
+                vec[j * stride] = 0;
+            garray_redraw(a);
+        }
+    }
+    outlet_soundfile_info(x->x_out2, &l->l_info);
+    outlet_float(x->x_obj.ob_outlet, (t_float)itemsread);
+}
+
+static void soundfiler_poll(t_soundfiler *x)
+{
+    t_sfload *l;
+    while (1)
+    {
+        pthread_mutex_lock(&sfloader.l_mutex);
+        if ((l = x->x_loads) && l->l_state == SFLOAD_DONE)
+            x->x_loads = l->l_nextread;
+        else l = 0;
+        pthread_mutex_unlock(&sfloader.l_mutex);
+        if (!l)
+            break;
+        soundfiler_finishread(x, l);
+        sfload_free(l);
+        if (!x->x_loads)
+        {
+            outlet_bang(x->x_out3);
+            return;
+        }
+    }
+    clock_delay(x->x_clock, SFLOAD_POLLMS);
+}
+
 static t_soundfiler *soundfiler_new(void)
 {
     t_soundfiler *x = (t_soundfiler *)pd_new(soundfiler_class);
     x->x_canvas = canvas_getcurrent();
     outlet_new(&x->x_obj, &s_float);
     x->x_out2 = outlet_new(&x->x_obj, &s_float);
+    x->x_out3 = outlet_new(&x->x_obj, &s_bang);
+    x->x_clock = clock_new(x, (t_method)soundfiler_poll);
+    x->x_loads = 0;
     return (x);
 }
 
+    /* drop pending reads; ones a loader thread is busy with are freed
+    by that thread */
+static void soundfiler_free(t_soundfiler *x)
+{
+    t_sfload *l, *next, *prev, *q;
+    pthread_mutex_lock(&sfloader.l_mutex);
+    for (l = x->x_loads; l; l = next)
+    {
+        next = l->l_nextread;
+        if (l->l_state == SFLOAD_QUEUED)
+        {
+            for (prev = 0, q = sfloader.l_head; q != l;
+                prev = q, q = q->l_next)
+                    ;
+            if (prev)
+                prev->l_next = l->l_next;
+            else sfloader.l_head = l->l_next;
+            if (sfloader.l_tail == l)
+                sfloader.l_tail = prev;
+            sfload_free(l);
+        }
+        else if (l->l_state == SFLOAD_BUSY)
+            l->l_owner = 0;
+        else sfload_free(l);
+    }
+    x->x_loads = 0;
+    pthread_mutex_unlock(&sfloader.l_mutex);
+    clock_free(x->x_clock);
+}
+
     /* soundfiler_read ...
 
     usage: read [flags] filename table ...
@@ -1237,24 +1694,22 @@ static t_soundfiler *soundfiler_new(void)
         -raw <headersize channels bytes endian>
         -resize
         -maxsize <max-size>
+        -async ... load in a thread and output when done, see above
     */
 
 static void soundfiler_read(t_soundfiler *x, t_symbol *s,
     int argc, t_atom *argv)
 {
     t_soundfile_info info;
-    int resize = 0, i;
+    int resize = 0, async = 0, i;
     long skipframes = 0, finalsize = 0,
         maxsize = DEFMAXSIZE, itemsread = 0, j;
     int fd = -1;
     char endianness;
     const char *filename;
     t_garray *garrays[MAXSFCHANS];
-    t_word *vecs[MAXSFCHANS];
-    char sampbuf[SAMPBUFSIZE];
-    int bufframes;
-    long nitems;
-    FILE *fp;
+    t_float *vecs[MAXSFCHANS];
+    int strides[MAXSFCHANS];
     info.samplerate = 0,
     info.channels = 0,
     info.bytespersample = 0,
@@ -1310,6 +1765,11 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
             resize = 1;     /* maxsize implies resize. */
             argc -= 2; argv += 2;
         }
+        else if (!strcmp(flag, "async"))
+        {
+            async = 1;
+            argc -= 1; argv += 1;
+        }
         else goto usage;
     }
     if (argc < 1 ||                           /* no filename or tables */
@@ -1330,10 +1790,13 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
             pd_error(x, "%s: no such table", argv[i].a_w.w_symbol->s_name);
             goto done;
         }
-        else if (!garray_getfloatwords(garrays[i], &vecsize,
-                &vecs[i]))
+        else if (!garray_getfloatvec(garrays[i], &vecsize,
+                &vecs[i], &strides[i]))
+        {
             error("%s: bad template for tabwrite",
                 argv[i].a_w.w_symbol->s_name);
+            strides[i] = 1;
+        }
         if (finalsize && finalsize != vecsize && !resize)
         {
             post("soundfiler_read: arrays have different lengths; resizing...");
@@ -1341,6 +1804,12 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
         }
         finalsize = vecsize;
     }
+    if (async)
+    {
+        soundfiler_readasync(x, gensym(filename), argc, argv, strides,
+            &info, skipframes, resize, maxsize, finalsize);
+        return;
+    }
     fd = open_soundfile_via_canvas(x->x_canvas, filename, &info, skipframes);
 
     if (fd < 0)
@@ -1353,17 +1822,12 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
     if (resize)
     {
             /* figure out what to resize to */
-        long poswas, eofis, framesinfile;
-
-        poswas = (long)lseek(fd, 0, SEEK_CUR);
-        eofis = (long)lseek(fd, 0, SEEK_END);
-        if (poswas < 0 || eofis < 0 || eofis < poswas)
+        long framesinfile = soundfiler_framesinfile(fd, &info);
+        if (framesinfile < 0)
         {
             pd_error(x, "soundfiler_read: lseek failed");
             goto done;
         }
-        lseek(fd, poswas, SEEK_SET);
-        framesinfile = (eofis - poswas) / (info.channels * info.bytespersample);
         if (framesinfile > maxsize)
         {
             pd_error(x, "soundfiler_read: truncated to %ld elements", maxsize);
@@ -1379,7 +1843,8 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
             garray_resize_long(garrays[i], finalsize);
                 /* for sanity's sake let's clear the save-in-patch flag here */
             garray_setsaveit(garrays[i], 0);
-            if (!garray_getfloatwords(garrays[i], &vecsize, &vecs[i])
+            if (!garray_getfloatvec(garrays[i], &vecsize, &vecs[i],
+                &strides[i])
                 /* if the resize failed, garray_resize reported the error */
                 || (vecsize != framesinfile))
             {
@@ -1391,45 +1856,32 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
     if (!finalsize) finalsize = 0x7fffffff;
     if (finalsize > info.bytelimit / (info.channels * info.bytespersample))
         finalsize = info.bytelimit / (info.channels * info.bytespersample);
-    fp = fdopen(fd, "rb");
-    bufframes = SAMPBUFSIZE / (info.channels * info.bytespersample);
-
-    for (itemsread = 0; itemsread < finalsize; )
-    {
-        long thisread = finalsize - itemsread;
-        thisread = (thisread > bufframes ? bufframes : thisread);
-        nitems = fread(sampbuf, info.channels * info.bytespersample, thisread, fp);
-        if (nitems <= 0) break;
-        soundfile_xferin_words(info.channels, argc, vecs, itemsread,
-            (unsigned char *)sampbuf, nitems, info.bytespersample, info.bigendian);
-        itemsread += nitems;
-    }
+    itemsread = soundfiler_readframes(fd, &info, argc, vecs, strides,
+        finalsize);
         /* zero out remaining elements of vectors */
     for (i = 0; i < argc; i++)
     {
         int vecsize;
-        if (garray_getfloatwords(garrays[i], &vecsize, &vecs[i]))
+        if (garray_getfloatvec(garrays[i], &vecsize, &vecs[i], &strides[i]))
             for (j = itemsread; j < vecsize; j++)
-                vecs[i][j].w_float = 0;
+                vecs[i][j * strides[i]] = 0;
     }
         /* zero out vectors in excess of number of channels */
     for (i = info.channels; i < argc; i++)
     {
-        int vecsize;
-        t_word *foo;
-        if (garray_getfloatwords(garrays[i], &vecsize, &foo))
+        int vecsize, stride;
+        t_float *foo;
+        if (garray_getfloatvec(garrays[i], &vecsize, &foo, &stride))
             for (j = 0; j < vecsize; j++)
-                foo[j].w_float = 0;
+                foo[j * stride] = 0;
     }
         /* do all graphics updates */
     for (i = 0; i < argc; i++)
         garray_redraw(garrays[i]);
-    fclose(fp);
-    fd = -1;
     goto done;
 usage:
     pd_error(x, "usage: read [flags] filename tablename...");
-    post("flags: -skip <n> -resize -maxsize <n> ...");
+    post("flags: -skip <n> -resize -maxsize <n> -async ...");
     post("-raw <headerbytes> <channels> <bytespersamp> <endian (b, l, or n)>.");
 done:
     if (fd >= 0)
@@ -1447,7 +1899,8 @@ long soundfiler_dowrite(void *obj, t_canvas *canvas,
     int swap, filetype, normalize, i;
     long onset, nframes, itemswritten = 0, j;
     t_garray *garrays[MAXSFCHANS];
-    t_word *vectors[MAXSFCHANS];
+    t_float *vectors[MAXSFCHANS];
+    int strides[MAXSFCHANS];
     char sampbuf[SAMPBUFSIZE];
     int bufframes;
     int fd = -1;
@@ -1477,7 +1930,8 @@ long soundfiler_dowrite(void *obj, t_canvas *canvas,
             pd_error(obj, "%s: no such table", argv[i].a_w.w_symbol->s_name);
             goto fail;
         }
-        else if (!garray_getfloatwords(garrays[i], &vecsize, &vectors[i]))
+        else if (!garray_getfloatvec(garrays[i], &vecsize, &vectors[i],
+            &strides[i]))
             error("%s: bad template for tabwrite",
                 argv[i].a_w.w_symbol->s_name);
         if (nframes > vecsize - onset)
@@ -1492,10 +1946,11 @@ long soundfiler_dowrite(void *obj, t_canvas *canvas,
     {
         for (j = onset; j < nframes + onset; j++)
         {
-            if (vectors[i][j].w_float > biggest)
-                biggest = vectors[i][j].w_float;
-            else if (-vectors[i][j].w_float > biggest)
-                biggest = -vectors[i][j].w_float;
+            t_sample f = vectors[i][j * strides[i]];
+            if (f > biggest)
+                biggest = f;
+            else if (-f > biggest)
+                biggest = -f;
         }
     }
     if ((fd = create_soundfile(canvas, filesym->s_name, filetype,
@@ -1525,7 +1980,8 @@ long soundfiler_dowrite(void *obj, t_canvas *canvas,
     {
         long thiswrite = nframes - itemswritten, nbytes;
         thiswrite = (thiswrite > bufframes ? bufframes : thiswrite);
-        soundfile_xferout_words(argc, vectors, (unsigned char *)sampbuf,
+        soundfile_xferout_words(argc, vectors, strides,
+            (unsigned char *)sampbuf,
             thiswrite, onset, info->bytespersample, info->bigendian, normfactor);
         nbytes = write(fd, sampbuf, info->channels * info->bytespersample * thiswrite);
         if (nbytes < info->channels * info->bytespersample * thiswrite)
@@ -1575,27 +2031,227 @@ static void soundfiler_write(t_soundfiler *x, t_symbol *s,
 static void soundfiler_setup(void)
 {
     soundfiler_class = class_new(gensym("soundfiler"), (t_newmethod)soundfiler_new,
-        0, sizeof(t_soundfiler), 0, 0);
+        (t_method)soundfiler_free, sizeof(t_soundfiler), 0, 0);
     class_addmethod(soundfiler_class, (t_method)soundfiler_read, gensym("read"),
         A_GIMME, 0);
     class_addmethod(soundfiler_class, (t_method)soundfiler_write,
         gensym("write"), A_GIMME, 0);
 }
 
+/**************** sound file streams outside the DSP chain ***************/
+
+/* These read or write sample frames directly, without tables or a
+child thread, for callers that run Pd's ticks themselves and can afford to
+block on the disk, such as libpd's offline renderer. */
+
+struct _sfstream
+{
+    int s_fd;
+    int s_write;            /* true if writing */
+    int s_filetype;         /* writing only; type of file created */
+    int s_swap;             /* writing only; true if byte swapping */
+    int s_nchannels;
+    int s_bytespersample;
+    int s_bigendian;
+    long s_bytelimit;       /* reading only; data bytes left in file */
+    long s_itemswritten;    /* writing only; frames written */
+    unsigned char *s_buf;   /* one conversion buffer of s_bufframes */
+    int s_bufframes;
+    char s_filename[MAXPDSTRING];
+};
+
+static t_sfstream *sfstream_new(const char *filename, int fd, int write,
+    int nchannels, int bytespersample, int bigendian)
+{
+    t_sfstream *x = (t_sfstream *)getbytes(sizeof(*x));
+    x->s_fd = fd;
+    x->s_write = write;
+    x->s_filetype = FORMAT_WAVE;
+    x->s_swap = 0;
+    x->s_nchannels = nchannels;
+    x->s_bytespersample = bytespersample;
+    x->s_bigendian = bigendian;
+    x->s_bytelimit = 0x7fffffff;
+    x->s_itemswritten = 0;
+    x->s_bufframes = SAMPBUFSIZE;
+    x->s_buf = (unsigned char *)getbytes(x->s_bufframes *
+        nchannels * bytespersample);
+    strncpy(x->s_filename, filename, MAXPDSTRING);
+    x->s_filename[MAXPDSTRING-1] = 0;
+    return (x);
+}
+
+    /* create a sound file for writing nchannels of bytespersample (2, 3 or
+    4 for float); the format follows the file extension as for soundfiler.
+    Returns NULL on failure. */
+t_sfstream *soundfile_openwrite(const char *filename, int nchannels,
+    int samplerate, int bytespersample)
+{
+    t_atom argv[3], *ap = argv;
+    int argc = 3, filetype, bytespersamp, swap, bigendian, normalize, fd;
+    long onset, nframes;
+    t_float rate;
+    t_symbol *filesym;
+    t_sfstream *x;
+    if (nchannels < 1 || nchannels > MAXSFCHANS)
+    {
+        error("%s: %d channels: must be 1 to %d", filename, nchannels,
+            MAXSFCHANS);
+        return (0);
+    }
+    SETSYMBOL(&argv[0], gensym("-bytes"));
+    SETFLOAT(&argv[1], bytespersample);
+    SETSYMBOL(&argv[2], gensym(filename));
+    if (soundfiler_writeargparse(0, &argc, &ap, &filesym, &filetype,
+        &bytespersamp, &swap, &bigendian, &normalize, &onset, &nframes,
+            &rate))
+    {
+        error("%s: can't write %d byte samples", filename, bytespersample);
+        return (0);
+    }
+    if ((fd = create_soundfile(0, filename, filetype, 0, bytespersamp,
+        bigendian, nchannels, swap, samplerate, 0)) < 0)
+    {
+        error("%s: %s", filename, strerror(errno));
+        return (0);
+    }
+    x = sfstream_new(filename, fd, 1, nchannels, bytespersamp, bigendian);
+    x->s_filetype = filetype;
+    x->s_swap = swap;
+    return (x);
+}
+
+    /* open a sound file for reading, filling in its channel count and
+    sample rate.  Returns NULL on failure. */
+t_sfstream *soundfile_openread(const char *filename, int *p_nchannels,
+    int *p_samplerate)
+{
+    t_soundfile_info info;
+    int fd, sf_fd;
+    t_sfstream *x;
+    info.samplerate = 0,
+    info.channels = 0,
+    info.bytespersample = 0,
+    info.headersize = -1,
+    info.bigendian = 0,
+    info.bytelimit = 0x7fffffff;
+    if ((fd = sys_open(filename, O_RDONLY)) < 0 ||
+        (sf_fd = open_soundfile_via_fd(fd, &info, 0)) < 0)
+    {
+        if (fd >= 0)
+            sys_close(fd);
+        error("%s: %s", filename, (errno ? strerror(errno) :
+            "unknown or bad header format"));
+        return (0);
+    }
+    x = sfstream_new(filename, sf_fd, 0, info.channels,
+        info.bytespersample, info.bigendian);
+    x->s_bytelimit = info.bytelimit;
+    *p_nchannels = info.channels;
+    *p_samplerate = info.samplerate;
+    return (x);
+}
+
+    /* write nframes from vecs, one vector per channel of the file.  Returns
+    the number of frames written, less than nframes on error. */
+long soundfile_writeframes(t_sfstream *x, t_sample **vecs, long nframes)
+{
+    long done = 0;
+    int bytesperframe = x->s_nchannels * x->s_bytespersample;
+    while (done < nframes)
+    {
+        int thiswrite = (nframes - done > x->s_bufframes ?
+            x->s_bufframes : (int)(nframes - done));
+        long nbytes;
+        soundfile_xferout_sample(x->s_nchannels, vecs, x->s_buf, thiswrite,
+            done, x->s_bytespersample, x->s_bigendian, 1);
+        nbytes = write(x->s_fd, x->s_buf, thiswrite * bytesperframe);
+        if (nbytes < thiswrite * bytesperframe)
+        {
+            error("%s: %s", x->s_filename, strerror(errno));
+            if (nbytes > 0)
+                done += nbytes / bytesperframe;
+            break;
+        }
+        done += thiswrite;
+    }
+    x->s_itemswritten += done;
+    return (done);
+}
+
+    /* read up to nframes into nvecs vectors; file channels past nvecs are
+    dropped and vectors past the file's channels, as well as any frames
+    after the end of the file, are zeroed.  Returns the number of frames
+    read from the file. */
+long soundfile_readframes(t_sfstream *x, t_sample **vecs, int nvecs,
+    long nframes)
+{
+    long done = 0;
+    int i, bytesperframe = x->s_nchannels * x->s_bytespersample;
+    while (done < nframes)
+    {
+        long want = (nframes - done > x->s_bufframes ?
+            x->s_bufframes : nframes - done), nbytes, got;
+        if (want * bytesperframe > x->s_bytelimit)
+            want = x->s_bytelimit / bytesperframe;
+        if (want <= 0 ||
+            (nbytes = read(x->s_fd, x->s_buf, want * bytesperframe)) <= 0)
+                break;
+        got = nbytes / bytesperframe;
+        x->s_bytelimit -= nbytes;
+        soundfile_xferin_sample(x->s_nchannels, nvecs, vecs, done,
+            x->s_buf, (int)got, x->s_bytespersample, x->s_bigendian);
+        done += got;
+        if (got < want)
+            break;
+    }
+    for (i = 0; i < nvecs; i++)
+    {
+        long j = (i < x->s_nchannels ? done : 0);
+        for (; j < nframes; j++)
+            vecs[i][j] = 0;
+    }
+    return (done);
+}
+
+    /* close the file, fixing up the header of a written file */
+void soundfile_close(t_sfstream *x)
+{
+    if (x->s_write)
+        soundfile_finishwrite(0, x->s_filename, x->s_fd, x->s_filetype,
+            0x7fffffff, x->s_itemswritten,
+                x->s_nchannels * x->s_bytespersample, x->s_swap);
+    sys_close(x->s_fd);
+    freebytes(x->s_buf, x->s_bufframes *
+        x->s_nchannels * x->s_bytespersample);
+    freebytes(x, sizeof(*x));
+}
 
 /************************* readsf object ******************************/
 
 /* READSF uses the Posix threads package; for the moment we're Linux
 only although this should be portable to the other platforms.
 
-Each instance of readsf~ owns a "child" thread for doing the unix (MSW?) file
-reading.  The parent thread signals the child each time:
+The file reading (and writing, for writesf~ below) is done by a small pool of
+I/O threads shared by all readsf~ and writesf~ objects of all Pd instances,
+rather than by a thread per object.  Each object keeps a FIFO of file data
+and a mutex protecting it.  The object "kicks" the pool each time:
     (1) a file wants opening or closing;
-    (2) we've eaten another 1/16 of the shared buffer (so that the
-        child thread should check if it's time to read some more.)
-The child signals the parent whenever a read has completed.  Signalling
-is done by setting "conditions" and putting data in mutex-controlled common
-areas.
+    (2) we've eaten another 1/16 of the shared buffer (so that it should
+        be checked if it's time to read some more.)
+A kicked object is queued with a deadline, the time at which its FIFO will
+run dry (or, for writesf~, full) at the current sample rate; requests to
+open or close are due at once.  The I/O threads take the object with the
+earliest deadline and do one piece of work for it: open or close a file, or
+read or write one chunk of at most READSIZE bytes.  If there's more to do the
+object is queued again with its new deadline, so that many streams share the
+threads in the order they need their data.  An object is only ever serviced
+by one thread at a time.  Whenever an I/O operation has completed the object's
+"answer" condition is signalled, which the perform routine waits for if the
+FIFO ran dry after all.  The FIFO itself is only allocated on the first
+"open" so that objects which never stream don't take up memory.
+
+The number of I/O threads can be set with "pd sf-threads <n>" (default 2).
 */
 
 #define MAXBYTESPERSAMPLE 4
@@ -1617,6 +2273,9 @@ areas.
 #define STATE_STARTUP 1
 #define STATE_STREAM 2
 
+#define SFPOOL_DEFTHREADS 2
+#define SFPOOL_MAXTHREADS 64
+
 static t_class *readsf_class;
 
 typedef struct _readsf
@@ -1632,7 +2291,7 @@ typedef struct _readsf
     t_outlet *x_bangout;                    /* bang-on-done outlet */
     int x_state;                            /* opened, running, or idle */
     t_float x_insamplerate;   /* sample rate of input signal if known */
-        /* parameters to communicate with subthread */
+        /* parameters to communicate with the I/O threads */
     int x_requestcode;      /* pending request from parent to I/O thread */
     const char *x_filename;       /* file to open (string is permanently allocated) */
     int x_fileerror;        /* slot for "errno" return */
@@ -1648,20 +2307,28 @@ typedef struct _readsf
     int x_fifohead;         /* index of next byte to get from file */
     int x_fifotail;         /* index of next byte the ugen will read */
     int x_eof;              /* true if fifohead has stopped changing */
-    int x_sigcountdown;     /* counter for signalling child for more data */
-    int x_sigperiod;        /* number of ticks per signal */
+    int x_sigcountdown;     /* counter for kicking the I/O threads */
+    int x_sigperiod;        /* number of ticks per kick */
     int x_filetype;         /* writesf~ only; type of file to create */
     int x_itemswritten;     /* writesf~ only; items written */
     int x_swap;             /* writesf~ only; true if byte swapping */
     t_float x_f;              /* writesf~ only; scalar for signal inlet */
     pthread_mutex_t x_mutex;
-    pthread_cond_t x_requestcondition;
     pthread_cond_t x_answercondition;
-    pthread_t x_childthread;
+        /* scheduling in the I/O pool, protected by the pool's mutex */
+    int (*x_service)(struct _readsf *x);   /* do a piece of I/O */
+    double x_bytespersec;   /* FIFO throughput while streaming */
+    double x_deadline;      /* when the FIFO runs dry (or full) */
+    int x_queued;           /* true if waiting for an I/O thread */
+    int x_busy;             /* true while an I/O thread services it */
+    int x_rekick;           /* kicked while busy; queue again afterward */
+#ifdef PDINSTANCE
+    t_pdinstance *x_instance;   /* for open_via_path() in the I/O threads */
+#endif
 } t_readsf;
 
 
-/************** the child thread which performs file I/O ***********/
+/************** the pool of threads which perform file I/O ***********/
 
 #if 0
 static void pute(char *s)   /* debug routine */
@@ -1691,289 +2358,436 @@ static void readsf_fakewait(pthread_mutex_t *b)
 #define sfread_cond_signal(a)
 #endif
 
-static void *readsf_child_main(void *zz)
+static struct _sfpool
 {
-    t_readsf *x = zz;
-#ifdef DEBUG_SOUNDFILE
-    pute("1\n");
+    pthread_mutex_t p_mutex;
+    pthread_cond_t p_cond;      /* signalled when an object is queued */
+    pthread_cond_t p_donecond;  /* broadcast when an object is let go */
+    t_readsf **p_queue;         /* objects waiting, in no particular order */
+    int p_nqueued;
+    int p_size;                 /* allocated size, one per object */
+    int p_nobjects;             /* number of readsf~ and writesf~ objects */
+    int p_nthreads;             /* number of I/O threads running */
+    int p_wantthreads;          /* number asked for; extra ones quit */
+} sfpool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, 0, SFPOOL_DEFTHREADS};
+
+    /* monotonic time in seconds, the same for all threads and instances */
+static double sfpool_now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return ((double)now.QuadPart / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + 1e-9 * ts.tv_nsec);
 #endif
-    pthread_mutex_lock(&x->x_mutex);
-    while (1)
+}
+
+    /* the time at which the object's FIFO will run dry (readsf~) or full
+    (writesf~), called with the object's mutex held */
+static double sfpool_deadline(t_readsf *x)
+{
+    double now = sfpool_now();
+    int used, room;
+    if (x->x_requestcode != REQUEST_BUSY || x->x_bytespersec <= 0 ||
+        !x->x_fifosize)
+            return (now);
+    used = x->x_fifohead - x->x_fifotail;
+    if (used < 0)
+        used += x->x_fifosize;
+    room = x->x_fifosize - used;
+    return (now + (pd_class(&x->x_obj.ob_pd) == readsf_class ?
+        used : room) / x->x_bytespersec);
+}
+
+    /* take the object due first off the queue, with the pool locked */
+static t_readsf *sfpool_pop(void)
+{
+    int i, best = 0;
+    t_readsf *x;
+    for (i = 1; i < sfpool.p_nqueued; i++)
+        if (sfpool.p_queue[i]->x_deadline <
+            sfpool.p_queue[best]->x_deadline)
+                best = i;
+    x = sfpool.p_queue[best];
+    sfpool.p_queue[best] = sfpool.p_queue[--sfpool.p_nqueued];
+    x->x_queued = 0;
+    return (x);
+}
+
+static void sfpool_push(t_readsf *x, double deadline)
+{
+    x->x_deadline = deadline;
+    x->x_queued = 1;
+    sfpool.p_queue[sfpool.p_nqueued++] = x;
+    pthread_cond_signal(&sfpool.p_cond);
+}
+
+static void *sfpool_thread(void *dummy)
+{
+    pthread_mutex_lock(&sfpool.p_mutex);
+    while (sfpool.p_nthreads <= sfpool.p_wantthreads)
     {
-        int fd, fifohead;
-        char *buf;
-#ifdef DEBUG_SOUNDFILE
-        pute("0\n");
-#endif
-        if (x->x_requestcode == REQUEST_NOTHING)
+        t_readsf *x;
+        double deadline;
+        int more;
+        if (!sfpool.p_nqueued)
         {
-#ifdef DEBUG_SOUNDFILE
-            pute("wait 2\n");
-#endif
-            sfread_cond_signal(&x->x_answercondition);
-            sfread_cond_wait(&x->x_requestcondition, &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE
-            pute("3\n");
-#endif
+            pthread_cond_wait(&sfpool.p_cond, &sfpool.p_mutex);
+            continue;
         }
-        else if (x->x_requestcode == REQUEST_OPEN)
-        {
-            char boo[80];
-            long sysrtn, wantbytes;
-
-                /* copy file stuff out of the data structure so we can
-                relinquish the mutex while we're in open_soundfile(). */
-            t_soundfile_info info;
-            long onsetframes = x->x_onsetframes;
-            const char *filename = x->x_filename;
-            const char *dirname = canvas_getdir(x->x_canvas)->s_name;
-            info.samplerate = x->x_samplerate;
-            info.channels = x->x_sfchannels;
-            info.headersize = x->x_skipheaderbytes;
-            info.bytespersample = x->x_bytespersample;
-            info.bigendian = x->x_bigendian;
-            info.bytelimit = 0x7fffffff;
-#ifdef DEBUG_SOUNDFILE
-            pute("4\n");
+        x = sfpool_pop();
+        x->x_busy = 1;
+        x->x_rekick = 0;
+        pthread_mutex_unlock(&sfpool.p_mutex);
+
+#ifdef PDINSTANCE
+        pd_setinstance(x->x_instance);
 #endif
-                /* alter the request code so that an ensuing "open" will get
-                noticed. */
-            x->x_requestcode = REQUEST_BUSY;
-            x->x_fileerror = 0;
+        more = (*x->x_service)(x);
 
-                /* if there's already a file open, close it */
-            if (x->x_fd >= 0)
-            {
-                fd = x->x_fd;
-                pthread_mutex_unlock(&x->x_mutex);
-                close (fd);
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_fd = -1;
-                if (x->x_requestcode != REQUEST_BUSY)
-                    goto lost;
-            }
-                /* open the soundfile with the mutex unlocked */
-            pthread_mutex_unlock(&x->x_mutex);
-            fd = open_soundfile(dirname, filename, &info, onsetframes);
-            pthread_mutex_lock(&x->x_mutex);
+        pthread_mutex_lock(&x->x_mutex);
+        deadline = sfpool_deadline(x);
+        pthread_mutex_lock(&sfpool.p_mutex);
+        x->x_busy = 0;
+        if (more || x->x_rekick)
+            sfpool_push(x, deadline);
+        pthread_cond_broadcast(&sfpool.p_donecond);
+            /* the object may be freed once both are unlocked */
+        pthread_mutex_unlock(&x->x_mutex);
+    }
+    sfpool.p_nthreads--;
+        /* pass on the wakeup in case it was meant for another thread */
+    if (sfpool.p_nqueued)
+        pthread_cond_signal(&sfpool.p_cond);
+    pthread_mutex_unlock(&sfpool.p_mutex);
+    return (0);
+}
 
-#ifdef DEBUG_SOUNDFILE
-            pute("5\n");
-#endif
-                /* copy back into the instance structure. */
-            x->x_bytespersample = info.bytespersample;
-            x->x_sfchannels = info.channels;
-            x->x_bigendian = info.bigendian;
-            x->x_fd = fd;
-            x->x_bytelimit = info.bytelimit;
-            if (fd < 0)
-            {
-                x->x_fileerror = errno;
-                x->x_eof = 1;
-#ifdef DEBUG_SOUNDFILE
-                pute("open failed\n");
-                pute(filename);
-                pute(dirname);
-#endif
-                goto lost;
-            }
-                /* check if another request has been made; if so, field it */
-            if (x->x_requestcode != REQUEST_BUSY)
-                goto lost;
-#ifdef DEBUG_SOUNDFILE
-            pute("6\n");
-#endif
-            x->x_fifohead = 0;
-                    /* set fifosize from bufsize.  fifosize must be a
-                    multiple of the number of bytes eaten for each DSP
-                    tick.  We pessimistically assume MAXVECSIZE samples
-                    per tick since that could change.  There could be a
-                    problem here if the vector size increases while a
-                    soundfile is being played...  */
-            x->x_fifosize = x->x_bufsize - (x->x_bufsize %
-                (x->x_bytespersample * x->x_sfchannels * MAXVECSIZE));
-                    /* arrange for the "request" condition to be signalled 16
-                    times per buffer */
-#ifdef DEBUG_SOUNDFILE
-            sprintf(boo, "fifosize %d\n",
-                x->x_fifosize);
-            pute(boo);
-#endif
-            x->x_sigcountdown = x->x_sigperiod =
-                (x->x_fifosize /
-                    (16 * x->x_bytespersample * x->x_sfchannels *
-                        x->x_vecsize));
-                /* in a loop, wait for the fifo to get hungry and feed it */
+    /* start I/O threads up to the number wanted, with the pool locked */
+static void sfpool_startthreads(void)
+{
+    while (sfpool.p_nthreads < sfpool.p_wantthreads)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, sfpool_thread, 0))
+        {
+            error("readsf~/writesf~: couldn't start I/O thread");
+            break;
+        }
+        pthread_detach(thread);
+        sfpool.p_nthreads++;
+    }
+}
 
-            while (x->x_requestcode == REQUEST_BUSY)
-            {
-                int fifosize = x->x_fifosize;
-#ifdef DEBUG_SOUNDFILE
-                pute("77\n");
-#endif
-                if (x->x_eof)
-                    break;
-                if (x->x_fifohead >= x->x_fifotail)
-                {
-                        /* if the head is >= the tail, we can immediately read
-                        to the end of the fifo.  Unless, that is, we would
-                        read all the way to the end of the buffer and the
-                        "tail" is zero; this would fill the buffer completely
-                        which isn't allowed because you can't tell a completely
-                        full buffer from an empty one. */
-                    if (x->x_fifotail || (fifosize - x->x_fifohead > READSIZE))
-                    {
-                        wantbytes = fifosize - x->x_fifohead;
-                        if (wantbytes > READSIZE)
-                            wantbytes = READSIZE;
-                        if (wantbytes > x->x_bytelimit)
-                            wantbytes = x->x_bytelimit;
-#ifdef DEBUG_SOUNDFILE
-                        sprintf(boo, "head %d, tail %d, size %d\n",
-                            x->x_fifohead, x->x_fifotail, wantbytes);
-                        pute(boo);
-#endif
-                    }
-                    else
-                    {
-#ifdef DEBUG_SOUNDFILE
-                        pute("wait 7a ...\n");
-#endif
-                        sfread_cond_signal(&x->x_answercondition);
-#ifdef DEBUG_SOUNDFILE
-                        pute("signalled\n");
-#endif
-                        sfread_cond_wait(&x->x_requestcondition,
-                            &x->x_mutex);
+    /* "pd sf-threads <n>": set the number of I/O threads */
+void glob_sfthreads(void *dummy, t_floatarg f)
+{
+    int n = (f < 1 ? 1 : (f > SFPOOL_MAXTHREADS ? SFPOOL_MAXTHREADS : f));
+    pthread_mutex_lock(&sfpool.p_mutex);
+    sfpool.p_wantthreads = n;
+    if (sfpool.p_nobjects)
+        sfpool_startthreads();
+    pthread_cond_broadcast(&sfpool.p_cond);
+    pthread_mutex_unlock(&sfpool.p_mutex);
+}
+
+    /* make room for a new object in the queue, so that kicking never
+    allocates memory, and start the I/O threads if needed */
+static int sfpool_add(void)
+{
+    pthread_mutex_lock(&sfpool.p_mutex);
+    if (sfpool.p_nobjects == sfpool.p_size)
+    {
+        int newsize = (sfpool.p_size ? 2 * sfpool.p_size : 64);
+        t_readsf **queue = (t_readsf **)realloc(sfpool.p_queue,
+            newsize * sizeof(*queue));
+        if (!queue)
+        {
+            pthread_mutex_unlock(&sfpool.p_mutex);
+            return (0);
+        }
+        sfpool.p_queue = queue;
+        sfpool.p_size = newsize;
+    }
+    sfpool.p_nobjects++;
+    sfpool_startthreads();
+    pthread_mutex_unlock(&sfpool.p_mutex);
+    return (1);
+}
+
+    /* ask the I/O threads to look at the object; called with the object's
+    mutex held */
+static void sfpool_kick(t_readsf *x)
+{
+    double deadline = sfpool_deadline(x);
+    pthread_mutex_lock(&sfpool.p_mutex);
+    if (x->x_busy)
+        x->x_rekick = 1;
+    else if (!x->x_queued)
+        sfpool_push(x, deadline);
+    else if (deadline < x->x_deadline)
+        x->x_deadline = deadline;
+    pthread_mutex_unlock(&sfpool.p_mutex);
+}
+
+    /* take an object out of the pool once its last request was answered;
+    waits until no I/O thread holds on to it */
+static void sfpool_remove(t_readsf *x)
+{
+    int i;
+    pthread_mutex_lock(&sfpool.p_mutex);
+    while (x->x_busy)
+        pthread_cond_wait(&sfpool.p_donecond, &sfpool.p_mutex);
+    if (x->x_queued)
+    {
+        for (i = 0; i < sfpool.p_nqueued; i++)
+            if (sfpool.p_queue[i] == x)
+                sfpool.p_queue[i] = sfpool.p_queue[--sfpool.p_nqueued];
+        x->x_queued = 0;
+    }
+    sfpool.p_nobjects--;
+    pthread_mutex_unlock(&sfpool.p_mutex);
+}
+
+    /* allocate the FIFO on the first "open" */
+static int sfpool_allocbuf(t_readsf *x)
+{
+    char *buf;
+    if (x->x_buf)
+        return (1);
+    if (!(buf = getbytes(x->x_bufsize)))
+    {
+        pd_error(x, "%s: couldn't allocate %d byte buffer",
+            class_getname(pd_class(&x->x_obj.ob_pd)), x->x_bufsize);
+        return (0);
+    }
+    pthread_mutex_lock(&x->x_mutex);
+    x->x_buf = buf;
+    pthread_mutex_unlock(&x->x_mutex);
+    return (1);
+}
+
+    /* close the object's file if any, with its mutex held */
+static void readsf_closefd(t_readsf *x)
+{
+    if (x->x_fd >= 0)
+    {
+        int fd = x->x_fd;
+        pthread_mutex_unlock(&x->x_mutex);
+        close (fd);
+        pthread_mutex_lock(&x->x_mutex);
+        x->x_fd = -1;
+    }
+}
+
+    /* do a piece of file I/O for readsf~: open or close the file or read
+    a chunk into the FIFO.  Returns nonzero if there's more to do. */
+static int readsf_service(t_readsf *x)
+{
+    int fd, fifohead, fifosize, ret = 0;
+    long sysrtn, wantbytes;
+    char *buf;
+    pthread_mutex_lock(&x->x_mutex);
+    if (x->x_requestcode == REQUEST_OPEN)
+    {
+        char boo[80];
+
+            /* copy file stuff out of the data structure so we can
+            relinquish the mutex while we're in open_soundfile(). */
+        t_soundfile_info info;
+        long onsetframes = x->x_onsetframes;
+        const char *filename = x->x_filename;
+        const char *dirname = canvas_getdir(x->x_canvas)->s_name;
+        info.samplerate = x->x_samplerate;
+        info.channels = x->x_sfchannels;
+        info.headersize = x->x_skipheaderbytes;
+        info.bytespersample = x->x_bytespersample;
+        info.bigendian = x->x_bigendian;
+        info.bytelimit = 0x7fffffff;
 #ifdef DEBUG_SOUNDFILE
-                        pute("7a done\n");
+        pute("4\n");
 #endif
-                        continue;
-                    }
-                }
-                else
-                {
-                        /* otherwise check if there are at least READSIZE
-                        bytes to read.  If not, wait and loop back. */
-                    wantbytes =  x->x_fifotail - x->x_fifohead - 1;
-                    if (wantbytes < READSIZE)
-                    {
+            /* alter the request code so that an ensuing "open" will get
+            noticed. */
+        x->x_requestcode = REQUEST_BUSY;
+        x->x_fileerror = 0;
+
+            /* if there's already a file open, close it */
+        readsf_closefd(x);
+        if (x->x_requestcode != REQUEST_BUSY)
+            goto lost;
+            /* open the soundfile with the mutex unlocked */
+        pthread_mutex_unlock(&x->x_mutex);
+        fd = open_soundfile(dirname, filename, &info, onsetframes);
+        pthread_mutex_lock(&x->x_mutex);
+
 #ifdef DEBUG_SOUNDFILE
-                        pute("wait 7...\n");
+        pute("5\n");
 #endif
-                        sfread_cond_signal(&x->x_answercondition);
-                        sfread_cond_wait(&x->x_requestcondition,
-                            &x->x_mutex);
+            /* copy back into the instance structure. */
+        x->x_bytespersample = info.bytespersample;
+        x->x_sfchannels = info.channels;
+        x->x_bigendian = info.bigendian;
+        x->x_fd = fd;
+        x->x_bytelimit = info.bytelimit;
+        if (fd < 0)
+        {
+            x->x_fileerror = errno;
+            x->x_eof = 1;
 #ifdef DEBUG_SOUNDFILE
-                        pute("7 done\n");
+            pute("open failed\n");
+            pute(filename);
+            pute(dirname);
 #endif
-                        continue;
-                    }
-                    else wantbytes = READSIZE;
-                    if (wantbytes > x->x_bytelimit)
-                        wantbytes = x->x_bytelimit;
-                }
+            goto lost;
+        }
+            /* check if another request has been made; if so, field it */
+        if (x->x_requestcode != REQUEST_BUSY)
+            goto lost;
 #ifdef DEBUG_SOUNDFILE
-                pute("8\n");
+        pute("6\n");
 #endif
-                fd = x->x_fd;
-                buf = x->x_buf;
-                fifohead = x->x_fifohead;
-                pthread_mutex_unlock(&x->x_mutex);
-                sysrtn = read(fd, buf + fifohead, wantbytes);
-                pthread_mutex_lock(&x->x_mutex);
-                if (x->x_requestcode != REQUEST_BUSY)
-                    break;
-                if (sysrtn < 0)
-                {
+        x->x_fifohead = 0;
+                /* set fifosize from bufsize.  fifosize must be a
+                multiple of the number of bytes eaten for each DSP
+                tick.  We pessimistically assume MAXVECSIZE samples
+                per tick since that could change.  There could be a
+                problem here if the vector size increases while a
+                soundfile is being played...  */
+        x->x_fifosize = x->x_bufsize - (x->x_bufsize %
+            (x->x_bytespersample * x->x_sfchannels * MAXVECSIZE));
+                /* arrange for the I/O threads to be kicked 16
+                times per buffer */
 #ifdef DEBUG_SOUNDFILE
-                    pute("fileerror\n");
+        sprintf(boo, "fifosize %d\n",
+            x->x_fifosize);
+        pute(boo);
 #endif
-                    x->x_fileerror = errno;
-                    break;
-                }
-                else if (sysrtn == 0)
-                {
-                    x->x_eof = 1;
-                    break;
-                }
-                else
-                {
-                    x->x_fifohead += sysrtn;
-                    x->x_bytelimit -= sysrtn;
-                    if (x->x_fifohead == fifosize)
-                        x->x_fifohead = 0;
-                    if (x->x_bytelimit <= 0)
-                    {
-                        x->x_eof = 1;
-                        break;
-                    }
-                }
+        x->x_sigcountdown = x->x_sigperiod =
+            (x->x_fifosize /
+                (16 * x->x_bytespersample * x->x_sfchannels *
+                    x->x_vecsize));
+        x->x_bytespersec = (double)x->x_bytespersample * x->x_sfchannels *
+            x->x_insamplerate;
+            /* go on to fill the FIFO */
+        ret = 1;
+    }
+    else if (x->x_requestcode == REQUEST_BUSY)
+    {
+            /* feed the FIFO a chunk if it's hungry */
+        fifosize = x->x_fifosize;
 #ifdef DEBUG_SOUNDFILE
-                sprintf(boo, "after: head %d, tail %d\n",
-                    x->x_fifohead, x->x_fifotail);
-                pute(boo);
+        pute("77\n");
 #endif
-                    /* signal parent in case it's waiting for data */
-                sfread_cond_signal(&x->x_answercondition);
-            }
-        lost:
-
-            if (x->x_requestcode == REQUEST_BUSY)
-                x->x_requestcode = REQUEST_NOTHING;
-                /* fell out of read loop: close file if necessary,
-                set EOF and signal once more */
-            if (x->x_fd >= 0)
+        if (x->x_eof)
+            goto lost;
+        if (x->x_fifohead >= x->x_fifotail)
+        {
+                /* if the head is >= the tail, we can immediately read
+                to the end of the fifo.  Unless, that is, we would
+                read all the way to the end of the buffer and the
+                "tail" is zero; this would fill the buffer completely
+                which isn't allowed because you can't tell a completely
+                full buffer from an empty one. */
+            if (x->x_fifotail || (fifosize - x->x_fifohead > READSIZE))
             {
-                fd = x->x_fd;
-                pthread_mutex_unlock(&x->x_mutex);
-                close (fd);
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_fd = -1;
+                wantbytes = fifosize - x->x_fifohead;
+                if (wantbytes > READSIZE)
+                    wantbytes = READSIZE;
+                if (wantbytes > x->x_bytelimit)
+                    wantbytes = x->x_bytelimit;
             }
-            sfread_cond_signal(&x->x_answercondition);
-
-        }
-        else if (x->x_requestcode == REQUEST_CLOSE)
-        {
-            if (x->x_fd >= 0)
+            else
             {
-                fd = x->x_fd;
-                pthread_mutex_unlock(&x->x_mutex);
-                close (fd);
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_fd = -1;
+                    /* full; wait to be kicked again */
+                sfread_cond_signal(&x->x_answercondition);
+                goto done;
             }
-            if (x->x_requestcode == REQUEST_CLOSE)
-                x->x_requestcode = REQUEST_NOTHING;
-            sfread_cond_signal(&x->x_answercondition);
         }
-        else if (x->x_requestcode == REQUEST_QUIT)
+        else
         {
-            if (x->x_fd >= 0)
+                /* otherwise check if there are at least READSIZE
+                bytes to read.  If not, wait to be kicked again. */
+            wantbytes =  x->x_fifotail - x->x_fifohead - 1;
+            if (wantbytes < READSIZE)
             {
-                fd = x->x_fd;
-                pthread_mutex_unlock(&x->x_mutex);
-                close (fd);
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_fd = -1;
+                sfread_cond_signal(&x->x_answercondition);
+                goto done;
             }
-            x->x_requestcode = REQUEST_NOTHING;
-            sfread_cond_signal(&x->x_answercondition);
-            break;
+            else wantbytes = READSIZE;
+            if (wantbytes > x->x_bytelimit)
+                wantbytes = x->x_bytelimit;
         }
-        else
+#ifdef DEBUG_SOUNDFILE
+        pute("8\n");
+#endif
+        fd = x->x_fd;
+        buf = x->x_buf;
+        fifohead = x->x_fifohead;
+        pthread_mutex_unlock(&x->x_mutex);
+        sysrtn = read(fd, buf + fifohead, wantbytes);
+        pthread_mutex_lock(&x->x_mutex);
+        if (x->x_requestcode != REQUEST_BUSY)
+            goto lost;
+        if (sysrtn < 0)
         {
 #ifdef DEBUG_SOUNDFILE
-            pute("13\n");
+            pute("fileerror\n");
 #endif
+            x->x_fileerror = errno;
+            goto lost;
         }
+        else if (sysrtn == 0)
+        {
+            x->x_eof = 1;
+            goto lost;
+        }
+        else
+        {
+            x->x_fifohead += sysrtn;
+            x->x_bytelimit -= sysrtn;
+            if (x->x_fifohead == fifosize)
+                x->x_fifohead = 0;
+            if (x->x_bytelimit <= 0)
+            {
+                x->x_eof = 1;
+                goto lost;
+            }
+        }
+            /* signal parent in case it's waiting for data */
+        sfread_cond_signal(&x->x_answercondition);
+        ret = 1;
     }
-#ifdef DEBUG_SOUNDFILE
-    pute("thread exit\n");
-#endif
+    else if (x->x_requestcode == REQUEST_CLOSE ||
+        x->x_requestcode == REQUEST_QUIT)
+    {
+        int code = x->x_requestcode;
+        readsf_closefd(x);
+        if (x->x_requestcode == code)
+            x->x_requestcode = REQUEST_NOTHING;
+        else ret = 1;
+        sfread_cond_signal(&x->x_answercondition);
+    }
+    else sfread_cond_signal(&x->x_answercondition);
+done:
     pthread_mutex_unlock(&x->x_mutex);
-    return (0);
+    return (ret);
+
+lost:
+        /* fell out of reading: close file if necessary, set EOF and
+        signal once more; if another request came in, field it next */
+    if (x->x_requestcode == REQUEST_BUSY)
+        x->x_requestcode = REQUEST_NOTHING;
+    readsf_closefd(x);
+    sfread_cond_signal(&x->x_answercondition);
+    ret = (x->x_requestcode != REQUEST_NOTHING);
+    pthread_mutex_unlock(&x->x_mutex);
+    return (ret);
 }
 
 /******** the object proper runs in the calling (parent) thread ****/
@@ -1984,7 +2798,6 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
 {
     t_readsf *x;
     int nchannels = fnchannels, bufsize = fbufsize, i;
-    char *buf;
 
     if (nchannels < 1)
         nchannels = 1;
@@ -1995,8 +2808,9 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
         bufsize = MINBUFSIZE;
     else if (bufsize > MAXBUFSIZE)
         bufsize = MAXBUFSIZE;
-    buf = getbytes(bufsize);
-    if (!buf) return (0);
+
+    if (!sfpool_add())
+        return (0);
 
     x = (t_readsf *)pd_new(readsf_class);
 
@@ -2005,7 +2819,6 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_noutlets = nchannels;
     x->x_bangout = outlet_new(&x->x_obj, &s_bang);
     pthread_mutex_init(&x->x_mutex, 0);
-    pthread_cond_init(&x->x_requestcondition, 0);
     pthread_cond_init(&x->x_answercondition, 0);
     x->x_vecsize = MAXVECSIZE;
     x->x_state = STATE_IDLE;
@@ -2014,10 +2827,16 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_bytespersample = 2;
     x->x_sfchannels = 1;
     x->x_fd = -1;
-    x->x_buf = buf;
+    x->x_buf = 0;
     x->x_bufsize = bufsize;
     x->x_fifosize = x->x_fifohead = x->x_fifotail = x->x_requestcode = 0;
-    pthread_create(&x->x_childthread, 0, readsf_child_main, x);
+    x->x_insamplerate = sys_getsr();
+    x->x_service = readsf_service;
+    x->x_bytespersec = x->x_deadline = 0;
+    x->x_queued = x->x_busy = x->x_rekick = 0;
+#ifdef PDINSTANCE
+    x->x_instance = pd_this;
+#endif
     return (x);
 }
 
@@ -2030,13 +2849,16 @@ static t_int *readsf_perform(t_int *w)
 {
     t_readsf *x = (t_readsf *)(w[1]);
     int vecsize = x->x_vecsize, noutlets = x->x_noutlets, i, j,
-        bytespersample = x->x_bytespersample,
-        bigendian = x->x_bigendian;
+        bytespersample, bigendian;
     t_sample *fp;
     if (x->x_state == STATE_STREAM)
     {
-        int wantbytes, sfchannels = x->x_sfchannels;
+        int wantbytes, sfchannels;
         pthread_mutex_lock(&x->x_mutex);
+            /* the I/O thread sets these when it opens the file */
+        sfchannels = x->x_sfchannels;
+        bytespersample = x->x_bytespersample;
+        bigendian = x->x_bigendian;
         wantbytes = sfchannels * vecsize * bytespersample;
         while (
             !x->x_eof && x->x_fifohead >= x->x_fifotail &&
@@ -2045,7 +2867,7 @@ static t_int *readsf_perform(t_int *w)
 #ifdef DEBUG_SOUNDFILE
             pute("wait...\n");
 #endif
-            sfread_cond_signal(&x->x_requestcondition);
+            sfpool_kick(x);
             sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
                 /* resync local cariables -- bug fix thanks to Shahrokh */
             vecsize = x->x_vecsize;
@@ -2086,7 +2908,7 @@ static t_int *readsf_perform(t_int *w)
                 for (j = vecsize, fp = x->x_outvec[i] + xfersize; j--; )
                     *fp++ = 0;
 
-            sfread_cond_signal(&x->x_requestcondition);
+            sfpool_kick(x);
             pthread_mutex_unlock(&x->x_mutex);
             return (w+2);
         }
@@ -2100,7 +2922,7 @@ static t_int *readsf_perform(t_int *w)
             x->x_fifotail = 0;
         if ((--x->x_sigcountdown) <= 0)
         {
-            sfread_cond_signal(&x->x_requestcondition);
+            sfpool_kick(x);
             x->x_sigcountdown = x->x_sigperiod;
         }
         pthread_mutex_unlock(&x->x_mutex);
@@ -2129,7 +2951,7 @@ static void readsf_stop(t_readsf *x)
     pthread_mutex_lock(&x->x_mutex);
     x->x_state = STATE_IDLE;
     x->x_requestcode = REQUEST_CLOSE;
-    sfread_cond_signal(&x->x_requestcondition);
+    sfpool_kick(x);
     pthread_mutex_unlock(&x->x_mutex);
 }
 
@@ -2154,7 +2976,7 @@ static void readsf_open(t_readsf *x, t_symbol *s, int argc, t_atom *argv)
     t_float channels = atom_getfloatarg(3, argc, argv);
     t_float bytespersamp = atom_getfloatarg(4, argc, argv);
     t_symbol *endian = atom_getsymbolarg(5, argc, argv);
-    if (!*filesym->s_name)
+    if (!*filesym->s_name || !sfpool_allocbuf(x))
         return;
     pthread_mutex_lock(&x->x_mutex);
     x->x_requestcode = REQUEST_OPEN;
@@ -2176,7 +2998,7 @@ static void readsf_open(t_readsf *x, t_symbol *s, int argc, t_atom *argv)
     x->x_eof = 0;
     x->x_fileerror = 0;
     x->x_state = STATE_STARTUP;
-    sfread_cond_signal(&x->x_requestcondition);
+    sfpool_kick(x);
     pthread_mutex_unlock(&x->x_mutex);
 }
 
@@ -2190,6 +3012,9 @@ static void readsf_dsp(t_readsf *x, t_signal **sp)
         (x->x_bytespersample * x->x_sfchannels * x->x_vecsize));
     for (i = 0; i < noutlets; i++)
         x->x_outvec[i] = sp[i]->s_vec;
+    x->x_insamplerate = sp[0]->s_sr;
+    x->x_bytespersec = (double)x->x_bytespersample * x->x_sfchannels *
+        x->x_insamplerate;
     pthread_mutex_unlock(&x->x_mutex);
     dsp_add(readsf_perform, 1, x);
 }
@@ -2207,23 +3032,20 @@ static void readsf_print(t_readsf *x)
 static void readsf_free(t_readsf *x)
 {
         /* request QUIT and wait for acknowledge */
-    void *threadrtn;
     pthread_mutex_lock(&x->x_mutex);
     x->x_requestcode = REQUEST_QUIT;
-    sfread_cond_signal(&x->x_requestcondition);
     while (x->x_requestcode != REQUEST_NOTHING)
     {
-        sfread_cond_signal(&x->x_requestcondition);
+        sfpool_kick(x);
         sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
     }
     pthread_mutex_unlock(&x->x_mutex);
-    if (pthread_join(x->x_childthread, &threadrtn))
-        error("readsf_free: join failed");
+    sfpool_remove(x);
 
-    pthread_cond_destroy(&x->x_requestcondition);
     pthread_cond_destroy(&x->x_answercondition);
     pthread_mutex_destroy(&x->x_mutex);
-    freebytes(x->x_buf, x->x_bufsize);
+    if (x->x_buf)
+        freebytes(x->x_buf, x->x_bufsize);
     clock_free(x->x_clock);
 }
 
@@ -2247,233 +3069,184 @@ static t_class *writesf_class;
 
 #define t_writesf t_readsf      /* just re-use the structure */
 
-/************** the child thread which performs file I/O ***********/
+/************** file I/O, done by the pool of I/O threads ***********/
 
-static void *writesf_child_main(void *zz)
+    /* finish and close the object's file if any, with its mutex held */
+static void writesf_closefd(t_writesf *x)
 {
-    t_writesf *x = zz;
-#ifdef DEBUG_SOUNDFILE
-    pute("1\n");
-#endif
-    pthread_mutex_lock(&x->x_mutex);
-    while (1)
+    if (x->x_fd >= 0)
     {
-#ifdef DEBUG_SOUNDFILE
-        pute("0\n");
-#endif
-        if (x->x_requestcode == REQUEST_NOTHING)
-        {
-#ifdef DEBUG_SOUNDFILE
-            pute("wait 2\n");
-#endif
-            sfread_cond_signal(&x->x_answercondition);
-            sfread_cond_wait(&x->x_requestcondition, &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE
-            pute("3\n");
-#endif
-        }
-        else if (x->x_requestcode == REQUEST_OPEN)
-        {
-            char boo[80];
-            int fd, writebytes;
-            long sysrtn;
+        int bytesperframe = x->x_bytespersample * x->x_sfchannels;
+        const char *filename = x->x_filename;
+        int fd = x->x_fd;
+        int filetype = x->x_filetype;
+        int itemswritten = x->x_itemswritten;
+        int swap = x->x_swap;
+        pthread_mutex_unlock(&x->x_mutex);
 
-                /* copy file stuff out of the data structure so we can
-                relinquish the mutex while we're in open_soundfile(). */
-            int bytespersample = x->x_bytespersample;
-            int sfchannels = x->x_sfchannels;
-            int bigendian = x->x_bigendian;
-            int filetype = x->x_filetype;
-            const char *filename = x->x_filename;
-            t_canvas *canvas = x->x_canvas;
-            t_float samplerate = x->x_samplerate;
+        soundfile_finishwrite(x, filename, fd,
+            filetype, 0x7fffffff, itemswritten,
+            bytesperframe, swap);
+        close (fd);
 
-                /* alter the request code so that an ensuing "open" will get
-                noticed. */
-#ifdef DEBUG_SOUNDFILE
-            pute("4\n");
-#endif
-            x->x_requestcode = REQUEST_BUSY;
-            x->x_fileerror = 0;
+        pthread_mutex_lock(&x->x_mutex);
+        x->x_fd = -1;
+    }
+}
 
-                /* if there's already a file open, close it.  This
-                should never happen since writesf_open() calls stop if
-                needed and then waits until we're idle. */
-            if (x->x_fd >= 0)
-            {
-                int bytesperframe = x->x_bytespersample * x->x_sfchannels;
-                const char *filename = x->x_filename;
-                int fd = x->x_fd;
-                int filetype = x->x_filetype;
-                int itemswritten = x->x_itemswritten;
-                int swap = x->x_swap;
-                pthread_mutex_unlock(&x->x_mutex);
-
-                soundfile_finishwrite(x, filename, fd,
-                    filetype, 0x7fffffff, itemswritten,
-                    bytesperframe, swap);
-                close (fd);
-
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_fd = -1;
-#ifdef DEBUG_SOUNDFILE
-                {
-                    char s[1000];
-                    sprintf(s, "bug??? ditched %d\n", itemswritten);
-                    pute(s);
-                }
-#endif
-                if (x->x_requestcode != REQUEST_BUSY)
-                    continue;
-            }
-                /* open the soundfile with the mutex unlocked */
-            pthread_mutex_unlock(&x->x_mutex);
-            fd = create_soundfile(canvas, filename, filetype, 0,
-                    bytespersample, bigendian, sfchannels,
-                        garray_ambigendian() != bigendian, samplerate, 0);
-            pthread_mutex_lock(&x->x_mutex);
+    /* do a piece of file I/O for writesf~: create or close the file or
+    write a chunk from the FIFO.  Returns nonzero if there's more to do. */
+static int writesf_service(t_writesf *x)
+{
+    int fd, writebytes, ret = 0;
+    long sysrtn;
+    pthread_mutex_lock(&x->x_mutex);
+    if (x->x_requestcode == REQUEST_OPEN)
+    {
+            /* copy file stuff out of the data structure so we can
+            relinquish the mutex while we're in open_soundfile(). */
+        int bytespersample = x->x_bytespersample;
+        int sfchannels = x->x_sfchannels;
+        int bigendian = x->x_bigendian;
+        int filetype = x->x_filetype;
+        const char *filename = x->x_filename;
+        t_canvas *canvas = x->x_canvas;
+        t_float samplerate = x->x_samplerate;
+
+            /* alter the request code so that an ensuing "open" will get
+            noticed. */
 #ifdef DEBUG_SOUNDFILE
-            pute("5\n");
+        pute("4\n");
 #endif
+        x->x_requestcode = REQUEST_BUSY;
+        x->x_fileerror = 0;
 
-            if (fd < 0)
-            {
-                x->x_fd = -1;
-                x->x_eof = 1;
-                x->x_fileerror = errno;
-#ifdef DEBUG_SOUNDFILE
-                pute("open failed\n");
-                pute(filename);
-#endif
-                x->x_requestcode = REQUEST_NOTHING;
-                continue;
-            }
-            /* check if another request has been made; if so, field it */
+            /* if there's already a file open, close it.  This
+            should never happen since writesf_open() calls stop if
+            needed and then waits until we're idle. */
+        if (x->x_fd >= 0)
+        {
+            writesf_closefd(x);
             if (x->x_requestcode != REQUEST_BUSY)
-                continue;
-#ifdef DEBUG_SOUNDFILE
-            pute("6\n");
-#endif
-            x->x_fd = fd;
-            x->x_fifotail = 0;
-            x->x_itemswritten = 0;
-            x->x_swap = garray_ambigendian() != bigendian;
-                /* in a loop, wait for the fifo to have data and write it
-                    to disk */
-            while (x->x_requestcode == REQUEST_BUSY ||
-                (x->x_requestcode == REQUEST_CLOSE &&
-                    x->x_fifohead != x->x_fifotail))
-            {
-                int fifosize = x->x_fifosize, fifotail;
-                char *buf = x->x_buf;
-#ifdef DEBUG_SOUNDFILE
-                pute("77\n");
-#endif
-                    /* if the head is < the tail, we can immediately write
-                    from tail to end of fifo to disk; otherwise we hold off
-                    writing until there are at least WRITESIZE bytes in the
-                    buffer */
-                if (x->x_fifohead < x->x_fifotail ||
-                    x->x_fifohead >= x->x_fifotail + WRITESIZE
-                    || (x->x_requestcode == REQUEST_CLOSE &&
-                        x->x_fifohead != x->x_fifotail))
-                {
-                    writebytes = (x->x_fifohead < x->x_fifotail ?
-                        fifosize : x->x_fifohead) - x->x_fifotail;
-                    if (writebytes > READSIZE)
-                        writebytes = READSIZE;
-                }
-                else
-                {
+                goto more;
+        }
+            /* open the soundfile with the mutex unlocked */
+        pthread_mutex_unlock(&x->x_mutex);
+        fd = create_soundfile(canvas, filename, filetype, 0,
+                bytespersample, bigendian, sfchannels,
+                    garray_ambigendian() != bigendian, samplerate, 0);
+        pthread_mutex_lock(&x->x_mutex);
 #ifdef DEBUG_SOUNDFILE
-                    pute("wait 7a ...\n");
+        pute("5\n");
 #endif
-                    sfread_cond_signal(&x->x_answercondition);
+
+        if (fd < 0)
+        {
+            x->x_fd = -1;
+            x->x_eof = 1;
+            x->x_fileerror = errno;
 #ifdef DEBUG_SOUNDFILE
-                    pute("signalled\n");
+            pute("open failed\n");
+            pute(filename);
 #endif
-                    sfread_cond_wait(&x->x_requestcondition,
-                        &x->x_mutex);
+            x->x_requestcode = REQUEST_NOTHING;
+            sfread_cond_signal(&x->x_answercondition);
+            goto done;
+        }
+        x->x_fd = fd;
+        /* check if another request has been made; if so, field it */
+        if (x->x_requestcode != REQUEST_BUSY)
+            goto more;
 #ifdef DEBUG_SOUNDFILE
-                    pute("7a done\n");
+        pute("6\n");
 #endif
-                    continue;
-                }
+        x->x_fifotail = 0;
+        x->x_itemswritten = 0;
+        x->x_swap = garray_ambigendian() != bigendian;
+            /* go on to write whatever is in the fifo */
+        ret = 1;
+    }
+    else if (x->x_requestcode == REQUEST_BUSY ||
+        ((x->x_requestcode == REQUEST_CLOSE ||
+            x->x_requestcode == REQUEST_QUIT) && x->x_fd >= 0 &&
+                x->x_fifohead != x->x_fifotail))
+    {
+        int fifosize = x->x_fifosize, fifotail;
+        char *buf = x->x_buf;
 #ifdef DEBUG_SOUNDFILE
-                pute("8\n");
+        pute("77\n");
 #endif
-                fifotail = x->x_fifotail;
-                fd = x->x_fd;
-                pthread_mutex_unlock(&x->x_mutex);
-                sysrtn = write(fd, buf + fifotail, writebytes);
-                pthread_mutex_lock(&x->x_mutex);
-                if (x->x_requestcode != REQUEST_BUSY &&
-                    x->x_requestcode != REQUEST_CLOSE)
-                        break;
-                if (sysrtn < writebytes)
-                {
+            /* if the head is < the tail, we can immediately write
+            from tail to end of fifo to disk; otherwise we hold off
+            writing until there are at least WRITESIZE bytes in the
+            buffer, or we're closing and must write what's left */
+        if (x->x_fifohead < x->x_fifotail ||
+            x->x_fifohead >= x->x_fifotail + WRITESIZE
+            || x->x_requestcode != REQUEST_BUSY)
+        {
+            writebytes = (x->x_fifohead < x->x_fifotail ?
+                fifosize : x->x_fifohead) - x->x_fifotail;
+            if (writebytes > READSIZE)
+                writebytes = READSIZE;
+        }
+        else
+        {
+                /* wait to be kicked again */
+            sfread_cond_signal(&x->x_answercondition);
+            goto done;
+        }
 #ifdef DEBUG_SOUNDFILE
-                    pute("fileerror\n");
+        pute("8\n");
 #endif
-                    x->x_fileerror = errno;
-                    break;
-                }
-                else
-                {
-                    x->x_fifotail += sysrtn;
-                    if (x->x_fifotail == fifosize)
-                        x->x_fifotail = 0;
-                }
-                x->x_itemswritten +=
-                    sysrtn / (x->x_bytespersample * x->x_sfchannels);
+        fifotail = x->x_fifotail;
+        fd = x->x_fd;
+        pthread_mutex_unlock(&x->x_mutex);
+        sysrtn = write(fd, buf + fifotail, writebytes);
+        pthread_mutex_lock(&x->x_mutex);
+        if (x->x_requestcode == REQUEST_OPEN)
+            goto more;
+        if (sysrtn < writebytes)
+        {
 #ifdef DEBUG_SOUNDFILE
-                sprintf(boo, "after: head %d, tail %d written %d\n",
-                    x->x_fifohead, x->x_fifotail, x->x_itemswritten);
-                pute(boo);
+            pute("fileerror\n");
 #endif
-                    /* signal parent in case it's waiting for data */
-                sfread_cond_signal(&x->x_answercondition);
-            }
-        }
-        else if (x->x_requestcode == REQUEST_CLOSE ||
-            x->x_requestcode == REQUEST_QUIT)
-        {
-            int quit = (x->x_requestcode == REQUEST_QUIT);
-            if (x->x_fd >= 0)
-            {
-                int bytesperframe = x->x_bytespersample * x->x_sfchannels;
-                const char *filename = x->x_filename;
-                int fd = x->x_fd;
-                int filetype = x->x_filetype;
-                int itemswritten = x->x_itemswritten;
-                int swap = x->x_swap;
-                pthread_mutex_unlock(&x->x_mutex);
-
-                soundfile_finishwrite(x, filename, fd,
-                    filetype, 0x7fffffff, itemswritten,
-                    bytesperframe, swap);
-                close (fd);
-
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_fd = -1;
-            }
-            x->x_requestcode = REQUEST_NOTHING;
+            x->x_fileerror = errno;
+                /* drop what's in the fifo rather than block DSP; we'll
+                try again when kicked */
+            x->x_fifotail = x->x_fifohead;
             sfread_cond_signal(&x->x_answercondition);
-            if (quit)
-                break;
+            goto done;
         }
         else
         {
-#ifdef DEBUG_SOUNDFILE
-            pute("13\n");
-#endif
+            x->x_fifotail += sysrtn;
+            if (x->x_fifotail == fifosize)
+                x->x_fifotail = 0;
         }
+        x->x_itemswritten +=
+            sysrtn / (x->x_bytespersample * x->x_sfchannels);
+            /* signal parent in case it's waiting for data */
+        sfread_cond_signal(&x->x_answercondition);
+        ret = 1;
     }
-#ifdef DEBUG_SOUNDFILE
-    pute("thread exit\n");
-#endif
+    else if (x->x_requestcode == REQUEST_CLOSE ||
+        x->x_requestcode == REQUEST_QUIT)
+    {
+        int code = x->x_requestcode;
+        writesf_closefd(x);
+        if (x->x_requestcode == code)
+            x->x_requestcode = REQUEST_NOTHING;
+        else ret = 1;
+        sfread_cond_signal(&x->x_answercondition);
+    }
+    else sfread_cond_signal(&x->x_answercondition);
+done:
     pthread_mutex_unlock(&x->x_mutex);
-    return (0);
+    return (ret);
+more:
+    ret = (x->x_requestcode != REQUEST_NOTHING);
+    pthread_mutex_unlock(&x->x_mutex);
+    return (ret);
 }
 
 /******** the object proper runs in the calling (parent) thread ****/
@@ -2484,7 +3257,6 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
 {
     t_writesf *x;
     int nchannels = fnchannels, bufsize = fbufsize, i;
-    char *buf;
 
     if (nchannels < 1)
         nchannels = 1;
@@ -2495,8 +3267,8 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
         bufsize = MINBUFSIZE;
     else if (bufsize > MAXBUFSIZE)
         bufsize = MAXBUFSIZE;
-    buf = getbytes(bufsize);
-    if (!buf) return (0);
+    if (!sfpool_add())
+        return (0);
 
     x = (t_writesf *)pd_new(writesf_class);
 
@@ -2506,7 +3278,6 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_f = 0;
     x->x_sfchannels = nchannels;
     pthread_mutex_init(&x->x_mutex, 0);
-    pthread_cond_init(&x->x_requestcondition, 0);
     pthread_cond_init(&x->x_answercondition, 0);
     x->x_vecsize = MAXVECSIZE;
     x->x_insamplerate = x->x_samplerate = 0;
@@ -2515,10 +3286,15 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_canvas = canvas_getcurrent();
     x->x_bytespersample = 2;
     x->x_fd = -1;
-    x->x_buf = buf;
+    x->x_buf = 0;
     x->x_bufsize = bufsize;
     x->x_fifosize = x->x_fifohead = x->x_fifotail = x->x_requestcode = 0;
-    pthread_create(&x->x_childthread, 0, writesf_child_main, x);
+    x->x_service = writesf_service;
+    x->x_bytespersec = x->x_deadline = 0;
+    x->x_queued = x->x_busy = x->x_rekick = 0;
+#ifdef PDINSTANCE
+    x->x_instance = pd_this;
+#endif
     return (x);
 }
 
@@ -2541,7 +3317,7 @@ static t_int *writesf_perform(t_int *w)
             fprintf(stderr, "writesf waiting for disk write..\n");
             fprintf(stderr, "(head %d, tail %d, room %d, want %d)\n",
                 x->x_fifohead, x->x_fifotail, roominfifo, wantbytes);
-            sfread_cond_signal(&x->x_requestcondition);
+            sfpool_kick(x);
             sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
             fprintf(stderr, "... done waiting.\n");
             roominfifo = x->x_fifotail - x->x_fifohead;
@@ -2561,7 +3337,7 @@ static t_int *writesf_perform(t_int *w)
 #ifdef DEBUG_SOUNDFILE
             pute("signal 1\n");
 #endif
-            sfread_cond_signal(&x->x_requestcondition);
+            sfpool_kick(x);
             x->x_sigcountdown = x->x_sigperiod;
         }
         pthread_mutex_unlock(&x->x_mutex);
@@ -2588,7 +3364,7 @@ static void writesf_stop(t_writesf *x)
 #ifdef DEBUG_SOUNDFILE
     pute("signal 2\n");
 #endif
-    sfread_cond_signal(&x->x_requestcondition);
+    sfpool_kick(x);
     pthread_mutex_unlock(&x->x_mutex);
 }
 
@@ -2620,10 +3396,12 @@ static void writesf_open(t_writesf *x, t_symbol *s, int argc, t_atom *argv)
         pd_error(x, "normalize/onset/nframes argument to writesf~: ignored");
     if (argc)
         pd_error(x, "extra argument(s) to writesf~: ignored");
+    if (!sfpool_allocbuf(x))
+        return;
     pthread_mutex_lock(&x->x_mutex);
     while (x->x_requestcode != REQUEST_NOTHING)
     {
-        sfread_cond_signal(&x->x_requestcondition);
+        sfpool_kick(x);
         sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
     }
     x->x_bytespersample = bytespersamp;
@@ -2649,11 +3427,13 @@ static void writesf_open(t_writesf *x, t_symbol *s, int argc, t_atom *argv)
         tick.  */
     x->x_fifosize = x->x_bufsize - (x->x_bufsize %
         (x->x_bytespersample * x->x_sfchannels * MAXVECSIZE));
-            /* arrange for the "request" condition to be signalled 16
-            times per buffer */
+            /* arrange for the I/O threads to be kicked 16 times per
+            buffer */
     x->x_sigcountdown = x->x_sigperiod = (x->x_fifosize /
             (16 * x->x_bytespersample * x->x_sfchannels * x->x_vecsize));
-    sfread_cond_signal(&x->x_requestcondition);
+    x->x_bytespersec = (double)x->x_bytespersample * x->x_sfchannels *
+        (x->x_insamplerate > 0 ? x->x_insamplerate : sys_getsr());
+    sfpool_kick(x);
     pthread_mutex_unlock(&x->x_mutex);
 }
 
@@ -2667,6 +3447,8 @@ static void writesf_dsp(t_writesf *x, t_signal **sp)
     for (i = 0; i < ninlets; i++)
         x->x_outvec[i] = sp[i]->s_vec;
     x->x_insamplerate = sp[0]->s_sr;
+    x->x_bytespersec = (double)x->x_bytespersample * x->x_sfchannels *
+        x->x_insamplerate;
     pthread_mutex_unlock(&x->x_mutex);
     dsp_add(writesf_perform, 1, x);
 }
@@ -2684,26 +3466,20 @@ static void writesf_print(t_writesf *x)
 static void writesf_free(t_writesf *x)
 {
         /* request QUIT and wait for acknowledge */
-    void *threadrtn;
     pthread_mutex_lock(&x->x_mutex);
     x->x_requestcode = REQUEST_QUIT;
-    /* post("stopping writesf thread..."); */
-    sfread_cond_signal(&x->x_requestcondition);
     while (x->x_requestcode != REQUEST_NOTHING)
     {
-        /* post("signalling..."); */
-        sfread_cond_signal(&x->x_requestcondition);
+        sfpool_kick(x);
         sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
     }
     pthread_mutex_unlock(&x->x_mutex);
-    if (pthread_join(x->x_childthread, &threadrtn))
-        error("writesf_free: join failed");
-    /* post("... done."); */
+    sfpool_remove(x);
 
-    pthread_cond_destroy(&x->x_requestcondition);
     pthread_cond_destroy(&x->x_answercondition);
     pthread_mutex_destroy(&x->x_mutex);
-    freebytes(x->x_buf, x->x_bufsize);
+    if (x->x_buf)
+        freebytes(x->x_buf, x->x_bufsize);
 }
 
 static void writesf_setup(void)
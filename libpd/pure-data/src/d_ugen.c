@@ -13,8 +13,28 @@
 
 #include "m_pd.h"
 #include "m_imp.h"
+#include "g_canvas.h"
+#include "s_stuff.h"
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+    /* multithreaded DSP ("pd dsp-threads") needs pthreads and atomics */
+#if PDTHREADS && (defined(__GNUC__) || defined(__clang__))
+#define UGEN_PARALLEL
+#include <pthread.h>
+#include <errno.h>
+#ifdef __APPLE__        /* macOS has no unnamed POSIX semaphores */
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+#endif
 
 extern t_class *vinlet_class, *voutlet_class, *canvas_class, *text_class;
 t_float *obj_findsignalscalar(t_object *x, int m);
@@ -45,6 +65,32 @@ struct _instanceugen
     int u_phase;
     int u_loud;
     struct _dspcontext *u_context;
+        /* steps recorded while sorting for parallel DSP, see below */
+    struct _dspstep *u_steps;
+    int u_nsteps;
+    int u_stepsize;             /* allocated size of u_steps */
+    struct _dspaccess *u_access;    /* signal buffers used by the steps */
+    int u_naccess;
+    int u_accesssize;           /* allocated size of u_access */
+    int u_stepping;             /* true while recording a step */
+    int u_stepshared;           /* true if the step touches shared state */
+    int u_stepend;              /* chain onset after the last step */
+        /* the steps merged into tasks for the worker threads */
+    struct _dspsched *u_sched;      /* tasks the chain is run as, if any */
+    struct _dspsched *u_ready;      /* newly made by the compiler thread */
+    struct _dspsched *u_retired;    /* replaced ones still to be freed */
+    struct _dsppool *u_pool;    /* the worker threads, if more than one */
+        /* DSP profiling, see below */
+    int u_profile;              /* true if "pd dsp-profile" is on */
+    struct _dspprofslot *u_prof;    /* the counters */
+    int u_nprof;
+    int u_profsize;             /* allocated size of u_prof */
+    struct _dspmark *u_marks;   /* chain onsets where counters change */
+    int u_nmarks;
+    int u_marksize;             /* allocated size of u_marks */
+    int *u_profmap;             /* counter for each chain onset, if timing */
+    int u_profmapsize;
+    uint64_t u_profticks;       /* ticks timed since the last reset */
 };
 
 #define THIS (pd_this->pd_ugen)
@@ -57,8 +103,19 @@ void d_ugen_newpdinstance( void)
     THIS->u_signals = 0;
 }
 
+static void ugen_freesteps(void);
+static void ugen_freetasks(void);
+static void dsppool_free(struct _dsppool *x);
+static void dsppool_resize(struct _dsppool *x, int ntasks);
+static void ugen_freeprofile(void);
+
 void d_ugen_freepdinstance( void)
 {
+    ugen_freesteps();
+    ugen_freeprofile();
+    if (THIS->u_pool)
+        dsppool_free(THIS->u_pool);
+    ugen_freetasks();
     freebytes(THIS, sizeof(*THIS));
 }
 
@@ -307,6 +364,7 @@ void block_tilde_setup(void)
 {
     block_class = class_new(gensym("block~"), (t_newmethod)block_new, 0,
             sizeof(t_block), 0, A_DEFFLOAT, A_DEFFLOAT, A_DEFFLOAT, 0);
+    class_setparalleldsp(block_class);
     class_addcreator((t_newmethod)switch_new, gensym("switch~"),
         A_DEFFLOAT, A_DEFFLOAT, A_DEFFLOAT, 0);
     class_addmethod(block_class, (t_method)block_set, gensym("set"),
@@ -361,12 +419,1197 @@ void dsp_addv(t_perfroutine f, int n, t_int *vec)
     THIS->u_dspchainsize = newsize;
 }
 
+/* ------------------------- parallel DSP ---------------------------- */
+
+/* With "pd dsp-threads <n>" the DSP chain is run by a pool of n threads,
+the thread calling dsp_tick() being one of them.  While the root canvases
+are sorted, the code ugen_doit() puts on the chain for each ugen, and for
+each sum of signals, is recorded as a "step" along with the signal buffers
+it and the objects inside it (for subpatches and clones) read and write, and
+whether any of these objects is of a class that touches state shared with
+other objects, i.e., whose class wasn't marked by class_setparalleldsp().
+Objects whose code has independent parts, like clone with "-p", may split
+the step into several with ugen_splitstep().  Code outside any step, such as
+that of root canvases with a block~ object, becomes a "barrier" step.  Signal
+buffers aren't reused while recording, since reusing one would make the step
+reusing it wait for all the steps which used it before.
+
+Once all root canvases are sorted, ugen_finish() makes each step wait for the
+last writer of each buffer it reads, the last writer and later readers of each
+buffer it writes, the previous shared step if it is shared itself, and the
+previous barrier; barriers wait for everything before them.  Chains of steps
+that only wait for each other are merged into tasks, and in each DSP tick the
+threads run the tasks as they become ready, stealing ready tasks from each
+other when they run out.  Every buffer sees the same writes and reads in the
+same order as in the serial chain, and objects with shared state (send~,
+throw~, dac~, tabwrite~, clocks, ...) still run one at a time in chain order,
+so the output is the same as that of the serial chain.
+
+Making the tasks takes time in proportion to the size of the whole patch, so
+it isn't done while the instance is locked.  Instead ugen_finish() hands a
+snapshot of the steps to a "compiler" thread belonging to the pool and
+returns at once; meanwhile dsp_tick() runs the new chain serially, which is
+always correct.  When the tasks are ready the compiler thread publishes them
+with an atomic pointer swap, and the next dsp_tick() takes them up if they
+were made for the chain being run (the "sort number" tells), retiring the
+ones they replace.  Retired tasks are freed later, outside of dsp_tick(), by
+whoever next rebuilds or stops the chain.  Since the compiler thread doesn't
+hold the instance, it uses malloc() and free() rather than getbytes() and
+freebytes(), which might use the instance's memory pool.
+
+Only the tasks are made off the lock.  The sort itself, ugen_done_graph() and
+the objects' "dsp" methods that build the new chain still run with the
+instance locked, as before, since those methods change object state that the
+running chain reads.  With one DSP thread, the default, no tasks are made at
+all and rebuilding the chain costs what it always did. */
+
+typedef struct _dspstep
+{
+    int s_onset;            /* onset of the step's code in the chain */
+    int s_end;              /* and onset of the code after it */
+    int s_access;           /* first of its buffers in u_access */
+    int s_naccess;          /* and number of buffers */
+    char s_shared;          /* true if it touches shared state */
+    char s_barrier;         /* true if it has to run alone */
+} t_dspstep;
+
+typedef struct _dspaccess
+{
+    t_sample *a_vec;        /* signal buffer */
+    int a_write;            /* true if written, otherwise only read */
+} t_dspaccess;
+
+typedef struct _dsptask
+{
+    int t_range;            /* first of its chain ranges in s_ranges */
+    int t_nrange;
+    int t_succ;             /* first of its successors in s_succ */
+    int t_nsucc;
+    int t_npred;            /* number of predecessors */
+    int t_pending;          /* predecessors still to run in this tick */
+} t_dsptask;
+
+    /* a snapshot of the steps for the compiler thread, in one block */
+typedef struct _dspjob
+{
+    int j_sortno;           /* sort number of the chain they were made for */
+    int j_nsteps;
+    int j_naccess;
+    t_dspaccess *j_access;  /* point into the block */
+    t_dspstep *j_steps;
+} t_dspjob;
+
+    /* the tasks made from a job */
+typedef struct _dspsched
+{
+    int s_sortno;
+    int s_nsteps;
+    t_dsptask *s_tasks;
+    int s_ntasks;
+    int *s_ranges;          /* onset and end in the chain of each task's */
+    int s_nranges;          /* code, grouped by task */
+    int *s_succ;            /* successors of each task, grouped by task */
+    int s_nsucc;
+    int *s_roots;           /* tasks without predecessors */
+    int s_nroots;
+    struct _dspsched *s_next;   /* next in u_retired */
+} t_dspsched;
+
+    /* grow an array allocated with getbytes() to hold at least n elements */
+static void *ugen_grow(void *vec, int *size, int n, size_t elemsize)
+{
+    int newsize = (*size ? *size : 64);
+    if (n <= *size)
+        return (vec);
+    while (newsize < n)
+        newsize *= 2;
+    vec = resizebytes(vec, *size * elemsize, newsize * elemsize);
+    *size = newsize;
+    return (vec);
+}
+
+static void ugen_addstep(int onset, int end, int barrier)
+{
+    t_dspstep *s;
+    THIS->u_steps = (t_dspstep *)ugen_grow(THIS->u_steps,
+        &THIS->u_stepsize, THIS->u_nsteps + 1, sizeof(*THIS->u_steps));
+    s = &THIS->u_steps[THIS->u_nsteps++];
+    s->s_onset = onset;
+    s->s_end = THIS->u_stepend = end;
+    s->s_access = THIS->u_naccess;
+    s->s_naccess = 0;
+    s->s_shared = s->s_barrier = barrier;
+}
+
+    /* start recording a step for the code about to be put on the chain */
+static void ugen_beginstep(void)
+{
+    int onset = THIS->u_dspchainsize - 1;
+    if (onset > THIS->u_stepend)
+        ugen_addstep(THIS->u_stepend, onset, 1);
+    ugen_addstep(onset, onset, 0);
+    THIS->u_stepping = 1;
+    THIS->u_stepshared = 0;
+}
+
+static void ugen_stepaccess(t_sample *vec, int write)
+{
+    t_dspaccess *a;
+    if (!THIS->u_stepping || !vec)
+        return;
+    THIS->u_access = (t_dspaccess *)ugen_grow(THIS->u_access,
+        &THIS->u_accesssize, THIS->u_naccess + 1, sizeof(*THIS->u_access));
+    a = &THIS->u_access[THIS->u_naccess++];
+    a->a_vec = vec;
+    a->a_write = write;
+}
+
+static void ugen_endstep(void)
+{
+    t_dspstep *s = &THIS->u_steps[THIS->u_nsteps - 1];
+    THIS->u_stepping = 0;
+    s->s_end = THIS->u_stepend = THIS->u_dspchainsize - 1;
+        /* forget steps which didn't put anything on the chain */
+    if (s->s_end == s->s_onset)
+    {
+        THIS->u_naccess = s->s_access;
+        THIS->u_nsteps--;
+    }
+    else
+    {
+        s->s_naccess = THIS->u_naccess - s->s_access;
+        s->s_shared = THIS->u_stepshared;
+    }
+}
+
+static void ugen_freesteps(void)
+{
+    if (THIS->u_steps)
+        freebytes(THIS->u_steps, THIS->u_stepsize * sizeof(*THIS->u_steps));
+    if (THIS->u_access)
+        freebytes(THIS->u_access,
+            THIS->u_accesssize * sizeof(*THIS->u_access));
+    THIS->u_steps = 0;
+    THIS->u_access = 0;
+    THIS->u_nsteps = THIS->u_stepsize = 0;
+    THIS->u_naccess = THIS->u_accesssize = 0;
+    THIS->u_stepping = 0;
+}
+
+static void ugen_freesched(t_dspsched *x)
+{
+    free(x->s_tasks);
+    free(x->s_ranges);
+    free(x->s_succ);
+    free(x->s_roots);
+    free(x);
+}
+
+static t_dspsched *ugen_exchangeready(t_dspsched *x);
+
+    /* free the tasks in use, those retired, and any not yet taken up */
+static void ugen_freetasks(void)
+{
+    t_dspsched *x;
+    if (THIS->u_sched)
+        ugen_freesched(THIS->u_sched);
+    THIS->u_sched = 0;
+    while ((x = THIS->u_retired))
+    {
+        THIS->u_retired = x->s_next;
+        ugen_freesched(x);
+    }
+    if ((x = ugen_exchangeready(0)))
+        ugen_freesched(x);
+}
+
+    /* last writer and readers since of a signal buffer */
+typedef struct _dspbuf
+{
+    t_sample *b_vec;
+    int b_writer;
+    int b_reader;           /* last reader, earlier ones in readers' r_next */
+} t_dspbuf;
+
+typedef struct _dspreader
+{
+    int r_step;
+    int r_next;
+} t_dspreader;
+
+static t_dspbuf *ugen_findbuf(t_dspbuf *tab, int mask, t_sample *vec)
+{
+    unsigned long h = ((unsigned long)vec >> 4) * 2654435761UL;
+    t_dspbuf *b;
+    for (b = &tab[h & mask]; b->b_vec && b->b_vec != vec;
+        b = &tab[(++h) & mask])
+            ;
+    if (!b->b_vec)
+    {
+        b->b_vec = vec;
+        b->b_writer = b->b_reader = -1;
+    }
+    return (b);
+}
+
+    /* like ugen_grow() but with realloc(), for the compiler thread; if
+    out of memory the vector is freed and zero returned */
+static void *ugen_sysgrow(void *vec, int *size, int n, size_t elemsize)
+{
+    int newsize = (*size ? *size : 64);
+    void *newvec;
+    if (n <= *size)
+        return (vec);
+    while (newsize < n)
+        newsize *= 2;
+    if (!(newvec = realloc(vec, newsize * elemsize)))
+    {
+        free(vec);
+        return (0);
+    }
+    *size = newsize;
+    return (newvec);
+}
+
+    /* make the task graph from a snapshot of the steps recorded while
+    sorting; this runs in the compiler thread.  If out of memory it gives
+    up and returns zero, and the chain just goes on running serially. */
+static t_dspsched *ugen_maketasks(t_dspjob *job)
+{
+    t_dspstep *steps = job->j_steps, *s;
+    t_dspaccess *a;
+    t_dspbuf *tab, *b;
+    t_dspreader *readers;
+    t_dspsched *x = 0;
+    int nsteps = job->j_nsteps, ntasks = 0, nreaders = 0, tabsize, i, j, k;
+    int *pred = 0, npred = 0, predsize = 0, *predonset, *nsucc, *mark, *task;
+    int *ntaskpred = 0, *lastend = 0, lastbarrier = -1, lastshared = -1;
+    t_dsptask *t;
+
+    if (nsteps < 2)
+        return (0);
+    for (tabsize = 16; tabsize < 2 * job->j_naccess; tabsize *= 2)
+        ;
+    tab = (t_dspbuf *)calloc(tabsize, sizeof(*tab));
+    readers = (t_dspreader *)calloc(job->j_naccess + 1, sizeof(*readers));
+    predonset = (int *)calloc(nsteps + 1, sizeof(int));
+    nsucc = (int *)calloc(nsteps, sizeof(int));
+    mark = (int *)calloc(nsteps, sizeof(int));
+    task = (int *)calloc(nsteps, sizeof(int));
+    if (!tab || !readers || !predonset || !nsucc || !mark || !task)
+        goto done;
+    for (i = 0; i < nsteps; i++)
+        mark[i] = -1;
+
+        /* find the steps each step has to wait for */
+#define ADDPRED(p) if ((p) >= 0 && mark[(p)] != i) { \
+        if (!(pred = (int *)ugen_sysgrow(pred, &predsize, npred + 1, \
+            sizeof(int)))) goto done; \
+        pred[npred++] = (p); mark[(p)] = i; nsucc[(p)]++; }
+    for (i = 0, s = steps; i < nsteps; i++, s++)
+    {
+        mark[i] = i;
+        predonset[i] = npred;
+        if (s->s_barrier)
+        {
+            for (j = (lastbarrier < 0 ? 0 : lastbarrier); j < i; j++)
+                ADDPRED(j);
+            lastbarrier = i;
+        }
+        else ADDPRED(lastbarrier);
+        if (s->s_shared)
+        {
+            ADDPRED(lastshared);
+            lastshared = i;
+        }
+        for (j = 0, a = job->j_access + s->s_access; j < s->s_naccess;
+            j++, a++)
+        {
+            b = ugen_findbuf(tab, tabsize - 1, a->a_vec);
+            ADDPRED(b->b_writer);
+            if (a->a_write)
+                for (k = b->b_reader; k >= 0; k = readers[k].r_next)
+                    ADDPRED(readers[k].r_step);
+        }
+        for (j = 0, a = job->j_access + s->s_access; j < s->s_naccess;
+            j++, a++)
+                if (a->a_write)
+        {
+            b = ugen_findbuf(tab, tabsize - 1, a->a_vec);
+            b->b_writer = i;
+            b->b_reader = -1;
+        }
+        for (j = 0, a = job->j_access + s->s_access; j < s->s_naccess;
+            j++, a++)
+                if (!a->a_write)
+        {
+            b = ugen_findbuf(tab, tabsize - 1, a->a_vec);
+            if (b->b_writer != i && (b->b_reader < 0 ||
+                readers[b->b_reader].r_step != i))
+            {
+                readers[nreaders].r_step = i;
+                readers[nreaders].r_next = b->b_reader;
+                b->b_reader = nreaders++;
+            }
+        }
+    }
+    predonset[nsteps] = npred;
+#undef ADDPRED
+
+        /* merge each step into its predecessor's task if it's the only
+        one either waits for */
+    for (i = 0; i < nsteps; i++)
+    {
+        if (predonset[i+1] - predonset[i] == 1 &&
+            nsucc[pred[predonset[i]]] == 1)
+                task[i] = task[pred[predonset[i]]];
+        else task[i] = ntasks++;
+    }
+    if (ntasks < 2)
+        goto done;
+
+        /* gather each task's code, joining adjacent ranges */
+    if (!(x = (t_dspsched *)calloc(1, sizeof(*x))))
+        goto done;
+    x->s_sortno = job->j_sortno;
+    x->s_nsteps = nsteps;
+    x->s_tasks = t = (t_dsptask *)calloc(ntasks, sizeof(*t));
+    x->s_ntasks = ntasks;
+    lastend = (int *)calloc(ntasks, sizeof(int));
+    ntaskpred = (int *)calloc(ntasks, sizeof(int));
+    if (!t || !lastend || !ntaskpred)
+        goto fail;
+    for (i = 0; i < ntasks; i++)
+        lastend[i] = -1;
+    for (i = 0, s = steps; i < nsteps; i++, s++)
+    {
+        if (lastend[task[i]] != s->s_onset)
+            t[task[i]].t_nrange++;
+        lastend[task[i]] = s->s_end;
+        for (j = predonset[i]; j < predonset[i+1]; j++)
+            if (task[pred[j]] != task[i])
+        {
+            t[task[pred[j]]].t_nsucc++;
+            ntaskpred[task[i]]++;
+        }
+    }
+    for (i = 0; i < ntasks; i++)
+    {
+        t[i].t_range = x->s_nranges;
+        x->s_nranges += t[i].t_nrange;
+        t[i].t_succ = x->s_nsucc;
+        x->s_nsucc += t[i].t_nsucc;
+        t[i].t_npred = ntaskpred[i];
+        if (!ntaskpred[i])
+            x->s_nroots++;
+        t[i].t_nrange = t[i].t_nsucc = 0;
+        lastend[i] = -1;
+    }
+    x->s_ranges = (int *)calloc(2 * x->s_nranges + 1, sizeof(int));
+    x->s_succ = (int *)calloc(x->s_nsucc + 1, sizeof(int));
+    x->s_roots = (int *)calloc(x->s_nroots + 1, sizeof(int));
+    if (!x->s_ranges || !x->s_succ || !x->s_roots)
+        goto fail;
+    for (i = 0, s = steps; i < nsteps; i++, s++)
+    {
+        int *range;
+        if (lastend[task[i]] != s->s_onset)
+        {
+            range = x->s_ranges +
+                2 * (t[task[i]].t_range + t[task[i]].t_nrange++);
+            range[0] = s->s_onset;
+        }
+        else range = x->s_ranges +
+            2 * (t[task[i]].t_range + t[task[i]].t_nrange - 1);
+        range[1] = lastend[task[i]] = s->s_end;
+        for (j = predonset[i]; j < predonset[i+1]; j++)
+            if (task[pred[j]] != task[i])
+        {
+            t_dsptask *t2 = &t[task[pred[j]]];
+            x->s_succ[t2->t_succ + t2->t_nsucc++] = task[i];
+        }
+    }
+    for (i = j = 0; i < ntasks; i++)
+        if (!t[i].t_npred)
+            x->s_roots[j++] = i;
+    goto done;
+fail:
+    ugen_freesched(x);
+    x = 0;
+done:
+    free(lastend);
+    free(ntaskpred);
+    free(tab);
+    free(readers);
+    free(predonset);
+    free(nsucc);
+    free(mark);
+    free(task);
+    free(pred);
+    return (x);
+}
+
+/* ------------------------- DSP profiling ---------------------------- */
+
+/* With "pd dsp-profile 1" each perform routine is timed as the chain runs,
+and the time is charged to the object whose "dsp" method put it there, or,
+for code a canvas adds itself (block~ and inlet~/outlet~ prologs, sums of
+signals connected to the same inlet), to the canvas.  While the graph is
+sorted, ugen_setcanvas() and ugen_doit() mark the chain onsets where the
+owner changes, and ugen_finish() turns the marks into a map from onset to
+counter.  With "pd dsp-threads" the code of one canvas may run on several
+threads at once, so the counters are added to atomically.  They belong to
+the sorted graph and are thrown away with it, i.e., they start over when the
+graph is resorted.  Timing every call costs two clock reads per perform
+routine, so this is off unless asked for. */
+
+typedef struct _dspprofslot
+{
+    t_dspprofile s_prof;
+    int s_canvas;               /* counter of the canvas's own code */
+} t_dspprofslot;
+
+typedef struct _dspmark
+{
+    int m_onset;
+    int m_slot;
+} t_dspmark;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DSP_PROFADD(x, v) __atomic_add_fetch(&(x), (v), __ATOMIC_RELAXED)
+#else
+#define DSP_PROFADD(x, v) ((x) += (v))
+#endif
+
+    /* monotonic time in nanoseconds */
+static uint64_t dsp_profclock(void)
+{
+#ifdef _WIN32
+    static double nspertick;
+    LARGE_INTEGER now;
+    if (!nspertick)
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        nspertick = 1e9 / (double)freq.QuadPart;
+    }
+    QueryPerformanceCounter(&now);
+    return ((uint64_t)(now.QuadPart * nspertick));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+#endif
+}
+
+    /* run the chain from ip up to end, or to its end if 0, timing each
+    perform routine */
+static void dsp_profilerun(t_int *ip, t_int *end)
+{
+    t_int *chain = THIS->u_dspchain, *next;
+    int *map = THIS->u_profmap;
+    t_dspprofile *p;
+    uint64_t start, ns;
+    int bin;
+    while (ip && (end ? ip < end : *ip != (t_int)dsp_done))
+    {
+        start = dsp_profclock();
+        next = (*(t_perfroutine)(*ip))(ip);
+        ns = dsp_profclock() - start;
+        p = &THIS->u_prof[map[ip - chain]].s_prof;
+#if defined(__GNUC__) || defined(__clang__)
+        bin = (ns ? 63 - __builtin_clzll(ns) : 0);
+#else
+        for (bin = 0; (ns >> bin) > 1; bin++)
+            ;
+#endif
+        if (bin >= DSP_PROFBINS)
+            bin = DSP_PROFBINS - 1;
+        DSP_PROFADD(p->p_time, ns);
+        DSP_PROFADD(p->p_calls, 1);
+        DSP_PROFADD(p->p_hist[bin], 1);
+        ip = next;
+    }
+}
+
+static int ugen_newprofslot(t_object *obj, t_canvas *canvas, int parent)
+{
+    t_dspprofslot *s;
+    THIS->u_prof = (t_dspprofslot *)ugen_grow(THIS->u_prof,
+        &THIS->u_profsize, THIS->u_nprof + 1, sizeof(*THIS->u_prof));
+    s = &THIS->u_prof[THIS->u_nprof];
+    memset(s, 0, sizeof(*s));
+    s->s_prof.p_object = obj;
+    s->s_prof.p_canvas = canvas;
+    s->s_canvas = parent;
+    return (THIS->u_nprof++);
+}
+
+    /* charge code added to the chain from here on to a counter */
+static void ugen_profmark(int slot)
+{
+    int onset = THIS->u_dspchainsize - 1;
+    if (THIS->u_nmarks &&
+        THIS->u_marks[THIS->u_nmarks - 1].m_onset == onset)
+            THIS->u_nmarks--;
+    THIS->u_marks = (t_dspmark *)ugen_grow(THIS->u_marks,
+        &THIS->u_marksize, THIS->u_nmarks + 1, sizeof(*THIS->u_marks));
+    THIS->u_marks[THIS->u_nmarks].m_onset = onset;
+    THIS->u_marks[THIS->u_nmarks].m_slot = slot;
+    THIS->u_nmarks++;
+}
+
+static void ugen_freemarks(void)
+{
+    if (THIS->u_marks)
+        freebytes(THIS->u_marks, THIS->u_marksize * sizeof(*THIS->u_marks));
+    THIS->u_marks = 0;
+    THIS->u_nmarks = THIS->u_marksize = 0;
+}
+
+    /* once the chain is complete, map each onset to its counter */
+static void ugen_makeprofmap(void)
+{
+    int i, j, n = THIS->u_dspchainsize;
+    if (!THIS->u_nmarks)
+        return;
+    THIS->u_profmap = (int *)getbytes(n * sizeof(*THIS->u_profmap));
+    THIS->u_profmapsize = n;
+    for (i = j = 0; i < n; i++)
+    {
+        while (j + 1 < THIS->u_nmarks && THIS->u_marks[j + 1].m_onset <= i)
+            j++;
+        THIS->u_profmap[i] = THIS->u_marks[j].m_slot;
+    }
+    ugen_freemarks();
+    THIS->u_profticks = 0;
+}
+
+static void ugen_freeprofile(void)
+{
+    ugen_freemarks();
+    if (THIS->u_profmap)
+        freebytes(THIS->u_profmap,
+            THIS->u_profmapsize * sizeof(*THIS->u_profmap));
+    THIS->u_profmap = 0;
+    THIS->u_profmapsize = 0;
+    if (THIS->u_prof)
+        freebytes(THIS->u_prof, THIS->u_profsize * sizeof(*THIS->u_prof));
+    THIS->u_prof = 0;
+    THIS->u_nprof = THIS->u_profsize = 0;
+    THIS->u_profticks = 0;
+}
+
+    /* turn profiling on or off; the graph is resorted to mark the owners */
+void dsp_setprofile(int on)
+{
+    if (!on == !THIS->u_profile)
+        return;
+    THIS->u_profile = (on != 0);
+    canvas_update_dsp();
+}
+
+int dsp_getprofile(void)
+{
+    return (THIS->u_profile);
+}
+
+    /* zero the counters */
+void dsp_resetprofile(void)
+{
+    int i;
+    for (i = 0; i < THIS->u_nprof; i++)
+    {
+        t_dspprofile *p = &THIS->u_prof[i].s_prof;
+        memset(p->p_hist, 0, sizeof(p->p_hist));
+        p->p_time = p->p_calls = 0;
+    }
+    THIS->u_profticks = 0;
+}
+
+static int dsp_profcompare(const void *a, const void *b)
+{
+    const t_dspprofile *p1 = (const t_dspprofile *)a,
+        *p2 = (const t_dspprofile *)b;
+    return (p1->p_time < p2->p_time ? 1 : (p1->p_time > p2->p_time ? -1 : 0));
+}
+
+    /* copy up to n counters, the most expensive first, to vec.  If
+    "bycanvas" is set, there's one per canvas totaling the canvas's own
+    code and everything in it, subpatches included.  The number of ticks
+    timed is returned in *ticks.  Returns the number of counters copied. */
+int dsp_getprofiletop(t_dspprofile *vec, int n, int bycanvas,
+    uint64_t *ticks)
+{
+    int nprof = THIS->u_nprof, i, j, k, b, count;
+    t_dspprofile *all;
+    if (ticks)
+        *ticks = THIS->u_profticks;
+    if (!THIS->u_profmap || n <= 0)
+        return (0);
+    all = (t_dspprofile *)getbytes(nprof * sizeof(*all));
+    for (i = 0; i < nprof; i++)
+    {
+        all[i] = THIS->u_prof[i].s_prof;
+        if (bycanvas)
+        {
+            memset(all[i].p_hist, 0, sizeof(all[i].p_hist));
+            all[i].p_time = all[i].p_calls = 0;
+        }
+    }
+    if (bycanvas)
+    {
+            /* add each counter to its canvas and the canvases above */
+        for (i = 0; i < nprof; i++)
+        {
+            t_dspprofile *p = &THIS->u_prof[i].s_prof;
+            for (j = (p->p_object ? THIS->u_prof[i].s_canvas : i); j >= 0;
+                j = THIS->u_prof[j].s_canvas)
+            {
+                all[j].p_time += p->p_time;
+                all[j].p_calls += p->p_calls;
+                for (b = 0; b < DSP_PROFBINS; b++)
+                    all[j].p_hist[b] += p->p_hist[b];
+            }
+        }
+        for (i = k = 0; i < nprof; i++)
+            if (!all[i].p_object && all[i].p_calls)
+                all[k++] = all[i];
+    }
+    else for (i = k = 0; i < nprof; i++)
+        if (all[i].p_object && all[i].p_calls)
+            all[k++] = all[i];
+    qsort(all, k, sizeof(*all), dsp_profcompare);
+    count = (k < n ? k : n);
+    memcpy(vec, all, count * sizeof(*vec));
+    freebytes(all, nprof * sizeof(*all));
+    return (count);
+}
+
+static void dsp_profileprint(int n)
+{
+    t_dspprofile *vec;
+    uint64_t ticks;
+    double tickns = 1e9 * sys_getblksize() / sys_getsr();
+    int i, count, bycanvas;
+    if (!THIS->u_profile)
+    {
+        post("dsp-profile: off");
+        return;
+    }
+    vec = (t_dspprofile *)getbytes(n * sizeof(*vec));
+    for (bycanvas = 0; bycanvas < 2; bycanvas++)
+    {
+        count = dsp_getprofiletop(vec, n, bycanvas, &ticks);
+        if (!ticks)
+        {
+            post("dsp-profile: no ticks timed yet");
+            break;
+        }
+        post("dsp-profile: %s, microseconds per tick (%% of real time):",
+            (bycanvas ? "canvases" : "objects"));
+        for (i = 0; i < count; i++)
+        {
+            t_dspprofile *p = &vec[i];
+            double ns = (double)p->p_time / ticks;
+            if (p->p_object && p->p_canvas)
+                post("%10.2f (%5.2f%%) %s %d in %s", ns * 1e-3,
+                    100. * ns / tickns, class_getname(pd_class(
+                        &p->p_object->ob_pd)), canvas_getindex(p->p_canvas,
+                            &p->p_object->ob_g), p->p_canvas->gl_name->s_name);
+            else if (p->p_object)
+                post("%10.2f (%5.2f%%) %s", ns * 1e-3, 100. * ns / tickns,
+                    class_getname(pd_class(&p->p_object->ob_pd)));
+            else post("%10.2f (%5.2f%%) %s", ns * 1e-3, 100. * ns / tickns,
+                (p->p_canvas ? p->p_canvas->gl_name->s_name : "?"));
+        }
+    }
+    freebytes(vec, n * sizeof(*vec));
+}
+
+    /* "pd dsp-profile 1|0", "pd dsp-profile reset",
+    "pd dsp-profile print [n]" */
+void glob_dspprofile(void *dummy, t_symbol *s, int argc, t_atom *argv)
+{
+    t_symbol *what = atom_getsymbolarg(0, argc, argv);
+    if (what == gensym("reset"))
+        dsp_resetprofile();
+    else if (what == gensym("print"))
+    {
+        int n = atom_getfloatarg(1, argc, argv);
+        dsp_profileprint(n > 0 ? n : 10);
+    }
+    else if (argc && argv->a_type == A_FLOAT)
+        dsp_setprofile(atom_getfloat(argv) != 0);
+    else pd_error(0, "dsp-profile: expected 0, 1, 'reset' or 'print'");
+}
+
+#ifdef UGEN_PARALLEL
+
+#define DSP_MAXTHREADS 64
+#define DSP_SPINS 4096      /* polls before an idle worker goes to sleep */
+
+#define DSP_LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define DSP_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define DSP_ADD(x, v) __atomic_add_fetch(&(x), (v), __ATOMIC_SEQ_CST)
+#define DSP_EXCHANGE(x, v) __atomic_exchange_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define DSP_CAS(x, old, v) __atomic_compare_exchange_n(&(x), &(old), (v), \
+    0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#if defined(__i386__) || defined(__x86_64__)
+#define DSP_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define DSP_PAUSE() __asm__ __volatile__("yield")
+#else
+#define DSP_PAUSE()
+#endif
+
+    /* idle workers sleep on a semaphore of their own, which dsp_tick()
+    posts to wake them; unlike signaling a condition variable this takes
+    no lock, and it only calls the kernel if the worker is really asleep */
+#ifdef __APPLE__
+typedef dispatch_semaphore_t t_dspsem;
+
+static int dspsem_init(t_dspsem *s)
+{
+    return (!(*s = dispatch_semaphore_create(0)));
+}
+
+static void dspsem_post(t_dspsem *s)
+{
+    dispatch_semaphore_signal(*s);
+}
+
+static void dspsem_wait(t_dspsem *s)
+{
+    dispatch_semaphore_wait(*s, DISPATCH_TIME_FOREVER);
+}
+
+static void dspsem_destroy(t_dspsem *s)
+{
+    dispatch_release(*s);
+}
+#else
+typedef sem_t t_dspsem;
+
+static int dspsem_init(t_dspsem *s)
+{
+    return (sem_init(s, 0, 0));
+}
+
+static void dspsem_post(t_dspsem *s)
+{
+    sem_post(s);
+}
+
+static void dspsem_wait(t_dspsem *s)
+{
+    while (sem_wait(s) && errno == EINTR)
+        ;
+}
+
+static void dspsem_destroy(t_dspsem *s)
+{
+    sem_destroy(s);
+}
+#endif
+
+typedef struct _dspworker
+{
+    struct _dsppool *w_pool;
+    int w_index;
+    int *w_deque;           /* ready tasks; the worker pushes and pops at */
+    int w_top;              /* the bottom, others steal from the top */
+    int w_bottom;
+    int w_sleeping;         /* true while it is (about to be) on w_wake */
+    t_dspsem w_wake;
+    pthread_t w_thread;
+} t_dspworker;
+
+typedef struct _dsppool
+{
+    t_pdinstance *p_instance;   /* instance the threads run DSP for */
+    int p_nthreads;
+    t_dspworker *p_workers;     /* the first is the caller of dsp_tick() */
+    int p_dequesize;
+    t_dspsched *p_sched;        /* tasks being run in this tick */
+    int p_remaining;            /* tasks still to run in this tick */
+    int p_running;              /* true while the tasks may be taken */
+    int p_busy;                 /* number of workers looking at them */
+    int p_generation;           /* incremented each tick to wake workers */
+    int p_quit;
+    pthread_mutex_t p_mutex;    /* only for handing jobs to the compiler */
+    t_dspjob *p_job;            /* next job for the compiler thread */
+    int p_hascompiler;          /* true if the compiler thread started */
+    pthread_t p_compiler;
+    pthread_cond_t p_jobcond;   /* signaled, with p_mutex, for a new job */
+} t_dsppool;
+
+static void dspworker_push(t_dspworker *w, int task)
+{
+    int b = w->w_bottom;
+    DSP_STORE(w->w_deque[b], task);
+    DSP_STORE(w->w_bottom, b + 1);
+}
+
+static int dspworker_pop(t_dspworker *w)
+{
+    int b = w->w_bottom - 1, t, task;
+    DSP_STORE(w->w_bottom, b);
+    t = DSP_LOAD(w->w_top);
+    if (t > b)
+    {
+        DSP_STORE(w->w_bottom, b + 1);
+        return (-1);
+    }
+    task = w->w_deque[b];
+    if (t == b)
+    {
+            /* last one: race any thief for it */
+        if (!DSP_CAS(w->w_top, t, t + 1))
+            task = -1;
+        DSP_STORE(w->w_bottom, b + 1);
+    }
+    return (task);
+}
+
+static int dspworker_steal(t_dspworker *w)
+{
+    int t = DSP_LOAD(w->w_top), b = DSP_LOAD(w->w_bottom), task;
+    if (t >= b)
+        return (-1);
+    task = DSP_LOAD(w->w_deque[t]);
+    if (!DSP_CAS(w->w_top, t, t + 1))
+        return (-1);
+    return (task);
+}
+
+static void dspworker_run(t_dspworker *w, int task)
+{
+    t_dspsched *x = w->w_pool->p_sched;
+    t_dsptask *t = &x->s_tasks[task];
+    int *range = x->s_ranges + 2 * t->t_range, i;
+    for (i = 0; i < t->t_nrange; i++, range += 2)
+    {
+        t_int *ip = THIS->u_dspchain + range[0],
+            *end = THIS->u_dspchain + range[1];
+        if (THIS->u_profmap)
+            dsp_profilerun(ip, end);
+        else while (ip && ip < end)
+            ip = (*(t_perfroutine)(*ip))(ip);
+    }
+    for (i = 0; i < t->t_nsucc; i++)
+    {
+        int succ = x->s_succ[t->t_succ + i];
+        if (!DSP_ADD(x->s_tasks[succ].t_pending, -1))
+            dspworker_push(w, succ);
+    }
+    DSP_ADD(w->w_pool->p_remaining, -1);
+}
+
+    /* run and steal tasks until all are done */
+static void dspworker_work(t_dspworker *w)
+{
+    t_dsppool *x = w->w_pool;
+    int task, i;
+    while (DSP_LOAD(x->p_remaining) > 0)
+    {
+        if ((task = dspworker_pop(w)) < 0)
+            for (i = 1; i < x->p_nthreads && task < 0; i++)
+                task = dspworker_steal(
+                    &x->p_workers[(w->w_index + i) % x->p_nthreads]);
+        if (task >= 0)
+            dspworker_run(w, task);
+        else DSP_PAUSE();
+    }
+}
+
+static void *dspworker_thread(void *z)
+{
+    t_dspworker *w = (t_dspworker *)z;
+    t_dsppool *x = w->w_pool;
+        /* a new pool starts at generation zero; don't read it here, since
+        dsp_tick() or dsppool_free() may have moved it on before we start */
+    int generation = 0, spins;
+#ifdef PDINSTANCE
+    pd_setinstance(x->p_instance);
+#endif
+#ifdef SCHED_FIFO
+    {
+            /* try for the same real-time priority as sys_set_priority() */
+        struct sched_param par;
+        par.sched_priority = sched_get_priority_max(SCHED_FIFO) - 7;
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &par);
+    }
+#endif
+    while (1)
+    {
+            /* spin for a while since ticks often come back to back,
+            then sleep until the next one */
+        for (spins = 0; spins < DSP_SPINS &&
+            DSP_LOAD(x->p_generation) == generation; spins++)
+                DSP_PAUSE();
+        while (DSP_LOAD(x->p_generation) == generation)
+        {
+                /* say we're going to sleep, then look again; if the tick
+                came in between and dsppool_wake() already took our flag,
+                its post is coming and has to be taken off the semaphore */
+            DSP_STORE(w->w_sleeping, 1);
+            if (DSP_LOAD(x->p_generation) != generation &&
+                DSP_EXCHANGE(w->w_sleeping, 0))
+                    break;
+            dspsem_wait(&w->w_wake);
+        }
+        generation = DSP_LOAD(x->p_generation);
+        if (DSP_LOAD(x->p_quit))
+            break;
+            /* only look at the tasks while dsp_tick() says they're valid */
+        DSP_ADD(x->p_busy, 1);
+        if (DSP_LOAD(x->p_running))
+            dspworker_work(w);
+        DSP_ADD(x->p_busy, -1);
+    }
+    return (0);
+}
+
+    /* make tasks from each job handed over by ugen_finish() and publish
+    them in u_ready for dsp_tick() to take up */
+static void *dspcompiler_thread(void *z)
+{
+    t_dsppool *x = (t_dsppool *)z;
+    struct _instanceugen *u = x->p_instance->pd_ugen;
+    t_dspjob *job;
+    t_dspsched *sched;
+    while (1)
+    {
+        pthread_mutex_lock(&x->p_mutex);
+        while (!x->p_job && !DSP_LOAD(x->p_quit))
+            pthread_cond_wait(&x->p_jobcond, &x->p_mutex);
+        job = x->p_job;
+        x->p_job = 0;
+        pthread_mutex_unlock(&x->p_mutex);
+        if (!job)
+            break;
+        sched = ugen_maketasks(job);
+        free(job);
+            /* drop tasks made earlier which dsp_tick() never took up */
+        if (sched && (sched = DSP_EXCHANGE(u->u_ready, sched)))
+            ugen_freesched(sched);
+    }
+    return (0);
+}
+
+    /* hand a job to the compiler thread, replacing any it hasn't started */
+static void dsppool_compile(t_dsppool *x, t_dspjob *job)
+{
+    t_dspjob *old;
+    if (!x->p_hascompiler)
+    {
+        free(job);
+        return;
+    }
+    pthread_mutex_lock(&x->p_mutex);
+    old = x->p_job;
+    x->p_job = job;
+    pthread_cond_signal(&x->p_jobcond);
+    pthread_mutex_unlock(&x->p_mutex);
+    free(old);
+}
+
+    /* start a new generation and post to the workers asleep; this is
+    called from dsp_tick() so it mustn't take any lock */
+static void dsppool_wake(t_dsppool *x)
+{
+    int i;
+    DSP_ADD(x->p_generation, 1);
+    for (i = 1; i < x->p_nthreads; i++)
+        if (DSP_LOAD(x->p_workers[i].w_sleeping) &&
+            DSP_EXCHANGE(x->p_workers[i].w_sleeping, 0))
+                dspsem_post(&x->p_workers[i].w_wake);
+}
+
+static t_dsppool *dsppool_new(int nthreads)
+{
+    t_dsppool *x = (t_dsppool *)getbytes(sizeof(*x));
+    int i;
+    x->p_instance = pd_this;
+    x->p_nthreads = nthreads;
+    x->p_workers = (t_dspworker *)getbytes(nthreads * sizeof(*x->p_workers));
+    pthread_mutex_init(&x->p_mutex, 0);
+    pthread_cond_init(&x->p_jobcond, 0);
+    if (pthread_create(&x->p_compiler, 0, dspcompiler_thread, x))
+        error("dsp-threads: couldn't start compiler thread");
+    else x->p_hascompiler = 1;
+    for (i = 0; i < nthreads; i++)
+    {
+        x->p_workers[i].w_pool = x;
+        x->p_workers[i].w_index = i;
+    }
+    for (i = 1; i < nthreads; i++)
+    {
+        if (dspsem_init(&x->p_workers[i].w_wake))
+        {
+            error("dsp-threads: couldn't start thread %d", i);
+            x->p_nthreads = i;
+            break;
+        }
+        if (pthread_create(&x->p_workers[i].w_thread, 0,
+            dspworker_thread, &x->p_workers[i]))
+        {
+            dspsem_destroy(&x->p_workers[i].w_wake);
+            error("dsp-threads: couldn't start thread %d", i);
+            x->p_nthreads = i;
+            break;
+        }
+    }
+    return (x);
+}
+
+static void dsppool_free(t_dsppool *x)
+{
+    int i;
+    DSP_STORE(x->p_quit, 1);
+    dsppool_wake(x);
+    for (i = 1; i < x->p_nthreads; i++)
+    {
+        pthread_join(x->p_workers[i].w_thread, 0);
+        dspsem_destroy(&x->p_workers[i].w_wake);
+    }
+    if (x->p_hascompiler)
+    {
+        pthread_mutex_lock(&x->p_mutex);
+        free(x->p_job);
+        x->p_job = 0;
+        pthread_cond_signal(&x->p_jobcond);
+        pthread_mutex_unlock(&x->p_mutex);
+        pthread_join(x->p_compiler, 0);
+    }
+    pthread_mutex_destroy(&x->p_mutex);
+    pthread_cond_destroy(&x->p_jobcond);
+    for (i = 0; i < x->p_nthreads; i++)
+        if (x->p_workers[i].w_deque)
+            freebytes(x->p_workers[i].w_deque,
+                x->p_dequesize * sizeof(int));
+    freebytes(x->p_workers, x->p_nthreads * sizeof(*x->p_workers));
+    freebytes(x, sizeof(*x));
+}
+
+    /* make room for all tasks in each worker's deque */
+static void dsppool_resize(t_dsppool *x, int ntasks)
+{
+    int i;
+    if (ntasks <= x->p_dequesize)
+        return;
+    for (i = 0; i < x->p_nthreads; i++)
+        x->p_workers[i].w_deque = (int *)resizebytes(
+            x->p_workers[i].w_deque, x->p_dequesize * sizeof(int),
+                ntasks * sizeof(int));
+    x->p_dequesize = ntasks;
+}
+
+static void dsppool_tick(t_dsppool *x, t_dspsched *sched)
+{
+    t_dspworker *w = x->p_workers;
+    int i;
+    x->p_sched = sched;
+    for (i = 0; i < x->p_nthreads; i++)
+        w[i].w_top = w[i].w_bottom = 0;
+    for (i = 0; i < sched->s_ntasks; i++)
+        sched->s_tasks[i].t_pending = sched->s_tasks[i].t_npred;
+    for (i = sched->s_nroots; i--; )
+        dspworker_push(w, sched->s_roots[i]);
+    DSP_STORE(x->p_remaining, sched->s_ntasks);
+    DSP_STORE(x->p_running, 1);
+    dsppool_wake(x);
+    dspworker_work(w);
+        /* wait for the other workers to let go of the tasks */
+    DSP_STORE(x->p_running, 0);
+    while (DSP_LOAD(x->p_busy))
+        DSP_PAUSE();
+}
+
+    /* "pd dsp-threads <n>": run DSP on n threads */
+void glob_dspthreads(void *dummy, t_floatarg f)
+{
+    int nthreads = (f < 1 ? 1 : (f > DSP_MAXTHREADS ? DSP_MAXTHREADS : f));
+    if (nthreads == (THIS->u_pool ? THIS->u_pool->p_nthreads : 1))
+        return;
+    if (THIS->u_pool)
+        dsppool_free(THIS->u_pool);
+    ugen_freetasks();
+    THIS->u_pool = (nthreads > 1 ? dsppool_new(nthreads) : 0);
+    canvas_update_dsp();
+}
+
+static t_dspsched *ugen_exchangeready(t_dspsched *x)
+{
+    return (DSP_EXCHANGE(THIS->u_ready, x));
+}
+
+    /* take up tasks the compiler thread has made if they fit the chain */
+static void ugen_takesched(void)
+{
+    t_dspsched *x;
+    if (!DSP_LOAD(THIS->u_ready) || !(x = ugen_exchangeready(0)))
+        return;
+    if (x->s_sortno == THIS->u_sortno)
+    {
+        t_dspsched *old = THIS->u_sched;
+        THIS->u_sched = x;
+        if (THIS->u_loud)
+            post("parallel DSP: %d steps, %d tasks, %d roots",
+                x->s_nsteps, x->s_ntasks, x->s_nroots);
+        x = old;
+    }
+    if (x)
+    {
+        x->s_next = THIS->u_retired;
+        THIS->u_retired = x;
+    }
+}
+
+#else /* UGEN_PARALLEL */
+
+static void dsppool_tick(struct _dsppool *x, t_dspsched *sched) {}
+static void dsppool_free(struct _dsppool *x) {}
+static void dsppool_resize(struct _dsppool *x, int ntasks) {}
+static void ugen_takesched(void) {}
+
+static t_dspsched *ugen_exchangeready(t_dspsched *x)
+{
+    t_dspsched *ret = THIS->u_ready;
+    THIS->u_ready = x;
+    return (ret);
+}
+
+static void dsppool_compile(struct _dsppool *x, t_dspjob *job)
+{
+    THIS->u_ready = ugen_maketasks(job);
+    free(job);
+}
+
+void glob_dspthreads(void *dummy, t_floatarg f)
+{
+    if (f > 1)
+        error("dsp-threads: multithreaded DSP not supported on this platform");
+}
+
+#endif /* UGEN_PARALLEL */
+
 void dsp_tick(void)
 {
     if (THIS->u_dspchain)
     {
         t_int *ip;
-        for (ip = THIS->u_dspchain; ip; ) ip = (*(t_perfroutine)(*ip))(ip);
+        if (THIS->u_pool)
+            ugen_takesched();
+        if (THIS->u_sched)
+            dsppool_tick(THIS->u_pool, THIS->u_sched);
+        else if (THIS->u_profmap)
+            dsp_profilerun(THIS->u_dspchain, 0);
+        else for (ip = THIS->u_dspchain; ip; )
+            ip = (*(t_perfroutine)(*ip))(ip);
+        if (THIS->u_profmap)
+            THIS->u_profticks++;
         THIS->u_phase++;
     }
 }
@@ -440,6 +1683,11 @@ void signal_makereusable(t_signal *sig)
         sig->s_nextfree = THIS->u_freeborrowed;
         THIS->u_freeborrowed = sig;
     }
+    else if (THIS->u_pool)
+    {
+            /* with parallel DSP we don't reuse signal buffers, as that would
+            make otherwise independent steps wait for each other */
+    }
     else
     {
             /* if it's a real signal (not borrowed), put it on the free list
@@ -496,6 +1744,9 @@ t_signal *signal_new(int n, t_float sr)
     ret->s_refcount = 0;
     ret->s_borrowedfrom = 0;
     if (THIS->u_loud) post("new %lx: %lx", ret, ret->s_vec);
+        /* a step recorded for parallel DSP writes all buffers it gets */
+    if (THIS->u_stepping && n)
+        ugen_stepaccess(ret->s_vec, 1);
     return (ret);
 }
 
@@ -572,6 +1823,10 @@ struct _dspcontext
     char dc_toplevel;       /* true if "iosigs" is invalid. */
     char dc_reblock;        /* true if we have to reblock inlets/outlets */
     char dc_switched;       /* true if we're switched */
+    char dc_parallel;       /* true if recording steps for parallel DSP */
+    char dc_cansplit;       /* true if ugen_splitstep() may split them */
+    t_canvas *dc_canvas;    /* canvas being sorted, if known */
+    int dc_profslot;        /* profiling counter for the canvas's own code */
 };
 
 #define t_dspcontext struct _dspcontext
@@ -585,6 +1840,9 @@ t_signal *signal_newfromcontext(int borrowed)
 
 void ugen_stop(void)
 {
+    ugen_freesteps();
+    ugen_freetasks();
+    ugen_freeprofile();
     if (THIS->u_dspchain)
     {
         freebytes(THIS->u_dspchain,
@@ -602,9 +1860,48 @@ void ugen_start(void)
     THIS->u_dspchain = (t_int *)getbytes(sizeof(*THIS->u_dspchain));
     THIS->u_dspchain[0] = (t_int)dsp_done;
     THIS->u_dspchainsize = 1;
+    THIS->u_stepend = 0;
     if (THIS->u_context) bug("ugen_start");
 }
 
+    /* called once all root canvases are sorted: hand a snapshot of the
+    steps to the compiler thread */
+void ugen_finish(void)
+{
+    t_dspjob *job;
+    size_t stepbytes, accessbytes;
+    if (THIS->u_profile)
+        ugen_makeprofmap();
+    if (!THIS->u_pool)
+        return;
+    if (THIS->u_dspchainsize - 1 > THIS->u_stepend)
+        ugen_addstep(THIS->u_stepend, THIS->u_dspchainsize - 1, 1);
+    if (THIS->u_nsteps >= 2)
+    {
+        stepbytes = THIS->u_nsteps * sizeof(*THIS->u_steps);
+        accessbytes = THIS->u_naccess * sizeof(*THIS->u_access);
+            /* without memory for the job, just run the chain serially */
+        if (!(job = (t_dspjob *)malloc(sizeof(*job) + stepbytes +
+            accessbytes)))
+        {
+            error("dsp-threads: out of memory; running serially");
+            ugen_freesteps();
+            return;
+        }
+        job->j_sortno = THIS->u_sortno;
+        job->j_nsteps = THIS->u_nsteps;
+        job->j_naccess = THIS->u_naccess;
+        job->j_access = (t_dspaccess *)(job + 1);
+        job->j_steps = (t_dspstep *)((char *)job->j_access + accessbytes);
+        memcpy(job->j_steps, THIS->u_steps, stepbytes);
+        memcpy(job->j_access, THIS->u_access, accessbytes);
+            /* there are never more tasks than steps */
+        dsppool_resize(THIS->u_pool, THIS->u_nsteps);
+        dsppool_compile(THIS->u_pool, job);
+    }
+    ugen_freesteps();
+}
+
 int ugen_getsortno(void)
 {
     return (THIS->u_sortno);
@@ -651,14 +1948,30 @@ t_dspcontext *ugen_start_graph(int toplevel, t_signal **sp,
 
     dc->dc_ugenlist = 0;
     dc->dc_toplevel = toplevel;
+    dc->dc_parallel = dc->dc_cansplit = 0;
     dc->dc_iosigs = sp;
     dc->dc_ninlets = ninlets;
     dc->dc_noutlets = noutlets;
     dc->dc_parentcontext = THIS->u_context;
+    dc->dc_canvas = 0;
+    dc->dc_profslot = -1;
     THIS->u_context = dc;
     return (dc);
 }
 
+    /* tell which canvas a graph is for, so that profiling can charge its
+    code to it */
+void ugen_setcanvas(t_dspcontext *dc, t_canvas *x)
+{
+    dc->dc_canvas = x;
+    if (THIS->u_profile)
+    {
+        dc->dc_profslot = ugen_newprofslot(0, x, (dc->dc_parentcontext ?
+            dc->dc_parentcontext->dc_profslot : -1));
+        ugen_profmark(dc->dc_profslot);
+    }
+}
+
     /* first the canvas calls this to create all the boxes... */
 void ugen_add(t_dspcontext *dc, t_object *obj)
 {
@@ -766,6 +2079,14 @@ static void ugen_doit(t_dspcontext *dc, t_ugenbox *u)
 
     if (THIS->u_loud) post("doit %s %d %d", class_getname(class), nofreesigs,
         nonewsigs);
+        /* a subcanvas marks its own code when it's sorted */
+    if (THIS->u_profile && class != canvas_class)
+        ugen_profmark(ugen_newprofslot(u->u_obj, dc->dc_canvas,
+            dc->dc_profslot));
+    if (dc->dc_parallel)
+        ugen_beginstep();
+    if (!class_isparalleldsp(class))
+        THIS->u_stepshared = 1;
     for (i = 0, uin = u->u_in; i < u->u_nin; i++, uin++)
     {
         if (!uin->i_nconnect)
@@ -799,6 +2120,9 @@ static void ugen_doit(t_dspcontext *dc, t_ugenbox *u)
         else if (!newrefcount)
             signal_makereusable(*sig);
     }
+    if (THIS->u_stepping)
+        for (sig = insig, i = u->u_nin; i--; sig++)
+            ugen_stepaccess((*sig)->s_vec, 0);
     for (sig = outsig, uout = u->u_out, i = u->u_nout; i--; sig++, uout++)
     {
             /* similarly, for outlets of subcanvases we delay creating
@@ -821,6 +2145,8 @@ static void ugen_doit(t_dspcontext *dc, t_ugenbox *u)
         routine must fill in "borrowed" signal outputs in case it's either
         a subcanvas or a signal inlet. */
     mess1(&u->u_obj->ob_pd, gensym("dsp"), insig);
+    if (THIS->u_profile && dc->dc_profslot >= 0)
+        ugen_profmark(dc->dc_profslot);
 
         /* if any output signals aren't connected to anyone, free them
         now; otherwise they'll either get freed when the reference count
@@ -831,6 +2157,12 @@ static void ugen_doit(t_dspcontext *dc, t_ugenbox *u)
         if (!(*sig)->s_refcount)
             signal_makereusable(*sig);
     }
+        /* outputs are written by the step's last part if it was split */
+    if (THIS->u_stepping)
+        for (sig = outsig, i = u->u_nout; i--; sig++)
+            ugen_stepaccess((*sig)->s_vec, 1);
+    if (dc->dc_parallel)
+        ugen_endstep();
     if (THIS->u_loud)
     {
         if (u->u_nin + u->u_nout == 0) post("put %s %d",
@@ -864,8 +2196,14 @@ static void ugen_doit(t_dspcontext *dc, t_ugenbox *u)
                         class_getname(u->u_obj->ob_pd));
                     return;
                 }
+                if (dc->dc_parallel)
+                    ugen_beginstep();
                 s3 = signal_newlike(s1);
                 dsp_add_plus(s1->s_vec, s2->s_vec, s3->s_vec, s1->s_n);
+                ugen_stepaccess(s1->s_vec, 0);
+                ugen_stepaccess(s2->s_vec, 0);
+                if (dc->dc_parallel)
+                    ugen_endstep();
                 uin->i_signal = s3;
                 s3->s_refcount = 1;
                 if (!s1->s_refcount) signal_makereusable(s1);
@@ -1000,6 +2338,14 @@ void ugen_done_graph(t_dspcontext *dc)
     }
     dc->dc_reblock = reblock;
     dc->dc_switched = switched;
+        /* record the steps of root canvases for parallel DSP.  A root
+        canvas with a block~ wraps all its code in the block~'s prolog and
+        epilog so it can only be run as a whole. */
+    dc->dc_parallel = (THIS->u_pool && !parent_context && !blk);
+        /* and steps may be split unless a block~ would jump over the code */
+    dc->dc_cansplit = (parent_context ?
+        (parent_context->dc_cansplit && !reblock && !switched) :
+            dc->dc_parallel);
     dc->dc_srate = srate;
     dc->dc_vecsize = vecsize;
     dc->dc_calcsize = calcsize;
@@ -1177,6 +2523,33 @@ void ugen_done_graph(t_dspcontext *dc)
 
 }
 
+    /* called from the "dsp" method of an object, like clone, whose code
+    has independent parts: if a step is being recorded for parallel DSP,
+    end it and start another for the next part, which reads the n signals
+    given.  Returns 0 if the code can't be split. */
+int ugen_splitstep(int n, t_signal **sigs)
+{
+    int i;
+    if (!THIS->u_stepping || !THIS->u_context->dc_cansplit)
+        return (0);
+    ugen_endstep();
+    ugen_beginstep();
+    for (i = 0; i < n; i++)
+        ugen_stepaccess(sigs[i]->s_vec, 0);
+    return (1);
+}
+
+    /* and, for a part made by ugen_splitstep(), record that it also writes
+    the n signals given, which it didn't get from signal_new() */
+void ugen_stepwrites(int n, t_signal **sigs)
+{
+    int i;
+    if (!THIS->u_stepping)
+        return;
+    for (i = 0; i < n; i++)
+        ugen_stepaccess(sigs[i]->s_vec, 1);
+}
+
 t_signal *ugen_getiosig(int index, int inout)
 {
     if (!THIS->u_context) bug("ugen_getiosig");
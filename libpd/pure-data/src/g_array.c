@@ -50,14 +50,16 @@ void array_resize(t_array *x, int n)
     if (n < 1)
         n = 1;
     oldn = x->a_n;
-    elemsize = sizeof(t_word) * template->t_n;
+    elemsize = x->a_elemsize;
 
     tmp = (char *)resizebytes(x->a_vec, oldn * elemsize, n * elemsize);
     if (!tmp)
         return;
     x->a_vec = tmp;
     x->a_n = n;
-    if (n > oldn)
+        /* packed arrays (see garray_setpacked()) hold plain floats, which
+        resizebytes() has already zeroed */
+    if (n > oldn && elemsize == sizeof(t_word) * template->t_n)
     {
         char *cp = x->a_vec + elemsize * oldn;
         int i = n - oldn;
@@ -114,6 +116,7 @@ struct _garray
     char x_saveit;          /* true if we should save this with parent */
     char x_listviewing;     /* true if list view window is open */
     char x_hidename;        /* don't print name above graph */
+    char x_packed;          /* true if stored as plain floats */
 };
 
 static t_pd *garray_arraytemplatecanvas;  /* written at setup w/ global lock */
@@ -170,6 +173,7 @@ static t_garray *graph_scalar(t_glist *gl, t_symbol *s, t_symbol *templatesym,
     x->x_usedindsp = 0;
     x->x_saveit = saveit;
     x->x_listviewing = 0;
+    x->x_packed = 0;
     glist_add(gl, &x->x_gobj);
     x->x_glist = gl;
     return (x);
@@ -318,6 +322,8 @@ t_garray *graph_array(t_glist *gl, t_symbol *s, t_symbol *templateargsym,
     if (n <= 0)
         n = 100;
     array_resize(x->x_scalar->sc_vec[zonset].w_array, n);
+    if (flags & 16)
+        garray_setpacked(x, 1);
 
     template_setfloat(template, gensym("style"), x->x_scalar->sc_vec,
         style, 1);
@@ -625,6 +631,7 @@ static void array_getrect(t_array *array, t_glist *glist,
         &elemtemplate, &elemsize, 0, 0, 0, &xonset, &yonset, &wonset))
     {
         int incr;
+        elemsize = array->a_elemsize;   /* less than the template's if packed */
             /* if it has more than 2000 points, just check 300 of them. */
         if (array->a_n < 2000)
             incr = 1;
@@ -715,7 +722,8 @@ void garray_savecontentsto(t_garray *x, t_binbuf *b)
                 chunk = ARRAYWRITECHUNKSIZE;
             binbuf_addv(b, "si", gensym("#A"), n2);
             for (i = 0; i < chunk; i++)
-                binbuf_addv(b, "f", ((t_word *)(array->a_vec))[n2+i].w_float);
+                binbuf_addv(b, "f", *(t_float *)(array->a_vec +
+                    array->a_elemsize * (n2+i)));
             binbuf_addv(b, ";");
             n2 += chunk;
         }
@@ -747,7 +755,7 @@ static void garray_save(t_gobj *z, t_binbuf *b)
         (style == PLOTSTYLE_POLY ? 0 : style));
     binbuf_addv(b, "sssisi;", gensym("#X"), gensym("array"),
         x->x_name, array->a_n, &s_float,
-            x->x_saveit + 2 * filestyle + 8*x->x_hidename);
+            x->x_saveit + 2 * filestyle + 8*x->x_hidename + 16*x->x_packed);
     garray_savecontentsto(x, b);
 }
 
@@ -832,6 +840,12 @@ int garray_getfloatwords(t_garray *x, int *size, t_word **vec)
         error("%s: needs floating-point 'y' field", x->x_realname->s_name);
         return (0);
     }
+    else if (x->x_packed && sizeof(t_word) != sizeof(t_float))
+    {
+        error("%s: packed array can't be accessed as words",
+            x->x_realname->s_name);
+        return (0);
+    }
     else if (elemsize != sizeof(t_word))
     {
         error("%s: has more than one field", x->x_realname->s_name);
@@ -841,11 +855,34 @@ int garray_getfloatwords(t_garray *x, int *size, t_word **vec)
     *vec =  (t_word *)garray_vec(x);
     return (1);
 }
-    /* older, non-64-bit safe version, supplied for older externs */
+
+    /* same for packed or unpacked arrays: point i is (*vec)[i * *stride] */
+int garray_getfloatvec(t_garray *x, int *size, t_float **vec, int *stride)
+{
+    int yonset, elemsize;
+    t_array *a = garray_getarray_floatonly(x, &yonset, &elemsize);
+    if (!a)
+    {
+        error("%s: needs floating-point 'y' field", x->x_realname->s_name);
+        return (0);
+    }
+    else if (elemsize != sizeof(t_word) && !x->x_packed)
+    {
+        error("%s: has more than one field", x->x_realname->s_name);
+        return (0);
+    }
+    *size = garray_npoints(x);
+    *vec =  (t_float *)garray_vec(x);
+    *stride = elemsize / sizeof(t_float);
+    return (1);
+}
+
+    /* older, non-64-bit safe version, supplied for older externs; it
+    works for packed arrays though */
 
 int garray_getfloatarray(t_garray *x, int *size, t_float **vec)
 {
-    if (sizeof(t_word) != sizeof(t_float))
+    if (sizeof(t_word) != sizeof(t_float) && !x->x_packed)
     {
         t_symbol *patchname;
         if (x->x_glist->gl_owner)
@@ -856,9 +893,65 @@ int garray_getfloatarray(t_garray *x, int *size, t_float **vec)
               x->x_name->s_name, patchname->s_name);
         error("failed since it uses garray_getfloatarray while running 64-bit!");
     }
+    else if (x->x_packed)
+    {
+        int stride;
+        return (garray_getfloatvec(x, size, vec, &stride));
+    }
     return (garray_getfloatwords(x, size, (t_word **)vec));
 }
 
+int garray_ispacked(t_garray *x)
+{
+    return (x->x_packed);
+}
+
+    /* store the points as plain floats instead of t_words, which halves
+    their size where pointers are 64 bits and makes them contiguous.  Only
+    objects that use garray_getfloatvec() can access a packed array; the
+    template code (plotting, [get], [element], [array] ...) goes by the
+    array's a_elemsize and works either way. */
+void garray_setpacked(t_garray *x, int packed)
+{
+    int yonset, elemsize, newsize, i;
+    t_array *a = garray_getarray_floatonly(x, &yonset, &elemsize);
+    t_template *template;
+    char *vec;
+    packed = (packed != 0);
+    if (!a)
+    {
+        error("%s: needs floating-point 'y' field", x->x_realname->s_name);
+        return;
+    }
+    if (packed == x->x_packed)
+        return;
+    if (!(template = template_findbyname(a->a_templatesym)) ||
+        template->t_n != 1)
+    {
+        error("%s: only arrays of plain floats can be packed",
+            x->x_realname->s_name);
+        return;
+    }
+    newsize = (packed ? sizeof(t_float) : sizeof(t_word));
+    if (!(vec = (char *)getbytes(a->a_n * newsize)))
+        return;
+    for (i = 0; i < a->a_n; i++)
+        *(t_float *)(vec + newsize * i) =
+            *(t_float *)(a->a_vec + elemsize * i + yonset);
+    freebytes(a->a_vec, a->a_n * elemsize);
+    a->a_vec = vec;
+    a->a_elemsize = newsize;
+    a->a_valid = ++glist_valid;
+    x->x_packed = packed;
+    if (x->x_usedindsp)
+        canvas_update_dsp();
+}
+
+static void garray_packed(t_garray *x, t_floatarg f)
+{
+    garray_setpacked(x, (f != 0));
+}
+
     /* set the "saveit" flag */
 void garray_setsaveit(t_garray *x, int saveit)
 {
@@ -1137,7 +1230,7 @@ static void garray_write(t_garray *x, t_symbol *filename)
     for (i = 0; i < array->a_n; i++)
     {
         if (fprintf(fd, "%g\n",
-            *(t_float *)(((array->a_vec + sizeof(t_word) * i)) + yonset)) < 1)
+            *(t_float *)(((array->a_vec + elemsize * i)) + yonset)) < 1)
         {
             post("%s: write error", filename->s_name);
             break;
@@ -1168,6 +1261,39 @@ void garray_resize_long(t_garray *x, long n)
         canvas_update_dsp();
 }
 
+    /* give the array "n" new points at "vec", laid out as garray_getfloatvec()
+    reports them, "stride" t_floats apart, in memory from calloc() or
+    getbytes() which the array then owns.  This lets soundfiler's "read
+    -async" fill the points in another thread and swap them in at once.
+    Returns 0, leaving "vec" to the caller, if the layout doesn't match. */
+int garray_setvec(t_garray *x, long n, t_float *vec, int stride)
+{
+    int yonset, elemsize, vis = glist_isvisible(x->x_glist);
+    t_array *a = garray_getarray_floatonly(x, &yonset, &elemsize), *a2;
+    t_template *template;
+    if (!a || yonset || n < 1 || elemsize != stride * (int)sizeof(t_float) ||
+        (elemsize != sizeof(t_word) && !x->x_packed) ||
+        !(template = template_findbyname(a->a_templatesym)) ||
+        template->t_n != 1)
+            return (0);
+    garray_fittograph(x, (int)n, template_getfloat(
+        template_findbyname(x->x_scalar->sc_template),
+            gensym("style"), x->x_scalar->sc_vec, 1));
+    for (a2 = a; a2->a_gp.gp_stub->gs_which == GP_ARRAY; )
+        a2 = a2->a_gp.gp_stub->gs_un.gs_array;
+    if (vis)
+        gobj_vis(&a2->a_gp.gp_un.gp_scalar->sc_gobj, x->x_glist, 0);
+    freebytes(a->a_vec, a->a_n * elemsize);
+    a->a_vec = (char *)vec;
+    a->a_n = (int)n;
+    a->a_valid = ++glist_valid;
+    if (vis)
+        gobj_vis(&a2->a_gp.gp_un.gp_scalar->sc_gobj, x->x_glist, 1);
+    if (x->x_usedindsp)
+        canvas_update_dsp();
+    return (1);
+}
+
     /* float version to use as Pd method */
 void garray_resize(t_garray *x, t_floatarg f)
 {
@@ -1182,8 +1308,9 @@ static void garray_zoom(t_garray *x, t_floatarg f)
 static void garray_print(t_garray *x)
 {
     t_array *array = garray_getarray(x);
-    post("garray %s: template %s, length %d",
-        x->x_realname->s_name, array->a_templatesym->s_name, array->a_n);
+    post("garray %s: template %s, length %d%s",
+        x->x_realname->s_name, array->a_templatesym->s_name, array->a_n,
+            (x->x_packed ? " (packed)" : ""));
 }
 
 void g_array_setup(void)
@@ -1214,6 +1341,8 @@ void g_array_setup(void)
         A_FLOAT, A_NULL);
     class_addmethod(garray_class, (t_method)garray_zoom, gensym("zoom"),
         A_FLOAT, 0);
+    class_addmethod(garray_class, (t_method)garray_packed, gensym("packed"),
+        A_FLOAT, 0);
     class_addmethod(garray_class, (t_method)garray_print, gensym("print"),
         A_NULL);
     class_addmethod(garray_class, (t_method)garray_sinesum, gensym("sinesum"),
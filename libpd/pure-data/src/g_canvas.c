@@ -1185,6 +1185,7 @@ EXTERN_STRUCT _dspcontext;
 
 void ugen_start(void);
 void ugen_stop(void);
+void ugen_finish(void);
 
 t_dspcontext *ugen_start_graph(int toplevel, t_signal **sp,
     int ninlets, int noutlets);
@@ -1192,6 +1193,7 @@ void ugen_add(t_dspcontext *dc, t_object *x);
 void ugen_connect(t_dspcontext *dc, t_object *x1, int outno,
     t_object *x2, int inno);
 void ugen_done_graph(t_dspcontext *dc);
+void ugen_setcanvas(t_dspcontext *dc, t_canvas *x);
 
     /* schedule one canvas for DSP.  This is called below for all "root"
     canvases, but is also called from the "dsp" method for sub-
@@ -1212,6 +1214,7 @@ void canvas_dodsp(t_canvas *x, int toplevel, t_signal **sp)
     dc = ugen_start_graph(toplevel, sp,
         obj_nsiginlets(&x->gl_obj),
         obj_nsigoutlets(&x->gl_obj));
+    ugen_setcanvas(dc, x);
 
         /* find all the "dsp" boxes and add them to the graph */
 
@@ -1246,6 +1249,7 @@ static void canvas_start_dsp(void)
 
     for (x = pd_getcanvaslist(); x; x = x->gl_next)
         canvas_dodsp(x, 1, 0);
+    ugen_finish();
 
     canvas_dspstate = THISGUI->i_dspstate = 1;
     if (gensym("pd-dsp-started")->s_thing)
@@ -1880,6 +1884,7 @@ void g_canvas_setup(void)
         by sending 0 for a creator function. */
     canvas_class = class_new(gensym("canvas"), 0,
         (t_method)canvas_free, sizeof(t_canvas), CLASS_NOINLET, 0);
+    class_setparalleldsp(canvas_class);
             /* here is the real creator function, invoked in patch files
             by sending the "canvas" message to #N, which is bound
             to pd_camvasmaker. */
@@ -551,6 +551,7 @@ EXTERN void linetraverser_skipobject(t_linetraverser *t);
 /* --------- functions on garrays (graphical arrays) -------------------- */
 
 EXTERN t_template *garray_template(t_garray *x);
+EXTERN int garray_setvec(t_garray *x, long n, t_float *vec, int stride);
 
 /* -------------------- arrays --------------------- */
 EXTERN t_garray *graph_array(t_glist *gl, t_symbol *s, t_symbol *tmpl,
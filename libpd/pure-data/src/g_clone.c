@@ -59,6 +59,7 @@ typedef struct _clone
     int x_phase;
     int x_startvoice;   /* number of first voice, 0 by default */
     int x_suppressvoice; /* suppress voice number as $1 arg */
+    int x_parallel;     /* compute copies in parallel with "pd dsp-threads" */
 } t_clone;
 
 int clone_match(t_pd *z, t_symbol *name, t_symbol *dir)
@@ -279,6 +280,44 @@ static void clone_loadbang(t_clone *x, t_floatarg f)
 void canvas_dodsp(t_canvas *x, int toplevel, t_signal **sp);
 t_signal *signal_newfromcontext(int borrowed);
 void signal_makereusable(t_signal *sig);
+int ugen_splitstep(int n, t_signal **sigs);
+void ugen_stepwrites(int n, t_signal **sigs);
+
+    /* in parallel mode, each copy's code is a separate part of the DSP chain
+    that can run on its own thread (see d_ugen.c); each copy gets its own
+    output signals, which are summed in the same order as in clone_dsp()
+    below once all copies are done. */
+static void clone_dsp_parallel(t_clone *x, t_signal **sp, int nin, int nout,
+    t_signal **tempsigs)
+{
+    int i, j;
+    t_signal **outsigs =
+        (t_signal **)getbytes(x->x_n * nout * sizeof(*outsigs));
+    for (j = 0; j < x->x_n; j++)
+    {
+        if (j > 0)
+            ugen_splitstep(nin, sp);
+        for (i = 0; i < nout; i++)
+            outsigs[j * nout + i] = tempsigs[2 * nout + nin + i] =
+                signal_newfromcontext(1);
+        canvas_dodsp(x->x_vec[j].c_gl, 0, tempsigs + 2*nout);
+    }
+        /* the sums go into the first copy's outputs */
+    ugen_splitstep(x->x_n * nout, outsigs);
+    ugen_stepwrites(nout, outsigs);
+    for (i = 0; i < nout; i++)
+    {
+        for (j = 1; j < x->x_n; j++)
+        {
+            dsp_add_plus(outsigs[j * nout + i]->s_vec, outsigs[i]->s_vec,
+                outsigs[i]->s_vec, outsigs[i]->s_n);
+            signal_makereusable(outsigs[j * nout + i]);
+        }
+        dsp_add_copy(outsigs[i]->s_vec, sp[nin+i]->s_vec, outsigs[i]->s_n);
+        signal_makereusable(outsigs[i]);
+    }
+    freebytes(outsigs, x->x_n * nout * sizeof(*outsigs));
+}
 
 static void clone_dsp(t_clone *x, t_signal **sp)
 {
@@ -313,6 +352,11 @@ static void clone_dsp(t_clone *x, t_signal **sp)
             use of this input signal but we must add the others. */
         sp[i]->s_refcount += x->x_n-1;
         tempsigs[2 * nout + i] = sp[i];
+    }
+    if (x->x_parallel && ugen_splitstep(nin, sp))
+    {
+        clone_dsp_parallel(x, sp, nin, nout, tempsigs);
+        return;
     }
         /* for first copy, write output to first nout temp sigs */
     for (i = 0; i < nout; i++)
@@ -350,6 +394,7 @@ static void *clone_new(t_symbol *s, int argc, t_atom *argv)
     x->x_outvec = 0;
     x->x_startvoice = 0;
     x->x_suppressvoice = 0;
+    x->x_parallel = 0;
     if (argc == 0)
     {
         x->x_vec = 0;
@@ -368,6 +413,8 @@ static void *clone_new(t_symbol *s, int argc, t_atom *argv)
         }
         else if (!strcmp(argv[0].a_w.w_symbol->s_name, "-x"))
             x->x_suppressvoice = 1, argc--, argv++;
+        else if (!strcmp(argv[0].a_w.w_symbol->s_name, "-p"))
+            x->x_parallel = 1, argc--, argv++;
         else goto usage;
     }
     if (argc >= 2 && (wantn = atom_getfloatarg(0, argc, argv)) >= 0
@@ -422,7 +469,8 @@ static void *clone_new(t_symbol *s, int argc, t_atom *argv)
     canvas_resume_dsp(dspstate);
     return (x);
 usage:
-    error("usage: clone [-s starting-number] <number> <name> [arguments]");
+    error("usage: clone [-s starting-number] [-x] [-p] <number> <name> "
+        "[arguments]");
 fail:
     freebytes(x, sizeof(t_clone));
     canvas_resume_dsp(dspstate);
@@ -433,6 +481,7 @@ void clone_setup(void)
 {
     clone_class = class_new(gensym("clone"), (t_newmethod)clone_new,
         (t_method)clone_free, sizeof(t_clone), CLASS_NOINLET, A_GIMME, 0);
+    class_setparalleldsp(clone_class);
     class_addmethod(clone_class, (t_method)clone_click, gensym("click"),
         A_FLOAT, A_FLOAT, A_FLOAT, A_FLOAT, A_FLOAT, 0);
     class_addmethod(clone_class, (t_method)clone_loadbang, gensym("loadbang"),
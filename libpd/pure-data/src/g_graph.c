@@ -993,8 +993,8 @@ static void graph_motion(void *z, t_floatarg dx, t_floatarg dy)
     t_garray *a = (t_garray *)(x->gl_list);
     int oldx = 0.5 + glist_pixelstox(x, THISGUI->i_graph_lastxpix);
     int newx = 0.5 + glist_pixelstox(x, newxpix);
-    t_word *vec;
-    int nelem, i;
+    t_float *vec;
+    int nelem, stride, i;
     t_float oldy = glist_pixelstoy(x, THISGUI->i_graph_lastypix);
     t_float newy = glist_pixelstoy(x, newypix);
     THISGUI->i_graph_lastxpix = newxpix;
@@ -1002,7 +1002,7 @@ static void graph_motion(void *z, t_floatarg dx, t_floatarg dy)
         /* verify that the array is OK */
     if (!a || pd_class((t_pd *)a) != garray_class)
         return;
-    if (!garray_getfloatwords(a, &nelem, &vec))
+    if (!garray_getfloatvec(a, &nelem, &vec, &stride))
         return;
     if (oldx < 0) oldx = 0;
     if (oldx >= nelem)
@@ -1013,16 +1013,16 @@ static void graph_motion(void *z, t_floatarg dx, t_floatarg dy)
     if (oldx < newx - 1)
     {
         for (i = oldx + 1; i <= newx; i++)
-            vec[i].w_float = newy + (oldy - newy) *
+            vec[i * stride] = newy + (oldy - newy) *
                 ((t_float)(newx - i))/(t_float)(newx - oldx);
     }
     else if (oldx > newx + 1)
     {
         for (i = oldx - 1; i >= newx; i--)
-            vec[i].w_float = newy + (oldy - newy) *
+            vec[i * stride] = newy + (oldy - newy) *
                 ((t_float)(newx - i))/(t_float)(newx - oldx);
     }
-    else vec[newx].w_float = newy;
+    else vec[newx * stride] = newy;
     garray_redraw(a);
 }
 
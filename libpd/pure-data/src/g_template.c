@@ -1644,6 +1644,7 @@ static void plot_getrect(t_gobj *z, t_glist *glist,
     {
             /* if it has more than 2000 points, just check 1000 of them. */
         int incr = (array->a_n <= 2000 ? 1 : array->a_n / 1000);
+        elemsize = array->a_elemsize;   /* less than the template's if packed */
         for (i = 0, xsum = 0; i < array->a_n; i += incr)
         {
             t_float usexloc, useyloc;
@@ -1760,6 +1761,7 @@ static void plot_vis(t_gobj *z, t_glist *glist,
                     return;
     nelem = array->a_n;
     elem = (char *)array->a_vec;
+    elemsize = array->a_elemsize;
 
     if (glist->gl_isgraph)
         linewidth *= glist_getzoom(glist);
@@ -2120,6 +2122,7 @@ static int array_doclick_element(t_array *array, t_glist *glist,
         &elemtemplate, &elemsize, xfield, yfield, wfield,
             &xonset, &yonset, &wonset))
                 return (0);
+    elemsize = array->a_elemsize;
         /* if it has more than 2000 points, just check 300 of them. */
     if (array->a_n < 2000)
         incr = 1;
@@ -2163,6 +2166,7 @@ static int array_doclick(t_array *array, t_glist *glist, t_scalar *sc,
         t_float best = 100;
             /* if it has more than 2000 points, just check 1000 of them. */
         int incr = (array->a_n <= 2000 ? 1 : array->a_n / 1000);
+        elemsize = array->a_elemsize;
         TEMPLATE->array_motion_elemsize = elemsize;
         TEMPLATE->array_motion_glist = glist;
         TEMPLATE->array_motion_scalar = sc;
@@ -2175,7 +2179,7 @@ static int array_doclick(t_array *array, t_glist *glist, t_scalar *sc,
             call "motion" later. */
         if (glist->gl_list && pd_class(&glist->gl_list->g_pd) == garray_class
             && !glist->gl_list->g_next &&
-                elemsize == sizeof(t_word))
+                elemtemplate->t_n == 1)
         {
             int xval = glist_pixelstox(glist, xpix);
             if (xval < 0)
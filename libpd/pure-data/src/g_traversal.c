@@ -897,9 +897,8 @@ static void elem_float(t_elem *x, t_float f)
         return;
     }
 
-    elemsize = elemtemplate->t_n * sizeof(t_word);
-
     array = *(t_array **)(((char *)w) + onset);
+    elemsize = array->a_elemsize;
 
     nitems = array->a_n;
     if (indx < 0) indx = 0;
@@ -1094,11 +1093,13 @@ static void setsize_float(t_setsize *x, t_float f)
         return;
     }
 
-    elemsize = elemtemplate->t_n * sizeof(t_word);
-
     array = *(t_array **)(((char *)w) + onset);
 
-    if (elemsize != array->a_elemsize) bug("setsize_gpointer");
+        /* a packed garray's elements are smaller than the template's */
+    elemsize = array->a_elemsize;
+    if (elemsize != elemtemplate->t_n * sizeof(t_word) &&
+        elemsize != sizeof(t_float))
+            bug("setsize_gpointer");
 
     nitems = array->a_n;
     if (newsize < 1) newsize = 1;
@@ -1137,8 +1138,8 @@ static void setsize_float(t_setsize *x, t_float f)
     array->a_vec = (char *)resizebytes(array->a_vec,
         elemsize * nitems, elemsize * newsize);
     array->a_n = newsize;
-        /* if growing, initialize new scalars */
-    if (newsize > nitems)
+        /* if growing, initialize new scalars (packed floats were zeroed) */
+    if (newsize > nitems && elemsize == elemtemplate->t_n * sizeof(t_word))
     {
         char *elem;
         int count;
@@ -52,6 +52,8 @@ void g_canvas_newpdinstance( void);
 void g_canvas_freepdinstance( void);
 void d_ugen_newpdinstance( void);
 void d_ugen_freepdinstance( void);
+void m_sched_freepdinstance( void);
+void m_memory_freepdinstance( void);
 void new_anything(void *dummy, t_symbol *s, int argc, t_atom *argv);
 
 void s_stuff_newpdinstance( void)
@@ -60,11 +62,18 @@ void s_stuff_newpdinstance( void)
     STUFF->st_externlist = STUFF->st_searchpath =
         STUFF->st_staticpath = STUFF->st_helppath = STUFF->st_temppath = 0;
     STUFF->st_schedblocksize = STUFF->st_blocksize = DEFDACBLKSIZE;
+    STUFF->st_clockheap = 0;
+    STUFF->st_nclocks = STUFF->st_clockheapsize = 0;
+    STUFF->st_clockseq = 0;
+    STUFF->st_mempool = 0;
 }
 
 void s_stuff_freepdinstance( void)
 {
+    m_sched_freepdinstance();
+    m_memory_freepdinstance();
     freebytes(STUFF, sizeof(*STUFF));
+    STUFF = 0;
 }
 
 static t_pdinstance *pdinstance_init(t_pdinstance *x)
@@ -244,7 +253,6 @@ EXTERN void pdinstance_free(t_pdinstance *x)
     g_canvas_freepdinstance();
     d_ugen_freepdinstance();
     s_stuff_freepdinstance();
-    s_inter_freepdinstance();
     for (i = instanceno; i < pd_ninstances-1; i++)
         pd_instances[i] = pd_instances[i+1];
     pd_instances = (t_pdinstance **)resizebytes(pd_instances,
@@ -254,6 +262,8 @@ EXTERN void pdinstance_free(t_pdinstance *x)
     pdinstance_renumber();
     pd_globalunlock();
     sys_unlock();
+        /* the instance's lock lives here so free it only after unlocking */
+    s_inter_freepdinstance();
     pd_setinstance(&pd_maininstance);
 }
 
@@ -481,6 +491,7 @@ t_class *class_new(t_symbol *s, t_newmethod newmethod, t_method freemethod,
     c->c_patchable = (typeflag == CLASS_PATCHABLE);
     c->c_gobj = (typeflag >= CLASS_GOBJ);
     c->c_drawcommand = 0;
+    c->c_paralleldsp = 0;
     c->c_floatsignalin = 0;
     c->c_externdir = class_extern_dir;
     c->c_savefn = (typeflag == CLASS_PATCHABLE ? text_save : class_nosavefn);
@@ -709,6 +720,23 @@ int class_isdrawcommand(const t_class *c)
     return (c->c_drawcommand);
 }
 
+    /* declare that the class's perform routines only touch the object
+    itself and its signal buffers, so that it may be run in parallel with
+    other such objects when DSP is multithreaded ("pd dsp-threads"). */
+void class_setparalleldsp(t_class *c)
+{
+    if(!c)
+        return;
+    c->c_paralleldsp = 1;
+}
+
+int class_isparalleldsp(const t_class *c)
+{
+    if(!c)
+        return 0;
+    return (c->c_paralleldsp);
+}
+
 static void pd_floatforsignal(t_pd *x, t_float f)
 {
     int offset = (*x)->c_floatsignalin;
@@ -18,6 +18,12 @@ over.  Some others are prototyped in m_imp.h as well. */
 void glob_menunew(void *dummy, t_symbol *name, t_symbol *dir);
 void glob_verifyquit(void *dummy, t_floatarg f);
 void glob_dsp(void *dummy, t_symbol *s, int argc, t_atom *argv);
+void glob_dspthreads(void *dummy, t_floatarg f);
+void glob_dspprofile(void *dummy, t_symbol *s, int argc, t_atom *argv);
+void glob_sfthreads(void *dummy, t_floatarg f);
+void glob_fftbackend(void *dummy, t_symbol *s);
+void glob_memorypool(void *dummy, t_floatarg on, t_floatarg reserve);
+void glob_memorystats(void *dummy);
 void glob_meters(void *dummy, t_floatarg f);
 void glob_key(void *dummy, t_symbol *s, int ac, t_atom *av);
 void glob_audiostatus(void *dummy);
@@ -146,6 +152,18 @@ void glob_init(void)
         gensym("verifyquit"), A_DEFFLOAT, 0);
     class_addmethod(glob_pdobject, (t_method)glob_foo, gensym("foo"), A_GIMME, 0);
     class_addmethod(glob_pdobject, (t_method)glob_dsp, gensym("dsp"), A_GIMME, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_dspthreads,
+        gensym("dsp-threads"), A_FLOAT, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_dspprofile,
+        gensym("dsp-profile"), A_GIMME, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_sfthreads,
+        gensym("sf-threads"), A_FLOAT, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_fftbackend,
+        gensym("fft-backend"), A_DEFSYM, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_memorypool,
+        gensym("memory-pool"), A_FLOAT, A_DEFFLOAT, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_memorystats,
+        gensym("memory-stats"), 0);
     class_addmethod(glob_pdobject, (t_method)glob_meters, gensym("meters"),
         A_FLOAT, 0);
     class_addmethod(glob_pdobject, (t_method)glob_key, gensym("key"), A_GIMME, 0);
@@ -57,6 +57,8 @@ struct _class
     char c_patchable;                   /* true if we have a t_object header */
     char c_firstin;                 /* if patchable, true if draw first inlet */
     char c_drawcommand;             /* a drawing command for a template */
+    char c_paralleldsp;             /* DSP touches no state shared with
+                                    other objects, see d_ugen.c */
 };
 
 /* m_pd.c */
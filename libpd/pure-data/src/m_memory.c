@@ -17,10 +17,432 @@
 static int totalmem = 0;
 #endif
 
+/* ------------------------ per-instance memory pool ----------------------- */
+
+/* When an instance's pool is turned on ("pd memory-pool 1"), getbytes() and
+friends serve requests of up to MEMPOOL_MAXSIZE bytes from free lists
+belonging to the current instance, so that once the pool has warmed up (or
+been given a reserve) loading patches or rebuilding the DSP graph makes no
+calls to the system allocator and each allocation takes bounded time.
+Blocks are carved out of "chunks" of MEMPOOL_CHUNKSIZE bytes, each serving
+one size class and aligned to its size, so a block's chunk is found by
+masking the block's address.  A global table of chunk addresses tells
+pooled blocks from malloc()ed ones; this way memory allocated before the
+pool was turned on, or too big for it, is still freed correctly, and the
+size arguments of freebytes() and resizebytes() needn't be trusted.
+Like everything else in an instance, a pool may only be used by the
+thread that holds the instance.  A block freed while a different instance
+(or none) is current is pushed onto a lock-free "remote" list of its own
+pool, which that pool's thread takes back later. */
+
+#if PDTHREADS && (defined(__GNUC__) || defined(__clang__))
+#define MEMPOOL
+#endif
+
+#ifdef MEMPOOL
+#include <pthread.h>
+#include "s_stuff.h"
+
+#define MEMPOOL_CHUNKSIZE 65536
+#define MEMPOOL_HEADER 64       /* room for the t_memchunk at the start */
+#define MEMPOOL_MAXSIZE 8192
+#define MEMPOOL_NCLASSES 32
+
+#define MEM_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define MEM_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define MEM_CAS(p, oldp, v) __atomic_compare_exchange_n((p), (oldp), (v), \
+    1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#define MEM_EXCHANGE(p, v) __atomic_exchange_n((p), (v), __ATOMIC_ACQUIRE)
+
+typedef struct _memblock
+{
+    struct _memblock *b_next;
+} t_memblock;
+
+typedef struct _memchunk
+{
+    struct _mempool *c_pool;
+    struct _memchunk *c_next;   /* next chunk of the class or reserve */
+    int c_class;
+    int c_used;                 /* blocks handed out */
+} t_memchunk;
+
+typedef struct _memclass
+{
+    t_memblock *m_free;         /* blocks given back */
+    char *m_bump;               /* unused part of the newest chunk */
+    char *m_bumpend;
+    t_memchunk *m_chunks;
+    int m_inuse;                /* blocks handed out */
+    int m_peak;
+} t_memclass;
+
+typedef struct _mempool
+{
+    t_memclass p_class[MEMPOOL_NCLASSES];
+    t_memchunk *p_reserve;      /* chunks not yet given a size class */
+    t_memblock *p_remote;       /* blocks freed from other threads */
+    int p_on;                   /* serve getbytes() from the pool */
+    int p_nchunks;              /* chunks in use, not counting reserve */
+    int p_nreserve;
+    unsigned long p_nalloc;     /* blocks allocated */
+    unsigned long p_nfree;      /* blocks freed */
+    unsigned long p_nremote;    /* ... from another thread */
+    unsigned long p_nsystem;    /* calls to the system allocator while on */
+} t_mempool;
+
+    /* global set of chunk addresses, open addressing with linear probing.
+    Readers don't lock: keys are only ever added to empty slots, and a
+    grown table is published atomically while the old one stays valid. */
+#define MEMTABLE_EMPTY 0
+#define MEMTABLE_DELETED 1
+
+typedef struct _memtable
+{
+    int t_size;                 /* power of two */
+    int t_count;                /* used slots including deleted ones */
+    uintptr_t t_keys[1];        /* actually t_size */
+} t_memtable;
+
+static t_memtable *mempool_table;
+static pthread_mutex_t mempool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int mempool_hash(uintptr_t base, int size)
+{
+    return ((int)(((base / MEMPOOL_CHUNKSIZE) * 2654435761u) & (size - 1)));
+}
+
+static t_memchunk *mempool_findchunk(void *ptr)
+{
+    uintptr_t base = (uintptr_t)ptr & ~(uintptr_t)(MEMPOOL_CHUNKSIZE - 1), k;
+    t_memtable *t = MEM_LOAD(&mempool_table);
+    int i;
+    if (!t)
+        return (0);
+    for (i = mempool_hash(base, t->t_size);
+        (k = MEM_LOAD(&t->t_keys[i])) != MEMTABLE_EMPTY;
+            i = (i + 1) & (t->t_size - 1))
+                if (k == base)
+                    return ((t_memchunk *)base);
+    return (0);
+}
+
+    /* add or (if "delete" is set) remove a chunk, with mempool_mutex held */
+static int mempool_register(t_memchunk *c, int delete)
+{
+    uintptr_t base = (uintptr_t)c, k;
+    t_memtable *t = mempool_table;
+    int i;
+    if (delete)
+    {
+        for (i = mempool_hash(base, t->t_size);
+            (k = t->t_keys[i]) != base; i = (i + 1) & (t->t_size - 1))
+                ;
+        MEM_STORE(&t->t_keys[i], (uintptr_t)MEMTABLE_DELETED);
+        return (1);
+    }
+    if (!t || 2 * (t->t_count + 1) > t->t_size)
+    {
+            /* grow (or clean up) the table.  The old one is never freed
+            since other threads may still be looking through it. */
+        int size = (t ? 2 * t->t_size : 256), j;
+        t_memtable *t2 = (t_memtable *)calloc(1,
+            sizeof(t_memtable) + (size - 1) * sizeof(uintptr_t));
+        if (!t2)
+            return (0);
+        t2->t_size = size;
+        if (t) for (j = 0; j < t->t_size; j++)
+        {
+            if ((k = t->t_keys[j]) <= MEMTABLE_DELETED)
+                continue;
+            for (i = mempool_hash(k, size); t2->t_keys[i];
+                i = (i + 1) & (size - 1))
+                    ;
+            t2->t_keys[i] = k;
+            t2->t_count++;
+        }
+        MEM_STORE(&mempool_table, t2);
+        t = t2;
+    }
+    for (i = mempool_hash(base, t->t_size); t->t_keys[i] != MEMTABLE_EMPTY;
+        i = (i + 1) & (t->t_size - 1))
+            ;
+    MEM_STORE(&t->t_keys[i], base);
+    t->t_count++;
+    return (1);
+}
+
+static t_memchunk *mempool_newchunk(t_mempool *p)
+{
+    void *mem;
+    int ok;
+#ifdef _WIN32
+    if (!(mem = _aligned_malloc(MEMPOOL_CHUNKSIZE, MEMPOOL_CHUNKSIZE)))
+        return (0);
+#else
+    if (posix_memalign(&mem, MEMPOOL_CHUNKSIZE, MEMPOOL_CHUNKSIZE))
+        return (0);
+#endif
+    pthread_mutex_lock(&mempool_mutex);
+    ok = mempool_register((t_memchunk *)mem, 0);
+    pthread_mutex_unlock(&mempool_mutex);
+    if (!ok)
+    {
+#ifdef _WIN32
+        _aligned_free(mem);
+#else
+        free(mem);
+#endif
+        return (0);
+    }
+    p->p_nsystem++;
+    ((t_memchunk *)mem)->c_pool = p;
+    return ((t_memchunk *)mem);
+}
+
+static void mempool_freechunk(t_memchunk *c)
+{
+    pthread_mutex_lock(&mempool_mutex);
+    mempool_register(c, 1);
+    pthread_mutex_unlock(&mempool_mutex);
+#ifdef _WIN32
+    _aligned_free(c);
+#else
+    free(c);
+#endif
+}
+
+    /* size classes: multiples of 16 up to 128, then four per octave */
+static int mempool_class(size_t nbytes)
+{
+    int octave;
+    if (nbytes <= 128)
+        return ((int)(nbytes - 1) >> 4);
+    octave = (int)(8 * sizeof(long)) - 1 -
+        __builtin_clzl((unsigned long)(nbytes - 1));
+    return (8 + 4 * (octave - 7) + (int)((nbytes - 1) >> (octave - 2)) - 4);
+}
+
+static size_t mempool_classsize(int class)
+{
+    if (class < 8)
+        return (16 * (class + 1));
+    else return ((size_t)(5 + (class - 8) % 4) << (5 + (class - 8) / 4));
+}
+
+static t_mempool *mempool_current(void)
+{
+#ifdef PDINSTANCE
+    if (!pd_this)   /* a thread that never set an instance */
+        return (0);
+#endif
+    return (pd_this->pd_stuff ? STUFF->st_mempool : 0);
+}
+
+    /* give a block back to its chunk's class; pool thread only */
+static void mempool_release(t_memchunk *c, t_memblock *b)
+{
+    t_memclass *m = &c->c_pool->p_class[c->c_class];
+    b->b_next = m->m_free;
+    m->m_free = b;
+    m->m_inuse--;
+    c->c_used--;
+    c->c_pool->p_nfree++;
+}
+
+    /* take back blocks other threads freed */
+static void mempool_drain(t_mempool *p)
+{
+    t_memblock *b = MEM_EXCHANGE(&p->p_remote, (t_memblock *)0), *next;
+    for (; b; b = next)
+    {
+        next = b->b_next;
+        mempool_release((t_memchunk *)((uintptr_t)b &
+            ~(uintptr_t)(MEMPOOL_CHUNKSIZE - 1)), b);
+    }
+}
+
+static void *mempool_get(t_mempool *p, size_t nbytes)
+{
+    int class = mempool_class(nbytes);
+    t_memclass *m = &p->p_class[class];
+    t_memblock *b;
+    t_memchunk *c;
+    if (!m->m_free && MEM_LOAD(&p->p_remote))
+        mempool_drain(p);
+    if ((b = m->m_free))
+        m->m_free = b->b_next;
+    else
+    {
+        size_t size = mempool_classsize(class);
+        if (m->m_bump == m->m_bumpend)
+        {
+            if ((c = p->p_reserve))
+                p->p_reserve = c->c_next, p->p_nreserve--;
+            else if (!(c = mempool_newchunk(p)))
+                return (0);
+            c->c_class = class;
+            c->c_used = 0;
+            c->c_next = m->m_chunks;
+            m->m_chunks = c;
+            m->m_bump = (char *)c + MEMPOOL_HEADER;
+            m->m_bumpend = m->m_bump +
+                ((MEMPOOL_CHUNKSIZE - MEMPOOL_HEADER) / size) * size;
+            p->p_nchunks++;
+        }
+        b = (t_memblock *)m->m_bump;
+        m->m_bump += size;
+    }
+    ((t_memchunk *)((uintptr_t)b &
+        ~(uintptr_t)(MEMPOOL_CHUNKSIZE - 1)))->c_used++;
+    if (++m->m_inuse > m->m_peak)
+        m->m_peak = m->m_inuse;
+    p->p_nalloc++;
+    memset(b, 0, nbytes);
+    return (b);
+}
+
+static void mempool_put(t_memchunk *c, void *ptr)
+{
+    t_mempool *p = c->c_pool;
+    t_memblock *b = (t_memblock *)ptr;
+    if (p == mempool_current())
+        mempool_release(c, b);
+    else
+    {
+        b->b_next = MEM_LOAD(&p->p_remote);
+        while (!MEM_CAS(&p->p_remote, &b->b_next, b))
+            ;
+        __atomic_fetch_add(&p->p_nremote, 1, __ATOMIC_RELAXED);
+    }
+}
+
+    /* "pd memory-pool <on/off> [reserve]": turn the current instance's pool
+    on or off, optionally setting aside chunks for at least "reserve"
+    kilobytes so that not even the first allocations call malloc(). */
+void glob_memorypool(void *dummy, t_floatarg on, t_floatarg reserve)
+{
+    t_mempool *p = mempool_current();
+    int nreserve = (reserve * 1024 + MEMPOOL_CHUNKSIZE - 1) /
+        MEMPOOL_CHUNKSIZE;
+    if (!p)
+    {
+        if (!on || !pd_this->pd_stuff)
+            return;
+        if (!(p = (t_mempool *)calloc(1, sizeof(*p))))
+        {
+            pd_error(0, "memory-pool: out of memory");
+            return;
+        }
+        STUFF->st_mempool = p;
+    }
+    p->p_on = (on != 0);
+    while (p->p_nreserve < nreserve)
+    {
+        t_memchunk *c = mempool_newchunk(p);
+        if (!c)
+        {
+            pd_error(0, "memory-pool: out of memory");
+            break;
+        }
+        c->c_next = p->p_reserve;
+        p->p_reserve = c;
+        p->p_nreserve++;
+    }
+}
+
+    /* "pd memory-stats": print statistics for the current instance's pool */
+void glob_memorystats(void *dummy)
+{
+    t_mempool *p = mempool_current();
+    int i;
+    if (!p)
+    {
+        post("memory pool: off");
+        return;
+    }
+    if (MEM_LOAD(&p->p_remote))
+        mempool_drain(p);
+    post("memory pool: %s, %d chunks of %dK in use, %d in reserve",
+        (p->p_on ? "on" : "off"), p->p_nchunks, MEMPOOL_CHUNKSIZE / 1024,
+            p->p_nreserve);
+    post("allocations %lu, frees %lu (%lu from other threads), "
+        "system allocations %lu", p->p_nalloc, p->p_nfree,
+            __atomic_load_n(&p->p_nremote, __ATOMIC_RELAXED), p->p_nsystem);
+    for (i = 0; i < MEMPOOL_NCLASSES; i++)
+        if (p->p_class[i].m_peak)
+            post("%6d bytes: %d in use, peak %d", (int)mempool_classsize(i),
+                p->p_class[i].m_inuse, p->p_class[i].m_peak);
+}
+
+    /* called when an instance is deleted.  Chunks that still hold blocks
+    (memory allocated for this instance but shared, for instance by
+    classes) are left alone and stay valid, as does the pool itself. */
+void m_memory_freepdinstance(void)
+{
+    t_mempool *p = mempool_current();
+    t_memchunk *c, *next, *keep;
+    int i;
+    if (!p)
+        return;
+    STUFF->st_mempool = 0;
+    mempool_drain(p);
+    for (c = p->p_reserve; c; c = next)
+        next = c->c_next, mempool_freechunk(c);
+    p->p_reserve = 0;
+    p->p_nreserve = 0;
+    p->p_on = 0;
+    for (i = 0; i < MEMPOOL_NCLASSES; i++)
+    {
+        for (c = p->p_class[i].m_chunks, keep = 0; c; c = next)
+        {
+            next = c->c_next;
+            if (c->c_used)
+                c->c_next = keep, keep = c;
+            else mempool_freechunk(c), p->p_nchunks--;
+        }
+        p->p_class[i].m_chunks = keep;
+        p->p_class[i].m_free = 0;
+        p->p_class[i].m_bump = p->p_class[i].m_bumpend = 0;
+    }
+    if (!p->p_nchunks)
+        free(p);
+}
+
+#else /* MEMPOOL */
+
+void glob_memorypool(void *dummy, t_floatarg on, t_floatarg reserve)
+{
+    if (on)
+        pd_error(0, "memory-pool: not supported in this build");
+}
+
+void glob_memorystats(void *dummy)
+{
+    post("memory pool: not supported in this build");
+}
+
+void m_memory_freepdinstance(void)
+{
+}
+
+#endif /* MEMPOOL */
+
 void *getbytes(size_t nbytes)
 {
     void *ret;
+#ifdef MEMPOOL
+    t_mempool *p = mempool_current();
+#endif
     if (nbytes < 1) nbytes = 1;
+#ifdef MEMPOOL
+    if (p && p->p_on)
+    {
+        if (nbytes <= MEMPOOL_MAXSIZE && (ret = mempool_get(p, nbytes)))
+            return (ret);
+        p->p_nsystem++;
+    }
+#endif
     ret = (void *)calloc(nbytes, 1);
 #ifdef LOUD
     fprintf(stderr, "new  %lx %d\n", (int)ret, nbytes);
@@ -50,8 +472,32 @@ void *copybytes(const void *src, size_t nbytes)
 void *resizebytes(void *old, size_t oldsize, size_t newsize)
 {
     void *ret;
+#ifdef MEMPOOL
+    t_memchunk *c;
+#endif
     if (newsize < 1) newsize = 1;
     if (oldsize < 1) oldsize = 1;
+#ifdef MEMPOOL
+    if (old && (c = mempool_findchunk(old)))
+    {
+        size_t have = mempool_classsize(c->c_class);
+            /* keep the block if the new size still fits */
+        if (newsize <= have)
+        {
+            if (newsize > oldsize)
+                memset(((char *)old) + oldsize, 0, newsize - oldsize);
+            return (old);
+        }
+        if ((ret = getbytes(newsize)))
+        {
+            memcpy(ret, old, (oldsize < have ? oldsize : have));
+            mempool_put(c, old);
+        }
+        return (ret);
+    }
+    else if (!old && (ret = getbytes(newsize)))
+        return (ret);
+#endif
     ret = (void *)realloc((char *)old, newsize);
     if (newsize > oldsize && ret)
         memset(((char *)ret) + oldsize, 0, newsize - oldsize);
@@ -75,6 +521,16 @@ void freebytes(void *fatso, size_t nbytes)
 #endif /* LOUD */
 #ifdef DEBUGMEM
     totalmem -= nbytes;
+#endif
+#ifdef MEMPOOL
+    {
+        t_memchunk *c;
+        if (fatso && (c = mempool_findchunk(fatso)))
+        {
+            mempool_put(c, fatso);
+            return;
+        }
+    }
 #endif
     free(fatso);
 }
@@ -218,9 +218,11 @@ typedef struct _gstack
     struct _gstack *g_next;
 } t_gstack;
 
-static t_gstack *gstack_head = 0;
-static t_pd *lastpopped;
-static t_symbol *pd_loadingabstraction;
+    /* per thread so that instances on separate threads can load patches
+    at the same time */
+static PERTHREAD t_gstack *gstack_head = 0;
+static PERTHREAD t_pd *lastpopped;
+static PERTHREAD t_symbol *pd_loadingabstraction;
 
 int pd_setloadingabstraction(t_symbol *sym)
 {
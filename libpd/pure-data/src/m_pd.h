@@ -381,6 +381,18 @@ EXTERN double clock_gettimesincewithunits(double prevsystime,
 EXTERN double clock_getsystimeafter(double delaytime);
 EXTERN void clock_free(t_clock *x);
 
+/* ------------------  workers --------------- */
+
+EXTERN_STRUCT _worker;
+#define t_worker struct _worker
+typedef void (*t_workmethod)(void *owner, void *job);
+
+EXTERN t_worker *worker_new(void *owner, t_workmethod work,
+    t_workmethod done, int maxjobs);
+EXTERN int worker_submit(t_worker *x, void *job);
+EXTERN void worker_sync(t_worker *x);
+EXTERN void worker_free(t_worker *x);
+
 /* ----------------- pure data ---------------- */
 EXTERN t_pd *pd_new(t_class *cls);
 EXTERN void pd_free(t_pd *x);
@@ -489,6 +501,8 @@ EXTERN const char *class_gethelpname(const t_class *c);
 EXTERN const char *class_gethelpdir(const t_class *c);
 EXTERN void class_setdrawcommand(t_class *c);
 EXTERN int class_isdrawcommand(const t_class *c);
+EXTERN void class_setparalleldsp(t_class *c);
+EXTERN int class_isparalleldsp(const t_class *c);
 EXTERN void class_domainsignalin(t_class *c, int onset);
 EXTERN void class_set_extern_dir(t_symbol *s);
 #define CLASS_MAINSIGNALIN(c, type, field) \
@@ -610,6 +624,7 @@ EXTERN void mayer_fft(int n, t_sample *real, t_sample *imag);
 EXTERN void mayer_ifft(int n, t_sample *real, t_sample *imag);
 EXTERN void mayer_realfft(int n, t_sample *real);
 EXTERN void mayer_realifft(int n, t_sample *real);
+EXTERN int mayer_threadsafe(void);
 
 EXTERN float *cos_table;
 #define LOGCOSTABSIZE 9
@@ -669,6 +684,11 @@ EXTERN_STRUCT _garray;
 EXTERN t_class *garray_class;
 EXTERN int garray_getfloatarray(t_garray *x, int *size, t_float **vec);
 EXTERN int garray_getfloatwords(t_garray *x, int *size, t_word **vec);
+    /* works for packed arrays too: point i is (*vec)[i * (*stride)] */
+EXTERN int garray_getfloatvec(t_garray *x, int *size, t_float **vec,
+    int *stride);
+EXTERN int garray_ispacked(t_garray *x);
+EXTERN void garray_setpacked(t_garray *x, int packed);
 EXTERN void garray_redraw(t_garray *x);
 EXTERN int garray_npoints(t_garray *x);
 EXTERN char *garray_vec(t_garray *x);
@@ -814,7 +834,7 @@ EXTERN_STRUCT _instancestuff;
 struct _pdinstance
 {
     double pd_systime;          /* global time in Pd ticks */
-    t_clock *pd_clock_setlist;  /* list of set clocks */
+    t_clock *pd_clock_setlist;  /* earliest set clock, if any */
     t_canvas *pd_canvaslist;    /* list of all root canvases */
     struct _template *pd_templatelist;  /* list of all templates */
     int pd_instanceno;          /* ordinal number of this instance */
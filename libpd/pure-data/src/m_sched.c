@@ -30,10 +30,27 @@ struct _clock
     double c_settime;       /* in TIMEUNITS; <0 if unset */
     void *c_owner;
     t_clockmethod c_fn;
-    struct _clock *c_next;
+    int c_index;            /* position in the clock heap if set */
     t_float c_unit;         /* >0 if in TIMEUNITS; <0 if in samples */
 };
 
+    /* Set clocks are kept in a binary heap ordered by time, so that setting
+    and unsetting a clock costs O(log n) however many clocks are pending.
+    Clocks set for the same time must go off in the order they were set,
+    so each heap slot also carries a sequence number taken when the clock
+    is set; ties go to the lower one.  The key is copied into the slot so
+    that sifting doesn't have to look at the clocks themselves.  The
+    earliest clock is also kept in pd_clock_setlist. */
+struct _clockslot
+{
+    double s_settime;
+    uint64_t s_seq;
+    t_clock *s_clock;
+};
+
+#define CLOCK_EARLIER(a, b) ((a)->s_settime < (b)->s_settime || \
+    ((a)->s_settime == (b)->s_settime && (a)->s_seq < (b)->s_seq))
+
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -44,50 +61,102 @@ t_clock *clock_new(void *owner, t_method fn)
     x->c_settime = -1;
     x->c_owner = owner;
     x->c_fn = (t_clockmethod)fn;
-    x->c_next = 0;
+    x->c_index = -1;
     x->c_unit = TIMEUNITPERMSEC;
     return (x);
 }
 
+    /* move the slot at "index" toward the root until it's in order */
+static void clock_siftup(struct _clockslot *heap, int index)
+{
+    struct _clockslot slot = heap[index];
+    while (index > 0)
+    {
+        int parent = (index - 1) >> 1;
+        if (!CLOCK_EARLIER(&slot, &heap[parent]))
+            break;
+        heap[index] = heap[parent];
+        heap[index].s_clock->c_index = index;
+        index = parent;
+    }
+    heap[index] = slot;
+    slot.s_clock->c_index = index;
+}
+
+    /* ... and toward the leaves */
+static void clock_siftdown(struct _clockslot *heap, int n, int index)
+{
+    struct _clockslot slot = heap[index];
+    while (1)
+    {
+        int child = 2 * index + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && CLOCK_EARLIER(&heap[child + 1], &heap[child]))
+            child++;
+        if (!CLOCK_EARLIER(&heap[child], &slot))
+            break;
+        heap[index] = heap[child];
+        heap[index].s_clock->c_index = index;
+        index = child;
+    }
+    heap[index] = slot;
+    slot.s_clock->c_index = index;
+}
+
 void clock_unset(t_clock *x)
 {
     if (x->c_settime >= 0)
     {
-        if (x == pd_this->pd_clock_setlist)
-            pd_this->pd_clock_setlist = x->c_next;
-        else
+        struct _clockslot *heap = STUFF->st_clockheap;
+        int index = x->c_index, n = --STUFF->st_nclocks;
+        if (index < n)
         {
-            t_clock *x2 = pd_this->pd_clock_setlist;
-            while (x2->c_next != x) x2 = x2->c_next;
-            x2->c_next = x->c_next;
+            heap[index] = heap[n];
+            if (index > 0 && CLOCK_EARLIER(&heap[index],
+                &heap[(index - 1) >> 1]))
+                    clock_siftup(heap, index);
+            else clock_siftdown(heap, n, index);
         }
+        pd_this->pd_clock_setlist = (n ? heap[0].s_clock : 0);
         x->c_settime = -1;
+        x->c_index = -1;
     }
 }
 
     /* set the clock to call back at an absolute system time */
 void clock_set(t_clock *x, double setticks)
 {
+    struct _clockslot *slot;
     if (setticks < pd_this->pd_systime) setticks = pd_this->pd_systime;
     clock_unset(x);
-    x->c_settime = setticks;
-    if (pd_this->pd_clock_setlist &&
-        pd_this->pd_clock_setlist->c_settime <= setticks)
+    if (STUFF->st_nclocks == STUFF->st_clockheapsize)
     {
-        t_clock *cbefore, *cafter;
-        for (cbefore = pd_this->pd_clock_setlist,
-            cafter = pd_this->pd_clock_setlist->c_next;
-                cbefore; cbefore = cafter, cafter = cbefore->c_next)
-        {
-            if (!cafter || cafter->c_settime > setticks)
-            {
-                cbefore->c_next = x;
-                x->c_next = cafter;
-                return;
-            }
-        }
+        int newsize = (STUFF->st_clockheapsize ?
+            2 * STUFF->st_clockheapsize : 64);
+        STUFF->st_clockheap = (struct _clockslot *)resizebytes(
+            STUFF->st_clockheap,
+                STUFF->st_clockheapsize * sizeof(struct _clockslot),
+                    newsize * sizeof(struct _clockslot));
+        STUFF->st_clockheapsize = newsize;
     }
-    else x->c_next = pd_this->pd_clock_setlist, pd_this->pd_clock_setlist = x;
+    x->c_settime = setticks;
+    slot = &STUFF->st_clockheap[STUFF->st_nclocks];
+    slot->s_settime = setticks;
+    slot->s_seq = STUFF->st_clockseq++;
+    slot->s_clock = x;
+    clock_siftup(STUFF->st_clockheap, STUFF->st_nclocks++);
+    pd_this->pd_clock_setlist = STUFF->st_clockheap[0].s_clock;
+}
+
+    /* free the clock heap when deleting a Pd instance */
+void m_sched_freepdinstance( void)
+{
+    if (STUFF->st_clockheap)
+        freebytes(STUFF->st_clockheap,
+            STUFF->st_clockheapsize * sizeof(struct _clockslot));
+    STUFF->st_clockheap = 0;
+    STUFF->st_nclocks = STUFF->st_clockheapsize = 0;
 }
 
     /* set the clock to call back after a delay in msec */
@@ -165,6 +234,355 @@ void clock_free(t_clock *x)
     freebytes(x, sizeof *x);
 }
 
+/* ------------------------------ workers ------------------------------- */
+
+/* A worker runs an object's jobs in the background, on threads shared by all
+workers, and hands each one back to the object on Pd's thread when it's done.
+Jobs of the same worker are run one at a time and in the order they were
+submitted, so the "work" function may keep state from one job to the next
+without locking; it runs in another thread, though, and so mustn't call Pd
+(no post(), getbytes(), outlets or clocks).  Finished jobs are given to the
+"done" function, again in order, by a clock that looks once per scheduler
+tick, so the results arrive a tick or more after the job was submitted, but
+never in the middle of computing DSP.  Jobs belong to the caller; a worker
+holds at most "maxjobs" of them at once.  worker_sync() waits for all of
+them and hands them back at once, for when the object must change its state
+or run something in its own thread; worker_free() drops any that haven't
+started.  Without threads the work is done at once and only the handing back
+is put off.
+
+Since jobs are submitted from the scheduler, which in libpd is the audio
+thread, worker_submit() neither locks nor allocates: each worker's jobs are
+a ring that only Pd's thread adds to and only the pool's threads take from,
+and a semaphore wakes the pool.  The threads are all started by the first
+worker_new().  The pool's lock is taken only by its own threads, to pick a
+worker to run, and by worker_sync() and worker_free(), which wait anyway. */
+
+#define WORKER_MAXTHREADS 16
+#define WORKER_STACKSIZE (8 << 20)  /* analyses like big arrays on the stack */
+
+    /* the pool needs pthreads and atomics; without, jobs are run at once */
+#if PDTHREADS && (defined(__GNUC__) || defined(__clang__))
+#define WORKER_POOL
+#endif
+
+#ifdef WORKER_POOL
+#define WORKER_LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define WORKER_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#else
+#define WORKER_LOAD(x) (x)
+#define WORKER_STORE(x, v) ((x) = (v))
+#endif
+
+struct _worker
+{
+    void *w_owner;
+    t_workmethod w_work;
+    t_workmethod w_done;
+    t_clock *w_clock;
+    void **w_jobs;          /* ring of w_size jobs, a power of two */
+    int w_size;
+    unsigned int w_head;    /* oldest job not handed back yet (Pd's thread) */
+    unsigned int w_run;     /* next job to run (the pool's threads) */
+    unsigned int w_tail;    /* one past the last job submitted (Pd's thread) */
+    int w_claimed;          /* true while a thread is running a job; locked */
+    struct _worker *w_next; /* next in the pool's list of workers; locked */
+};
+
+#ifdef WORKER_POOL
+#include <pthread.h>
+#include <errno.h>
+#ifdef __APPLE__        /* macOS has no unnamed POSIX semaphores */
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+    /* posted once for each job submitted, and again by a thread that
+    leaves jobs behind in a worker; a thread that wakes up for a job that
+    another thread is already running just waits again */
+#ifdef __APPLE__
+typedef dispatch_semaphore_t t_workersem;
+
+static int workersem_init(t_workersem *s)
+{
+    return (!(*s = dispatch_semaphore_create(0)));
+}
+
+static void workersem_post(t_workersem *s)
+{
+    dispatch_semaphore_signal(*s);
+}
+
+static void workersem_wait(t_workersem *s)
+{
+    dispatch_semaphore_wait(*s, DISPATCH_TIME_FOREVER);
+}
+#else
+typedef sem_t t_workersem;
+
+static int workersem_init(t_workersem *s)
+{
+    return (sem_init(s, 0, 0));
+}
+
+static void workersem_post(t_workersem *s)
+{
+    sem_post(s);
+}
+
+static void workersem_wait(t_workersem *s)
+{
+    while (sem_wait(s) && errno == EINTR)
+        ;
+}
+#endif
+
+static struct _workerpool
+{
+    pthread_mutex_t p_mutex;
+    pthread_cond_t p_donecond;  /* broadcast when a job is done, if waited */
+    t_workersem p_sem;          /* wakes threads to run jobs */
+    t_worker *p_head;           /* all workers, the least recently run first */
+    t_worker *p_tail;
+    int p_started;              /* true once worker_new() started threads */
+    int p_nthreads;             /* threads started; they never exit */
+    int p_nwaiting;             /* number of worker_sync()s etc. waiting */
+} workerpool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+
+static int workerpool_maxthreads(void)
+{
+    int maxthreads;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    maxthreads = info.dwNumberOfProcessors;
+#else
+    maxthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (maxthreads < 1)
+        maxthreads = 1;
+    else if (maxthreads > WORKER_MAXTHREADS)
+        maxthreads = WORKER_MAXTHREADS;
+    return (maxthreads);
+}
+
+    /* put a worker at the end of the list, with the pool locked */
+static void workerpool_append(t_worker *w)
+{
+    w->w_next = 0;
+    if (workerpool.p_tail)
+        workerpool.p_tail->w_next = w;
+    else workerpool.p_head = w;
+    workerpool.p_tail = w;
+}
+
+static void workerpool_unlink(t_worker *w)
+{
+    t_worker *prev = 0, *w2;
+    for (w2 = workerpool.p_head; w2 && w2 != w; prev = w2, w2 = w2->w_next)
+        ;
+    if (!w2)
+        return;
+    if (prev)
+        prev->w_next = w->w_next;
+    else workerpool.p_head = w->w_next;
+    if (workerpool.p_tail == w)
+        workerpool.p_tail = prev;
+}
+
+    /* find the worker that ran least recently of those with jobs that no
+    other thread is running, and claim it, with the pool locked */
+static t_worker *workerpool_claim(void)
+{
+    t_worker *w;
+    for (w = workerpool.p_head; w; w = w->w_next)
+        if (!w->w_claimed && w->w_run != WORKER_LOAD(w->w_tail))
+    {
+        w->w_claimed = 1;
+            /* go to the back of the line so that workers take turns */
+        workerpool_unlink(w);
+        workerpool_append(w);
+        return (w);
+    }
+    return (0);
+}
+
+static void *workerpool_thread(void *dummy)
+{
+    while (1)
+    {
+        t_worker *w;
+        unsigned int run;
+        int more;
+        workersem_wait(&workerpool.p_sem);
+        pthread_mutex_lock(&workerpool.p_mutex);
+        w = workerpool_claim();
+        pthread_mutex_unlock(&workerpool.p_mutex);
+        if (!w)
+            continue;
+        run = w->w_run;
+        (*w->w_work)(w->w_owner, w->w_jobs[run & (w->w_size - 1)]);
+        WORKER_STORE(w->w_run, run + 1);
+
+            /* once it's unclaimed, worker_free() may free it */
+        pthread_mutex_lock(&workerpool.p_mutex);
+        w->w_claimed = 0;
+        more = (run + 1 != WORKER_LOAD(w->w_tail));
+        if (workerpool.p_nwaiting)
+            pthread_cond_broadcast(&workerpool.p_donecond);
+        pthread_mutex_unlock(&workerpool.p_mutex);
+        if (more)
+            workersem_post(&workerpool.p_sem);
+    }
+    return (0);
+}
+
+    /* start all the threads, from the first worker_new(), with the pool
+    locked; they just wait on the semaphore until there are jobs */
+static void workerpool_start(void)
+{
+    int i, n = workerpool_maxthreads();
+    pthread_attr_t attr;
+    workerpool.p_started = 1;
+    if (workersem_init(&workerpool.p_sem))
+    {
+        pd_error(0, "workers: couldn't make a semaphore; running at once");
+        return;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, WORKER_STACKSIZE);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (i = 0; i < n; i++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, workerpool_thread, 0))
+            break;
+    }
+    pthread_attr_destroy(&attr);
+    if (!i)
+        pd_error(0, "workers: couldn't start threads; running at once");
+    workerpool.p_nthreads = i;
+}
+#endif /* WORKER_POOL */
+
+    /* nonzero if any worker runs its jobs in other threads; only called
+    from Pd's thread (see glob_fftbackend()) */
+int worker_threaded(void)
+{
+#ifdef WORKER_POOL
+    int threaded;
+    pthread_mutex_lock(&workerpool.p_mutex);
+    threaded = (workerpool.p_nthreads && workerpool.p_head);
+    pthread_mutex_unlock(&workerpool.p_mutex);
+    return (threaded);
+#else
+    return (0);
+#endif
+}
+
+    /* hand finished jobs back to the owner, oldest first */
+static void worker_deliver(t_worker *x)
+{
+    unsigned int run = WORKER_LOAD(x->w_run);
+    while (x->w_head != run)
+        (*x->w_done)(x->w_owner, x->w_jobs[x->w_head++ & (x->w_size - 1)]);
+}
+
+    /* look for finished jobs once per scheduler tick while any are out */
+static void worker_poll(t_worker *x)
+{
+    worker_deliver(x);
+    if (x->w_head != x->w_tail)
+        clock_delay(x->w_clock, STUFF->st_schedblocksize);
+}
+
+t_worker *worker_new(void *owner, t_workmethod work, t_workmethod done,
+    int maxjobs)
+{
+    t_worker *x = (t_worker *)getbytes(sizeof(*x));
+    x->w_owner = owner;
+    x->w_work = work;
+    x->w_done = done;
+    x->w_clock = clock_new(x, (t_method)worker_poll);
+    clock_setunit(x->w_clock, 1, 1);
+    for (x->w_size = 1; x->w_size < maxjobs; x->w_size <<= 1)
+        ;
+    x->w_jobs = (void **)getbytes(x->w_size * sizeof(*x->w_jobs));
+    x->w_head = x->w_run = x->w_tail = 0;
+    x->w_claimed = 0;
+    x->w_next = 0;
+#ifdef WORKER_POOL
+    pthread_mutex_lock(&workerpool.p_mutex);
+    if (!workerpool.p_started)
+        workerpool_start();
+    workerpool_append(x);
+    pthread_mutex_unlock(&workerpool.p_mutex);
+#endif
+    return (x);
+}
+
+    /* queue a job; returns zero, and does nothing, if the worker already
+    holds as many jobs as it can.  Doesn't lock or allocate. */
+int worker_submit(t_worker *x, void *job)
+{
+    if (x->w_tail - x->w_head >= (unsigned int)x->w_size)
+        return (0);
+    x->w_jobs[x->w_tail & (x->w_size - 1)] = job;
+#ifdef WORKER_POOL
+    if (workerpool.p_nthreads)
+    {
+        WORKER_STORE(x->w_tail, x->w_tail + 1);
+        workersem_post(&workerpool.p_sem);
+    }
+    else
+#endif
+    {
+            /* no threads: do it now, but still hand it back later */
+        x->w_tail++;
+        (*x->w_work)(x->w_owner, job);
+        WORKER_STORE(x->w_run, x->w_run + 1);
+    }
+    if (x->w_head + 1 == x->w_tail)
+        clock_delay(x->w_clock, STUFF->st_schedblocksize);
+    return (1);
+}
+
+    /* wait for all jobs and hand them back now */
+void worker_sync(t_worker *x)
+{
+#ifdef WORKER_POOL
+    pthread_mutex_lock(&workerpool.p_mutex);
+    workerpool.p_nwaiting++;
+    while (WORKER_LOAD(x->w_run) != x->w_tail)
+        pthread_cond_wait(&workerpool.p_donecond, &workerpool.p_mutex);
+    workerpool.p_nwaiting--;
+    pthread_mutex_unlock(&workerpool.p_mutex);
+#endif
+    worker_deliver(x);
+    clock_unset(x->w_clock);
+}
+
+    /* drop jobs that haven't started, wait for one that has, and free */
+void worker_free(t_worker *x)
+{
+#ifdef WORKER_POOL
+    pthread_mutex_lock(&workerpool.p_mutex);
+    workerpool_unlink(x);
+    workerpool.p_nwaiting++;
+    while (x->w_claimed)
+        pthread_cond_wait(&workerpool.p_donecond, &workerpool.p_mutex);
+    workerpool.p_nwaiting--;
+    pthread_mutex_unlock(&workerpool.p_mutex);
+#endif
+    clock_free(x->w_clock);
+    freebytes(x->w_jobs, x->w_size * sizeof(*x->w_jobs));
+    freebytes(x, sizeof(*x));
+}
+
 /* the following routines maintain a real-execution-time histogram of the
 various phases of real-time execution. */
 
@@ -173,7 +591,7 @@ static int sys_bin[] = {0, 2, 5, 10, 20, 30, 50, 100, 1000};
 #define NHIST 10
 static int sys_histogram[NHIST][NBIN];
 static double sys_histtime;
-static int sched_diddsp, sched_didpoll, sched_didnothing;
+static PERTHREAD int sched_diddsp, sched_didpoll, sched_didnothing;
 
 void sys_clearhist( void)
 {
@@ -155,21 +155,40 @@ static void audio_init( void)
 
     /* set channels and sample rate.  */
 
-void sys_setchsr(int chin, int chout, int sr)
+    /* free the adc~/dac~ buffers, which hold st_schedblocksize samples for
+    each channel (or two channels if there are none) */
+static void audio_freebufs(void)
 {
-    int inbytes = (chin ? chin : 2) *
-                (DEFDACBLKSIZE*sizeof(t_sample));
-    int outbytes = (chout ? chout : 2) *
-                (DEFDACBLKSIZE*sizeof(t_sample));
-
+    int blocksize = STUFF->st_schedblocksize;
     if (STUFF->st_soundin)
         freebytes(STUFF->st_soundin,
             (STUFF->st_inchannels? STUFF->st_inchannels : 2) *
-                (DEFDACBLKSIZE*sizeof(t_sample)));
+                (blocksize*sizeof(t_sample)));
     if (STUFF->st_soundout)
         freebytes(STUFF->st_soundout,
             (STUFF->st_outchannels? STUFF->st_outchannels : 2) *
-                (DEFDACBLKSIZE*sizeof(t_sample)));
+                (blocksize*sizeof(t_sample)));
+    STUFF->st_soundin = STUFF->st_soundout = 0;
+}
+
+static void audio_allocbufs(void)
+{
+    int blocksize = STUFF->st_schedblocksize;
+    int inbytes = (STUFF->st_inchannels ? STUFF->st_inchannels : 2) *
+                (blocksize*sizeof(t_sample));
+    int outbytes = (STUFF->st_outchannels ? STUFF->st_outchannels : 2) *
+                (blocksize*sizeof(t_sample));
+
+    STUFF->st_soundin = (t_sample *)getbytes(inbytes);
+    memset(STUFF->st_soundin, 0, inbytes);
+
+    STUFF->st_soundout = (t_sample *)getbytes(outbytes);
+    memset(STUFF->st_soundout, 0, outbytes);
+}
+
+void sys_setchsr(int chin, int chout, int sr)
+{
+    audio_freebufs();
     STUFF->st_inchannels = chin;
     STUFF->st_outchannels = chout;
     STUFF->st_dacsr = sr;
@@ -177,11 +196,7 @@ void sys_setchsr(int chin, int chout, int sr)
     if (sys_advance_samples < DEFDACBLKSIZE)
         sys_advance_samples = DEFDACBLKSIZE;
 
-    STUFF->st_soundin = (t_sample *)getbytes(inbytes);
-    memset(STUFF->st_soundin, 0, inbytes);
-
-    STUFF->st_soundout = (t_sample *)getbytes(outbytes);
-    memset(STUFF->st_soundout, 0, outbytes);
+    audio_allocbufs();
 
     if (sys_verbose)
         post("input channels = %d, output channels = %d",
@@ -189,6 +204,31 @@ void sys_setchsr(int chin, int chout, int sr)
     canvas_resume_dsp(canvas_suspend_dsp());
 }
 
+    /* set the number of samples computed per DSP tick, which is also the
+    top-level signal vector size.  The audio APIs here all exchange
+    DEFDACBLKSIZE samples with the device, so this is only for callers
+    that run the ticks themselves such as libpd.  Returns 0 on success or
+    -1 if blocksize isn't a power of two up to MAXSCHEDBLKSIZE. */
+int sys_setschedblocksize(int blocksize)
+{
+    int dspstate;
+    if (blocksize < 1 || blocksize > MAXSCHEDBLKSIZE ||
+        blocksize != (1 << ilog2(blocksize)))
+    {
+        error("block size %d: must be a power of two from 1 to %d",
+            blocksize, MAXSCHEDBLKSIZE);
+        return (-1);
+    }
+    if (blocksize == STUFF->st_schedblocksize)
+        return (0);
+    dspstate = canvas_suspend_dsp();
+    audio_freebufs();
+    STUFF->st_schedblocksize = blocksize;
+    audio_allocbufs();
+    canvas_resume_dsp(dspstate);
+    return (0);
+}
+
 /* ----------------------- public routines ----------------------- */
 
     /* set audio device settings (after cleaning up the specified device and
@@ -524,7 +564,8 @@ int sys_send_dacs(void)
     {
         int i, n;
         t_sample maxsamp;
-        for (i = 0, n = sys_inchannels * DEFDACBLKSIZE, maxsamp = sys_inmax;
+        for (i = 0, n = sys_inchannels * STUFF->st_schedblocksize,
+            maxsamp = sys_inmax;
             i < n; i++)
         {
             t_sample f = STUFF->st_soundin[i];
@@ -532,7 +573,7 @@ int sys_send_dacs(void)
             else if (-f > maxsamp) maxsamp = -f;
         }
         sys_inmax = maxsamp;
-        for (i = 0, n = STUFF->st_outchannels * DEFDACBLKSIZE,
+        for (i = 0, n = STUFF->st_outchannels * STUFF->st_schedblocksize,
             maxsamp = sys_outmax; i < n; i++)
         {
             t_sample f = STUFF->st_soundout[i];
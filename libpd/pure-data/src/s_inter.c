@@ -1598,7 +1598,10 @@ int sys_trylock( void)
     if (!(ret = pthread_mutex_trylock(&pd_this->pd_inter->i_mutex)))
     {
         if (!(ret = pthread_rwlock_tryrdlock(&sys_rwlock)))
+        {
+            pd_this->pd_islocked = 1;
             return (0);
+        }
         else
         {
             pthread_mutex_unlock(&pd_this->pd_inter->i_mutex);
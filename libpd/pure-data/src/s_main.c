@@ -1378,7 +1378,7 @@ int sys_argparse(int argc, char **argv)
 
 int sys_getblksize(void)
 {
-    return (DEFDACBLKSIZE);
+    return (STUFF->st_schedblocksize);
 }
 
     /* stuff to do, once, after calling sys_argparse() -- which may itself
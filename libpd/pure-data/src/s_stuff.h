@@ -60,6 +60,7 @@ EXTERN void sys_register_loader(loader_t loader);
 #define SENDDACS_SLEPT 2
 
 #define DEFDACBLKSIZE 64
+#define MAXSCHEDBLKSIZE 4096    /* largest sys_setschedblocksize() */
 extern int sys_hipriority;      /* real-time flag, true if priority boosted */
 extern int sys_schedadvance;
 extern int sys_sleepgrain;
@@ -145,6 +146,38 @@ void sys_alsa_do_open_midi(int nmidiindev, int *midiindev,
     int nmidioutdev, int *midioutdev);
 #endif
 
+/* d_soundfile.c: sound file streams for callers that run the ticks */
+EXTERN_STRUCT _sfstream;
+#define t_sfstream struct _sfstream
+EXTERN t_sfstream *soundfile_openwrite(const char *filename, int nchannels,
+    int samplerate, int bytespersample);
+EXTERN t_sfstream *soundfile_openread(const char *filename, int *p_nchannels,
+    int *p_samplerate);
+EXTERN long soundfile_writeframes(t_sfstream *x, t_sample **vecs,
+    long nframes);
+EXTERN long soundfile_readframes(t_sfstream *x, t_sample **vecs, int nvecs,
+    long nframes);
+EXTERN void soundfile_close(t_sfstream *x);
+
+/* d_ugen.c: DSP profiling ("pd dsp-profile") */
+#define DSP_PROFBINS 24
+typedef struct _dspprofile
+{
+    t_object *p_object;         /* object the code is for, or 0 if it's a
+                                canvas's own code */
+    struct _glist *p_canvas;    /* canvas the object is in, or the canvas */
+    uint64_t p_time;            /* nanoseconds spent in perform routines */
+    uint64_t p_calls;           /* number of perform routine calls */
+        /* calls by duration: bin n counts those taking 2^n to 2^(n+1)
+        nanoseconds, the last bin also those taking longer */
+    uint64_t p_hist[DSP_PROFBINS];
+} t_dspprofile;
+EXTERN void dsp_setprofile(int on);
+EXTERN int dsp_getprofile(void);
+EXTERN void dsp_resetprofile(void);
+EXTERN int dsp_getprofiletop(t_dspprofile *vec, int n, int bycanvas,
+    uint64_t *ticks);
+
 /* m_sched.c */
 EXTERN void sys_log_error(int type);
 #define ERR_NOTHING 0
@@ -375,6 +408,7 @@ EXTERN int sys_addhist(int phase);
 EXTERN void sched_tick( void);
 EXTERN void sys_pollmidiqueue(void );
 EXTERN void sys_setchsr(int chin, int chout, int sr);
+EXTERN int sys_setschedblocksize(int blocksize);
 
 EXTERN void inmidi_realtimein(int portno, int cmd);
 EXTERN void inmidi_byte(int portno, int byte);
@@ -409,6 +443,12 @@ struct _instancestuff
     t_sample *st_soundout;
     t_sample *st_soundin;
     double st_time_per_dsp_tick;    /* obsolete - included for GEM?? */
+    void *st_impdata;   /* optional implementation-specific data for libpd, etc */
+    struct _clockslot *st_clockheap;    /* set clocks, see m_sched.c */
+    int st_nclocks;             /* number of clocks in st_clockheap */
+    int st_clockheapsize;       /* allocated size of st_clockheap */
+    uint64_t st_clockseq;       /* orders clocks set for the same time */
+    struct _mempool *st_mempool;    /* memory pool, see m_memory.c */
 };
 
 #define STUFF (pd_this->pd_stuff)
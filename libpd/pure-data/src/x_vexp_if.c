@@ -894,10 +894,11 @@ max_ex_tab(struct expr *expr, fts_symbol_t s, struct ex_ex *arg,
         t_garray *garray;
         int size;
         long indx;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
 
         if (!s || !(garray = (t_garray *)pd_findbyclass(s, garray_class)) ||
-            !garray_getfloatwords(garray, &size, &wvec))
+            !garray_getfloatvec(garray, &size, &wvec, &stride))
         {
                 optr->ex_type = ET_FLT;
                 optr->ex_flt = 0;
@@ -921,7 +922,7 @@ max_ex_tab(struct expr *expr, fts_symbol_t s, struct ex_ex *arg,
         }
         if (indx < 0) indx = 0;
         else if (indx >= size) indx = size - 1;
-        optr->ex_flt = wvec[indx].w_float;
+        optr->ex_flt = wvec[indx * stride];
 #else /* MSP */
         /*
          * table lookup not done for MSP yet
@@ -955,10 +956,11 @@ max_ex_tab_store(struct expr *expr, t_symbol *s, struct ex_ex *arg,
         t_garray *garray;
         int size;
         long indx;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
 
         if (!s || !(garray = (t_garray *)pd_findbyclass(s, garray_class)) ||
-                !garray_getfloatwords(garray, &size, &wvec)) {
+                !garray_getfloatvec(garray, &size, &wvec, &stride)) {
                 optr->ex_type = ET_FLT;
                 optr->ex_flt = 0;
                 if (s)
@@ -990,10 +992,10 @@ max_ex_tab_store(struct expr *expr, t_symbol *s, struct ex_ex *arg,
         *optr = *rval;
         switch (rval->ex_type) {
         case ET_INT:
-                wvec[indx].w_float = rval->ex_int;
+                wvec[indx * stride] = rval->ex_int;
                                 break;
         case ET_FLT:
-                wvec[indx].w_float = rval->ex_flt;
+                wvec[indx * stride] = rval->ex_flt;
                                 break;
         default:
                 pd_error(expr, "expr:bad right value type '%ld'", rval->ex_type);
@@ -1035,9 +1037,9 @@ max_ex_var(struct expr *expr, t_symbol *var, struct ex_ex *optr, int idx)
 #ifdef PD /* this goes to the end of this file as the following functions
            * should be defined in the expr object in MSP
            */
-#define ISTABLE(sym, garray, size, vec)                               \
+#define ISTABLE(sym, garray, size, vec, stride)                       \
 if (!sym || !(garray = (t_garray *)pd_findbyclass(sym, garray_class)) || \
-                !garray_getfloatwords(garray, &size, &vec))  {          \
+                !garray_getfloatvec(garray, &size, &vec, &stride))  {   \
         optr->ex_type = ET_FLT;                                         \
         optr->ex_int = 0;                                               \
         error("no such table '%s'", sym?(sym->s_name):"(null)");                       \
@@ -1053,7 +1055,8 @@ ex_size(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
         t_symbol *s;
         t_garray *garray;
         int size;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
 
         if (argv->ex_type != ET_SYM)
         {
@@ -1065,7 +1068,7 @@ ex_size(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         s = (fts_symbol_t ) argv->ex_ptr;
 
-        ISTABLE(s, garray, size, wvec);
+        ISTABLE(s, garray, size, wvec, stride);
 
         optr->ex_type = ET_INT;
         optr->ex_int = size;
@@ -1081,7 +1084,8 @@ ex_sum(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
         t_symbol *s;
         t_garray *garray;
         int size;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
         t_float sum;
         int indx;
 
@@ -1095,10 +1099,10 @@ ex_sum(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         s = (fts_symbol_t ) argv->ex_ptr;
 
-        ISTABLE(s, garray, size, wvec);
+        ISTABLE(s, garray, size, wvec, stride);
 
         for (indx = 0, sum = 0; indx < size; indx++)
-                sum += wvec[indx].w_float;
+                sum += wvec[indx * stride];
 
         optr->ex_type = ET_FLT;
         optr->ex_flt = sum;
@@ -1115,7 +1119,8 @@ ex_Sum(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
         t_symbol *s;
         t_garray *garray;
         int size;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
         t_float sum;
         long indx, n1, n2;
 
@@ -1129,7 +1134,7 @@ ex_Sum(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         s = (fts_symbol_t ) argv->ex_ptr;
 
-        ISTABLE(s, garray, size, wvec);
+        ISTABLE(s, garray, size, wvec, stride);
 
                 switch((++argv)->ex_type) {
                 case ET_INT:
@@ -1165,7 +1170,7 @@ ex_Sum(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         for (indx = n1, sum = 0; indx <= n2; indx++)
                         if (indx >= 0 && indx < size)
-                                sum += wvec[indx].w_float;
+                                sum += wvec[indx * stride];
 
         optr->ex_type = ET_FLT;
         optr->ex_flt = sum;
@@ -1181,7 +1186,8 @@ ex_avg(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
         t_symbol *s;
         t_garray *garray;
         int size;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
         t_float sum;
         int indx;
 
@@ -1195,10 +1201,10 @@ ex_avg(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         s = (fts_symbol_t ) argv->ex_ptr;
 
-        ISTABLE(s, garray, size, wvec);
+        ISTABLE(s, garray, size, wvec, stride);
 
         for (indx = 0, sum = 0; indx < size; indx++)
-                sum += wvec[indx].w_float;
+                sum += wvec[indx * stride];
 
         optr->ex_type = ET_FLT;
         optr->ex_flt = sum / size;
@@ -1215,7 +1221,8 @@ ex_Avg(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
         t_symbol *s;
         t_garray *garray;
         int size;
-        t_word *wvec;
+        t_float *wvec;
+        int stride;
         t_float sum;
         long indx, n1, n2;
 
@@ -1229,7 +1236,7 @@ ex_Avg(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         s = (fts_symbol_t ) argv->ex_ptr;
 
-        ISTABLE(s, garray, size, wvec);
+        ISTABLE(s, garray, size, wvec, stride);
 
                 switch((++argv)->ex_type) {
                 case ET_INT:
@@ -1265,7 +1272,7 @@ ex_Avg(t_expr *e, long int argc, struct ex_ex *argv, struct ex_ex *optr)
 
         for (indx = n1, sum = 0; indx <= n2; indx++)
                 if (indx >= 0 && indx < size)
-                        sum += wvec[indx].w_float;
+                        sum += wvec[indx * stride];
 
         optr->ex_type = ET_FLT;
         optr->ex_flt = sum / (n2 - n1 + 1);
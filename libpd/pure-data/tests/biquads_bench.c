@@ -0,0 +1,139 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  time a biquads~ against as many biquad~ objects, for banks of 1 to 128
+    filters: the biquad~ objects run one after the other as they would on
+    the DSP chain, and biquads~ is run with each of its kernels (the plain
+    C one, v4 and, if the CPU has AVX2, v8), counting the interleaving
+    and the FPU mode switch it does each block.  Prints nanoseconds per
+    sample per filter and the speedup over biquad~.  Usage:
+        biquads_bench [block size (64)] [milliseconds per test (200)]
+*/
+
+#include "biquads_kernels.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static const int banksizes[] = {1, 4, 8, 13, 32, 128};
+#define NBANKSIZES (sizeof(banksizes) / sizeof(*banksizes))
+
+static double bench_now(void)       /* seconds */
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return ((double)count.QuadPart / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#endif
+}
+
+    /* run nw routines in turn, over and over, for about "seconds"; returns
+    ns per sample of each of nchans filters */
+static double bench_run(t_int (*w)[8], int nw, int nchans, int n,
+    double seconds)
+{
+    double start, elapsed;
+    long count = 0, i, batch = 1 + 100000 / (n * nchans);
+    int j;
+    for (i = 0; i < batch; i++)     /* warm up */
+        for (j = 0; j < nw; j++)
+            filter_run(w[j]);
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < batch; i++)
+            for (j = 0; j < nw; j++)
+                filter_run(w[j]);
+        count += batch;
+    } while ((elapsed = bench_now() - start) < seconds);
+    return (1e9 * elapsed / ((double)count * n * nchans));
+}
+
+    /* nchans biquad~ objects reading and writing vecs */
+static double bench_biquad(int nchans, t_sample **vecs, int n,
+    double seconds)
+{
+    t_sigbiquad *x[MAXCHANS];
+    t_int w[MAXCHANS][8];
+    t_sample *sig[2];
+    double t;
+    int ch;
+    for (ch = 0; ch < nchans; ch++)
+    {
+        x[ch] = filter_newbiquad(ch);
+        sig[0] = vecs[ch];
+        sig[1] = vecs[nchans + ch];
+        filter_dsp(x[ch], (t_method)sigbiquad_dsp, sig, 2, n, w[ch]);
+    }
+    t = bench_run(w, nchans, nchans, n, seconds);
+    for (ch = 0; ch < nchans; ch++)
+        freebytes(x[ch], sizeof(*x[ch]));
+    return (t);
+}
+
+    /* a biquads~ with nchans filters, running kernel k */
+static double bench_biquads(int nchans, const t_bqkernel *k,
+    t_sample **vecs, int n, double seconds)
+{
+    t_sigbiquads *x = filter_newbiquads(nchans);
+    t_int w[1][8];
+    double t;
+    filter_dsp(x, (t_method)sigbiquads_dsp, vecs, 2 * nchans, n, w[0]);
+    x->x_kernel = k->k_kernel;
+    t = bench_run(w, 1, nchans, n, seconds);
+    filter_freebiquads(x);
+    return (t);
+}
+
+int main(int argc, char **argv)
+{
+    int n = (argc > 1 ? atoi(argv[1]) : 64), i;
+    double seconds = (argc > 2 ? atof(argv[2]) : 200) * 0.001;
+    t_sample *bufs, *vecs[2 * MAXCHANS];
+    unsigned int nsize, nkernel;
+    if (n < 1)
+        n = 64;
+        /* ordinary audio: no denormals, NaNs or zeros */
+    bufs = (t_sample *)malloc(2 * MAXCHANS * n * sizeof(t_sample));
+    srand(1);
+    for (i = 0; i < 2 * MAXCHANS * n; i++)
+        bufs[i] = 2.f * rand() / RAND_MAX - 1.f;
+    printf("block size %d, ns per sample per filter "
+        "(speedup over biquad~)\n", n);
+    printf("%-8s %8s", "filters", "biquad~");
+    for (nkernel = 0; nkernel < NBQKERNELS; nkernel++)
+        printf(" %16s", bqkernels[nkernel].k_name);
+    printf("\n");
+    for (nsize = 0; nsize < NBANKSIZES; nsize++)
+    {
+        int nchans = banksizes[nsize];
+        double single;
+        for (i = 0; i < 2 * nchans; i++)
+            vecs[i] = bufs + i * n;
+        single = bench_biquad(nchans, vecs, n, seconds);
+        printf("%-8d %8.3f", nchans, single);
+        for (nkernel = 0; nkernel < NBQKERNELS; nkernel++)
+        {
+            const t_bqkernel *k = &bqkernels[nkernel];
+            double t;
+            if (!filter_canrun(k))
+            {
+                printf(" %16s", "-");
+                continue;
+            }
+            t = bench_biquads(nchans, k, vecs, n, seconds);
+            printf(" %8.3f (%4.1fx)", t, single / t);
+        }
+        printf("\n");
+    }
+    free(bufs);
+    return (0);
+}
@@ -0,0 +1,193 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  shared by biquads_test.c and biquads_bench.c: biquad~ and biquads~ from
+    d_filter.c, compiled in here so that their static functions can be
+    reached.  The objects are made with their "new" functions and their
+    "dsp" methods called on signals of our own; the stub dsp_add() keeps
+    the routine and arguments each asked for, so that they can be run as
+    the DSP chain would run them.  pd_new() and class_new() are just enough
+    to give each object memory of its class's size.
+*/
+
+#include "../src/d_filter.c"
+#include "../src/m_imp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* ------------------------ stubs for Pd ------------------------ */
+
+int pd_compatibilitylevel = 100000;
+t_symbol s_signal;
+
+t_symbol *gensym(const char *s) { return (&s_signal); }
+t_float atom_getfloatarg(int which, int argc, const t_atom *argv)
+{
+    return (which < argc && argv[which].a_type == A_FLOAT ?
+        argv[which].a_w.w_float : 0);
+}
+void *getbytes(size_t nbytes) { return (calloc(1, nbytes)); }
+void *resizebytes(void *x, size_t oldsize, size_t newsize)
+    { return (realloc(x, newsize)); }
+void freebytes(void *x, size_t nbytes) { free(x); }
+t_pd *pd_new(t_class *cls)
+{
+    t_pd *x = (t_pd *)getbytes(cls->c_size);
+    *x = cls;
+    return (x);
+}
+void pd_float(t_pd *x, t_float f) {}
+t_inlet *inlet_new(t_object *owner, t_pd *dest, t_symbol *s1,
+    t_symbol *s2) { return (0); }
+t_outlet *outlet_new(t_object *owner, t_symbol *s) { return (0); }
+t_class *class_new(t_symbol *name, t_newmethod newmethod,
+    t_method freemethod, size_t size, int flags, t_atomtype arg1, ...)
+{
+    t_class *c = (t_class *)getbytes(sizeof(*c));
+    c->c_size = size;
+    return (c);
+}
+void class_addmethod(t_class *c, t_method fn, t_symbol *sel,
+    t_atomtype arg1, ...) {}
+void (class_addlist)(t_class *c, t_method fn) {}
+void class_setparalleldsp(t_class *c) {}
+void class_domainsignalin(t_class *c, int onset) {}
+void pd_error(const void *object, const char *fmt, ...) {}
+
+    /* the last routine a "dsp" method put on the "chain" */
+static t_int filter_chain[8];
+
+void dsp_add(t_perfroutine f, int n, ...)
+{
+    va_list ap;
+    int i;
+    va_start(ap, n);
+    filter_chain[0] = (t_int)f;
+    for (i = 0; i < n; i++)
+        filter_chain[i+1] = va_arg(ap, t_int);
+    va_end(ap);
+}
+
+/* ------------------------ the filters ------------------------ */
+
+#define MAXCHANS 256
+
+    /* biquad~ coefficients (fb1 fb2 ff1 ff2 ff3) for a filter per channel:
+    lowpass, highpass and bandpass in turn, from the "audio EQ cookbook",
+    at frequencies spread from 50 Hz to 15 kHz and Qs from .7 to 8 */
+static void filter_coefs(int ch, t_float *coefs)
+{
+    double f = 50 * pow(1.37, ch % 19), q = 0.7 + (ch % 5) * 1.8;
+    double w0 = 2 * 3.14159265358979 * f / 44100, c = cos(w0),
+        alpha = sin(w0) / (2 * q), a0 = 1 + alpha, b0, b1, b2;
+    switch (ch % 3)
+    {
+    case 0: b0 = b2 = (1 - c) / 2, b1 = 1 - c; break;
+    case 1: b0 = b2 = (1 + c) / 2, b1 = -(1 + c); break;
+    default: b0 = alpha, b1 = 0, b2 = -alpha;
+    }
+    coefs[0] = 2 * c / a0;
+    coefs[1] = -(1 - alpha) / a0;
+    coefs[2] = b0 / a0;
+    coefs[3] = b1 / a0;
+    coefs[4] = b2 / a0;
+}
+
+static void filter_setup(void)
+{
+    static int done;
+    if (!done)
+        d_filter_setup(), done = 1;
+}
+
+    /* a biquad~ for channel "ch" */
+static t_sigbiquad *filter_newbiquad(int ch)
+{
+    t_atom at[5];
+    t_float coefs[5];
+    int i;
+    filter_setup();
+    filter_coefs(ch, coefs);
+    for (i = 0; i < 5; i++)
+        SETFLOAT(&at[i], coefs[i]);
+    return ((t_sigbiquad *)sigbiquad_new(&s_signal, 5, at));
+}
+
+    /* a biquads~ with a filter per channel, set as filter_newbiquad()'s */
+static t_sigbiquads *filter_newbiquads(int nchans)
+{
+    t_atom at[1 + 5 * MAXCHANS];
+    t_float coefs[5];
+    int ch, i;
+    filter_setup();
+    SETFLOAT(&at[0], nchans);
+    for (ch = 0; ch < nchans; ch++)
+    {
+        filter_coefs(ch, coefs);
+        for (i = 0; i < 5; i++)
+            SETFLOAT(&at[1 + 5 * ch + i], coefs[i]);
+    }
+    return ((t_sigbiquads *)sigbiquads_new(&s_signal, 1 + 5 * nchans, at));
+}
+
+static void filter_freebiquads(t_sigbiquads *x)
+{
+    sigbiquads_free(x);
+    freebytes(x, sizeof(*x));
+}
+
+    /* call a "dsp" method on nsig signals of n samples, inputs first, and
+    copy the routine and arguments it chose to w */
+static void filter_dsp(void *x, t_method dsp, t_sample **vecs, int nsig,
+    int n, t_int *w)
+{
+    t_signal sig[2 * MAXCHANS], *sp[2 * MAXCHANS];
+    int i;
+    memset(sig, 0, nsig * sizeof(*sig));
+    for (i = 0; i < nsig; i++)
+    {
+        sig[i].s_n = sig[i].s_vecsize = n;
+        sig[i].s_sr = 44100;
+        sig[i].s_vec = vecs[i];
+        sp[i] = &sig[i];
+    }
+    filter_chain[0] = 0;
+    (*(void (*)(void *, t_signal **))dsp)(x, sp);
+    memcpy(w, filter_chain, sizeof(filter_chain));
+}
+
+#define filter_run(w) ((*(t_perfroutine)(w)[0])(w))
+
+    /* the kernels biquads~ can run, by name; "dsp" is the one its "dsp"
+    method chose */
+typedef struct _bqkernel
+{
+    const char *k_name;
+    t_biquadskernel k_kernel;
+} t_bqkernel;
+
+static const t_bqkernel bqkernels[] =
+{
+    {"scalar", biquads_kernel},
+#ifdef SIMD_V4
+    {"v4", biquads_perfv4},
+#endif
+#ifdef SIMD_AVX2
+    {"v8", biquads_perfv8},
+#endif
+};
+
+#define NBQKERNELS (sizeof(bqkernels) / sizeof(*bqkernels))
+
+    /* whether a kernel can run on this CPU */
+static int filter_canrun(const t_bqkernel *k)
+{
+#ifdef SIMD_AVX2
+    if (k->k_kernel == biquads_perfv8)
+        return (simd_avx2());
+#endif
+    return (1);
+}
@@ -0,0 +1,174 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  check that a biquads~ with 13 filters gives the same bits as 13 biquad~
+    objects with the same coefficients.  Noise goes through both for half
+    a second, then two seconds of silence to let the filters ring out, then
+    noise again, in blocks of several sizes including ones that aren't a
+    multiple of 4 or 8.  Each block size is run with every kernel biquads~
+    has (the one its "dsp" method chooses, the plain C one, and v4 and v8
+    where built and the CPU has them), both with outlets of their own and
+    with each outlet sharing its inlet's signal vector, as Pd may arrange.
+
+    While noise goes in, the results must be identical, and that includes
+    the noise after the silence.  As the filters die away there is one
+    difference, which d_filter.c describes: biquad~ zeroes its state as
+    each new value falls below 2^-63, while the vector kernels let the
+    state go on decaying until the FPU flushes it as a denormal and zero it
+    at the end of the block.  So during the silence, samples that are below
+    2^-58 (some 350 dB down) on both sides may differ; they are counted.
+    Build and run it with "make check" here, without -ffast-math, and
+    without contracting multiply-adds into fused ones, which the compiler
+    could do to biquad~'s loop and not to the vector kernels.
+*/
+
+#include "biquads_kernels.h"
+
+#ifdef __FAST_MATH__
+#error "-ffast-math lets the compiler reorder biquad~'s arithmetic"
+#endif
+
+#define NCHANS 13
+#define SR 44100
+#define NLOUD (SR / 2)          /* samples of noise */
+#define NQUIET (2 * SR)         /* then samples of silence */
+#define NSAMPS (2 * NLOUD + NQUIET)
+#define TINY 3.4694470e-18      /* 2^-58, a little above PD_BIGORSMALL()'s
+                                    2^-63 as outputs sum three terms */
+
+static const int blocksizes[] = {1, 3, 8, 13, 64, 72, 256};
+#define NBLOCKSIZES (sizeof(blocksizes) / sizeof(*blocksizes))
+
+static t_sample *input[NCHANS], *ref[NCHANS], *out[NCHANS];
+static int nfail, ntiny;
+
+static unsigned int bits(t_sample f)
+{
+    unsigned int u;
+    memcpy(&u, &f, sizeof(u));
+    return (u);
+}
+
+    /* the reference: 13 biquad~ objects, one block at a time */
+static void test_reference(int n)
+{
+    t_sigbiquad *x[NCHANS];
+    t_sample inbuf[256], outbuf[256], *vecs[2];
+    t_int w[NCHANS][8];
+    int ch, onset;
+    vecs[0] = inbuf;
+    vecs[1] = outbuf;
+    for (ch = 0; ch < NCHANS; ch++)
+    {
+        x[ch] = filter_newbiquad(ch);
+        filter_dsp(x[ch], (t_method)sigbiquad_dsp, vecs, 2, n, w[ch]);
+    }
+    for (onset = 0; onset + n <= NSAMPS; onset += n)
+        for (ch = 0; ch < NCHANS; ch++)
+    {
+        memcpy(inbuf, input[ch] + onset, n * sizeof(t_sample));
+        filter_run(w[ch]);
+        memcpy(ref[ch] + onset, outbuf, n * sizeof(t_sample));
+    }
+    for (ch = 0; ch < NCHANS; ch++)
+        freebytes(x[ch], sizeof(*x[ch]));
+}
+
+    /* a biquads~ with the given kernel (or the one it chose if none),
+    outlets sharing the inlets' vectors if "inplace" is set */
+static void test_bank(const t_bqkernel *k, int n, int inplace)
+{
+    t_sigbiquads *x = filter_newbiquads(NCHANS);
+    t_sample *bufs = (t_sample *)malloc(2 * NCHANS * n * sizeof(t_sample)),
+        *vecs[2 * NCHANS];
+    t_int w[8];
+    int ch, onset;
+    for (ch = 0; ch < NCHANS; ch++)
+    {
+        vecs[ch] = bufs + ch * n;
+        vecs[NCHANS + ch] = (inplace ? vecs[ch] : bufs + (NCHANS + ch) * n);
+    }
+    filter_dsp(x, (t_method)sigbiquads_dsp, vecs, 2 * NCHANS, n, w);
+    if (k)
+        x->x_kernel = k->k_kernel;
+    for (onset = 0; onset + n <= NSAMPS; onset += n)
+    {
+        for (ch = 0; ch < NCHANS; ch++)
+            memcpy(vecs[ch], input[ch] + onset, n * sizeof(t_sample));
+        filter_run(w);
+        for (ch = 0; ch < NCHANS; ch++)
+            memcpy(out[ch] + onset, vecs[NCHANS + ch], n * sizeof(t_sample));
+    }
+    free(bufs);
+    filter_freebiquads(x);
+}
+
+static void test_compare(const char *name, int n, int inplace)
+{
+    int ch, i, bad = 0;
+    for (ch = 0; ch < NCHANS; ch++)
+        for (i = 0; i < NSAMPS - NSAMPS % n; i++)
+    {
+        if (!memcmp(&ref[ch][i], &out[ch][i], sizeof(t_sample)))
+            continue;
+        if (i >= NLOUD && i < NLOUD + NQUIET &&
+            fabs(ref[ch][i]) < TINY && fabs(out[ch][i]) < TINY)
+        {
+            ntiny++;
+            continue;
+        }
+        if (bad++ < 4)
+            fprintf(stderr, "%s%s, n %d, channel %d, sample %d: "
+                "%08x (%g), expected %08x (%g)\n", name,
+                (inplace ? " in place" : ""), n, ch, i, bits(out[ch][i]),
+                out[ch][i], bits(ref[ch][i]), ref[ch][i]);
+    }
+    if (bad)
+        nfail++;
+    printf("%-8s %-9s n %-4d %s\n", name, (inplace ? "in place" : ""), n,
+        (bad ? "FAILED" : "ok"));
+}
+
+int main(void)
+{
+    unsigned int nsize, nkernel;
+    int ch, i, inplace;
+    srand(1);
+    for (ch = 0; ch < NCHANS; ch++)
+    {
+        input[ch] = (t_sample *)malloc(NSAMPS * sizeof(t_sample));
+        ref[ch] = (t_sample *)malloc(NSAMPS * sizeof(t_sample));
+        out[ch] = (t_sample *)malloc(NSAMPS * sizeof(t_sample));
+        for (i = 0; i < NSAMPS; i++)
+            input[ch][i] = (i < NLOUD || i >= NLOUD + NQUIET ?
+                2.f * rand() / RAND_MAX - 1.f : 0);
+    }
+    for (nkernel = 0; nkernel < NBQKERNELS; nkernel++)
+        if (!filter_canrun(&bqkernels[nkernel]))
+            printf("%s: not run, not supported by this CPU\n",
+                bqkernels[nkernel].k_name);
+    for (nsize = 0; nsize < NBLOCKSIZES; nsize++)
+    {
+        int n = blocksizes[nsize];
+        test_reference(n);
+        for (inplace = 0; inplace < 2; inplace++)
+        {
+            test_bank(0, n, inplace);
+            test_compare("dsp", n, inplace);
+            for (nkernel = 0; nkernel < NBQKERNELS; nkernel++)
+                if (filter_canrun(&bqkernels[nkernel]))
+            {
+                test_bank(&bqkernels[nkernel], n, inplace);
+                test_compare(bqkernels[nkernel].k_name, n, inplace);
+            }
+        }
+    }
+    if (ntiny)
+        printf("%d samples below 2^-58 differed as the filters died away\n",
+            ntiny);
+    printf("%s\n", (nfail ? "FAILED" : "all ok"));
+    for (ch = 0; ch < NCHANS; ch++)
+        free(input[ch]), free(ref[ch]), free(out[ch]);
+    return (nfail != 0);
+}
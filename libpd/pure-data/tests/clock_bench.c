@@ -0,0 +1,300 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  time the clock heap of m_sched.c with many clocks set at once, against
+    the sorted list Pd used to keep them in (copied below as "list_set" and
+    "list_unset").  Two tests, both with every clock set all the time:
+        delay: re-set clocks picked at random to random delays, as
+            retriggered [delay] and [pipe] objects do;
+        tick: let each clock go off and set itself again after its own
+            period, as [metro] does, and run sched_tick() as the
+            scheduler would.
+    Prints nanoseconds per clock set (delay) or per clock gone off (tick)
+    and the speedup over the list.  Usage:
+        clock_bench [number of clocks (10000)] [milliseconds per test (500)]
+    m_sched.c is compiled in, so the rest of Pd is stubbed out.
+*/
+
+#include "../src/m_sched.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* ------------------------ stubs for Pd ------------------------ */
+
+static struct _instancestuff bench_stuff;
+t_pdinstance pd_maininstance;
+int sys_hipriority, sys_schedadvance;
+
+void *getbytes(size_t nbytes) { return (calloc(1, nbytes)); }
+void *resizebytes(void *x, size_t oldsize, size_t newsize)
+    { return (realloc(x, newsize)); }
+void freebytes(void *x, size_t nbytes) { free(x); }
+void post(const char *fmt, ...) {}
+void pd_error(const void *object, const char *fmt, ...) {}
+void sys_vgui(char *fmt, ...) {}
+t_float rmstodb(t_float f) { return (0); }
+void outlet_setstacklim(void) {}
+void dsp_tick(void) {}
+int audio_isopen(void) { return (0); }
+void sys_close_audio(void) {}
+void sys_reopen_audio(void) {}
+int sys_send_dacs(void) { return (0); }
+void sys_getmeters(t_sample *inmax, t_sample *outmax) {}
+void sys_reportidle(void) {}
+void sys_setmiditimediff(double inbuftime, double outbuftime) {}
+void sys_initmidiqueue(void) {}
+void sys_pollmidiqueue(void) {}
+int sys_pollgui(void) { return (0); }
+int sys_havegui(void) { return (0); }
+void sys_microsleep(int microsec) {}
+double sys_getrealtime(void) { return (0); }
+void sys_lock(void) {}
+void sys_unlock(void) {}
+void glob_watchdog(t_pd *dummy) {}
+
+/* ------------- the sorted list, as m_sched.c used to have it ------------- */
+
+typedef struct _listclock
+{
+    double c_settime;
+    double c_period;
+    struct _listclock *c_next;
+} t_listclock;
+
+static t_listclock *list_setlist;
+
+static void list_unset(t_listclock *x)
+{
+    if (x->c_settime >= 0)
+    {
+        if (x == list_setlist)
+            list_setlist = x->c_next;
+        else
+        {
+            t_listclock *x2 = list_setlist;
+            while (x2->c_next != x) x2 = x2->c_next;
+            x2->c_next = x->c_next;
+        }
+        x->c_settime = -1;
+    }
+}
+
+static void list_set(t_listclock *x, double setticks)
+{
+    if (setticks < pd_this->pd_systime) setticks = pd_this->pd_systime;
+    list_unset(x);
+    x->c_settime = setticks;
+    if (list_setlist && list_setlist->c_settime <= setticks)
+    {
+        t_listclock *cbefore, *cafter;
+        for (cbefore = list_setlist, cafter = list_setlist->c_next;
+            cbefore; cbefore = cafter, cafter = cbefore->c_next)
+        {
+            if (!cafter || cafter->c_settime > setticks)
+            {
+                cbefore->c_next = x;
+                x->c_next = cafter;
+                return;
+            }
+        }
+    }
+    else x->c_next = list_setlist, list_setlist = x;
+}
+
+    /* sched_tick() with the list */
+static void list_tick(long *nfired)
+{
+    double next_sys_time = pd_this->pd_systime +
+        (STUFF->st_schedblocksize/STUFF->st_dacsr) * TIMEUNITPERSECOND;
+    while (list_setlist && list_setlist->c_settime < next_sys_time)
+    {
+        t_listclock *c = list_setlist;
+        pd_this->pd_systime = c->c_settime;
+        list_unset(c);
+        list_set(c, pd_this->pd_systime + c->c_period);
+        (*nfired)++;
+    }
+    pd_this->pd_systime = next_sys_time;
+}
+
+/* ------------------------ the benchmark ------------------------ */
+
+static double bench_now(void)       /* seconds */
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return ((double)count.QuadPart / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#endif
+}
+
+typedef struct _metro
+{
+    t_clock *m_clock;
+    double m_period;        /* msec */
+    long *m_nfired;
+} t_metro;
+
+static void metro_tick(t_metro *x)
+{
+    clock_delay(x->m_clock, x->m_period);
+    (*x->m_nfired)++;
+}
+
+    /* random delays from 1 to 1000 msec, made up front so that rand()
+    isn't timed */
+#define NDELAY 4096
+static double bench_delay[NDELAY];
+static int *bench_pick;
+
+static void bench_reset(void)
+{
+    pd_this->pd_systime = 0;
+    list_setlist = 0;
+}
+
+    /* ns per clock_delay() or list_set() with n clocks set */
+static double bench_delay_heap(t_metro *m, int n, double seconds)
+{
+    double start, elapsed;
+    long count = 0, i;
+    for (i = 0; i < n; i++)
+        clock_delay(m[i].m_clock, bench_delay[i % NDELAY]);
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < NDELAY; i++)
+            clock_delay(m[bench_pick[i]].m_clock,
+                bench_delay[(i + count) % NDELAY]);
+        count += NDELAY;
+    } while ((elapsed = bench_now() - start) < seconds);
+    for (i = 0; i < n; i++)
+        clock_unset(m[i].m_clock);
+    return (1e9 * elapsed / count);
+}
+
+static double bench_delay_list(t_listclock *l, int n, double seconds)
+{
+    double start, elapsed;
+    long count = 0, i;
+    for (i = 0; i < n; i++)
+        list_set(&l[i], pd_this->pd_systime +
+            TIMEUNITPERMSEC * bench_delay[i % NDELAY]);
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < NDELAY; i++)
+            list_set(&l[bench_pick[i]], pd_this->pd_systime +
+                TIMEUNITPERMSEC * bench_delay[(i + count) % NDELAY]);
+        count += NDELAY;
+    } while ((elapsed = bench_now() - start) < seconds);
+    for (i = 0; i < n; i++)
+        list_unset(&l[i]);
+    return (1e9 * elapsed / count);
+}
+
+    /* ns per clock gone off, with n metros going */
+static double bench_tick_heap(t_metro *m, int n, double seconds,
+    long *nfired)
+{
+    double start, elapsed;
+    long i;
+    for (i = 0; i < n; i++)
+        clock_delay(m[i].m_clock, m[i].m_period);
+    *nfired = 0;
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < 100; i++)
+            sched_tick();
+    } while ((elapsed = bench_now() - start) < seconds);
+    for (i = 0; i < n; i++)
+        clock_unset(m[i].m_clock);
+    return (*nfired ? 1e9 * elapsed / *nfired : 0);
+}
+
+static double bench_tick_list(t_listclock *l, int n, double seconds,
+    long *nfired)
+{
+    double start, elapsed;
+    long i;
+    for (i = 0; i < n; i++)
+        list_set(&l[i], pd_this->pd_systime + l[i].c_period);
+    *nfired = 0;
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < 100; i++)
+            list_tick(nfired);
+    } while ((elapsed = bench_now() - start) < seconds);
+    for (i = 0; i < n; i++)
+        list_unset(&l[i]);
+    return (*nfired ? 1e9 * elapsed / *nfired : 0);
+}
+
+int main(int argc, char **argv)
+{
+    int n = (argc > 1 ? atoi(argv[1]) : 10000), i;
+    double seconds = (argc > 2 ? atof(argv[2]) : 500) * 0.001;
+    double heap, list;
+    long nfired;
+    t_metro *m;
+    t_listclock *l;
+    if (n < 1)
+        n = 10000;
+    pd_maininstance.pd_stuff = &bench_stuff;
+    STUFF->st_dacsr = 44100;
+    STUFF->st_schedblocksize = DEFDACBLKSIZE;
+    srand(1);
+    for (i = 0; i < NDELAY; i++)
+        bench_delay[i] = 1 + 999. * rand() / RAND_MAX;
+    bench_pick = (int *)malloc(NDELAY * sizeof(*bench_pick));
+    for (i = 0; i < NDELAY; i++)
+        bench_pick[i] = rand() % n;
+    m = (t_metro *)malloc(n * sizeof(*m));
+    l = (t_listclock *)malloc(n * sizeof(*l));
+    for (i = 0; i < n; i++)
+    {
+        m[i].m_clock = clock_new(&m[i], (t_method)metro_tick);
+        m[i].m_period = bench_delay[i % NDELAY];
+        m[i].m_nfired = &nfired;
+        l[i].c_settime = -1;
+        l[i].c_period = TIMEUNITPERMSEC * m[i].m_period;
+        l[i].c_next = 0;
+    }
+    printf("%d clocks, ns per clock (speedup over list)\n", n);
+    printf("%-8s %10s %10s\n", "test", "list", "heap");
+
+    bench_reset();
+    list = bench_delay_list(l, n, seconds);
+    bench_reset();
+    heap = bench_delay_heap(m, n, seconds);
+    printf("%-8s %10.1f %10.1f (%.1fx)\n", "delay", list, heap, list/heap);
+
+    bench_reset();
+    list = bench_tick_list(l, n, seconds, &nfired);
+    bench_reset();
+    heap = bench_tick_heap(m, n, seconds, &nfired);
+    printf("%-8s %10.1f %10.1f (%.1fx)\n", "tick", list, heap, list/heap);
+
+    for (i = 0; i < n; i++)
+        clock_free(m[i].m_clock);
+    m_sched_freepdinstance();
+    free(m);
+    free(l);
+    free(bench_pick);
+    return (0);
+}
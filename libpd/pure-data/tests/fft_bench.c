@@ -0,0 +1,101 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  time the vector FFT of d_fft_simd.c against Ooura for every power of
+    two from 64 to 65536 points: mayer_realfft() and mayer_realifft(), as
+    rfft~ and rifft~ use them, and the complex mayer_fft() of fft~.  Each
+    transform is run over and over on a copy of the same noise.  Prints
+    microseconds per transform and the speedup over Ooura.  Usage:
+        fft_bench [milliseconds per test (200)]
+*/
+
+#include "fft_kernels.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_MINLOG 6      /* 64 points */
+
+static const int bench_kinds[] = {FFT_REAL, FFT_IREAL, FFT_COMPLEX};
+#define NBENCHKINDS (sizeof(bench_kinds) / sizeof(*bench_kinds))
+
+static double bench_now(void)       /* seconds */
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return ((double)count.QuadPart / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#endif
+}
+
+    /* microseconds per transform of n points with Ooura (simd = 0) or the
+    vector FFT (1), or with simd = -1 per copy of its input alone.  Each
+    transform starts from a fresh copy of the input, so that transforming
+    the output over and over doesn't blow it up to infinity; the time of
+    the copy is taken off afterward */
+static double bench_run(int kind, int simd, const t_sample *in,
+    t_sample *buf, int n, double seconds)
+{
+    double start, elapsed;
+    long count = 0, i, batch = 1 + 1000000 / (n * (FFT_MAXLOG + 1));
+    int nvalues = fft_nvalues(kind, n);
+    if (simd >= 0)
+        fft_run(kind, simd, buf, n);    /* warm up, making the plan */
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < batch; i++)
+        {
+            memcpy(buf, in, nvalues * sizeof(t_sample));
+            if (simd >= 0)
+                fft_run(kind, simd, buf, n);
+        }
+        count += batch;
+    } while ((elapsed = bench_now() - start) < seconds);
+    return (1e6 * elapsed / count);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = (argc > 1 ? atof(argv[1]) : 200) * 0.001;
+    int nmax = 2 << FFT_MAXLOG, logn, i;
+    unsigned int nkind;
+    t_sample *in = (t_sample *)malloc(nmax * sizeof(t_sample)),
+        *buf = (t_sample *)malloc(nmax * sizeof(t_sample));
+    if (seconds <= 0)
+        seconds = 0.2;
+    srand(1);
+    for (i = 0; i < nmax; i++)
+        in[i] = 2.f * rand() / RAND_MAX - 1.f;
+    printf("vector FFT passes: %s; microseconds per transform, Ooura "
+        "against vector (speedup)\n%-6s", fft_simdname(), "n");
+    for (nkind = 0; nkind < NBENCHKINDS; nkind++)
+        printf(" %27s", fft_names[bench_kinds[nkind]]);
+    printf("\n");
+    for (logn = BENCH_MINLOG; logn <= FFT_MAXLOG; logn++)
+    {
+        int n = 1 << logn;
+        printf("%-6d", n);
+        for (nkind = 0; nkind < NBENCHKINDS; nkind++)
+        {
+            int kind = bench_kinds[nkind];
+            double copy = bench_run(kind, -1, in, buf, n, seconds);
+            double ooura = bench_run(kind, 0, in, buf, n, seconds) - copy;
+            double simd = bench_run(kind, 1, in, buf, n, seconds) - copy;
+            printf(" %9.2f %9.2f (%5.2fx)", ooura, simd, ooura / simd);
+        }
+        printf("\n");
+    }
+    simdfft_term();
+    ooura_term();
+    free(in), free(buf);
+    return (0);
+}
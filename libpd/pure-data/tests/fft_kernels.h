@@ -0,0 +1,89 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  shared by fft_test.c and fft_bench.c: the vector FFT of d_fft_simd.c
+    and the Ooura package it sits in front of, compiled in here together as
+    Pd links them.  Each transform is called through the mayer_*() and
+    pd_fft() entry points as fft~, rfft~ and friends call it; setting
+    simdfft_on, which "pd fft-backend" sets, decides whether d_fft_simd.c
+    takes it or hands it on to Ooura.  The little of Pd these need is
+    stubbed out.
+*/
+
+#include "../src/d_fft_simd.c"
+#include "../src/d_fft_fftsg.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ------------------------ stubs for Pd ------------------------ */
+
+int ilog2(int n)
+{
+    int r = -1;
+    if (n <= 0) return(0);
+    while (n)
+    {
+        r++;
+        n >>= 1;
+    }
+    return (r);
+}
+
+int worker_threaded(void) { return (0); }
+void post(const char *fmt, ...) {}
+void pd_error(const void *object, const char *fmt, ...) {}
+
+/* ------------------------ the transforms ------------------------ */
+
+#define FFT_MINLOG 2        /* 4 points */
+#define FFT_MAXLOG 16       /* 65536 points */
+
+#define FFT_COMPLEX 0       /* mayer_fft() on split re, im arrays */
+#define FFT_ICOMPLEX 1      /* mayer_ifft() */
+#define FFT_REAL 2          /* mayer_realfft() in place */
+#define FFT_IREAL 3         /* mayer_realifft() */
+#define FFT_PD 4            /* pd_fft() on interleaved re, im */
+#define FFT_IPD 5           /* pd_fft() inverse */
+#define NFFTKINDS 6
+
+static const char *fft_names[NFFTKINDS] =
+    {"fft", "ifft", "realfft", "realifft", "pd_fft", "pd_ifft"};
+
+    /* values in the buffer for a transform of n points, which is "re"
+    followed by "im" for the split complex ones */
+static int fft_nvalues(int kind, int n)
+{
+    return (kind == FFT_REAL || kind == FFT_IREAL ? n : 2 * n);
+}
+
+    /* run one transform of n points in place, with the vector FFT or with
+    Ooura */
+static void fft_run(int kind, int simd, t_sample *buf, int n)
+{
+    simdfft_on = simd;
+    switch (kind)
+    {
+    case FFT_COMPLEX: mayer_fft(n, buf, buf + n); break;
+    case FFT_ICOMPLEX: mayer_ifft(n, buf, buf + n); break;
+    case FFT_REAL: mayer_realfft(n, buf); break;
+    case FFT_IREAL: mayer_realifft(n, buf); break;
+    case FFT_PD: pd_fft(buf, n, 0); break;
+    default: pd_fft(buf, n, 1);
+    }
+}
+
+    /* which routines the vector FFT's passes use on this machine */
+static const char *fft_simdname(void)
+{
+#ifdef SIMD_AVX2
+    if (simd_avx2())
+        return ("v8");
+#endif
+#ifdef SIMD_V4
+    return ("v4");
+#else
+    return ("scalar");
+#endif
+}
@@ -0,0 +1,94 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  check the vector FFT of d_fft_simd.c against Ooura, which it stands in
+    front of.  Every transform Pd calls it for (mayer_fft(), mayer_ifft(),
+    mayer_realfft(), mayer_realifft() and pd_fft() both ways) is run on the
+    same noise by each, for every power of two from 4 to 65536 points.
+    The two can't agree to the bit: Ooura works in double precision and
+    rounds once at the end, while the vector FFT rounds to single precision
+    at every pass, so its error grows with the number of passes.  The
+    largest difference, relative to the RMS of Ooura's result, must be
+    below TOLERANCE times log2 of the size, which is some 7 times the
+    most seen on x86.  The vector FFT mustn't write past the end of its
+    buffer either.  Build and run it with "make check" here; with
+    -DPD_NOSIMD it checks the plain C version of the passes.
+*/
+
+#include "fft_kernels.h"
+#include <math.h>
+
+#define TOLERANCE 5e-7
+#define GUARD 8             /* values after the buffer checked for writes */
+#define GUARDVALUE 1234.5f
+
+static int nfail;
+
+    /* the largest difference between "out" and the reference, relative to
+    the reference's RMS */
+static double test_error(const t_sample *out, const t_sample *ref, int n)
+{
+    double sum = 0, worst = 0;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        double diff = fabs((double)out[i] - ref[i]);
+        sum += (double)ref[i] * ref[i];
+        if (diff > worst || diff != diff)
+            worst = (diff != diff ? HUGE_VAL : diff);
+    }
+    return (sum > 0 ? worst / sqrt(sum / n) : worst);
+}
+
+static void test_transform(int kind, int logn, t_sample *in, t_sample *ref,
+    t_sample *out)
+{
+    int n = 1 << logn, nvalues = fft_nvalues(kind, n), i, bad = 0;
+    double error, tolerance = TOLERANCE * logn;
+    memcpy(ref, in, nvalues * sizeof(t_sample));
+    fft_run(kind, 0, ref, n);
+    memcpy(out, in, nvalues * sizeof(t_sample));
+    for (i = 0; i < GUARD; i++)
+        out[nvalues + i] = GUARDVALUE;
+    fft_run(kind, 1, out, n);
+    error = test_error(out, ref, nvalues);
+    if (error > tolerance)
+    {
+        fprintf(stderr, "%s, n %d: error %g, more than %g\n",
+            fft_names[kind], n, error, tolerance);
+        bad = 1;
+    }
+    for (i = 0; i < GUARD; i++)
+        if (out[nvalues + i] != GUARDVALUE)
+    {
+        fprintf(stderr, "%s, n %d: wrote past the end\n",
+            fft_names[kind], n);
+        bad = 1;
+        break;
+    }
+    if (bad)
+        nfail++;
+    printf("%-9s n %-6d error %.2e %s\n", fft_names[kind], n, error,
+        (bad ? "FAILED" : "ok"));
+}
+
+int main(void)
+{
+    int nmax = 2 << FFT_MAXLOG, kind, logn, i;
+    t_sample *in = (t_sample *)malloc(nmax * sizeof(t_sample)),
+        *ref = (t_sample *)malloc(nmax * sizeof(t_sample)),
+        *out = (t_sample *)malloc((nmax + GUARD) * sizeof(t_sample));
+    srand(1);
+    for (i = 0; i < nmax; i++)
+        in[i] = 2.f * rand() / RAND_MAX - 1.f;
+    printf("vector FFT passes: %s\n", fft_simdname());
+    for (kind = 0; kind < NFFTKINDS; kind++)
+        for (logn = FFT_MINLOG; logn <= FFT_MAXLOG; logn++)
+            test_transform(kind, logn, in, ref, out);
+    printf("%s\n", (nfail ? "FAILED" : "all ok"));
+    simdfft_term();
+    ooura_term();
+    free(in), free(ref), free(out);
+    return (nfail != 0);
+}
@@ -0,0 +1,109 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  time the perform routines of d_arithmetic.c and d_math.c that have
+    vector versions: for each, the scalar routine the object used to run
+    (the "perf8" one if there is one, otherwise "perform"), the v4 routine
+    and, if the CPU has AVX2, the v8 one, each run over and over on the
+    same block as the DSP chain would.  Prints nanoseconds per sample and
+    the speedup over the scalar routine.  Usage:
+        simd_bench [block size (64)] [milliseconds per routine (200)]
+    The block size must be a multiple of 8 for the vector routines to run.
+*/
+
+#include "simd_kernels.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static double bench_now(void)       /* seconds */
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return ((double)count.QuadPart / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#endif
+}
+
+    /* ns per sample of one routine, run for about "seconds" */
+static double bench_run(const t_kernel *k, t_perfroutine f, t_kernelobj *x,
+    t_sample *in1, t_sample *in2, t_sample *out, int n, double seconds)
+{
+    t_int w[8];
+    double start, elapsed;
+    long count = 0, i, batch = 1 + 100000 / n;
+    w[0] = (t_int)f;
+    kernel_args(k, w, x, in1, in2, out, n);
+    for (i = 0; i < batch; i++)     /* warm up */
+        (*f)(w);
+    start = bench_now();
+    do
+    {
+        for (i = 0; i < batch; i++)
+            (*f)(w);
+        count += batch;
+    } while ((elapsed = bench_now() - start) < seconds);
+    return (1e9 * elapsed / ((double)count * n));
+}
+
+int main(int argc, char **argv)
+{
+    int n = (argc > 1 ? atoi(argv[1]) : 64), i;
+    double seconds = (argc > 2 ? atof(argv[2]) : 200) * 0.001;
+    t_sample *in1, *in2, *out;
+    unsigned int nkernel;
+    if (n < 1)
+        n = 64;
+    in1 = (t_sample *)malloc(n * sizeof(*in1));
+    in2 = (t_sample *)malloc(n * sizeof(*in2));
+    out = (t_sample *)malloc(n * sizeof(*out));
+        /* ordinary audio: no denormals, NaNs or zeros */
+    srand(1);
+    for (i = 0; i < n; i++)
+    {
+        in1[i] = 4.f * rand() / RAND_MAX - 2.f;
+        in2[i] = 4.f * rand() / RAND_MAX - 2.f;
+        if (in2[i] == 0)
+            in2[i] = 1;
+    }
+    printf("block size %d, ns per sample (speedup over scalar)\n", n);
+    printf("%-12s %8s %16s %16s\n", "routine", "scalar", "v4", "v8");
+    for (nkernel = 0; nkernel < NKERNELS; nkernel++)
+    {
+        const t_kernel *k = &kernels[nkernel];
+        t_kernelobj x;
+        double scalar;
+        kernel_set(k, &x, (k->k_type == KERNEL_CLIP ? -0.5 : 0.7), 0.5);
+        scalar = bench_run(k, kernel_reference(k, n), &x, in1, in2, out, n,
+            seconds);
+        printf("%-12s %8.3f", k->k_name, scalar);
+        if (!(n & 7) && k->k_v4)
+        {
+            double t = bench_run(k, k->k_v4, &x, in1, in2, out, n, seconds);
+            printf(" %8.3f (%4.1fx)", t, scalar / t);
+        }
+        else printf(" %16s", "-");
+#ifdef SIMD_AVX2
+        if (!(n & 7) && k->k_v8 && simd_avx2())
+        {
+            double t = bench_run(k, k->k_v8, &x, in1, in2, out, n, seconds);
+            printf(" %8.3f (%4.1fx)", t, scalar / t);
+        }
+        else
+#endif
+        printf(" %16s", "-");
+        printf("\n");
+    }
+    free(in1);
+    free(in2);
+    free(out);
+    return (0);
+}
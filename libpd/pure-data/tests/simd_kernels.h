@@ -0,0 +1,194 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  shared by simd_test.c and simd_bench.c: the perform routines of
+    d_arithmetic.c and d_math.c that have vector versions (see d_simd.h),
+    compiled in here so that their static functions can be reached.  Only
+    the perform routines and "dsp" methods are called, so the rest of Pd is
+    stubbed out; the stub dsp_add() keeps the routine and arguments a "dsp"
+    method asked for, so that they can be run as the DSP chain would run
+    them.
+*/
+
+#include "../src/d_arithmetic.c"
+#include "../src/d_math.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ------------------------ stubs for Pd ------------------------ */
+
+int pd_compatibilitylevel = 100000;
+t_symbol s_signal;
+
+t_symbol *gensym(const char *s) { return (&s_signal); }
+t_float atom_getfloatarg(int which, int argc, const t_atom *argv)
+    { return (0); }
+t_pd *pd_new(t_class *cls) { return (0); }
+void pd_float(t_pd *x, t_float f) {}
+t_inlet *inlet_new(t_object *owner, t_pd *dest, t_symbol *s1,
+    t_symbol *s2) { return (0); }
+t_inlet *floatinlet_new(t_object *owner, t_float *fp) { return (0); }
+t_inlet *signalinlet_new(t_object *owner, t_float f) { return (0); }
+t_outlet *outlet_new(t_object *owner, t_symbol *s) { return (0); }
+t_class *class_new(t_symbol *name, t_newmethod newmethod,
+    t_method freemethod, size_t size, int flags, t_atomtype arg1, ...)
+    { return (0); }
+void class_addcreator(t_newmethod newmethod, t_symbol *s,
+    t_atomtype type1, ...) {}
+void class_addmethod(t_class *c, t_method fn, t_symbol *sel,
+    t_atomtype arg1, ...) {}
+void class_sethelpsymbol(t_class *c, t_symbol *s) {}
+void class_setparalleldsp(t_class *c) {}
+void class_domainsignalin(t_class *c, int onset) {}
+void post(const char *fmt, ...) {}
+
+    /* the last routine a "dsp" method put on the "chain" */
+static t_int kernel_chain[8];
+
+void dsp_add(t_perfroutine f, int n, ...)
+{
+    va_list ap;
+    int i;
+    va_start(ap, n);
+    kernel_chain[0] = (t_int)f;
+    for (i = 0; i < n; i++)
+        kernel_chain[i+1] = va_arg(ap, t_int);
+    va_end(ap);
+}
+
+/* ------------------------ the kernels ------------------------ */
+
+#define KERNEL_BINOP 0      /* (in1, in2, out, n) */
+#define KERNEL_SCALAROP 1   /* (in, &scalar, out, n) */
+#define KERNEL_CLIP 2       /* (x, in, out, n) */
+#define KERNEL_UNOP 3       /* (in, out, n) */
+
+typedef void (*t_kerneldsp)(void *x, t_signal **sp);
+
+typedef struct _kernel
+{
+    const char *k_name;
+    int k_type;
+    t_kerneldsp k_dsp;          /* the object's "dsp" method */
+    t_perfroutine k_perform;    /* scalar routine for any block size */
+    t_perfroutine k_perf8;      /* the one for multiples of 8, if any */
+    t_perfroutine k_v4;         /* vector routines, if built */
+    t_perfroutine k_v8;
+    int k_scalar;               /* offset of the scalar in the object */
+} t_kernel;
+
+#ifdef SIMD_V4
+#define KERNEL_V4(name) name##_perfv4
+#else
+#define KERNEL_V4(name) 0
+#endif
+#ifdef SIMD_AVX2
+#define KERNEL_V8(name) name##_perfv8
+#else
+#define KERNEL_V8(name) 0
+#endif
+
+#define KERNEL(name, type, perf8) {#name, type, (t_kerneldsp)name##_dsp, \
+    name##_perform, perf8, KERNEL_V4(name), KERNEL_V8(name), 0}
+#define SCALARKERNEL(name) {#name, KERNEL_SCALAROP, (t_kerneldsp)name##_dsp, \
+    name##_perform, name##_perf8, KERNEL_V4(name), KERNEL_V8(name), \
+    (int)offsetof(t_##name, x_g)}
+
+static const t_kernel kernels[] =
+{
+    KERNEL(plus, KERNEL_BINOP, plus_perf8),
+    SCALARKERNEL(scalarplus),
+    KERNEL(minus, KERNEL_BINOP, minus_perf8),
+    SCALARKERNEL(scalarminus),
+    KERNEL(times, KERNEL_BINOP, times_perf8),
+    SCALARKERNEL(scalartimes),
+    KERNEL(over, KERNEL_BINOP, over_perf8),
+    SCALARKERNEL(scalarover),
+    KERNEL(max, KERNEL_BINOP, max_perf8),
+    SCALARKERNEL(scalarmax),
+    KERNEL(min, KERNEL_BINOP, min_perf8),
+    SCALARKERNEL(scalarmin),
+    KERNEL(clip, KERNEL_CLIP, 0),
+    KERNEL(sigwrap, KERNEL_UNOP, 0),
+    KERNEL(abs_tilde, KERNEL_UNOP, 0),
+};
+
+#define NKERNELS (sizeof(kernels) / sizeof(*kernels))
+
+    /* the object a kernel's "dsp" method and routines get */
+typedef union _kernelobj
+{
+    t_object o_obj;
+    t_scalarplus o_scalarplus;
+    t_scalarminus o_scalarminus;
+    t_scalartimes o_scalartimes;
+    t_scalarover o_scalarover;
+    t_scalarmax o_scalarmax;
+    t_scalarmin o_scalarmin;
+    t_clip o_clip;
+} t_kernelobj;
+
+    /* set the scalar of a "scalar" class, or clip's bounds */
+static void kernel_set(const t_kernel *k, t_kernelobj *x, t_float f1,
+    t_float f2)
+{
+    memset(x, 0, sizeof(*x));
+    if (k->k_type == KERNEL_SCALAROP)
+        *(t_float *)((char *)x + k->k_scalar) = f1;
+    else if (k->k_type == KERNEL_CLIP)
+        x->o_clip.x_lo = f1, x->o_clip.x_hi = f2;
+}
+
+    /* set up the arguments of a routine for block size n */
+static void kernel_args(const t_kernel *k, t_int *w, t_kernelobj *x,
+    t_sample *in1, t_sample *in2, t_sample *out, int n)
+{
+    switch (k->k_type)
+    {
+    case KERNEL_BINOP:
+        w[1] = (t_int)in1; w[2] = (t_int)in2; w[3] = (t_int)out; w[4] = n;
+        break;
+    case KERNEL_SCALAROP:
+        w[1] = (t_int)in1; w[2] = (t_int)((char *)x + k->k_scalar);
+        w[3] = (t_int)out; w[4] = n;
+        break;
+    case KERNEL_CLIP:
+        w[1] = (t_int)x; w[2] = (t_int)in1; w[3] = (t_int)out; w[4] = n;
+        break;
+    default:
+        w[1] = (t_int)in1; w[2] = (t_int)out; w[3] = n;
+    }
+}
+
+    /* call the "dsp" method for block size n and return the routine it
+    chose, with its arguments in kernel_chain */
+static t_perfroutine kernel_dsp(const t_kernel *k, t_kernelobj *x,
+    t_sample *in1, t_sample *in2, t_sample *out, int n)
+{
+    t_signal sig[3], *sp[3];
+    int i;
+    memset(sig, 0, sizeof(sig));
+    for (i = 0; i < 3; i++)
+    {
+        sig[i].s_n = sig[i].s_vecsize = n;
+        sig[i].s_sr = 44100;
+        sp[i] = &sig[i];
+    }
+    sig[0].s_vec = in1;
+    if (k->k_type == KERNEL_BINOP)
+        sig[1].s_vec = in2, sig[2].s_vec = out;
+    else sig[1].s_vec = out;
+    kernel_chain[0] = 0;
+    (*k->k_dsp)(x, sp);
+    return ((t_perfroutine)kernel_chain[0]);
+}
+
+    /* what the object ran for block size n before it had vector routines */
+static t_perfroutine kernel_reference(const t_kernel *k, int n)
+{
+    return ((n & 7) || !k->k_perf8 ? k->k_perform : k->k_perf8);
+}
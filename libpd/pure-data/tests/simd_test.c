@@ -0,0 +1,202 @@
+/* Copyright (c) 1997-1999 Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/*  check that the vector perform routines of d_arithmetic.c and d_math.c
+    give the same bits as the scalar ones they replace.  Every pair of a
+    set of awkward inputs (NaNs, signed zeros, denormals, infinities, values
+    near and beyond integers) goes through each routine, in blocks of every
+    size from 1 to 72 so that there are tails that aren't a multiple of 4
+    or 8, starting at every offset.  Each block is run three ways: by the
+    routine the object's "dsp" method chooses for its size, and by the v4
+    and v8 routines directly where the size allows; each result is compared
+    with memcmp() against what the object ran before it had vector routines
+    (the "perf8" routine for multiples of 8, otherwise "perform").  As
+    d_simd.h says, only the sign and payload of the NaN that comes out of
+    an operation on two NaNs may differ; that is allowed and counted.
+    Writing past the end of the block is checked too.  Build and run it
+    with "make check" here, without -ffast-math.
+*/
+
+#include "simd_kernels.h"
+
+#if PD_FLOATSIZE != 32
+#error "the test's inputs are single precision, and so are the routines"
+#endif
+#ifdef __FAST_MATH__
+#error "-ffast-math changes what the scalar routines do with NaNs, signed \
+zeros and denormals, so there'd be nothing to compare against"
+#endif
+
+static const unsigned int edgebits[] =
+{
+    0x00000000, 0x80000000,                         /* +0, -0 */
+    0x3f800000, 0xbf800000, 0x3f000000, 0xbf000000, /* 1, -1, .5, -.5 */
+    0x3fc00000, 0xbfc00000, 0x40400000, 0x40e00000, /* 1.5, -1.5, 3, 7 */
+    0x403fffff, 0xc03fffff,                 /* just below 3 and -3 */
+    0x3dcccccd, 0xbdcccccd, 0x322bcc77,     /* .1, -.1, 1e-8 */
+    0x00000001, 0x80000001,                 /* smallest denormals */
+    0x007fffff, 0x807fffff,                 /* largest denormals */
+    0x00800000, 0x80800000,                 /* smallest normals */
+    0x7f7fffff, 0xff7fffff,                 /* largest normals */
+    0x7f800000, 0xff800000,                 /* infinities */
+    0x7fc00000, 0xffc00000, 0x7fc12345,     /* quiet NaNs */
+    0x7f800001, 0xff812345,                 /* signaling NaNs */
+    0x4afffffe, 0x4b800000, 0xcb800001,     /* 2^23 - 1, 2^24, -2^24-2 */
+    0x4f000000, 0xcf000000, 0x4f32d05e,     /* 2^31, -2^31, 3e9 */
+    0xcf32d05e, 0x7149f2ca, 0xf149f2ca,     /* -3e9, 1e30, -1e30 */
+};
+
+#define NEDGES (sizeof(edgebits) / sizeof(*edgebits))
+#define MAXN 72             /* largest block size tried */
+#define GUARD 8             /* samples after the block checked for writes */
+#define GUARDBITS 0x7fbadbad
+
+static t_sample edges[NEDGES];
+
+static int isnanbits(const t_sample *f)
+{
+    unsigned int u;
+    memcpy(&u, f, sizeof(u));
+    return ((u & 0x7f800000) == 0x7f800000 && (u & 0x007fffff));
+}
+
+static unsigned int bits(t_sample f)
+{
+    unsigned int u;
+    memcpy(&u, &f, sizeof(u));
+    return (u);
+}
+
+    /* run a routine over one block, with a guard after it */
+static void kernel_run(const t_kernel *k, t_perfroutine f, t_kernelobj *x,
+    t_sample *in1, t_sample *in2, t_sample *out, int n)
+{
+    t_int w[8];
+    int i;
+    for (i = 0; i < n + GUARD; i++)
+        memcpy(&out[i], &(unsigned int){GUARDBITS}, sizeof(*out));
+    w[0] = (t_int)f;
+    kernel_args(k, w, x, in1, in2, out, n);
+    (*f)(w);
+}
+
+static int nfail, nnan;
+
+    /* compare a result with the reference one; returns nonzero if they
+    differ in anything else than the sign and payload of a NaN made from
+    two NaNs */
+static int kernel_compare(const t_kernel *k, const char *how,
+    const t_kernelobj *x, const t_sample *in1, const t_sample *in2,
+    const t_sample *ref, const t_sample *out, int n)
+{
+    int i, bad = 0;
+    if (!memcmp(ref, out, (n + GUARD) * sizeof(*out)))
+        return (0);
+    for (i = 0; i < n + GUARD; i++)
+    {
+        if (!memcmp(&ref[i], &out[i], sizeof(*out)))
+            continue;
+        if (i < n && isnanbits(&ref[i]) && isnanbits(&out[i]) &&
+            isnanbits(&in1[i]) && (k->k_type == KERNEL_BINOP ?
+                isnanbits(&in2[i]) : k->k_type == KERNEL_SCALAROP &&
+                    isnanbits((t_sample *)((char *)x + k->k_scalar))))
+        {
+            nnan++;
+            continue;
+        }
+        if (bad++ < 4 && nfail < 40)
+            fprintf(stderr, "%s (%s), n %d, sample %d: "
+                "in %08x %08x -> %08x, expected %08x\n",
+                k->k_name, how, n, i, bits(in1[i]),
+                (k->k_type == KERNEL_BINOP ? bits(in2[i]) : 0),
+                bits(out[i]), bits(ref[i]));
+    }
+    if (bad)
+        nfail++;
+    return (bad);
+}
+
+    /* all pairs of edge values in in1 and in2, and some room to spare
+    so that blocks can start anywhere in them */
+#define NDATA (NEDGES * NEDGES + MAXN)
+
+static int kernel_test(const t_kernel *k, t_float f1, t_float f2,
+    t_sample *in1, t_sample *in2, int ndata)
+{
+    t_sample ref[MAXN + GUARD], out[MAXN + GUARD];
+    t_kernelobj x;
+    int n, onset, nblocks = 0;
+    kernel_set(k, &x, f1, f2);
+    for (n = 1; n <= MAXN; n++)
+        for (onset = 0; onset + n <= ndata; onset += n)
+    {
+        t_sample *i1 = in1 + onset, *i2 = in2 + onset;
+        t_perfroutine f = kernel_dsp(k, &x, i1, i2, out, n);
+        kernel_run(k, kernel_reference(k, n), &x, i1, i2, ref, n);
+        if (!f)
+        {
+            fprintf(stderr, "%s: no routine for n %d\n", k->k_name, n);
+            nfail++;
+            continue;
+        }
+        kernel_run(k, f, &x, i1, i2, out, n);
+        kernel_compare(k, "dsp", &x, i1, i2, ref, out, n);
+        if (!(n & 7) && k->k_v4)
+        {
+            kernel_run(k, k->k_v4, &x, i1, i2, out, n);
+            kernel_compare(k, "v4", &x, i1, i2, ref, out, n);
+        }
+#ifdef SIMD_AVX2
+        if (!(n & 7) && k->k_v8 && simd_avx2())
+        {
+            kernel_run(k, k->k_v8, &x, i1, i2, out, n);
+            kernel_compare(k, "v8", &x, i1, i2, ref, out, n);
+        }
+#endif
+        nblocks++;
+    }
+    return (nblocks);
+}
+
+int main(void)
+{
+    static t_sample in1[NDATA], in2[NDATA];
+    unsigned int i, j, nkernel;
+    for (i = 0; i < NEDGES; i++)
+        memcpy(&edges[i], &edgebits[i], sizeof(*edges));
+        /* copy bits, so that signaling NaNs stay signaling */
+    for (i = 0; i < NDATA; i++)
+    {
+        memcpy(&in1[i], &edgebits[i % NEDGES], sizeof(*in1));
+        memcpy(&in2[i], &edgebits[(i / NEDGES) % NEDGES], sizeof(*in2));
+    }
+#ifdef SIMD_AVX2
+    printf("vector routines: v4 and v8 (%s)\n",
+        (simd_avx2() ? "run" : "not run, no AVX2 on this CPU"));
+#elif defined(SIMD_V4)
+    printf("vector routines: v4\n");
+#else
+    printf("vector routines: none (only the dispatch is tested)\n");
+#endif
+    for (nkernel = 0; nkernel < NKERNELS; nkernel++)
+    {
+        const t_kernel *k = &kernels[nkernel];
+        int failed = nfail, nblocks = 0;
+        if (k->k_type == KERNEL_SCALAROP)
+            for (i = 0; i < NEDGES; i++)
+                nblocks += kernel_test(k, edges[i], 0, in1, in2, NDATA);
+        else if (k->k_type == KERNEL_CLIP)  /* every lo and hi: less data */
+            for (i = 0; i < NEDGES; i++)
+                for (j = 0; j < NEDGES; j++)
+                    nblocks += kernel_test(k, edges[i], edges[j], in1, in2,
+                        3 * NEDGES + MAXN);
+        else nblocks = kernel_test(k, 0, 0, in1, in2, NDATA);
+        printf("%-12s %s (%d blocks)\n", k->k_name,
+            (nfail > failed ? "FAILED" : "ok"), nblocks);
+    }
+    if (nnan)
+        printf("%d NaNs from two NaNs differed in sign or payload\n", nnan);
+    printf("%s\n", (nfail ? "FAILED" : "all ok"));
+    return (nfail != 0);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/libpd/libpd for documentation
+ *
+ */
+
+// cost per sample against the tick size set with libpd_set_blocksize(): a
+// patch of voices ([osc~] -> [lop~] -> [*~] into a stereo [dac~], with a
+// [metro] per voice setting its frequency to give the scheduler some clocks)
+// is run through libpd_process_float() for each block size from 1 to 1024,
+// always 1024 frames per call, and the time per output frame is printed with
+// its ratio to the default block size of 64; small blocks show the per-tick
+// overhead of sched_tick() and dsp_tick(), large ones what is saved
+//
+// usage: blocksize_bench [voices (8)] [milliseconds per block size (300)]
+
+#include "libpd_bench.h"
+
+#define FRAMES 1024 // per libpd_process_float() call
+#define CHANNELS 2
+
+// ns per output frame at block size n
+static double bench_blocksize(int n, double seconds) {
+  static float out[FRAMES * CHANNELS];
+  double start, elapsed;
+  long count = 0;
+  int i, ticks = FRAMES / n;
+  if (libpd_set_blocksize(n)) return -1;
+  for (i = 0; i < 16; i++) // warm up
+    libpd_process_float(ticks, NULL, out);
+  start = bench_now();
+  do {
+    for (i = 0; i < 16; i++)
+      libpd_process_float(ticks, NULL, out);
+    count += 16;
+  } while ((elapsed = bench_now() - start) < seconds);
+  return 1e9 * elapsed / ((double)count * FRAMES);
+}
+
+int main(int argc, char **argv) {
+  int nvoices = (argc > 1 ? atoi(argv[1]) : 8), i, n;
+  double seconds = (argc > 2 ? atof(argv[2]) : 300) * 0.001, ref;
+  double times[11];
+  t_benchpatch p;
+  if (nvoices < 1) nvoices = 8;
+  libpd_init();
+  libpd_init_audio(0, CHANNELS, 44100);
+  bench_newpatch(&p, "blocksize");
+  for (i = 0; i < nvoices; i++) {
+    char text[64];
+    int bang, metro, rnd, add, osc, lop, gain;
+    snprintf(text, sizeof(text), "metro %d", 5 + i);
+    bang = bench_obj(&p, "loadbang");
+    metro = bench_obj(&p, text);
+    rnd = bench_obj(&p, "random 1000");
+    add = bench_obj(&p, "+ 100");
+    osc = bench_obj(&p, "osc~");
+    lop = bench_obj(&p, "lop~ 2000");
+    gain = bench_obj(&p, "*~ 0.1");
+    bench_connect(&p, bang, 0, metro, 0);
+    bench_connect(&p, metro, 0, rnd, 0);
+    bench_connect(&p, rnd, 0, add, 0);
+    bench_connect(&p, add, 0, osc, 0);
+    bench_connect(&p, osc, 0, lop, 0);
+    bench_connect(&p, lop, 0, gain, 0);
+    bench_connect(&p, gain, 0, bench_obj(&p, "dac~"), i & 1);
+  }
+  libpd_start_message(1);
+  libpd_finish_message(p.receiver, "loadbang");
+  bench_dsp(1);
+  printf("%d voices, ns per sample frame (relative to block size 64)\n",
+    nvoices);
+  for (i = 0, n = 1; n <= FRAMES; i++, n *= 2)
+    times[i] = bench_blocksize(n, seconds);
+  ref = times[6];
+  for (i = 0, n = 1; n <= FRAMES; i++, n *= 2)
+    printf("%5d %10.2f (%4.2fx)\n", n, times[i], times[i] / ref);
+  bench_dsp(0);
+  return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/libpd/libpd for documentation
+ *
+ */
+
+// throughput of several PdBase objects, each with its own pd instance,
+// processed at once on a thread each: every object gets the same patch of
+// voices as blocksize_bench, then for 1 to N threads that many objects are
+// run through processFloat() together for a while, and the total ticks per
+// second are printed with the speedup over one thread, which would be N for
+// perfect scaling
+//
+// libpd must be built with PDINSTANCE & PDTHREADS (as the makefile here
+// does), otherwise all objects share one instance and can't run at once
+//
+// usage: instance_bench [threads (number of cores, at least 4)]
+//                       [voices per instance (8)] [milliseconds per run (500)]
+
+#include "PdBase.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#ifndef PDINSTANCE
+    #error "instance_bench needs libpd and this file built with PDINSTANCE"
+#endif
+
+static const int ticksPerCall = 16;
+static const int channels = 2;
+
+// add an object to the patch "pd-bench" as its box text, ie. "osc~ 440",
+// returning its number for connect()
+static int addObject(pd::PdBase& pd, int& numObjects, const std::string& text) {
+    pd::List list;
+    list << 10 << 10 + 20 * numObjects;
+    size_t start = 0;
+    while(start < text.size()) {
+        size_t end = text.find(' ', start);
+        if(end == std::string::npos) {
+            end = text.size();
+        }
+        std::string token = text.substr(start, end - start);
+        char *rest;
+        float f = strtof(token.c_str(), &rest);
+        if(!token.empty() && *rest == '\0') {
+            list << f;
+        }
+        else if(!token.empty()) {
+            list << token;
+        }
+        start = end + 1;
+    }
+    pd.sendMessage("pd-bench", "obj", list);
+    return numObjects++;
+}
+
+static void connect(pd::PdBase& pd, int from, int outlet, int to, int inlet) {
+    pd::List list;
+    list << from << outlet << to << inlet;
+    pd.sendMessage("pd-bench", "connect", list);
+}
+
+// the blocksize_bench patch: voices of [metro]-driven [osc~] -> [lop~] ->
+// [*~] -> [dac~]
+static void makePatch(pd::PdBase& pd, int numVoices) {
+    pd::List name;
+    name << "bench" << ".";
+    pd.sendMessage("pd", "menunew", name);
+    int n = 0;
+    for(int i = 0; i < numVoices; ++i) {
+        char metroText[32];
+        snprintf(metroText, sizeof(metroText), "metro %d", 5 + i);
+        int bang = addObject(pd, n, "loadbang");
+        int metro = addObject(pd, n, metroText);
+        int rnd = addObject(pd, n, "random 1000");
+        int add = addObject(pd, n, "+ 100");
+        int osc = addObject(pd, n, "osc~");
+        int lop = addObject(pd, n, "lop~ 2000");
+        int gain = addObject(pd, n, "*~ 0.1");
+        connect(pd, bang, 0, metro, 0);
+        connect(pd, metro, 0, rnd, 0);
+        connect(pd, rnd, 0, add, 0);
+        connect(pd, add, 0, osc, 0);
+        connect(pd, osc, 0, lop, 0);
+        connect(pd, lop, 0, gain, 0);
+        connect(pd, gain, 0, addObject(pd, n, "dac~"), i & 1);
+    }
+    pd.sendMessage("pd-bench", "loadbang");
+    pd.computeAudio(true);
+}
+
+// run the first numThreads objects at once, returning total ticks per second
+static double run(std::vector<pd::PdBase*>& pds, int numThreads,
+                  double seconds) {
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false), stop(false);
+    std::vector<long> ticks(numThreads, 0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            std::vector<float> out(ticksPerCall *
+                                   pds[t]->instanceBlockSize() * channels);
+            pds[t]->processFloat(ticksPerCall, NULL, &out[0]); // warm up
+            ready++;
+            while(!go) {
+                std::this_thread::yield();
+            }
+            long count = 0;
+            while(!stop) {
+                pds[t]->processFloat(ticksPerCall, NULL, &out[0]);
+                count += ticksPerCall;
+            }
+            ticks[t] = count;
+        }));
+    }
+    while(ready < numThreads) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    long total = 0;
+    for(long count : ticks) {
+        total += count;
+    }
+    return total / elapsed;
+}
+
+int main(int argc, char **argv) {
+    int numThreads = (argc > 1 ? atoi(argv[1]) : 0);
+    int numVoices = (argc > 2 ? atoi(argv[2]) : 8);
+    double seconds = (argc > 3 ? atof(argv[3]) : 500) * 0.001;
+    if(numThreads < 1) {
+        numThreads = (int)std::thread::hardware_concurrency();
+        if(numThreads < 4) {
+            numThreads = 4;
+        }
+    }
+    if(numVoices < 1) {
+        numVoices = 8;
+    }
+
+    std::vector<pd::PdBase*> pds;
+    for(int i = 0; i < numThreads; ++i) {
+        pd::PdBase *pd = new pd::PdBase;
+        if(!pd->init(0, channels, 44100)) {
+            fprintf(stderr, "couldn't init instance %d\n", i);
+            return 1;
+        }
+        makePatch(*pd, numVoices);
+        pds.push_back(pd);
+    }
+
+    printf("%d voices per instance, %u cores, "
+           "ticks per second (speedup over 1 thread)\n",
+           numVoices, std::thread::hardware_concurrency());
+    double single = 0;
+    for(int n = 1; n <= numThreads; ++n) {
+        double rate = run(pds, n, seconds);
+        if(n == 1) {
+            single = rate;
+        }
+        printf("%3d threads %12.0f (%5.2fx)\n", n, rate, rate / single);
+    }
+
+    for(pd::PdBase *pd : pds) {
+        delete pd;
+    }
+    return 0;
+}
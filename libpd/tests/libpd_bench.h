@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/libpd/libpd for documentation
+ *
+ */
+
+// shared by the benchmarks here: a clock, and building a patch by sending
+// "obj" and "connect" messages to a new canvas, as the GUI would, so that
+// the benchmarks don't need patch files
+
+#ifndef __LIBPD_BENCH_H__
+#define __LIBPD_BENCH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+#include "z_libpd.h"
+
+// seconds from an arbitrary start
+static inline double bench_now(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (double)count.QuadPart / freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#endif
+}
+
+// sleep for about the given number of seconds
+static inline void bench_sleep(double seconds) {
+#ifdef _WIN32
+  Sleep((DWORD)(seconds * 1000));
+#else
+  struct timespec ts;
+  ts.tv_sec = (time_t)seconds;
+  ts.tv_nsec = (long)(1e9 * (seconds - ts.tv_sec));
+  nanosleep(&ts, NULL);
+#endif
+}
+
+// a patch being built in the current instance; objects are numbered from 0
+// in the order they were made, as "connect" wants them
+typedef struct _benchpatch {
+  char receiver[64]; // "pd-<name>"
+  int nobjects;
+} t_benchpatch;
+
+// make a new, empty patch called name
+static inline void bench_newpatch(t_benchpatch *p, const char *name) {
+  snprintf(p->receiver, sizeof(p->receiver), "pd-%s", name);
+  p->nobjects = 0;
+  libpd_start_message(2);
+  libpd_add_symbol(name);
+  libpd_add_symbol(".");
+  libpd_finish_message("pd", "menunew");
+}
+
+// add an object given as its box text, ie. "osc~ 440", and return its number
+static inline int bench_obj(t_benchpatch *p, const char *text) {
+  char buf[256], *tok, *end;
+  libpd_start_message(32);
+  libpd_add_float(10);
+  libpd_add_float(10 + 20 * p->nobjects);
+  snprintf(buf, sizeof(buf), "%s", text);
+  for (tok = buf; *tok; tok = end) {
+    double f;
+    size_t len = strcspn(tok, " ");
+    end = tok + len + (tok[len] != 0);
+    tok[len] = 0;
+    if (!len) continue;
+    f = strtod(tok, NULL);
+    if (strspn(tok, "-+.0123456789e") < len) libpd_add_symbol(tok);
+    else libpd_add_float((float)f);
+  }
+  libpd_finish_message(p->receiver, "obj");
+  return p->nobjects++;
+}
+
+static inline void bench_connect(t_benchpatch *p, int from, int outlet, int to,
+    int inlet) {
+  libpd_start_message(4);
+  libpd_add_float(from);
+  libpd_add_float(outlet);
+  libpd_add_float(to);
+  libpd_add_float(inlet);
+  libpd_finish_message(p->receiver, "connect");
+}
+
+// close a patch made with bench_newpatch(), freeing its objects
+static inline void bench_closepatch(t_benchpatch *p) {
+  libpd_start_message(1);
+  libpd_add_float(1); // don't ask about unsaved changes
+  libpd_finish_message(p->receiver, "menuclose");
+}
+
+static inline void bench_dsp(int on) {
+  libpd_start_message(1);
+  libpd_add_float(on);
+  libpd_finish_message("pd", "dsp");
+}
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 the juce_libpd contributors
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/libpd/libpd for documentation
+ *
+ */
+
+// how many [readsf~] voices the shared soundfile I/O pool keeps fed against
+// its number of threads: for "pd sf-threads" 1, 2, 4 and 8, patches of 16,
+// 32, 64... stereo 16-bit [readsf~] voices, each streaming one of a few test
+// files, are run through libpd_process_float() paced in real time, one tick
+// at a time, as an audio callback would be; a tick is late if it takes
+// longer than the time it stands for, mostly because a [readsf~] found its
+// FIFO dry and had to wait for the pool; the late ticks of each run are
+// printed, and for each thread count the most voices with no more than one
+// late tick in 200; the first voice is checked against its file as well
+//
+// late ticks are counted from the time libpd_process_float() takes rather
+// than from when it ends against the schedule, so that a sleep that wakes up
+// late, which the pool can't help, doesn't count
+//
+// usage: soundfile_bench [most voices (1024)] [milliseconds per run (2000)]
+
+#include "libpd_bench.h"
+
+#define SR 44100
+#define BLOCK 64
+#define CHANNELS 2
+#define NFILES 8
+#define FIFOSIZE 262144 // per [readsf~], the smallest it takes
+#define WARMUP (SR / 4 / BLOCK) // ticks not counted while files open
+
+static const int threadcounts[] = {1, 2, 4, 8};
+#define NTHREADCOUNTS (sizeof(threadcounts) / sizeof(*threadcounts))
+
+static short *file0; // the first file's samples, to check the first voice
+static long file0frames;
+
+static void bench_print(const char *s) {
+  fputs(s, stderr);
+}
+
+// write NFILES files of noise, long enough for one run
+static int bench_writefiles(long frames) {
+  int i;
+  for (i = 0; i < NFILES; i++) {
+    char name[64];
+    unsigned char header[44];
+    long bytes = frames * CHANNELS * 2, j;
+    FILE *f;
+    short *samples = (short *)malloc(bytes);
+    snprintf(name, sizeof(name), "soundfile_bench%d.wav", i);
+    if (!samples || !(f = fopen(name, "wb"))) {
+      fprintf(stderr, "couldn't write %s\n", name);
+      free(samples);
+      return 0;
+    }
+    for (j = 0; j < frames * CHANNELS; j++)
+      samples[j] = (short)(rand() % 65536 - 32768);
+    memcpy(header, "RIFF....WAVEfmt ", 16);
+    header[4] = (unsigned char)(36 + bytes);
+    header[5] = (unsigned char)((36 + bytes) >> 8);
+    header[6] = (unsigned char)((36 + bytes) >> 16);
+    header[7] = (unsigned char)((36 + bytes) >> 24);
+    memcpy(header + 16, "\x10\0\0\0\1\0\2\0\x44\xac\0\0\x10\xb1\2\0\4\0\x10\0",
+      20); // PCM, 2 channels, 44100 Hz, 176400 bytes/s, 4 bytes/frame, 16 bit
+    memcpy(header + 36, "data", 4);
+    header[40] = (unsigned char)bytes;
+    header[41] = (unsigned char)(bytes >> 8);
+    header[42] = (unsigned char)(bytes >> 16);
+    header[43] = (unsigned char)(bytes >> 24);
+    fwrite(header, 1, 44, f);
+    fwrite(samples, 1, bytes, f); // little-endian hosts only
+    fclose(f);
+    if (i == 0) {
+      file0 = samples;
+      file0frames = frames;
+    }
+    else free(samples);
+  }
+  return 1;
+}
+
+static void bench_removefiles(void) {
+  int i;
+  for (i = 0; i < NFILES; i++) {
+    char name[64];
+    snprintf(name, sizeof(name), "soundfile_bench%d.wav", i);
+    remove(name);
+  }
+}
+
+// run nvoices voices for the given number of ticks, after WARMUP ticks;
+// returns the number of late ticks and adds to *mismatches the samples of
+// the first voice that weren't the file's
+static int bench_voices(int nvoices, long ticks, long *mismatches) {
+  static float out[BLOCK * CHANNELS];
+  t_benchpatch p;
+  char patch[32], name[64], receiver[64];
+  double start, tick, period = (double)BLOCK / SR;
+  long i, j, frame = 0;
+  int v, late = 0;
+  snprintf(patch, sizeof(patch), "soundfile-%d", nvoices);
+  bench_newpatch(&p, patch);
+  for (v = 0; v < nvoices; v++) {
+    int r, sf;
+    snprintf(receiver, sizeof(receiver), "r sfbench-%d", v);
+    r = bench_obj(&p, receiver);
+    snprintf(receiver, sizeof(receiver), "readsf~ %d %d", CHANNELS,
+      FIFOSIZE);
+    sf = bench_obj(&p, receiver);
+    bench_connect(&p, r, 0, sf, 0);
+    if (v == 0) {
+      int dac = bench_obj(&p, "dac~");
+      bench_connect(&p, sf, 0, dac, 0);
+      bench_connect(&p, sf, 1, dac, 1);
+    }
+  }
+  for (v = 0; v < nvoices; v++) {
+    snprintf(receiver, sizeof(receiver), "sfbench-%d", v);
+    snprintf(name, sizeof(name), "soundfile_bench%d.wav", v % NFILES);
+    libpd_start_message(1);
+    libpd_add_symbol(name);
+    libpd_finish_message(receiver, "open");
+  }
+  for (v = 0; v < nvoices; v++) {
+    snprintf(receiver, sizeof(receiver), "sfbench-%d", v);
+    libpd_float(receiver, 1);
+  }
+  start = bench_now();
+  for (i = 0; i < WARMUP + ticks; i++) {
+    double due;
+    if (i == WARMUP) start = bench_now();
+    due = start + (i < WARMUP ? i : i - WARMUP) * period;
+    if (bench_now() < due) bench_sleep(due - bench_now());
+    tick = bench_now();
+    libpd_process_float(1, NULL, out);
+    if (i >= WARMUP && bench_now() - tick > period) late++;
+    for (j = 0; j < BLOCK * CHANNELS && frame < file0frames; j++)
+      if (out[j] != file0[frame * CHANNELS + j] / 32768.f) (*mismatches)++;
+    frame += BLOCK;
+  }
+  bench_closepatch(&p);
+  return late;
+}
+
+int main(int argc, char **argv) {
+  int maxvoices = (argc > 1 ? atoi(argv[1]) : 1024), nvoices;
+  double seconds = (argc > 2 ? atof(argv[2]) : 2000) * 0.001;
+  long ticks, mismatches = 0;
+  unsigned int t;
+  if (maxvoices < 1) maxvoices = 1024;
+  if (seconds <= 0) seconds = 1;
+  ticks = (long)(seconds * SR / BLOCK);
+  if (!bench_writefiles((WARMUP + ticks + 1) * BLOCK)) return 1;
+  libpd_set_printhook(bench_print);
+  libpd_init();
+  libpd_init_audio(0, CHANNELS, SR);
+  bench_dsp(1);
+  printf("late ticks of %ld paced in real time, by voices (most voices "
+    "with at most 1 in 200 late)\n%-8s", ticks, "threads");
+  for (nvoices = 16; nvoices <= maxvoices; nvoices *= 2)
+    printf(" %5d", nvoices);
+  printf(" %9s\n", "sustained");
+  for (t = 0; t < NTHREADCOUNTS; t++) {
+    int sustained = 0, failed = 0;
+    libpd_start_message(1);
+    libpd_add_float(threadcounts[t]);
+    libpd_finish_message("pd", "sf-threads");
+    printf("%-8d", threadcounts[t]);
+    fflush(stdout);
+    for (nvoices = 16; nvoices <= maxvoices; nvoices *= 2) {
+      int late;
+      if (failed) {
+        printf(" %5s", "-");
+        continue;
+      }
+      late = bench_voices(nvoices, ticks, &mismatches);
+      printf(" %5d", late);
+      fflush(stdout);
+      if (late * 200 > ticks) failed = 1;
+      else sustained = nvoices;
+    }
+    printf(" %9d\n", sustained);
+  }
+  bench_dsp(0);
+  bench_removefiles();
+  free(file0);
+  if (mismatches) {
+    printf("%ld samples of the first voice weren't its file's\n", mismatches);
+    return 1;
+  }
+  return 0;
+}